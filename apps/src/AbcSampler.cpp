@@ -0,0 +1,265 @@
+#include <iostream>
+#include <string>
+
+#include <cxxtest/TestSuite.h>
+#include "ExecutableSupport.hpp"
+#include "Exception.hpp"
+#include "PetscTools.hpp"
+#include "PetscException.hpp"
+
+#include "RandomNumberGenerator.hpp"
+
+#include "SimulatorOptions.hpp"
+#include "ModelLineage.hpp"
+#include "LineageBatch.hpp"
+#include "AbcHistogramDistance.hpp"
+#include "OutputFileHandler.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+/***********************************
+ * ABC SAMPLER
+ * Approximate Bayesian computation rejection sampling of He, Gomes or Boije parameters against an observed lineage
+ * count histogram, in one process (lineages are simulated by ModelLineage). Each candidate theta is drawn from uniform priors, and its lineages (seeds
+ * startSeed..endSeed, the same for every candidate) are simulated one at a time; the candidate is abandoned as soon as
+ * AbcHistogramDistance's lower bound on its final RSS exceeds the tolerance, so hopeless candidates cost a few lineages.
+ *
+ * Priors file: one line per model parameter, in the simulator's argument order: <name> <lowDouble> <highDouble>
+ * (low = high fixes the parameter; Boije generations are drawn as integers). Candidates whose probabilities sum over 1 are redrawn.
+ * He: inductionTime earliestLineageStartTime latestLineageStartTime endTime mitoticModePhase2 mitoticModePhase3 pPP1 pPD1 pPP2 pPD2 pPP3 pPD3
+ *     (stochastic mode, fixture 0, wild type founders)
+ * Gomes: endTime normalMu normalSigma pPP pPD pBC pAC pMG
+ * Boije: endGeneration phase2Generation phase3Generation pAtoh7 pPtf1a png
+ *
+ * Observed histogram file: P(count = 1), P(count = 2), ... one per line.
+ *
+ * --batched: each candidate's lineages run in LineageBatch blocks of BATCH_LINEAGES seeds, with the rejection test
+ * after each block; counts then match the simulators in distribution but not seed for seed.
+ *
+ * Accepted samples are written to <filenameString>.abc:
+ * "ISPABC01", uint32 number of parameters, then per parameter a uint32 name length & the name;
+ * then per accepted candidate: uint32 candidate index, double per parameter, double RSS.
+ * Read with python_fixtures/Abc_posterior.py.
+ ************************************/
+
+namespace
+{
+    const char ABC_MAGIC[8] = { 'I', 'S', 'P', 'A', 'B', 'C', '0', '1' };
+
+    //seeds per LineageBatch under --batched
+    const unsigned BATCH_LINEAGES = 256;
+}
+
+int main(int argc, char *argv[])
+{
+    SimulatorOptions::Startup(&argc, &argv);
+    //main() returns code indicating sim run success or failure mode
+    int exit_code = ExecutableSupport::EXIT_OK;
+
+    //positional arguments, less any trailing "--option <values>" pairs
+    int numPositional = SimulatorOptions::GetNumPositionalArguments(argc, argv);
+    if (numPositional != 11)
+    {
+        ExecutableSupport::PrintError(
+                "Wrong arguments for ABC sampler.\nUsage (replace<> with values):\n AbcSampler <directoryString> <filenameString> <modelString(He, Gomes or Boije)> <priorsFile> <observedHistogramFile> <toleranceDouble(RSS)> <numCandidatesUnsigned> <startSeedUnsigned> <endSeedUnsigned> <priorSeedUnsigned>\nPriors file: one line per model parameter, in the simulator's argument order: <name> <lowDouble> <highDouble> (uniform; low = high fixes it)\nObserved histogram file: P(count=1), P(count=2), ... one per line\nOptions:\n--serial : skip PETSc/MPI startup (not with mpirun)\n--batched : run each candidate's lineages in LineageBatch blocks\n",
+                true);
+        exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+        return exit_code;
+    }
+
+    /***********************
+     * SAMPLER PARAMETERS
+     ***********************/
+    std::string directoryString = argv[1];
+    std::string filenameString = argv[2];
+    std::string model = argv[3];
+    std::string priorsFile = argv[4];
+    std::string observedFile = argv[5];
+    double tolerance = std::stod(argv[6]);
+    unsigned numCandidates = std::stoul(argv[7]);
+    unsigned startSeed = std::stoul(argv[8]);
+    unsigned endSeed = std::stoul(argv[9]);
+    unsigned priorSeed = std::stoul(argv[10]);
+
+    /************************
+     * PARAMETER/ARGUMENT SANITY CHECK
+     ************************/
+    bool sane = 1;
+
+    std::vector<std::string> parameterNames = ModelLineage::GetParameterNames(model);
+    if (!ModelLineage::IsLineageModel(model))
+    {
+        ExecutableSupport::PrintError("Bad model (argument 3). Must be He, Gomes or Boije");
+        sane = 0;
+    }
+
+    //Uniform prior bounds, in parameterNames order
+    std::vector<double> priorLow, priorHigh;
+    std::ifstream priors(priorsFile.c_str());
+    std::string line;
+    while (std::getline(priors, line))
+    {
+        std::istringstream fields(line);
+        std::string name;
+        double low, high;
+        if (!(fields >> name)) continue; //blank line
+        if (!(fields >> low >> high) || low > high || priorLow.size() >= parameterNames.size()
+                || name != parameterNames[priorLow.size()])
+        {
+            ExecutableSupport::PrintError("Bad priors file line: " + line);
+            sane = 0;
+            break;
+        }
+        priorLow.push_back(low);
+        priorHigh.push_back(high);
+    }
+    if (sane && priorLow.size() != parameterNames.size())
+    {
+        ExecutableSupport::PrintError("Priors file " + priorsFile + " is missing or does not give every " + model + " parameter");
+        sane = 0;
+    }
+
+    std::vector<double> observed;
+    std::ifstream observedHistogram(observedFile.c_str());
+    double probability;
+    while (observedHistogram >> probability)
+    {
+        observed.push_back(probability);
+    }
+    if (observed.empty())
+    {
+        ExecutableSupport::PrintError("Observed histogram file " + observedFile + " is missing or empty");
+        sane = 0;
+    }
+
+    if (tolerance <= 0)
+    {
+        ExecutableSupport::PrintError("Bad tolerance (argument 6). Must be >0");
+        sane = 0;
+    }
+
+    if (endSeed < startSeed)
+    {
+        ExecutableSupport::PrintError("Bad start & end seeds (arguments 8, 9). endSeed must not be < startSeed");
+        sane = 0;
+    }
+
+    if (sane == 0)
+    {
+        ExecutableSupport::PrintError("Exiting with bad arguments. See errors for details");
+        exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+        return exit_code;
+    }
+
+    /************************
+     * SAMPLER OUTPUT SETUP
+     ************************/
+
+    OutputFileHandler handler(directoryString, false);
+    std::string outputPath = handler.GetOutputDirectoryFullPath() + filenameString + ".abc";
+    std::ofstream output(outputPath.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!output.is_open())
+    {
+        ExecutableSupport::PrintError("Could not open ABC posterior file " + outputPath);
+        exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+        return exit_code;
+    }
+    uint32_t numParameters = parameterNames.size();
+    output.write(ABC_MAGIC, sizeof(ABC_MAGIC));
+    output.write(reinterpret_cast<const char*>(&numParameters), sizeof(numParameters));
+    for (unsigned i = 0; i < parameterNames.size(); i++)
+    {
+        uint32_t length = parameterNames[i].size();
+        output.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        output.write(parameterNames[i].data(), length);
+    }
+
+    ExecutableSupport::Print("ABC sampler writing file " + filenameString + ".abc to directory " + directoryString);
+
+    /************************
+     * SAMPLING
+     ************************/
+
+    RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+    bool batched = SimulatorOptions::GetBatched();
+    unsigned numLineages = endSeed - startSeed + 1;
+    AbcHistogramDistance distance(observed, numLineages);
+    unsigned numAccepted = 0;
+    uint64_t lineagesSimulated = 0;
+
+    for (uint32_t candidate = 0; candidate < numCandidates; candidate++)
+    {
+        //Draw theta from the priors; the lineages reseed the RNG, so each candidate's draw has its own seed
+        std::vector<double> theta(parameterNames.size());
+        p_RNG->Reseed(priorSeed + candidate);
+        do
+        {
+            for (unsigned i = 0; i < theta.size(); i++)
+            {
+                if (ModelLineage::IsIntegerParameter(model, i))
+                {
+                    theta[i] = std::min(priorHigh[i], std::ceil(priorLow[i]) + std::floor(p_RNG->ranf() * (std::floor(priorHigh[i]) - std::ceil(priorLow[i]) + 1)));
+                }
+                else
+                {
+                    theta[i] = priorLow[i] + p_RNG->ranf() * (priorHigh[i] - priorLow[i]);
+                }
+            }
+        }
+        while (!ModelLineage::IsValidParameters(model, theta));
+
+        //Stream the lineages through the model until the candidate provably fails
+        distance.Reset();
+        bool rejected = false;
+        for (unsigned seed = startSeed; seed <= endSeed && !rejected; seed++)
+        {
+            if (batched)
+            {
+                LineageBatch batch(model);
+                unsigned blockEnd = std::min(endSeed, seed + BATCH_LINEAGES - 1);
+                for (unsigned batchSeed = seed; batchSeed <= blockEnd; batchSeed++)
+                {
+                    batch.AddLineage(theta, batchSeed);
+                }
+                batch.Run();
+                for (unsigned i = 0; i < batch.GetNumLineages(); i++)
+                {
+                    distance.AddLineage(batch.GetCount(i));
+                }
+                lineagesSimulated += batch.GetNumLineages();
+                seed = blockEnd;
+            }
+            else
+            {
+                distance.AddLineage(ModelLineage::Simulate(model, theta, seed)[0]);
+                lineagesSimulated++;
+            }
+            rejected = distance.GetLowerBound() > tolerance;
+        }
+
+        if (!rejected)
+        {
+            double rss = distance.GetLowerBound();
+            output.write(reinterpret_cast<const char*>(&candidate), sizeof(candidate));
+            output.write(reinterpret_cast<const char*>(&theta[0]), theta.size() * sizeof(double));
+            output.write(reinterpret_cast<const char*>(&rss), sizeof(rss));
+            output.flush();
+            numAccepted++;
+        }
+    }
+
+    output.close();
+
+    std::ostringstream summary;
+    summary << "ABC sampler: accepted " << numAccepted << " of " << numCandidates << " candidate(s); simulated "
+            << lineagesSimulated << " of " << uint64_t(numCandidates) * numLineages << " lineage(s)";
+    ExecutableSupport::Print(summary.str());
+
+    p_RNG->Destroy();
+
+    return exit_code;
+}
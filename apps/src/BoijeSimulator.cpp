@@ -8,6 +8,7 @@
 #include "PetscException.hpp"
 
 #include "BoijeCellCycleModel.hpp"
+#include "LineageModelRules.hpp"
 #include "OffLatticeSimulationPropertyStop.hpp"
 
 #include "AbstractCellBasedTestSuite.hpp"
@@ -23,18 +24,25 @@
 #include "NodeBasedCellPopulation.hpp"
 #include "VertexBasedCellPopulation.hpp"
 
-#include "ColumnDataWriter.hpp"
+#include "LineageOutput.hpp"
+#include "SimulatorOptions.hpp"
+#include "SimulatorRun.hpp"
+#include "LineageTreeRecorder.hpp"
+#include "CellAncestor.hpp"
 
 int main(int argc, char *argv[])
 {
-    ExecutableSupport::StartupWithoutShowingCopyright(&argc, &argv);
+    SimulatorOptions::Startup(&argc, &argv);
     //main() returns code indicating sim run success or failure mode
     int exit_code = ExecutableSupport::EXIT_OK;
 
-    if (argc != 13)
+    //positional arguments, less any trailing "--option <values>" pairs
+    int numArgs = SimulatorOptions::GetNumPositionalArguments(argc, argv);
+
+    if (numArgs != 13)
     {
         ExecutableSupport::PrintError(
-                "Wrong arguments for simulator.\nUsage (replace<> with values, pass bools as 0 or 1):\n BoijeSimulator <directoryString> <filenameString> <outputModeUnsigned(0=counts,1=events,2=sequence)> <debugOutputBool> <startSeedUnsigned> <endSeedUnsigned> <endGenerationUnsigned> <phase2GenerationUnsigned> <phase3GenerationUnsigned> <pAtoh7Double(0-1)> <pPtf1aDouble(0-1)> <pngDouble(0-1)>",
+                "Wrong arguments for simulator.\nUsage (replace<> with values, pass bools as 0 or 1):\n BoijeSimulator <directoryString> <filenameString> <outputModeString(0=counts,1=events,2=sequence,3=snapshots,4=sequence trie,6=decision statistics;combine eg. 06)> <debugOutputBool> <startSeedUnsigned> <endSeedUnsigned> <endGenerationUnsigned> <phase2GenerationUnsigned> <phase3GenerationUnsigned> <pAtoh7Double(0-1)> <pPtf1aDouble(0-1)> <pngDouble(0-1)>\nOptions:\n--count-times <countTimeDouble> ... : extra lineage counts at these times (generations) in the counts output, and one snapshot row per time\n--lineage-tree : also record every lineage's whole division tree to <filenameString>TREE.ltree, times in generations (query with LineageTreeQuery)\n--path-only : sequence output only; each division's unlabelled cell is killed, so only the sampled path is simulated\n--cache <cacheDirectory> : replay seeds already simulated by an identical job from this result cache, & add complete blocks of 50 seeds to it (not with debug output or --lineage-tree)\n--resume : continue a killed or crashed run with the same arguments; seeds recorded in <filenameString>.journal are skipped & output is appended (not with trie, debug or --lineage-tree output)\n--stop-ci-width <widthDouble> : run seeds in blocks from startSeed until every count's 95% CI for its probability is at most this wide (endSeed is then a cap); the seeds used are logged (not with mpirun, --path-only, --cache or --resume)\n--stop-aic-change <changeDouble> --stop-reference <histogramFile> : as --stop-ci-width, until log RSS of the count histogram against the reference (P(count=1), P(count=2), ... one per line) changes by at most this over a block; both criteria must be met if both are given\n--stop-block <seedsUnsigned> : seeds between sequential stopping checks (default 50)\n--pack <foundersUnsigned> : simulate this many consecutive seeds' founders together in one population per Solve(), split back out per seed by CellAncestor (counts, events & sequence output only; not with --count-times, debug output, --lineage-tree, --cache, --resume or sequential stopping); each founder's lineage draws from its own stream seeded with its seed, & packs are always startSeed + k*<founders> onwards, so a seed's output is the same in serial & under mpirun but is not that of an unpacked run\n--serial : skip PETSc/MPI startup, for many short single-process runs (not with mpirun)\nParallel: mpirun -np <N> BoijeSimulator ... shares the seed range over N-1 worker processes; rank 0 gathers their output in seed order (debug traces & lineage trees are written per worker, suffixed _<rank>)\n",
                 true);
         exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
         return exit_code;
@@ -44,7 +52,7 @@ int main(int argc, char *argv[])
      * SIMULATOR PARAMETERS
      ***********************/
     std::string directoryString, filenameString;
-    int outputMode; //0 = counts; 1 = mitotic mode events; 2 = mitotic mode sequence sampling
+    std::string outputModes; //digits of enabled outputs: 0 = counts; 1 = mitotic mode events; 2 = mitotic mode sequence sampling; 3 = snapshots; 4 = sequence trie
     bool debugOutput;
     unsigned startSeed, endSeed, endGeneration, phase2Generation, phase3Generation;
     double pAtoh7, pPtf1a, png; //stochastic model parameters
@@ -52,7 +60,7 @@ int main(int argc, char *argv[])
     //PARSE ARGUMENTS
     directoryString = argv[1];
     filenameString = argv[2];
-    outputMode = std::stoi(argv[3]);
+    outputModes = argv[3];
     debugOutput = std::stoul(argv[4]);
     startSeed = std::stoul(argv[5]);
     endSeed = std::stoul(argv[6]);
@@ -63,15 +71,25 @@ int main(int argc, char *argv[])
     pPtf1a = std::stod(argv[11]);
     png = std::stod(argv[12]);
 
+    //outputMode & the shared options (--count-times, --lineage-tree, --path-only, --cache, --resume, --stop-*, --pack), see SimulatorRun
+    SimulatorRun run(outputModes, debugOutput);
+    bool countOutput = run.IsOutput(LineageOutput::COUNTS);
+    bool eventOutput = run.IsOutput(LineageOutput::EVENTS);
+    bool sequenceOutput = run.IsOutput(LineageOutput::SEQUENCE);
+    bool snapshotOutput = run.IsOutput(LineageOutput::SNAPSHOTS);
+    bool decisionOutput = run.IsOutput(LineageOutput::DECISIONS);
+    bool treeOutput = run.IsTreeOutput();
+    bool pathOnly = run.IsPathOnly();
+    std::vector<double> countTimes = run.rGetCountTimes();
+
     /************************
      * PARAMETER/ARGUMENT SANITY CHECK
      ************************/
-    bool sane = 1;
+    bool sane = run.CheckOptions(endGeneration, "endGeneration (argument 7)");
 
-    if (outputMode != 0 && outputMode != 1 && outputMode != 2)
+    if (run.IsOutput(LineageOutput::SCORES))
     {
-        ExecutableSupport::PrintError(
-                "Bad outputMode (argument 3). Must be 0 (counts) 1 (mitotic events) or 2 (sequence sampling)");
+        ExecutableSupport::PrintError("Score function output (outputMode 5) is only available in HeSimulator");
         sane = 0;
     }
 
@@ -123,22 +141,14 @@ int main(int argc, char *argv[])
      * SIMULATOR OUTPUT SETUP
      ************************/
 
-//Set up singleton LogFile
-    LogFile* p_log = LogFile::Instance();
-    p_log->Set(0, directoryString, filenameString);
-
-    ExecutableSupport::Print("Simulator writing file " + filenameString + " to directory " + directoryString);
+//Seed range, journal, LineageOutput, debug trace, lineage tree archive & result cache; the cache's job is all but directory, filename & seeds
+    run.Open(argc, argv, directoryString, filenameString, startSeed, endSeed, { 1, 2, 5, 6 });
 
-//Log entry counter
-    unsigned entry_number = 1;
-
-//Write appropriate headers to log
-    if (outputMode == 0) *p_log << "Entry\tSeed\tCount\n";
-    if (outputMode == 1) *p_log << "Time (hpf)\tSeed\tCellID\tMitotic Mode (0=PP;1=PD;2=DD)\n";
-    if (outputMode == 2) *p_log << "Entry\tSeed\tSequence\n";
-
-//Instance RNG
-    RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+//Write appropriate headers to outputs; extra count columns follow the end time count, so it stays in column 2
+    run.WriteHeaders("", "gen");
+    LineageOutput* p_output = LineageOutput::Instance();
+    p_output->WriteHeader(LineageOutput::SNAPSHOTS, "Entry\tSeed\tGeneration\tCount\tMitotic\tRGC\tAC_HC\tPR_BC\n");
+    p_output->WriteHeader(LineageOutput::DECISIONS, "Entry\tSeed\tCount\tatoh7\tNo atoh7\tptf1a\tNo ptf1a\tng\tNo ng\n");
 
 //Initialise pointers to relevant singleton ProliferativeTypes and Properties
     MAKE_PTR(WildTypeCellMutationState, p_state);
@@ -149,34 +159,63 @@ int main(int argc, char *argv[])
     MAKE_PTR(ReceptorBipolar, p_PR_BC_fate);
     MAKE_PTR(CellLabel, p_label);
 
+    //Fates recorded for the cells left at the end of each lineage tree; fate 0 = none of these (still mitotic)
+    std::vector<boost::shared_ptr<AbstractCellProperty> > treeFates = { p_RGC_fate, p_AC_HC_fate, p_PR_BC_fate };
+
     /************************
      * SIMULATOR SETUP & RUN
      ************************/
 
-//iterate through supplied seed range, executing one simulation per seed
-    for (unsigned seed = startSeed; seed <= endSeed; seed++)
+//with --pack, iterate through this process's share of the seed range a pack of seeds at a time, in one population per pack;
+//founders do not interact, so each seed's lineage is the cells descended from its founder (its CellAncestor)
+    std::vector<unsigned> pack;
+    while (run.GetNextPack(pack))
     {
-        if (outputMode == 2) *p_log << entry_number << "\t" << seed << "\t"; //write seed to log - sequence written by cellcyclemodel objects
-
-        //initialise pointer to debugWriter
-        ColumnDataWriter* debugWriter;
+        //One founder per seed, tagged with its index in the pack; each founder's lineage draws from its own stream,
+        //seeded with its seed, so it does not depend on the other seeds in the pack (see LineageRandomStream)
+        std::vector<CellPtr> cells;
+        for (unsigned i = 0; i < pack.size(); i++)
+        {
+            unsigned seed = pack[i];
+            LineageRandomStream founderStream;
+            founderStream.Seed(seed);
+
+            BoijeCellCycleModel* p_cycle_model = new BoijeCellCycleModel;
+            p_cycle_model->SetRandomStream(founderStream);
+            p_cycle_model->SetDimension(2);
+            p_cycle_model->SetPostMitoticType(p_PostMitotic);
+            CellPtr p_cell(new Cell(p_state, p_cycle_model));
+            p_cell->SetCellProliferativeType(p_Mitotic);
+            p_cycle_model->SetModelParameters(phase2Generation, phase3Generation, pAtoh7, pPtf1a, png);
+            p_cycle_model->SetSpecifiedTypes(p_RGC_fate, p_AC_HC_fate, p_PR_BC_fate);
+            if (eventOutput) p_cycle_model->EnableModeEventOutput(0, seed);
+            if (sequenceOutput) p_cycle_model->EnableSequenceSampler(p_label, seed);
+            if (pathOnly) p_cycle_model->EnablePathOnlySampling();
+            if (sequenceOutput) p_cell->AddCellProperty(p_label);
+            MAKE_PTR_ARGS(CellAncestor, p_founder, (i));
+            p_cell->AddCellProperty(p_founder);
+            p_cell->InitialiseCellCycleModel();
+            cells.push_back(p_cell);
+        }
 
-        //initialise SimulationTime (permits cellcyclemodel setup)
-        SimulationTime::Instance()->SetStartTime(0.0);
+        //the pack stops once no lineage in it has mitotic cells left
+        run.SolvePack(pack, cells, p_Mitotic, LineageModelRules::BOIJE_DT, endGeneration, "");
+    }
 
-        //Reseed the RNG with the required seed
-        p_RNG->Reseed(seed);
+//iterate through this process's share of the seed range, executing one simulation per seed
+    unsigned seed;
+    while (run.GetNextSeed(seed))
+    {
+        //SimulationTime from 0, cells numbered from 0, RNG reseeded with the seed
+        run.BeginSeed(seed);
 
-        //Initialise a HeCellCycleModel and set it up with appropriate TiL values
+        //Initialise a BoijeCellCycleModel
         BoijeCellCycleModel* p_cycle_model = new BoijeCellCycleModel;
 
         if (debugOutput)
         {
-            //Pass ColumnDataWriter to cell cycle model for debug output
-            boost::shared_ptr<ColumnDataWriter> p_debugWriter(
-                    new ColumnDataWriter(directoryString, filenameString + "DEBUG_" + std::to_string(seed), false, 10));
-            p_cycle_model->EnableModelDebugOutput(p_debugWriter);
-            debugWriter = &*p_debugWriter;
+            //Cell cycle model writes debug records, tagged with seed, to the run's CellCycleTrace
+            p_cycle_model->EnableModelDebugOutput(seed);
         }
 
         //Setup lineages' cycle model with appropriate parameters
@@ -189,10 +228,22 @@ int main(int argc, char *argv[])
         p_cell->SetCellProliferativeType(p_Mitotic);
         p_cycle_model->SetModelParameters(phase2Generation, phase3Generation, pAtoh7, pPtf1a, png);
         p_cycle_model->SetSpecifiedTypes(p_RGC_fate, p_AC_HC_fate, p_PR_BC_fate);
-        if (outputMode == 2) p_cycle_model->EnableSequenceSampler(p_label);
-        if (outputMode == 2) p_cell->AddCellProperty(p_label);
+        if (eventOutput) p_cycle_model->EnableModeEventOutput(0, seed);
+        if (sequenceOutput) p_cycle_model->EnableSequenceSampler(p_label, seed);
+        if (pathOnly) p_cycle_model->EnablePathOnlySampling();
+        if (decisionOutput)
+        {
+            p_cycle_model->EnableDecisionCounts();
+            BoijeCellCycleModel::ResetDecisionCounts();
+        }
+        if (sequenceOutput) p_cell->AddCellProperty(p_label);
         p_cell->InitialiseCellCycleModel();
         cells.push_back(p_cell);
+        if (treeOutput)
+        {
+            p_cycle_model->EnableLineageTreeRecorder(seed);
+            LineageTreeRecorder::Instance()->BeginSeed(seed, p_cell->GetCellId(), 0.0, LineageModelRules::BOIJE_DT);
+        }
 
         //Generate 1x1 mesh for single-cell colony
         HoneycombMeshGenerator generator(1, 1);
@@ -207,31 +258,47 @@ int main(int argc, char *argv[])
         boost::shared_ptr<OffLatticeSimulationPropertyStop<2>> p_simulator(
                 new OffLatticeSimulationPropertyStop<2>(*cell_population));
         p_simulator->SetStopProperty(p_Mitotic); //simulation to stop if no mitotic cells are left
-        p_simulator->SetDt(0.25);
+        p_simulator->SetDt(LineageModelRules::BOIJE_DT);
         p_simulator->SetEndTime(endGeneration);
-        p_simulator->SetOutputDirectory("UnusedSimOutput" + filenameString); //unused output
+        p_simulator->DisableSimulationOutput(); //no directory, viz, results or parameter files- only the log is written
+        if (snapshotOutput)
+        {
+            //fate composition recorded with each count
+            p_simulator->AddCountProperty(p_Mitotic);
+            p_simulator->AddCountProperty(p_RGC_fate);
+            p_simulator->AddCountProperty(p_AC_HC_fate);
+            p_simulator->AddCountProperty(p_PR_BC_fate);
+        }
+        p_simulator->SetCountTimes(countTimes);
         p_simulator->Solve();
 
+        if (treeOutput)
+        {
+            LineageTreeRecorder::Instance()->RecordFinalCells(seed, *cell_population, treeFates);
+            LineageTreeRecorder::Instance()->CommitSeed(seed);
+        }
+
         //Count lineage size
         unsigned count = cell_population->GetNumRealCells();
 
-        if (outputMode == 0) *p_log << entry_number << "\t" << seed << "\t" << count << "\n";
-        if (outputMode == 2) *p_log << "\n";
+        if (countOutput) run.WriteCounts(seed, "", count, p_simulator->rGetCounts());
+        if (sequenceOutput) p_output->rGetStream(LineageOutput::SEQUENCE, seed) << "\n";
+        if (decisionOutput)
+        {
+            //each lineage's decision counts give its likelihood under other probabilities, see Importance_reweighting.py
+            run.WriteStatistics(LineageOutput::DECISIONS, seed, count, BoijeCellCycleModel::rGetDecisionCounts());
+        }
+        if (snapshotOutput) run.WriteSnapshots(seed, count, *p_simulator, endGeneration);
+        bool stop = run.CommitSeed(seed, count);
 
         //Reset for next simulation
         SimulationTime::Destroy();
         delete cell_population;
-        entry_number++;
-
-        if (debugOutput)
-        {
-            debugWriter->Close();
-        }
 
+        if (stop) break;
     }
 
-    p_RNG->Destroy();
-    LogFile::Close();
+    run.Close();
 
     return exit_code;
 }
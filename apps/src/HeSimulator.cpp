@@ -8,6 +8,7 @@
 #include "PetscException.hpp"
 
 #include "HeCellCycleModel.hpp"
+#include "LineageModelRules.hpp"
 #include "OffLatticeSimulationPropertyStop.hpp"
 
 #include "AbstractCellBasedTestSuite.hpp"
@@ -22,18 +23,61 @@
 #include "NodeBasedCellPopulation.hpp"
 #include "VertexBasedCellPopulation.hpp"
 
-#include "ColumnDataWriter.hpp"
+#include "LineageOutput.hpp"
+#include "SimulatorOptions.hpp"
+#include "SimulatorRun.hpp"
+#include "LineageTreeRecorder.hpp"
+#include "SimulationSnapshot.hpp"
+#include "OutputFileHandler.hpp"
+#include "CellAncestor.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+//A --fork-variants parameter set: output name, then stochastic mode arguments 14-21
+struct HeModeVariant
+{
+    std::string mName;
+    double mPhase2, mPhase3, mPP1, mPD1, mPP2, mPD2, mPP3, mPD3;
+};
+
+//Earliest TiL at which a division's mitotic mode may differ between two parameter sets; DBL_MAX if never
+double GetFirstDifferingTiL(const HeModeVariant& rBase, const HeModeVariant& rVariant)
+{
+    double baseBoundary3 = rBase.mPhase2 + rBase.mPhase3;
+    double variantBoundary3 = rVariant.mPhase2 + rVariant.mPhase3;
+    double til = DBL_MAX;
+    if (rBase.mPP1 != rVariant.mPP1 || rBase.mPD1 != rVariant.mPD1)
+    {
+        til = 0;
+    }
+    if (rBase.mPhase2 != rVariant.mPhase2 || rBase.mPP2 != rVariant.mPP2 || rBase.mPD2 != rVariant.mPD2)
+    {
+        til = std::min(til, std::min(rBase.mPhase2, rVariant.mPhase2));
+    }
+    if (baseBoundary3 != variantBoundary3 || rBase.mPP3 != rVariant.mPP3 || rBase.mPD3 != rVariant.mPD3)
+    {
+        til = std::min(til, std::min(baseBoundary3, variantBoundary3));
+    }
+    return til;
+}
 
 int main(int argc, char *argv[])
 {
-    ExecutableSupport::StartupWithoutShowingCopyright(&argc, &argv);
+    SimulatorOptions::Startup(&argc, &argv);
     //main() returns code indicating sim run success or failure mode
     int exit_code = ExecutableSupport::EXIT_OK;
 
-    if (argc != 22 && argc != 20)
+    //positional arguments, less any trailing "--option <values>" pairs
+    int numArgs = SimulatorOptions::GetNumPositionalArguments(argc, argv);
+
+    if (numArgs != 22 && numArgs != 20)
     {
         ExecutableSupport::PrintError(
-                "Wrong arguments for simulator.\nUsage (replace<> with values, pass bools as 0 or 1):\nStochastic Mode:\nHeSimulator <directoryString> <filenameString> <outputModeUnsigned(0=counts,1=events,2=sequence)> <deterministicBool=0> <fixtureUnsigned(0=He;1=Wan;2=test)> <founderAth5Mutant?Bool> <debugOutputBool> <startSeedUnsigned> <endSeedUnsigned>  <inductionTimeDoubleHours> <earliestLineageStartDoubleHours> <latestLineageStartDoubleHours> <endTimeDoubleHours> <mMitoticModePhase2Double> <mMitoticModePhase3Double> <pPP1Double(0-1)> <pPD1Double(0-1)> <pPP1Double(0-1)> <pPD1Double(0-1)> <pPP1Double(0-1)> <pPD1Double(0-1)>\nDeterministic Mode:\nHeSimulator <directoryString> <filenameString> <outputModeUnsigned(0=counts,1=events,2=sequence)> <deterministicBool=1> <fixtureUnsigned(0=He;1=Wan;2=test)> <founderAth5Mutant?Bool> <debugOutputBool> <startSeedUnsigned> <endSeedUnsigned>  <inductionTimeDoubleHours> <earliestLineageStartDoubleHours> <latestLineageStartDoubleHours> <endTimeDoubleHours> <phase1ShapeDouble(>0)> <phase1ScaleDouble(>0)> <phase2ShapeDouble(>0)> <phase2ScaleDouble(>0)> <phaseBoundarySisterShiftWidthDouble>\n",
+                "Wrong arguments for simulator.\nUsage (replace<> with values, pass bools as 0 or 1):\nStochastic Mode:\nHeSimulator <directoryString> <filenameString> <outputModeString(0=counts,1=events,2=sequence,3=snapshots,4=sequence trie,5=mode score functions,6=decision statistics;combine eg. 06)> <deterministicBool=0> <fixtureUnsigned(0=He;1=Wan;2=test)> <founderAth5Mutant?Bool> <debugOutputBool> <startSeedUnsigned> <endSeedUnsigned>  <inductionTimeDoubleHours> <earliestLineageStartDoubleHours> <latestLineageStartDoubleHours> <endTimeDoubleHours> <mMitoticModePhase2Double> <mMitoticModePhase3Double> <pPP1Double(0-1)> <pPD1Double(0-1)> <pPP1Double(0-1)> <pPD1Double(0-1)> <pPP1Double(0-1)> <pPD1Double(0-1)>\nDeterministic Mode:\nHeSimulator <directoryString> <filenameString> <outputModeString(0=counts,1=events,2=sequence,3=snapshots,4=sequence trie;combine eg. 01)> <deterministicBool=1> <fixtureUnsigned(0=He;1=Wan;2=test)> <founderAth5Mutant?Bool> <debugOutputBool> <startSeedUnsigned> <endSeedUnsigned>  <inductionTimeDoubleHours> <earliestLineageStartDoubleHours> <latestLineageStartDoubleHours> <endTimeDoubleHours> <phase1ShapeDouble(>0)> <phase1ScaleDouble(>0)> <phase2ShapeDouble(>0)> <phase2ScaleDouble(>0)> <phaseBoundarySisterShiftWidthDouble>\nOptions:\n--count-times <countTimeDouble> ... : extra lineage counts at these times (hpf) in the counts output, and one snapshot row per time\n--lineage-tree : also record every lineage's whole division tree to <filenameString>TREE.ltree, times in hpf (query with LineageTreeQuery)\n--path-only : sequence output only; each division's unlabelled cell is killed, so only the sampled path is simulated\n--induction-times <inductionTimeDouble> ... : fixture 0, counts output only; each lineage is simulated once from its start, a progenitor alive at each induction time (hpf) is labelled, and its clone size at endTime is written as one counts row per induction time (inductionTime argument is then unused; 0 = no progenitor left to label)\n--cache <cacheDirectory> : replay seeds already simulated by an identical job from this result cache, & add complete blocks of 50 seeds to it (not with debug output or --lineage-tree)\n--resume : continue a killed or crashed run with the same arguments; seeds recorded in <filenameString>.journal are skipped & output is appended (not with trie, debug or --lineage-tree output)\n--fork-variants <variantsFile> : stochastic mode, counts output only; each line of the file is <name> <mMitoticModePhase2> <mMitoticModePhase3> <pPP1> <pPD1> <pPP2> <pPD2> <pPP3> <pPD3>. Each lineage is simulated once up to the last timestep before any variant's mitotic modes could differ, then continued separately under each variant, whose counts are written to <filenameString>_<name> (not with mpirun, --count-times, --induction-times, --cache, --resume, debug output or --lineage-tree)\n--stop-ci-width <widthDouble> : run seeds in blocks from startSeed until every count's 95% CI for its probability is at most this wide (endSeed is then a cap); the seeds used are logged (not with mpirun, --induction-times, --path-only, --cache or --resume)\n--stop-aic-change <changeDouble> --stop-reference <histogramFile> : as --stop-ci-width, until log RSS of the count histogram against the reference (P(count=1), P(count=2), ... one per line) changes by at most this over a block; both criteria must be met if both are given\n--stop-block <seedsUnsigned> : seeds between sequential stopping checks (default 50)\n--pack <foundersUnsigned> : simulate this many consecutive seeds' founders together in one population per Solve(), split back out per seed by CellAncestor; founders with shorter simulated times start later, so all end at endTime (counts, events & sequence output only; not with --count-times, --induction-times, --fork-variants, debug output, --lineage-tree, --cache, --resume or sequential stopping); each founder's lineage draws from its own stream seeded with its seed, & packs are always startSeed + k*<founders> onwards, so a seed's output is the same in serial & under mpirun but is not that of an unpacked run\n--serial : skip PETSc/MPI startup, for many short single-process runs (not with mpirun)\nParallel: mpirun -np <N> HeSimulator ... shares the seed range over N-1 worker processes; rank 0 gathers their output in seed order (debug traces & lineage trees are written per worker, suffixed _<rank>)\n",
                 true);
         exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
         return exit_code;
@@ -43,7 +87,9 @@ int main(int argc, char *argv[])
      * SIMULATOR PARAMETERS
      ***********************/
     std::string directoryString, filenameString;
-    int outputMode; //0 = counts; 1 = mitotic mode events; 2 = mitotic mode sequence sampling
+    std::string outputModes; //digits of enabled outputs: 0 = counts; 1 = mitotic mode events; 2 = mitotic mode sequence sampling; 3 = snapshots; 4 = sequence trie
+    std::vector<double> inductionTimes; //clone induction times for single-pass fixture 0
+    std::string variantsFile; //--fork-variants parameter sets, empty if none
     bool deterministicMode, ath5founder, debugOutput;
     unsigned fixture, startSeed, endSeed; //fixture 0 = He2012; 1 = Wan2016
     double inductionTime, earliestLineageStartTime, latestLineageStartTime, endTime;
@@ -53,7 +99,9 @@ int main(int argc, char *argv[])
     //PARSE ARGUMENTS
     directoryString = argv[1];
     filenameString = argv[2];
-    outputMode = std::stoi(argv[3]);
+    outputModes = argv[3];
+    inductionTimes = SimulatorOptions::GetInductionTimes();
+    variantsFile = SimulatorOptions::GetStringOption("--fork-variants");
     deterministicMode = std::stoul(argv[4]);
     fixture = std::stoul(argv[5]);
     ath5founder = std::stoul(argv[6]);
@@ -92,15 +140,100 @@ int main(int argc, char *argv[])
         return exit_code;
     }
 
+    //outputMode & the shared options (--count-times, --lineage-tree, --path-only, --cache, --resume, --stop-*, --pack), see SimulatorRun
+    SimulatorRun run(outputModes, debugOutput);
+    bool countOutput = run.IsOutput(LineageOutput::COUNTS);
+    bool eventOutput = run.IsOutput(LineageOutput::EVENTS);
+    bool sequenceOutput = run.IsOutput(LineageOutput::SEQUENCE);
+    bool snapshotOutput = run.IsOutput(LineageOutput::SNAPSHOTS);
+    bool decisionOutput = run.IsOutput(LineageOutput::DECISIONS);
+    bool scoreOutput = run.IsOutput(LineageOutput::SCORES);
+    bool treeOutput = run.IsTreeOutput();
+    bool pathOnly = run.IsPathOnly();
+    std::vector<double> countTimes = run.rGetCountTimes();
+
     /************************
      * PARAMETER/ARGUMENT SANITY CHECK
      ************************/
-    bool sane = 1;
+    bool sane = run.CheckOptions(endTime, "endTime (argument 13)");
 
-    if (outputMode != 0 && outputMode != 1 && outputMode != 2)
+    if (scoreOutput && deterministicMode != 0)
     {
-        ExecutableSupport::PrintError(
-                "Bad outputMode (argument 3). Must be 0 (counts) 1 (mitotic events) or 2 (sequence sampling)");
+        ExecutableSupport::PrintError("Score function output (outputMode 5) differentiates the stochastic mode probabilities, so needs deterministicMode 0");
+        sane = 0;
+    }
+
+    if (decisionOutput && deterministicMode != 0)
+    {
+        ExecutableSupport::PrintError("Decision statistics (outputMode 6) count the stochastic mode draws, so need deterministicMode 0");
+        sane = 0;
+    }
+
+    bool multiInduction = !inductionTimes.empty();
+    if (multiInduction)
+    {
+        if (fixture != 0)
+        {
+            ExecutableSupport::PrintError("--induction-times is only available with fixture 0 (argument 5)");
+            sane = 0;
+        }
+        if (outputModes != "0" || !countTimes.empty())
+        {
+            ExecutableSupport::PrintError("--induction-times gives counts output only (outputMode 0, no --count-times)");
+            sane = 0;
+        }
+        if (inductionTimes.back() >= endTime)
+        {
+            ExecutableSupport::PrintError("Bad --induction-times. Must be <endTime(arg13)");
+            sane = 0;
+        }
+    }
+
+    bool forkVariants = !variantsFile.empty();
+    std::vector<HeModeVariant> variants;
+    if (forkVariants)
+    {
+        if (deterministicMode != 0 || outputModes != "0" || !countTimes.empty() || multiInduction)
+        {
+            ExecutableSupport::PrintError("--fork-variants needs stochastic mode & counts output alone (deterministicMode 0, outputMode 0, no --count-times or --induction-times)");
+            sane = 0;
+        }
+        if (debugOutput || treeOutput || run.IsCached() || run.IsResumed())
+        {
+            ExecutableSupport::PrintError("--fork-variants writes its own counts files, so cannot be combined with debug output, --lineage-tree, --cache or --resume");
+            sane = 0;
+        }
+        if (PetscTools::IsParallel())
+        {
+            ExecutableSupport::PrintError("--fork-variants counts files are written by one process, so cannot be run under mpirun");
+            sane = 0;
+        }
+
+        std::ifstream variantStream(variantsFile.c_str());
+        std::string line;
+        while (std::getline(variantStream, line))
+        {
+            std::istringstream fields(line);
+            HeModeVariant variant;
+            if (!(fields >> variant.mName)) continue; //blank line
+            if (!(fields >> variant.mPhase2 >> variant.mPhase3 >> variant.mPP1 >> variant.mPD1 >> variant.mPP2
+                    >> variant.mPD2 >> variant.mPP3 >> variant.mPD3))
+            {
+                ExecutableSupport::PrintError("Bad --fork-variants line: " + line);
+                sane = 0;
+            }
+            variants.push_back(variant);
+        }
+        if (variants.empty())
+        {
+            ExecutableSupport::PrintError("--fork-variants file " + variantsFile + " is missing or has no variants");
+            sane = 0;
+        }
+    }
+
+    if (run.IsSequentialStopping() && multiInduction)
+    {
+        ExecutableSupport::PrintError("Sequential stopping follows the end count histogram, so cannot be combined with --induction-times");
         sane = 0;
     }
 
@@ -200,6 +333,12 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (run.IsPacked() && (multiInduction || forkVariants))
+    {
+        ExecutableSupport::PrintError("--pack splits end counts back out per seed, so cannot be combined with --induction-times or --fork-variants");
+        sane = 0;
+    }
+
     if (sane == 0)
     {
         ExecutableSupport::PrintError("Exiting with bad arguments. See errors for details");
@@ -212,19 +351,30 @@ int main(int argc, char *argv[])
      * SIMULATOR OUTPUT SETUP
      ************************/
 
-//Set up singleton LogFile
-    LogFile* p_log = LogFile::Instance();
-    p_log->Set(0, directoryString, filenameString);
+//Seed range, journal, LineageOutput, debug trace, lineage tree archive & result cache; the cache's job is all but directory, filename & seeds
+    run.Open(argc, argv, directoryString, filenameString, startSeed, endSeed, { 1, 2, 8, 9 });
 
-    ExecutableSupport::Print("Simulator writing file " + filenameString + " to directory " + directoryString);
+//Write appropriate headers to outputs; extra count columns follow the end time count, so it stays in column 3
+    run.WriteHeaders("Induction Time (h)\t", "hpf");
+    LineageOutput* p_output = LineageOutput::Instance();
+    p_output->WriteHeader(LineageOutput::SNAPSHOTS, "Entry\tSeed\tTime (hpf)\tCount\tMitotic\tPostMitotic\n");
+    p_output->WriteHeader(LineageOutput::DECISIONS, "Entry\tSeed\tCount\tPP1\tPD1\tDD1\tPP2\tPD2\tDD2\tPP3\tPD3\tDD3\n");
+    p_output->WriteHeader(LineageOutput::SCORES, "Entry\tSeed\tCount\tScore pPP1\tScore pPD1\tScore pPP2\tScore pPD2\tScore pPP3\tScore pPD3\n");
 
-//Log entry counter
-    unsigned entry_number = 1;
-
-//Write appropriate headers to log
-    if (outputMode == 0) *p_log << "Entry\tInduction Time (h)\tSeed\tCount\n";
-    if (outputMode == 1) *p_log << "Time (hpf)\tSeed\tCellID\tMitotic Mode (0=PP;1=PD;2=DD)\n";
-    if (outputMode == 2) *p_log << "Entry\tSeed\tSequence\n";
+//Set up --fork-variants counts files, and the TiL before which every variant's lineages match the simulated parameters
+    std::vector<out_stream> variantCounts;
+    double forkTiL = DBL_MAX;
+    if (forkVariants)
+    {
+        HeModeVariant base = { "", mitoticModePhase2, mitoticModePhase3, pPP1, pPD1, pPP2, pPD2, pPP3, pPD3 };
+        OutputFileHandler variantHandler(directoryString, false);
+        for (unsigned i = 0; i < variants.size(); i++)
+        {
+            forkTiL = std::min(forkTiL, GetFirstDifferingTiL(base, variants[i]));
+            variantCounts.push_back(variantHandler.OpenOutputFile(filenameString + "_" + variants[i].mName));
+            *variantCounts[i] << run.rGetCountHeader() << "\n";
+        }
+    }
 
 //Instance RNG
     RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
@@ -236,34 +386,110 @@ int main(int argc, char *argv[])
     MAKE_PTR(Ath5Mo, p_Morpholino);
     MAKE_PTR(CellLabel, p_label);
 
+    //Fates recorded for the cells left at the end of each lineage tree; fate 0 = none of these (still mitotic)
+    std::vector<boost::shared_ptr<AbstractCellProperty> > treeFates = { p_PostMitotic };
+
     /************************
      * SIMULATOR SETUP & RUN
      ************************/
 
-//iterate through supplied seed range, executing one simulation per seed
-    for (unsigned seed = startSeed; seed <= endSeed; seed++)
+//with --pack, iterate through this process's share of the seed range a pack of seeds at a time, in one population per pack;
+//founders do not interact, so each seed's lineage is the cells descended from its founder (its CellAncestor)
+    std::vector<unsigned> pack;
+    while (run.GetNextPack(pack))
     {
-        if (outputMode == 2) *p_log << entry_number << "\t" << seed << "\t"; //write seed to log - sequence written by cellcyclemodel objects
+        //Each founder's lineage draws from its own stream, seeded with its seed, so it does not depend on the other seeds
+        //in the pack (see LineageRandomStream); first its TiL & simulated time, from its lineage start draw, as the
+        //per-seed fixtures below
+        std::vector<LineageRandomStream> founderStreams(pack.size());
+        std::vector<double> founderTiL(pack.size()), founderSimEndTime(pack.size()), founderEventStart(pack.size());
+        double packSimEndTime = 0.0;
+        for (unsigned i = 0; i < pack.size(); i++)
+        {
+            founderStreams[i].Seed(pack[i]);
+            if (fixture == 0)
+            {
+                double lineageStartTime = (founderStreams[i].ranf() * (latestLineageStartTime - earliestLineageStartTime))
+                        + earliestLineageStartTime;
+                founderTiL[i] = std::max(0.0, inductionTime - lineageStartTime);
+                founderSimEndTime[i] = endTime - std::max(inductionTime, lineageStartTime);
+                founderEventStart[i] = std::max(inductionTime, lineageStartTime);
+            }
+            else if (fixture == 1)
+            {
+                founderTiL[i] = founderStreams[i].ranf() * latestLineageStartTime;
+                founderSimEndTime[i] = std::max(.05, endTime - founderTiL[i]);
+                founderEventStart[i] = 0;
+            }
+            else
+            {
+                founderTiL[i] = inductionTime;
+                founderSimEndTime[i] = endTime;
+                founderEventStart[i] = 0;
+            }
+            packSimEndTime = std::max(packSimEndTime, founderSimEndTime[i]);
+        }
+
+        //One founder per seed, tagged with its index in the pack & delayed so that every lineage ends with the pack;
+        //its stream carries on to its phase boundary draws (deterministic mode) & its lineage's divisions
+        std::vector<CellPtr> cells;
+        for (unsigned i = 0; i < pack.size(); i++)
+        {
+            unsigned seed = pack[i];
+            double startDelay = packSimEndTime - founderSimEndTime[i];
+            HeCellCycleModel* p_cycle_model = new HeCellCycleModel;
+            p_cycle_model->SetDimension(2);
+            p_cycle_model->SetRandomStream(founderStreams[i]);
+            if (!deterministicMode)
+            {
+                p_cycle_model->SetModelParameters(founderTiL[i], mitoticModePhase2, mitoticModePhase2 + mitoticModePhase3,
+                                                  pPP1, pPD1, pPP2, pPD2, pPP3, pPD3);
+            }
+            else
+            {
+                double currPhase2Boundary = phaseOffset + founderStreams[i].GammaRandomDeviate(phase1Shape, phase1Scale);
+                double currPhase3Boundary = currPhase2Boundary + founderStreams[i].GammaRandomDeviate(phase2Shape, phase2Scale);
+                p_cycle_model->SetDeterministicMode(founderTiL[i], currPhase2Boundary, currPhase3Boundary, phaseSisterShiftWidth);
+            }
+            p_cycle_model->SetStartDelay(startDelay);
+            //event times are the founder's hpf, so its simulation time is shifted back by its delay (fixture 2 writes none, as below)
+            if (eventOutput && fixture < 2) p_cycle_model->EnableModeEventOutput(founderEventStart[i] - startDelay, seed);
+            if (sequenceOutput) p_cycle_model->EnableSequenceSampler(seed);
+            if (pathOnly) p_cycle_model->EnablePathOnlySampling();
+
+            CellPtr p_cell(new Cell(p_state, p_cycle_model));
+            p_cell->SetCellProliferativeType(p_Mitotic);
+            if (ath5founder == 1) p_cell->AddCellProperty(p_Morpholino);
+            if (sequenceOutput) p_cell->AddCellProperty(p_label);
+            MAKE_PTR_ARGS(CellAncestor, p_founder, (i));
+            p_cell->AddCellProperty(p_founder);
+            p_cell->InitialiseCellCycleModel();
+            cells.push_back(p_cell);
+        }
 
-        //initialise pointer to debugWriter
-        ColumnDataWriter* debugWriter;
+        //the pack stops once no lineage in it has mitotic cells left
+        std::ostringstream inductionColumn;
+        inductionColumn << inductionTime << "\t";
+        run.SolvePack(pack, cells, p_Mitotic, LineageModelRules::HE_DT, packSimEndTime, inductionColumn.str());
+    }
 
-        //initialise SimulationTime (permits cellcyclemodel setup)
-        SimulationTime::Instance()->SetStartTime(0.0);
+//iterate through this process's share of the seed range, executing one simulation per seed
+    unsigned seed;
+    while (run.GetNextSeed(seed))
+    {
+        //Log entry number, from the seed so it does not depend on which process ran it
+        unsigned entry_number = run.GetEntryNumber(seed);
 
-        //Reseed the RNG with the required seed
-        p_RNG->Reseed(seed);
+        //SimulationTime from 0, cells numbered from 0, RNG reseeded with the seed
+        run.BeginSeed(seed);
 
         //Initialise a HeCellCycleModel and set it up with appropriate TiL values
         HeCellCycleModel* p_cycle_model = new HeCellCycleModel;
 
         if (debugOutput)
         {
-            //Pass ColumnDataWriter to cell cycle model for debug output
-            boost::shared_ptr<ColumnDataWriter> p_debugWriter(
-                    new ColumnDataWriter(directoryString, filenameString + "DEBUG_" + std::to_string(seed), false, 10));
-            p_cycle_model->EnableModelDebugOutput(p_debugWriter);
-            debugWriter = &*p_debugWriter;
+            //Cell cycle model writes debug records, tagged with seed, to the run's CellCycleTrace
+            p_cycle_model->EnableModelDebugOutput(seed);
         }
 
         double currTiL; //Time in Lineage offset for lineages induced after first mitosis
@@ -279,20 +505,26 @@ int main(int argc, char *argv[])
             //generate lineage start time from even random distro across earliest-latest start time figures
             lineageStartTime = (p_RNG->ranf() * (latestLineageStartTime - earliestLineageStartTime))
                     + earliestLineageStartTime;
+            //with --induction-times the whole lineage is simulated from its first mitosis; clones are labelled by the simulator
+            if (multiInduction)
+            {
+                currTiL = 0.0;
+                currSimEndTime = endTime - lineageStartTime;
+            }
             //this reflects induction of cells after the lineages' first mitosis
-            if (lineageStartTime < inductionTime)
+            else if (lineageStartTime < inductionTime)
             {
                 currTiL = inductionTime - lineageStartTime;
                 currSimEndTime = endTime - inductionTime;
-                if (outputMode == 1) p_cycle_model->EnableModeEventOutput(inductionTime, seed);
+                if (eventOutput) p_cycle_model->EnableModeEventOutput(inductionTime, seed);
             }
             //if the lineage starts after the induction time, give it zero & TiL run the appropriate-length simulation
             //(ie. the endTime is reduced by the amount of time after induction that the first mitosis occurs)
-            if (lineageStartTime >= inductionTime)
+            else
             {
                 currTiL = 0.0;
                 currSimEndTime = endTime - lineageStartTime;
-                if (outputMode == 1) p_cycle_model->EnableModeEventOutput(lineageStartTime, seed);
+                if (eventOutput) p_cycle_model->EnableModeEventOutput(lineageStartTime, seed);
             }
 
         }
@@ -303,7 +535,7 @@ int main(int argc, char *argv[])
             //generate random lineage start time from even random distro across CMZ residency time
             currTiL = p_RNG->ranf() * latestLineageStartTime;
             currSimEndTime = std::max(.05, endTime - currTiL); //minimum 1 timestep, prevents 0 timestep SimulationTime error
-            if (outputMode == 1) p_cycle_model->EnableModeEventOutput(0, seed);
+            if (eventOutput) p_cycle_model->EnableModeEventOutput(0, seed);
         }
         else if (fixture == 2) //validation fixture- all founders have TiL given by induction time
         {
@@ -329,16 +561,33 @@ int main(int argc, char *argv[])
             p_cycle_model->SetDeterministicMode(currTiL, currPhase2Boundary, currPhase3Boundary, phaseSisterShiftWidth);
         }
 
-        if (outputMode == 2) p_cycle_model->EnableSequenceSampler();
+        if (sequenceOutput) p_cycle_model->EnableSequenceSampler(seed);
+        if (pathOnly) p_cycle_model->EnablePathOnlySampling();
+        if (decisionOutput)
+        {
+            p_cycle_model->EnableDecisionCounts();
+            HeCellCycleModel::ResetDecisionCounts();
+        }
+        if (scoreOutput)
+        {
+            p_cycle_model->EnableScoreFunction();
+            HeCellCycleModel::ResetLineageScore();
+        }
 
         //Setup vector containing lineage founder with the properly set up cell cycle model
         std::vector<CellPtr> cells;
         CellPtr p_cell(new Cell(p_state, p_cycle_model));
         p_cell->SetCellProliferativeType(p_Mitotic);
         if (ath5founder == 1) p_cell->AddCellProperty(p_Morpholino);
-        if (outputMode == 2) p_cell->AddCellProperty(p_label);
+        if (sequenceOutput) p_cell->AddCellProperty(p_label);
         p_cell->InitialiseCellCycleModel();
         cells.push_back(p_cell);
+        if (treeOutput)
+        {
+            p_cycle_model->EnableLineageTreeRecorder(seed);
+            LineageTreeRecorder::Instance()->BeginSeed(seed, p_cell->GetCellId(), endTime - currSimEndTime,
+                                                       LineageModelRules::HE_DT);
+        }
 
         //Generate 1x1 mesh for single-cell colony
         HoneycombMeshGenerator generator(1, 1);
@@ -353,31 +602,140 @@ int main(int argc, char *argv[])
         boost::shared_ptr<OffLatticeSimulationPropertyStop<2>> p_simulator(
                 new OffLatticeSimulationPropertyStop<2>(*cell_population));
         p_simulator->SetStopProperty(p_Mitotic); //simulation to stop if no mitotic cells are left
-        p_simulator->SetDt(0.05);
+        p_simulator->SetDt(LineageModelRules::HE_DT);
         p_simulator->SetEndTime(currSimEndTime);
-        p_simulator->SetOutputDirectory("UnusedSimOutput" + filenameString); //unused output
-        p_simulator->Solve();
+        p_simulator->DisableSimulationOutput(); //no directory, viz, results or parameter files- only the log is written
+        if (snapshotOutput)
+        {
+            //fate composition recorded with each count
+            p_simulator->AddCountProperty(p_Mitotic);
+            p_simulator->AddCountProperty(p_PostMitotic);
+        }
+        //Count times in hpf are converted to this lineage's simulation time, which starts at endTime - currSimEndTime hpf
+        std::vector<double> simCountTimes;
+        for (unsigned i = 0; i < countTimes.size(); i++)
+        {
+            simCountTimes.push_back(countTimes[i] - (endTime - currSimEndTime));
+        }
+        p_simulator->SetCountTimes(simCountTimes);
+        if (multiInduction)
+        {
+            //Induction times before the lineage's first mitosis label the founder, so the clone is the whole lineage
+            std::vector<double> simInductionTimes;
+            for (unsigned i = 0; i < inductionTimes.size(); i++)
+            {
+                simInductionTimes.push_back(inductionTimes[i] - lineageStartTime);
+            }
+            p_simulator->SetInductionTimes(simInductionTimes, p_Mitotic);
+        }
+
+        //With --fork-variants, solve to the last timestep before the variants' mitotic modes could differ & snapshot it;
+        //divisions at the earliest changed TiL itself may differ, as the phase boundaries are strict
+        double forkTime = currSimEndTime;
+        boost::shared_ptr<SimulationSnapshot<2> > p_snapshot;
+        if (forkVariants)
+        {
+            forkTime = std::floor((forkTiL - currTiL) / LineageModelRules::HE_DT) * LineageModelRules::HE_DT;
+            if (forkTime + currTiL >= forkTiL) forkTime -= LineageModelRules::HE_DT;
+            forkTime = std::min(currSimEndTime, std::max(0.0, forkTime));
+            if (forkTime > 0)
+            {
+                p_simulator->SetEndTime(forkTime);
+                p_simulator->Solve();
+                p_simulator->SetEndTime(currSimEndTime);
+            }
+            p_snapshot.reset(new SimulationSnapshot<2>(*cell_population));
+        }
+        if (!forkVariants || forkTime < currSimEndTime - 0.025)
+        {
+            p_simulator->Solve();
+        }
+
+        if (treeOutput)
+        {
+            LineageTreeRecorder::Instance()->RecordFinalCells(seed, *cell_population, treeFates);
+            LineageTreeRecorder::Instance()->CommitSeed(seed);
+        }
 
         //Count lineage size
         unsigned count = cell_population->GetNumRealCells();
 
-        if (outputMode == 0) *p_log << entry_number << "\t" << inductionTime << "\t" << seed << "\t" << count << "\n";
-        if (outputMode == 2) *p_log << "\n";
+        if (multiInduction)
+        {
+            //one counts row per induction time, in the single-induction format
+            std::vector<unsigned> cloneSizes = p_simulator->CountClones();
+            for (unsigned i = 0; i < inductionTimes.size(); i++)
+            {
+                std::ostringstream inductionColumn;
+                inductionColumn << inductionTimes[i] << "\t";
+                run.WriteCounts(seed, inductionColumn.str(), cloneSizes[i]);
+            }
+        }
+        else if (countOutput)
+        {
+            std::ostringstream inductionColumn;
+            inductionColumn << inductionTime << "\t";
+            run.WriteCounts(seed, inductionColumn.str(), count, p_simulator->rGetCounts());
+        }
+        if (sequenceOutput) p_output->rGetStream(LineageOutput::SEQUENCE, seed) << "\n";
+        if (decisionOutput)
+        {
+            //each lineage's decision counts give its likelihood under other probabilities, see Importance_reweighting.py
+            run.WriteStatistics(LineageOutput::DECISIONS, seed, count, HeCellCycleModel::rGetDecisionCounts());
+        }
+        if (scoreOutput)
+        {
+            //with the count, each lineage's score is its contribution to d P(count)/d theta, see Score_gradient.py
+            run.WriteStatistics(LineageOutput::SCORES, seed, count, HeCellCycleModel::rGetLineageScore());
+        }
+        if (snapshotOutput) run.WriteSnapshots(seed, count, *p_simulator, endTime);
+        bool stop = run.CommitSeed(seed, count);
+
+        //Continue each variant from the snapshot; lineages that ended before the fork have the simulated count
+        if (forkVariants)
+        {
+            //live cells are counted by their properties, so the simulated population goes before any is restored
+            delete cell_population;
+            cell_population = NULL;
+
+            for (unsigned i = 0; i < variants.size(); i++)
+            {
+                unsigned variantCount = count;
+                if (forkTime < currSimEndTime - 0.025)
+                {
+                    NodeBasedCellPopulation<2>* p_variant_population = p_snapshot->Restore();
+                    for (AbstractCellPopulation<2>::Iterator cell_iter = p_variant_population->Begin();
+                            cell_iter != p_variant_population->End(); ++cell_iter)
+                    {
+                        static_cast<HeCellCycleModel*>((*cell_iter)->GetCellCycleModel())->SetMitoticModeParameters(
+                                variants[i].mPhase2, variants[i].mPhase2 + variants[i].mPhase3, variants[i].mPP1,
+                                variants[i].mPD1, variants[i].mPP2, variants[i].mPD2, variants[i].mPP3, variants[i].mPD3);
+                    }
+
+                    {
+                        //restored cells are already initialised
+                        OffLatticeSimulationPropertyStop<2> variant_simulator(*p_variant_population, false, false);
+                        variant_simulator.SetStopProperty(p_Mitotic);
+                        variant_simulator.SetDt(LineageModelRules::HE_DT);
+                        variant_simulator.SetEndTime(currSimEndTime);
+                        variant_simulator.DisableSimulationOutput();
+                        variant_simulator.Solve();
+                    }
+                    variantCount = p_variant_population->GetNumRealCells();
+                    delete p_variant_population;
+                }
+                *variantCounts[i] << entry_number << "\t" << inductionTime << "\t" << seed << "\t" << variantCount << "\n";
+            }
+        }
 
         //Reset for next simulation
         SimulationTime::Destroy();
         delete cell_population;
-        entry_number++;
-
-        if (debugOutput)
-        {
-            debugWriter->Close();
-        }
 
+        if (stop) break;
     }
 
-    p_RNG->Destroy();
-    LogFile::Close();
+    run.Close();
 
     return exit_code;
 }
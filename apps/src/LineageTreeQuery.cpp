@@ -0,0 +1,135 @@
+#include <iostream>
+#include <string>
+
+#include "ExecutableSupport.hpp"
+#include "Exception.hpp"
+#include "PetscTools.hpp"
+#include "PetscException.hpp"
+
+#include "OutputFileHandler.hpp"
+#include "RandomNumberGenerator.hpp"
+#include "LineageTreeRecorder.hpp"
+
+/***********************************
+ * LINEAGE TREE QUERY
+ * Reads a LineageTreeRecorder archive (<filename>TREE.ltree, from a simulator run with --lineage-tree)
+ * and writes one statistic for every seed, so new statistics don't need the lineages re-simulated.
+ *
+ * Queries, written to "<archive base>_<Query>" in <directory>:
+ * sequences : every root-to-leaf mitotic mode sequence, one per cell, with the probability that the
+ *             models' sequence sampler would follow it ("Seed\tCellID\tWeight\tSequence")
+ * counts <t1> <t2> ... : clone size at each time, in the simulator's units (hpf, h or generations)
+ * paths <numPathsUnsigned> <rngSeedUnsigned> : sampled paths, in the sequence output's format ("Entry\tSeed\tSequence")
+ ************************************/
+
+int main(int argc, char *argv[])
+{
+    ExecutableSupport::StartupWithoutShowingCopyright(&argc, &argv);
+    int exit_code = ExecutableSupport::EXIT_OK;
+
+    std::string queryString = (argc > 3) ? argv[3] : "";
+    bool sane = (queryString == "sequences" && argc == 4) || (queryString == "counts" && argc > 4)
+            || (queryString == "paths" && argc == 6);
+
+    if (!sane)
+    {
+        ExecutableSupport::PrintError(
+                "Wrong arguments for query.\nUsage (replace<> with values):\n LineageTreeQuery <directoryString> <archiveFilenameString> sequences\n LineageTreeQuery <directoryString> <archiveFilenameString> counts <timeDouble> ...\n LineageTreeQuery <directoryString> <archiveFilenameString> paths <numPathsUnsigned> <rngSeedUnsigned>",
+                true);
+        exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+        return exit_code;
+    }
+
+    std::string directoryString = argv[1];
+    std::string archiveFilenameString = argv[2];
+
+    OutputFileHandler handler(directoryString, false);
+    std::string archivePath = handler.GetOutputDirectoryFullPath() + archiveFilenameString;
+
+    std::vector<LineageTree> trees;
+    if (!LineageTreeRecorder::ReadArchive(archivePath, trees))
+    {
+        ExecutableSupport::PrintError("Could not read lineage tree archive " + archivePath);
+        exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+        return exit_code;
+    }
+
+    std::string baseString = archiveFilenameString;
+    if (baseString.size() > 6 && baseString.substr(baseString.size() - 6) == ".ltree")
+    {
+        baseString = baseString.substr(0, baseString.size() - 6);
+    }
+
+    if (queryString == "sequences")
+    {
+        out_stream p_file = handler.OpenOutputFile(baseString + "_Sequences");
+        (*p_file) << "Seed\tCellID\tWeight\tSequence\n";
+
+        std::vector<unsigned> leafIds;
+        std::vector<std::string> sequences;
+        std::vector<double> weights;
+        for (unsigned t = 0; t < trees.size(); t++)
+        {
+            trees[t].GetModeSequences(leafIds, sequences, weights);
+            for (unsigned i = 0; i < sequences.size(); i++)
+            {
+                (*p_file) << trees[t].mSeed << "\t" << leafIds[i] << "\t" << weights[i] << "\t" << sequences[i] << "\n";
+            }
+        }
+        p_file->close();
+    }
+    else if (queryString == "counts")
+    {
+        std::vector<double> times;
+        for (int i = 4; i < argc; i++)
+        {
+            times.push_back(std::stod(argv[i]));
+        }
+
+        out_stream p_file = handler.OpenOutputFile(baseString + "_Counts");
+        (*p_file) << "Seed";
+        for (unsigned i = 0; i < times.size(); i++)
+        {
+            (*p_file) << "\tCount " << times[i];
+        }
+        (*p_file) << "\n";
+
+        for (unsigned t = 0; t < trees.size(); t++)
+        {
+            (*p_file) << trees[t].mSeed;
+            for (unsigned i = 0; i < times.size(); i++)
+            {
+                (*p_file) << "\t" << trees[t].GetCloneSize(times[i]);
+            }
+            (*p_file) << "\n";
+        }
+        p_file->close();
+    }
+    else if (queryString == "paths")
+    {
+        unsigned numPaths = std::stoul(argv[4]);
+        unsigned rngSeed = std::stoul(argv[5]);
+
+        RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+        p_RNG->Reseed(rngSeed);
+
+        out_stream p_file = handler.OpenOutputFile(baseString + "_Paths");
+        (*p_file) << "Entry\tSeed\tSequence\n";
+
+        unsigned entry_number = 1;
+        for (unsigned t = 0; t < trees.size(); t++)
+        {
+            for (unsigned i = 0; i < numPaths; i++)
+            {
+                (*p_file) << entry_number << "\t" << trees[t].mSeed << "\t" << trees[t].SamplePath(p_RNG) << "\n";
+                entry_number++;
+            }
+        }
+        p_file->close();
+        p_RNG->Destroy();
+    }
+
+    ExecutableSupport::Print("Queried " + std::to_string(trees.size()) + " lineage(s) from " + archiveFilenameString);
+
+    return exit_code;
+}
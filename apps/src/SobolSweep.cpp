@@ -0,0 +1,339 @@
+#include <iostream>
+#include <string>
+
+#include <cxxtest/TestSuite.h>
+#include "ExecutableSupport.hpp"
+#include "Exception.hpp"
+#include "PetscTools.hpp"
+#include "PetscException.hpp"
+
+#include "RandomNumberGenerator.hpp"
+
+#include "SimulatorOptions.hpp"
+#include "ModelLineage.hpp"
+#include "LineageBatch.hpp"
+#include "LineageOutput.hpp"
+#include "SeedRangeRunner.hpp"
+#include "SobolIndices.hpp"
+#include "OutputFileHandler.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+
+/***********************************
+ * SOBOL SWEEP
+ * Global sensitivity analysis of a model's outputs to its parameters: a Saltelli design over declared parameter ranges
+ * is run in one job (each point's seeds by ModelLineage, no simulator command lines), and first-order & total Sobol
+ * indices are computed for every output.
+ *
+ * Ranges file: one line per model parameter, in the simulator's argument order: <name> <lowDouble> <highDouble>
+ * (low = high fixes the parameter; see ModelLineage for each model's parameters). The d parameters with low < high are
+ * swept: base matrices A & B hold numBaseSamples uniform draws each, and AB_i is A with column i from B, so the design
+ * has numBaseSamples * (d + 2) points. Every point with a probability sum over 1 is an error: narrow the ranges.
+ *
+ * Each point simulates seeds startSeed..endSeed (the same for every point), and its outputs are the mean & variance over
+ * those seeds of each ModelLineage output (eg. "Mean Count" & "Var Count", clone size & clone-size variance).
+ * Points are written to <filenameString> ("Point\tBlock\tRow\t<parameters>\t<outputs>"; block 0 = A, 1 = B, 2 + i = AB_i),
+ * at full double precision (max_digits10), so the indices computed from the file are those of the simulated values.
+ * Indices are written to <filenameString>_Sobol ("Output\tParameter\tS1\tST"): Saltelli (2010) first-order & Jansen total
+ * estimators, see SobolIndices.
+ *
+ * --batched (He, Gomes & Boije): each point's seeds run together in a LineageBatch rather than one ModelLineage at a
+ * time; counts then match the simulators in distribution but not seed for seed.
+ *
+ * Parallel: mpirun -np <N> SobolSweep ... hands the design points out to N-1 worker processes as SeedRangeRunner does
+ * seeds; rank 0 gathers the points in order & computes the indices. Without mpirun every point runs in the one process,
+ * on one core.
+ ************************************/
+
+int main(int argc, char *argv[])
+{
+    SimulatorOptions::Startup(&argc, &argv);
+    //main() returns code indicating sim run success or failure mode
+    int exit_code = ExecutableSupport::EXIT_OK;
+
+    //positional arguments, less any trailing "--option <values>" pairs
+    int numPositional = SimulatorOptions::GetNumPositionalArguments(argc, argv);
+    if (numPositional != 9)
+    {
+        ExecutableSupport::PrintError(
+                "Wrong arguments for Sobol sweep.\nUsage (replace<> with values):\n SobolSweep <directoryString> <filenameString> <modelString(He, Gomes, Boije or Wan)> <rangesFile> <numBaseSamplesUnsigned> <startSeedUnsigned> <endSeedUnsigned> <designSeedUnsigned>\nRanges file: one line per model parameter, in the simulator's argument order: <name> <lowDouble> <highDouble> (low = high fixes it)\nOptions:\n--serial : skip PETSc/MPI startup, for single-process sweeps (not with mpirun)\n--batched : He, Gomes & Boije only; run each point's seeds together in a LineageBatch\nParallel: mpirun -np <N> SobolSweep ... shares the design points over N-1 worker processes; rank 0 gathers them & computes the indices. Points are only spread over cores under mpirun: without it the sweep runs in one process, on one core\n",
+                true);
+        exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+        return exit_code;
+    }
+
+    /***********************
+     * SWEEP PARAMETERS
+     ***********************/
+    std::string directoryString = argv[1];
+    std::string filenameString = argv[2];
+    std::string model = argv[3];
+    std::string rangesFile = argv[4];
+    unsigned numBaseSamples = std::stoul(argv[5]);
+    unsigned startSeed = std::stoul(argv[6]);
+    unsigned endSeed = std::stoul(argv[7]);
+    unsigned designSeed = std::stoul(argv[8]);
+
+    /************************
+     * PARAMETER/ARGUMENT SANITY CHECK
+     ************************/
+    bool sane = 1;
+
+    std::vector<std::string> parameterNames = ModelLineage::GetParameterNames(model);
+    if (parameterNames.empty())
+    {
+        ExecutableSupport::PrintError("Bad model (argument 3). Must be He, Gomes, Boije or Wan");
+        sane = 0;
+    }
+
+    std::vector<double> rangeLow, rangeHigh;
+    std::ifstream ranges(rangesFile.c_str());
+    std::string line;
+    while (std::getline(ranges, line))
+    {
+        std::istringstream fields(line);
+        std::string name;
+        double low, high;
+        if (!(fields >> name)) continue; //blank line
+        if (!(fields >> low >> high) || low > high || rangeLow.size() >= parameterNames.size()
+                || name != parameterNames[rangeLow.size()])
+        {
+            ExecutableSupport::PrintError("Bad ranges file line: " + line);
+            sane = 0;
+            break;
+        }
+        rangeLow.push_back(low);
+        rangeHigh.push_back(high);
+    }
+    if (sane && rangeLow.size() != parameterNames.size())
+    {
+        ExecutableSupport::PrintError("Ranges file " + rangesFile + " is missing or does not give every " + model + " parameter");
+        sane = 0;
+    }
+
+    //the swept parameters
+    std::vector<unsigned> swept;
+    for (unsigned i = 0; i < rangeLow.size(); i++)
+    {
+        if (rangeLow[i] < rangeHigh[i]) swept.push_back(i);
+    }
+    if (sane && swept.empty())
+    {
+        ExecutableSupport::PrintError("Ranges file " + rangesFile + " fixes every parameter; give at least one low < high");
+        sane = 0;
+    }
+
+    if (numBaseSamples < 2)
+    {
+        ExecutableSupport::PrintError("Bad numBaseSamples (argument 5). Must be >1");
+        sane = 0;
+    }
+
+    if (endSeed < startSeed)
+    {
+        ExecutableSupport::PrintError("Bad start & end seeds (arguments 6, 7). endSeed must not be < startSeed");
+        sane = 0;
+    }
+
+    bool batched = SimulatorOptions::GetBatched();
+    if (batched && !ModelLineage::IsLineageModel(model))
+    {
+        ExecutableSupport::PrintError("--batched runs He, Gomes or Boije lineages only");
+        sane = 0;
+    }
+
+    if (sane == 0)
+    {
+        ExecutableSupport::PrintError("Exiting with bad arguments. See errors for details");
+        exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+        return exit_code;
+    }
+
+    /************************
+     * SALTELLI DESIGN
+     ************************/
+
+    //A & B, in unit coordinates for the swept parameters; drawn alike on every rank, so any rank can build any point
+    RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+    p_RNG->Reseed(designSeed);
+    unsigned numSwept = swept.size();
+    std::vector<std::vector<double> > unitA(numBaseSamples, std::vector<double>(numSwept));
+    std::vector<std::vector<double> > unitB(numBaseSamples, std::vector<double>(numSwept));
+    for (unsigned r = 0; r < numBaseSamples; r++)
+    {
+        for (unsigned j = 0; j < numSwept; j++) unitA[r][j] = p_RNG->ranf();
+        for (unsigned j = 0; j < numSwept; j++) unitB[r][j] = p_RNG->ranf();
+    }
+
+    //theta of point p: block p / N (0 = A, 1 = B, 2 + i = AB_i), row p % N
+    unsigned numPoints = numBaseSamples * (numSwept + 2);
+    std::vector<std::vector<double> > design(numPoints, rangeLow);
+    for (unsigned p = 0; p < numPoints; p++)
+    {
+        unsigned block = p / numBaseSamples;
+        unsigned row = p % numBaseSamples;
+        for (unsigned j = 0; j < numSwept; j++)
+        {
+            bool fromB = (block == 1) || (block == j + 2);
+            double unit = fromB ? unitB[row][j] : unitA[row][j];
+            unsigned i = swept[j];
+            if (ModelLineage::IsIntegerParameter(model, i))
+            {
+                design[p][i] = std::min(rangeHigh[i], std::ceil(rangeLow[i]) + std::floor(unit * (std::floor(rangeHigh[i]) - std::ceil(rangeLow[i]) + 1)));
+            }
+            else
+            {
+                design[p][i] = rangeLow[i] + unit * (rangeHigh[i] - rangeLow[i]);
+            }
+        }
+        if (!ModelLineage::IsValidParameters(model, design[p]))
+        {
+            ExecutableSupport::PrintError("Ranges file " + rangesFile + " gives invalid " + model
+                    + " parameters (eg. probabilities summing over 1) within its ranges; narrow them");
+            exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+            return exit_code;
+        }
+    }
+
+    /************************
+     * SWEEP OUTPUT SETUP
+     ************************/
+
+//Hand out the design points- in order in serial; in chunks to worker ranks under mpirun, with their rows gathered on rank 0
+    SeedRangeRunner runner(0, numPoints - 1);
+
+    std::vector<std::string> modelOutputs = ModelLineage::GetOutputNames(model);
+    std::vector<bool> outputSinks(LineageOutput::NUM_SINKS, false);
+    outputSinks[LineageOutput::COUNTS] = true;
+    LineageOutput* p_output = LineageOutput::Instance();
+    p_output->Open(directoryString, filenameString, outputSinks);
+
+    std::string pointHeader = "Point\tBlock\tRow";
+    for (unsigned i = 0; i < parameterNames.size(); i++)
+    {
+        pointHeader += "\t" + parameterNames[i];
+    }
+    for (unsigned k = 0; k < modelOutputs.size(); k++)
+    {
+        pointHeader += "\tMean " + modelOutputs[k] + "\tVar " + modelOutputs[k];
+    }
+    p_output->WriteHeader(LineageOutput::COUNTS, pointHeader + "\n");
+
+    std::ostringstream designSummary;
+    designSummary << "Sobol sweep writing file " << filenameString << " to directory " << directoryString << ": "
+                  << numSwept << " swept parameter(s), " << numPoints << " point(s) of " << (endSeed - startSeed + 1)
+                  << " seed(s)";
+    ExecutableSupport::Print(designSummary.str());
+
+    /************************
+     * SWEEP
+     ************************/
+
+    unsigned point;
+    while (runner.GetNextSeed(point))
+    {
+        //mean & variance of each output over the seeds (Welford)
+        std::vector<double> mean(modelOutputs.size(), 0.0), sumSquares(modelOutputs.size(), 0.0);
+        unsigned n = 0;
+        LineageBatch* p_batch = NULL;
+        if (batched)
+        {
+            p_batch = new LineageBatch(model);
+            for (unsigned seed = startSeed; seed <= endSeed; seed++)
+            {
+                p_batch->AddLineage(design[point], seed);
+            }
+            p_batch->Run();
+        }
+        for (unsigned seed = startSeed; seed <= endSeed; seed++)
+        {
+            std::vector<double> outputs = batched ? std::vector<double>(1, p_batch->GetCount(seed - startSeed))
+                                                  : ModelLineage::Simulate(model, design[point], seed);
+            n++;
+            for (unsigned k = 0; k < outputs.size(); k++)
+            {
+                double delta = outputs[k] - mean[k];
+                mean[k] += delta / n;
+                sumSquares[k] += delta * (outputs[k] - mean[k]);
+            }
+        }
+        delete p_batch;
+
+        //full precision, as rank 0 computes the indices from the gathered rows
+        std::ostream& r_points = p_output->rGetStream(LineageOutput::COUNTS, point);
+        r_points << std::setprecision(std::numeric_limits<double>::max_digits10);
+        r_points << point << "\t" << point / numBaseSamples << "\t" << point % numBaseSamples;
+        for (unsigned i = 0; i < design[point].size(); i++)
+        {
+            r_points << "\t" << design[point][i];
+        }
+        for (unsigned k = 0; k < modelOutputs.size(); k++)
+        {
+            r_points << "\t" << mean[k] << "\t" << (n > 1 ? sumSquares[k] / (n - 1) : 0.0);
+        }
+        r_points << "\n";
+        p_output->CommitSeed(point);
+    }
+
+    LineageOutput::Destroy();
+
+    /************************
+     * SOBOL INDICES
+     ************************/
+
+    if (runner.IsWriter())
+    {
+        //read the gathered points back, f[p][k] for sweep output k
+        OutputFileHandler handler(directoryString, false);
+        std::ifstream points((handler.GetOutputDirectoryFullPath() + filenameString).c_str());
+        unsigned numSweepOutputs = 2 * modelOutputs.size();
+        std::vector<std::vector<double> > f(numPoints, std::vector<double>(numSweepOutputs));
+        std::getline(points, line); //header
+        unsigned numRead = 0;
+        while (std::getline(points, line))
+        {
+            std::istringstream fields(line);
+            unsigned p, block, row;
+            double value;
+            fields >> p >> block >> row;
+            for (unsigned i = 0; i < parameterNames.size(); i++) fields >> value;
+            for (unsigned k = 0; k < numSweepOutputs && p < numPoints; k++) fields >> f[p][k];
+            numRead++;
+        }
+        if (numRead != numPoints)
+        {
+            ExecutableSupport::PrintError("Sobol sweep point file " + filenameString + " is incomplete; indices not computed");
+            exit_code = ExecutableSupport::EXIT_ERROR;
+            return exit_code;
+        }
+
+        out_stream p_indices = handler.OpenOutputFile(filenameString + "_Sobol");
+        (*p_indices) << "Output\tParameter\tS1\tST\n";
+        for (unsigned k = 0; k < numSweepOutputs; k++)
+        {
+            std::string outputName = ((k % 2 == 0) ? "Mean " : "Var ") + modelOutputs[k / 2];
+
+            std::vector<double> values(numPoints);
+            for (unsigned p = 0; p < numPoints; p++) values[p] = f[p][k];
+            std::vector<double> firstOrder, total;
+            SobolIndices::Estimate(values, numBaseSamples, numSwept, firstOrder, total);
+
+            for (unsigned j = 0; j < numSwept; j++)
+            {
+                (*p_indices) << outputName << "\t" << parameterNames[swept[j]] << "\t" << firstOrder[j] << "\t" << total[j]
+                             << "\n";
+            }
+        }
+        p_indices->close();
+        ExecutableSupport::Print("Sobol indices written to " + filenameString + "_Sobol");
+    }
+
+    p_RNG->Destroy();
+
+    return exit_code;
+}
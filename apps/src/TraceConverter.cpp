@@ -0,0 +1,115 @@
+#include <iostream>
+#include <string>
+#include <set>
+
+#include "ExecutableSupport.hpp"
+#include "Exception.hpp"
+#include "PetscTools.hpp"
+#include "PetscException.hpp"
+
+#include "OutputFileHandler.hpp"
+#include "ColumnDataWriter.hpp"
+#include "CellCycleTrace.hpp"
+
+/***********************************
+ * TRACE CONVERTER
+ * Rewrites a CellCycleTrace binary debug file as the per-seed ColumnDataWriter files the simulators used to write.
+ * <traceFilename> "xDEBUG.trace" gives files "xDEBUG_<seed>" in <directory>, with the original columns & units.
+ * Columns a model did not write for an event (eg. MitoticModeRV in deterministic mode) are left unset, as before.
+ * Converts all seeds in the trace, or only <seed> if given.
+ ************************************/
+
+int main(int argc, char *argv[])
+{
+    ExecutableSupport::StartupWithoutShowingCopyright(&argc, &argv);
+    int exit_code = ExecutableSupport::EXIT_OK;
+
+    if (argc != 3 && argc != 4)
+    {
+        ExecutableSupport::PrintError(
+                "Wrong arguments for converter.\nUsage (replace<> with values):\n TraceConverter <directoryString> <traceFilenameString> [<seedUnsigned>]",
+                true);
+        exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+        return exit_code;
+    }
+
+    std::string directoryString = argv[1];
+    std::string traceFilenameString = argv[2];
+
+    OutputFileHandler handler(directoryString, false);
+    std::string tracePath = handler.GetOutputDirectoryFullPath() + traceFilenameString;
+
+    std::vector<CellCycleTraceIndexEntry> index;
+    if (!CellCycleTrace::ReadIndex(tracePath, index))
+    {
+        ExecutableSupport::PrintError("Could not read trace " + tracePath + ". Missing, or the run did not Close() it");
+        exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+        return exit_code;
+    }
+
+    //Seeds to convert, in index order
+    std::set<unsigned> seeds;
+    for (unsigned i = 0; i < index.size(); i++)
+    {
+        seeds.insert(index[i].mSeed);
+    }
+    if (argc == 4)
+    {
+        unsigned seed = std::stoul(argv[3]);
+        if (seeds.count(seed) == 0)
+        {
+            ExecutableSupport::PrintError("Seed " + std::to_string(seed) + " has no records in " + traceFilenameString);
+            exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+            return exit_code;
+        }
+        seeds.clear();
+        seeds.insert(seed);
+    }
+
+    std::string baseString = traceFilenameString;
+    if (baseString.size() > 6 && baseString.substr(baseString.size() - 6) == ".trace")
+    {
+        baseString = baseString.substr(0, baseString.size() - 6);
+    }
+
+    std::vector<CellCycleTraceRecord> records;
+    for (std::set<unsigned>::iterator it = seeds.begin(); it != seeds.end(); ++it)
+    {
+        if (!CellCycleTrace::ReadSeed(tracePath, index, *it, records) || records.empty())
+        {
+            ExecutableSupport::PrintError("Could not read records for seed " + std::to_string(*it));
+            exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+            continue;
+        }
+
+        //Layout from the first record; Wan stem records share the He layout
+        std::vector<std::pair<std::string, std::string> > columns = CellCycleTrace::GetColumns(records[0].mModel);
+
+        ColumnDataWriter writer(directoryString, baseString + "_" + std::to_string(*it), false, 10);
+        int timeID = writer.DefineUnlimitedDimension("Time", "h");
+        std::vector<int> varIDs;
+        for (unsigned c = 0; c < columns.size(); c++)
+        {
+            varIDs.push_back(writer.DefineVariable(columns[c].first, columns[c].second));
+        }
+        writer.EndDefineMode();
+
+        for (unsigned r = 0; r < records.size(); r++)
+        {
+            writer.PutVariable(timeID, records[r].mTime);
+            for (unsigned c = 0; c < varIDs.size(); c++)
+            {
+                if (records[r].mSetMask & (1u << c))
+                {
+                    writer.PutVariable(varIDs[c], records[r].mValues[c]);
+                }
+            }
+            writer.AdvanceAlongUnlimitedDimension();
+        }
+        writer.Close();
+    }
+
+    ExecutableSupport::Print("Converted " + std::to_string(seeds.size()) + " seed(s) from " + traceFilenameString);
+
+    return exit_code;
+}
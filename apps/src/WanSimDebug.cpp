@@ -25,6 +25,7 @@
 #include "VertexBasedCellPopulation.hpp"
 
 #include "CellProliferativeTypesCountWriter.hpp"
+#include "CellCycleTrace.hpp"
 
 
 int main(int argc, char *argv[])
@@ -79,11 +80,10 @@ int main(int argc, char *argv[])
 
     WanStemCellCycleModel* p_stem_model = new WanStemCellCycleModel;
 
-    boost::shared_ptr<ColumnDataWriter> p_debugWriter(
-            new ColumnDataWriter(directoryString, filenameString + "DEBUG_WAN", false, 10));
+    CellCycleTrace::Instance()->Open(directoryString, filenameString + "DEBUG_WAN.trace");
 
     p_stem_model->SetDimension(2);
-    p_stem_model->EnableModelDebugOutput(p_debugWriter);
+    p_stem_model->EnableModelDebugOutput(0);
     CellPtr p_cell(new Cell(p_state, p_stem_model));
     p_cell->InitialiseCellCycleModel();
     cells.push_back(p_cell);
@@ -121,6 +121,7 @@ int main(int argc, char *argv[])
 
     p_RNG->Destroy();
     LogFile::Close();
+    CellCycleTrace::Destroy();
 
     return exit_code;
 }
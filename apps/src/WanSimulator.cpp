@@ -1,5 +1,7 @@
 #include <iostream>
 #include <string>
+#include <cmath>
+#include <algorithm>
 
 #include <cxxtest/TestSuite.h>
 #include "ExecutableSupport.hpp"
@@ -7,24 +9,39 @@
 #include "PetscTools.hpp"
 #include "PetscException.hpp"
 
-#include "WanStemCellCycleModel.hpp"
-#include "HeCellCycleModel.hpp"
-#include "OffLatticeSimulationPropertyStop.hpp"
+#include "RandomNumberGenerator.hpp"
+#include "SimulationTime.hpp"
 
-#include "AbstractCellBasedTestSuite.hpp"
+#include "SeedRangeRunner.hpp"
+#include "SeedJournal.hpp"
+#include "ResultCache.hpp"
+#include "SimulatorOptions.hpp"
+#include "WanEventEngine.hpp"
+#include "WanMeanField.hpp"
+#include "WanSeedSimulation.hpp"
+#include "OutputFileHandler.hpp"
 
-#include "WildTypeCellMutationState.hpp"
-#include "StemCellProliferativeType.hpp"
-#include "TransitCellProliferativeType.hpp"
-#include "DifferentiatedCellProliferativeType.hpp"
-
-#include "CellsGenerator.hpp"
-#include "HoneycombMeshGenerator.hpp"
-#include "NodesOnlyMesh.hpp"
-#include "NodeBasedCellPopulation.hpp"
-#include "VertexBasedCellPopulation.hpp"
-
-#include "CellProliferativeTypesCountWriter.hpp"
+namespace
+{
+    //Write a WanEventEngine's or WanMeanField's samples as CellProliferativeTypesCountWriter's celltypes.dat
+    template<class SAMPLER>
+    void WriteCellTypeCounts(const std::string& rDirectory, const SAMPLER& rSampler)
+    {
+        OutputFileHandler results_handler(rDirectory + "/results_from_time_0");
+        out_stream p_types_file = results_handler.OpenOutputFile("celltypes.dat");
+        for (unsigned i = 0; i < rSampler.GetNumSamples(); i++)
+        {
+            *p_types_file << rSampler.GetSampleTime(i) << "\t";
+            auto counts = rSampler.GetSampleCounts(i);
+            for (unsigned j = 0; j < counts.size(); j++)
+            {
+                *p_types_file << counts[j] << "\t";
+            }
+            *p_types_file << "\n";
+        }
+        p_types_file->close();
+    }
+}
 
 int main(int argc, char *argv[])
 {
@@ -32,10 +49,12 @@ int main(int argc, char *argv[])
     //main() returns code indicating sim run success or failure mode
     int exit_code = ExecutableSupport::EXIT_OK;
 
-    if (argc != 23)
+    int numArgs = SimulatorOptions::GetNumPositionalArguments(argc, argv);
+
+    if (numArgs != 23)
     {
         ExecutableSupport::PrintError(
-                "Wrong arguments for simulator.\nUsage (replace<> with values, pass bools as 0 or 1):\n WanSimulator <directoryString> <startSeedUnsigned> <endSeedUnsigned> <cmzResidencyTimeDoubleHours> <stemDivisorDouble> <meanProgenitorPopualtion@3dpfDouble> <stdProgenitorPopulation@3dpfDouble> <stemGammaShiftDouble> <stemGammaShapeDouble> <stemGammaScaleDouble> <progenitorGammaShiftDouble> <progenitorGammaShapeDouble> <progenitorGammaScaleDouble> <progenitorSisterShiftDouble> <mMitoticModePhase2Double> <mMitoticModePhase3Double> <pPP1Double(0-1)> <pPD1Double(0-1)> <pPP1Double(0-1)> <pPD1Double(0-1)> <pPP1Double(0-1)> <pPD1Double(0-1)>",
+                "Wrong arguments for simulator.\nUsage (replace<> with values, pass bools as 0 or 1):\n WanSimulator <directoryString> <startSeedUnsigned> <endSeedUnsigned> <cmzResidencyTimeDoubleHours> <stemDivisorDouble> <meanProgenitorPopualtion@3dpfDouble> <stdProgenitorPopulation@3dpfDouble> <stemGammaShiftDouble> <stemGammaShapeDouble> <stemGammaScaleDouble> <progenitorGammaShiftDouble> <progenitorGammaShapeDouble> <progenitorGammaScaleDouble> <progenitorSisterShiftDouble> <mMitoticModePhase2Double> <mMitoticModePhase3Double> <pPP1Double(0-1)> <pPD1Double(0-1)> <pPP1Double(0-1)> <pPD1Double(0-1)> <pPP1Double(0-1)> <pPD1Double(0-1)>\nOptions:\n--resume : continue a killed or crashed run with the same arguments; seeds recorded in <directoryString>/WanSimulator.journal are skipped (serial runs only)\n--end-time <endTimeDoubleHours> : simulated hours after 3dpf (default 8568, 360dpf)\n--checkpoint-interval <intervalDoubleHours> : save each seed's simulation at every multiple of this time, to <directoryString>/Seed<seed>Results/archive (a whole multiple of --sampling-interval); each seed's cell type counts are still written to one results_from_time_0/celltypes.dat\n--restart-time <checkpointTimeDoubleHours> : continue each seed from its checkpoint at this time, to --end-time (eg. extend a study to 360dpf), replacing its counts after the checkpoint in results_from_time_0/celltypes.dat\n--sampling-interval <intervalDoubleHours> : write cell type counts at this interval (default 1, every step)\n--event-queue : run each seed as a discrete-event WanEventEngine simulation, writing only the cell type counts (not with --checkpoint-interval or --restart-time)\n--tau-leap <toleranceDouble> : as --event-queue, but phase 3 progenitors are tau-leaped as cohorts, with leaps chosen by the tolerance (eg. 0.03); for large progenitor pools, matching the simulator in distribution, not seed for seed\n--threads <numThreadsUnsigned> : as --event-queue, but each seed's progenitor divisions are shared out between this many threads (stems stay serial); counts do not depend on the number of threads, & match the simulator in distribution, not seed for seed (not with --tau-leap)\n--mean-field : in place of the seeds, write the expected cell type counts from WanMeanField to <directoryString>/MeanFieldResults (one process; not with --event-queue, --tau-leap, --threads, --resume or checkpoints)",
                 true);
         exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
         return exit_code;
@@ -51,6 +70,16 @@ int main(int argc, char *argv[])
     double stemGammaShift, stemGammaShape, stemGammaScale, progenitorGammaShift, progenitorGammaShape,
             progenitorGammaScale, progenitorGammaSister;
     double mitoticModePhase2, mitoticModePhase3, pPP1, pPD1, pPP2, pPD2, pPP3, pPD3; //stochastic He model parameters
+    bool resume; //continue a killed run from its journal
+    double endTime; //hours after 3dpf
+    double checkpointInterval; //hours between checkpoints, 0 = none
+    double restartTime; //checkpoint to restart each seed from, < 0 = none
+    double samplingInterval; //hours between cell type count rows
+    bool eventQueue; //run seeds in a WanEventEngine
+    bool meanField; //write WanMeanField's expected counts instead of running seeds
+    double tauLeapTolerance; //WanEventEngine's hybrid tau-leaping tolerance; 0 runs every division
+    unsigned numThreads; //threads for each WanEventEngine seed's progenitor lanes; 0 runs seeds serially
+    bool threadsValid; //whether --threads was a whole number
 
     //PARSE ARGUMENTS
     directoryString = argv[1];
@@ -78,10 +107,15 @@ int main(int argc, char *argv[])
     pPD2 = std::stod(argv[20]);
     pPP3 = std::stod(argv[21]);
     pPD3 = std::stod(argv[22]);
-
-    std::vector<double> stemOffspringParams = { mitoticModePhase2, mitoticModePhase2 + mitoticModePhase3, pPP1, pPD1,
-                                                pPP2, pPD2, pPP3, pPD3, progenitorGammaShift, progenitorGammaShape,
-                                                progenitorGammaScale, progenitorGammaSister };
+    resume = SimulatorOptions::GetResume();
+    endTime = SimulatorOptions::GetDoubleOption("--end-time", 8568); // 360dpf - 3dpf simulation start time
+    checkpointInterval = SimulatorOptions::GetDoubleOption("--checkpoint-interval", 0);
+    restartTime = SimulatorOptions::GetDoubleOption("--restart-time", -1);
+    samplingInterval = SimulatorOptions::GetDoubleOption("--sampling-interval", 1);
+    tauLeapTolerance = SimulatorOptions::GetDoubleOption("--tau-leap", 0);
+    threadsValid = SimulatorOptions::GetUnsignedOption("--threads", 0, numThreads);
+    eventQueue = SimulatorOptions::GetEventQueue() || tauLeapTolerance > 0 || numThreads > 0;
+    meanField = SimulatorOptions::GetMeanField();
 
     /************************
      * PARAMETER/ARGUMENT SANITY CHECK
@@ -94,6 +128,50 @@ int main(int argc, char *argv[])
         sane = 0;
     }
 
+    if (checkpointInterval < 0 || restartTime >= endTime)
+    {
+        ExecutableSupport::PrintError("Bad checkpoint options. --checkpoint-interval must not be negative, and --restart-time must be < --end-time");
+        sane = 0;
+    }
+
+    //checkpointed segments must sample on the steps an uncheckpointed run samples on, for their counts to join up
+    double samplingIntervals = checkpointInterval / std::max(1.0, std::round(samplingInterval));
+    if (std::fabs(samplingIntervals - std::round(samplingIntervals)) > 1e-9)
+    {
+        ExecutableSupport::PrintError("Bad --checkpoint-interval. Must be a whole multiple of --sampling-interval");
+        sane = 0;
+    }
+
+    if (samplingInterval < 1)
+    {
+        ExecutableSupport::PrintError("Bad --sampling-interval. Must be at least the 1 hour timestep");
+        sane = 0;
+    }
+
+    if (eventQueue && (checkpointInterval > 0 || restartTime >= 0))
+    {
+        ExecutableSupport::PrintError("--event-queue, --tau-leap & --threads run each seed in one pass; they do not take --checkpoint-interval or --restart-time");
+        sane = 0;
+    }
+
+    if (tauLeapTolerance < 0)
+    {
+        ExecutableSupport::PrintError("Bad --tau-leap. The tolerance must be positive-valued");
+        sane = 0;
+    }
+
+    if (!threadsValid || (numThreads > 0 && tauLeapTolerance > 0))
+    {
+        ExecutableSupport::PrintError("Bad --threads. Must be a whole number of threads, and not with --tau-leap");
+        sane = 0;
+    }
+
+    if (meanField && (eventQueue || resume || checkpointInterval > 0 || restartTime >= 0 || PetscTools::IsParallel()))
+    {
+        ExecutableSupport::PrintError("--mean-field runs in one process, without --event-queue, --tau-leap, --threads, --resume, --checkpoint-interval or --restart-time");
+        sane = 0;
+    }
+
     if (cmzResidencyTime <= 0)
     {
         ExecutableSupport::PrintError("Bad CMZ residency time (argument 5). cmzResidencyTime must be positive-valued");
@@ -168,89 +246,83 @@ int main(int argc, char *argv[])
 
     ExecutableSupport::Print("Simulator writing files to directory " + directoryString);
 
-//Instance RNG
-    RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+//cell type counts are written every samplingMultiple 1 hour steps
+    unsigned samplingMultiple = unsigned(std::round(samplingInterval));
 
-//Initialise pointers to relevant singleton ProliferativeTypes and Properties
-    boost::shared_ptr<AbstractCellProperty> p_state(CellPropertyRegistry::Instance()->Get<WildTypeCellMutationState>());
-    boost::shared_ptr<AbstractCellProperty> p_Stem(CellPropertyRegistry::Instance()->Get<StemCellProliferativeType>());
-    boost::shared_ptr<AbstractCellProperty> p_Transit(
-            CellPropertyRegistry::Instance()->Get<TransitCellProliferativeType>());
-    boost::shared_ptr<AbstractCellProperty> p_PostMitotic(
-            CellPropertyRegistry::Instance()->Get<DifferentiatedCellProliferativeType>());
+//the model's parameters in ModelLineage's Wan order, for WanSeedSimulation, WanEventEngine & WanMeanField
+    std::vector<double> wanTheta = { cmzResidencyTime, stemDivisor, progenitorMean, progenitorStd, stemGammaShift,
+                                     stemGammaShape, stemGammaScale, progenitorGammaShift, progenitorGammaShape,
+                                     progenitorGammaScale, progenitorGammaSister, mitoticModePhase2, mitoticModePhase3,
+                                     pPP1, pPD1, pPP2, pPD2, pPP3, pPD3, endTime };
 
-//iterate through supplied seed range, executing one simulation per seed
-    for (unsigned seed = startSeed; seed <= endSeed; seed++)
+//--mean-field: one deterministic trajectory of expected counts stands in for the seed range
+    if (meanField)
     {
-        //initialise SimulationTime (permits cellcyclemodel setup)
-        SimulationTime::Instance()->SetStartTime(0.0);
+        WanMeanField mean_field(wanTheta);
+        mean_field.Solve(samplingMultiple);
+        WriteCellTypeCounts(directoryString + "/MeanFieldResults", mean_field);
+        return exit_code;
+    }
 
-        //Reseed the RNG with the required seed
-        p_RNG->Reseed(seed);
+//Hand out the seed range- in order in serial; in chunks to worker ranks under mpirun. Each seed writes its own results directory
+    SeedRangeRunner runner(startSeed, endSeed, false);
 
-        //unsigned numberStem = int(std::round(p_RNG->NormalRandomDeviate(stemMean, stemStd)));
-        unsigned numberProgenitors = int(std::round(p_RNG->NormalRandomDeviate(progenitorMean, progenitorStd)));
-        unsigned numberStem = int(std::round(numberProgenitors / stemDivisor));
+//Set up the seed journal- completed seeds are recorded in WanSimulator.journal, so a killed serial run can be resumed, see SeedJournal
+    if (resume && runner.IsParallel())
+    {
+        ExecutableSupport::PrintError("--resume is for serial WanSimulator runs only");
+        exit_code = ExecutableSupport::EXIT_BAD_ARGUMENTS;
+        return exit_code;
+    }
+    SeedJournal journal;
+    journal.Open(directoryString, "WanSimulator.journal", ResultCache::MakeJobDescription(argc, argv, { }), resume,
+                 !runner.IsParallel());
+    if (resume) ExecutableSupport::Print("Resuming: " + std::to_string(journal.GetNumCompleted()) + " seed(s) already complete");
 
-        std::vector<CellPtr> stems;
-        std::vector<CellPtr> cells;
+//Instance RNG
+    RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
 
-        for (unsigned i = 0; i < numberStem; i++)
-        {
-            WanStemCellCycleModel* p_stem_model = new WanStemCellCycleModel;
-            p_stem_model->SetDimension(2);
-            p_stem_model->SetModelParameters(stemGammaShift, stemGammaShape, stemGammaScale, stemOffspringParams);
-
-            CellPtr p_cell(new Cell(p_state, p_stem_model));
-            p_cell->InitialiseCellCycleModel();
-            stems.push_back(p_cell);
-            cells.push_back(p_cell);
-        }
+//Event queue engine for --event-queue, tau-leaping phase 3 progenitors under --tau-leap, in lanes under --threads
+    WanEventEngine engine(wanTheta);
+    engine.SetTauLeapTolerance(tauLeapTolerance);
+    engine.SetNumThreads(numThreads);
 
-        for (unsigned i = 0; i < numberProgenitors; i++)
-        {
-            double currTiL = p_RNG->ranf() * cmzResidencyTime;
+//Chaste cell-based simulation of each seed otherwise, saving checkpoints every checkpointInterval if set
+    WanSeedSimulation chaste_path(wanTheta);
+    chaste_path.SetSamplingTimestepMultiple(samplingMultiple);
+    chaste_path.SetCheckpointInterval(checkpointInterval);
 
-            HeCellCycleModel* p_prog_model = new HeCellCycleModel;
-            p_prog_model->SetDimension(2);
-            p_prog_model->SetModelParameters(currTiL, mitoticModePhase2, mitoticModePhase2 + mitoticModePhase3, pPP1,
-                                             pPD1, pPP2, pPD2, pPP3, pPD3);
-            p_prog_model->EnableKillSpecified();
+//iterate through this process's share of the seed range, executing one simulation per seed
+    unsigned seed;
+    while (runner.GetNextSeed(seed))
+    {
+        if (journal.IsComplete(seed)) continue;
 
-            CellPtr p_cell(new Cell(p_state, p_prog_model));
-            p_cell->InitialiseCellCycleModel();
-            cells.push_back(p_cell);
-        }
+        //initialise SimulationTime (permits cellcyclemodel setup)
+        SimulationTime::Instance()->SetStartTime(0.0);
 
-        //Generate 1x#cells mesh for abstract colony
-        HoneycombMeshGenerator generator(1, (numberProgenitors + numberStem));
-        MutableMesh<2, 2>* p_generating_mesh = generator.GetMesh();
-        NodesOnlyMesh<2> mesh;
-        mesh.ConstructNodesWithoutMesh(*p_generating_mesh, 1.5);
+        //Reseed the RNG with the required seed
+        p_RNG->Reseed(seed);
 
-        //Setup cell population
-        boost::shared_ptr<NodeBasedCellPopulation<2>> cell_population(new NodeBasedCellPopulation<2>(mesh, cells));
-        cell_population->AddCellPopulationCountWriter<CellProliferativeTypesCountWriter>();
+        std::string seedDirectoryString = directoryString + "/Seed" + std::to_string(seed) + "Results";
 
-        //Give Wan stem cells the population & base stem pop size
-        for (auto p_cell : stems)
+        if (eventQueue)
         {
-            WanStemCellCycleModel* p_cycle_model = dynamic_cast<WanStemCellCycleModel*>(p_cell->GetCellCycleModel());
-            p_cycle_model->EnableExpandingStemPopulation(numberStem, cell_population);
+            //Run the seed's divisions from the event queue & write the CellProliferativeTypesCountWriter rows it samples
+            engine.Run(samplingMultiple);
+            WriteCellTypeCounts(seedDirectoryString, engine);
+
+            journal.RecordSeed(seed);
+            SimulationTime::Destroy();
+            continue;
         }
 
-        //Setup simulator & run simulation
-        boost::shared_ptr<OffLatticeSimulationPropertyStop<2>> p_simulator(
-                new OffLatticeSimulationPropertyStop<2>(*cell_population));
-        p_simulator->SetStopProperty(p_Transit); //simulation to stop if no RPCs are left
-        p_simulator->SetDt(1);
-        p_simulator->SetOutputDirectory(directoryString + "/Seed" + std::to_string(seed) + "Results");
-        p_simulator->SetEndTime(8568); // 360dpf - 3dpf simulation start time
-        p_simulator->Solve();
+        //Run the seed through Chaste, from its checkpoint if restarting; checkpointed segments write one celltypes.dat
+        chaste_path.Run(seedDirectoryString, restartTime);
+        journal.RecordSeed(seed);
 
         //Reset for next simulation
         SimulationTime::Destroy();
-        cell_population.reset();
     }
 
     p_RNG->Destroy();
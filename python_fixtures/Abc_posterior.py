@@ -0,0 +1,48 @@
+import struct
+import sys
+
+import numpy as np
+
+#####################################################################
+# READER FOR ABCSAMPLER POSTERIOR FILES
+# AbcSampler writes its accepted candidates to <filename>.abc:
+# "ISPABC01", uint32 number of parameters, per parameter a uint32 name length & the name,
+# then per accepted candidate: uint32 candidate index, one double per parameter, double RSS.
+#####################################################################
+
+ABC_MAGIC = b'ISPABC01'
+
+def load_posterior(filename):
+    #returns parameter names, candidate indices, the (samples x parameters) matrix & each sample's RSS
+    with open(filename, 'rb') as abc_file:
+        data = abc_file.read()
+    if data[0:8] != ABC_MAGIC:
+        raise Exception(filename + ' is not an AbcSampler posterior file')
+    offset = 8
+    number_params, = struct.unpack_from('<I', data, offset)
+    offset += 4
+    names = []
+    for i in range(0, number_params):
+        length, = struct.unpack_from('<I', data, offset)
+        offset += 4
+        names.append(data[offset:offset+length].decode('ascii'))
+        offset += length
+    record = np.dtype([('candidate', '<u4'), ('theta', '<f8', (number_params,)), ('rss', '<f8')])
+    samples = np.frombuffer(data, dtype=record, offset=offset)
+    return names, samples['candidate'], samples['theta'], samples['rss']
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: python3 Abc_posterior.py <abcFile>")
+        sys.exit(1)
+    names, candidates, theta, rss = load_posterior(sys.argv[1])
+
+    print("Candidate\t" + "\t".join(names) + "\tRSS")
+    for i in range(0, len(candidates)):
+        print(str(candidates[i]) + "\t" + "\t".join("%g" % t for t in theta[i,:]) + "\t" + "%.4g" % rss[i])
+    if len(candidates) > 0:
+        print("Posterior mean\t" + "\t".join("%.4g" % m for m in np.mean(theta, axis=0)))
+        print("Posterior sd\t" + "\t".join("%.4g" % s for s in np.std(theta, axis=0)))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,104 @@
+import sys
+
+import numpy as np
+
+#####################################################################
+# IMPORTANCE REWEIGHTING OF STORED LINEAGES TO OTHER PROBABILITY PARAMETERS
+# The simulators' outputMode 6 writes one row per lineage: Entry, Seed, Count, then the counts of each decision drawn
+# (He: PP1 PD1 DD1 PP2 PD2 DD2 PP3 PD3 DD3; Gomes: PP PD DD MG AC BC RPh; Boije: atoh7 on/off, ptf1a on/off, ng on/off).
+# Every decision is a categorical or Bernoulli draw, so a lineage simulated at theta0 has weight
+# P(decisions | theta) / P(decisions | theta0) at theta, & weighted histograms estimate the outputs at theta without
+# resimulating. Only the probability parameters can be reweighted- He phase boundaries & cycle times cannot.
+# The effective sample size (sum w)^2 / sum w^2 falls as theta moves from theta0; below ~10% of the lineages, resimulate.
+#####################################################################
+
+#parameter order of each model's theta, as the simulators' arguments
+parameter_names = {
+    'He' : ['pPP1', 'pPD1', 'pPP2', 'pPD2', 'pPP3', 'pPD3'],
+    'Gomes' : ['pPP', 'pPD', 'pBC', 'pAC', 'pMG'],
+    'Boije' : ['pAtoh7', 'pPtf1a', 'png']
+    }
+
+def decision_probabilities(model, theta):
+    #probability of each decision column for this model & theta
+    if model == 'He':
+        probabilities = []
+        for phase in range(0,3):
+            pPP = theta[2*phase]
+            pPD = theta[2*phase+1]
+            probabilities += [pPP, pPD, 1 - pPP - pPD]
+        return np.array(probabilities)
+    if model == 'Gomes':
+        pPP, pPD, pBC, pAC, pMG = theta
+        return np.array([pPP, pPD, 1 - pPP - pPD, pMG, pAC, pBC, 1 - pMG - pAC - pBC])
+    if model == 'Boije':
+        pAtoh7, pPtf1a, png = theta
+        return np.array([pAtoh7, 1 - pAtoh7, pPtf1a, 1 - pPtf1a, png, 1 - png])
+    raise Exception('Unknown model: ' + model)
+
+def load_decisions(filename):
+    #returns seeds, end counts & the (lineages x decisions) count matrix
+    table = np.loadtxt(filename, skiprows=1, ndmin=2)
+    return table[:,1].astype(int), table[:,2], table[:,3:]
+
+def log_likelihoods(model, decisions, theta):
+    #log P(decisions | theta) per lineage; -inf where a lineage drew a decision of probability 0
+    probabilities = decision_probabilities(model, theta)
+    log_probabilities = np.log(np.where(probabilities > 0, probabilities, 1))
+    likelihoods = np.dot(decisions, log_probabilities)
+    impossible = np.dot(decisions, (probabilities <= 0).astype(float)) > 0
+    likelihoods[impossible] = -np.inf
+    return likelihoods
+
+def weights(model, decisions, theta0, theta):
+    #likelihood ratio of each lineage, & the effective sample size
+    log_ratio = log_likelihoods(model, decisions, theta) - log_likelihoods(model, decisions, theta0)
+    w = np.exp(log_ratio)
+    if np.sum(w) == 0:
+        return w, 0
+    return w, np.square(np.sum(w)) / np.sum(np.square(w))
+
+def reweighted_histogram(values, w, bin_sequence):
+    #self-normalised weighted probability histogram of per-lineage values
+    histogram, bin_edges = np.histogram(values, bin_sequence, weights=w)
+    total = np.sum(w)
+    return histogram / total if total > 0 else histogram
+
+def reweighted_rate_histogram(events_filename, seeds, w, mode, rate_bin_sequence, bin_width=5):
+    #hourly per-lineage event probabilities of a mitotic mode, as the SPSA fixture's rate histograms
+    events = np.loadtxt(events_filename, skiprows=1, usecols=(0,1,3), ndmin=2)
+    events = events[np.where(events[:,2]==mode)]
+    weight_of_seed = dict(zip(seeds, w))
+    event_weights = np.array([weight_of_seed.get(int(seed), 0) for seed in events[:,1]])
+    histogram, bin_edges = np.histogram(events[:,0], rate_bin_sequence, weights=event_weights)
+    return histogram / (np.sum(w) * bin_width)
+
+def reweight_grid(model, decisions, values, theta0, theta_grid, bin_sequence):
+    #(theta, histogram, effective sample size) for each theta of the grid
+    results = []
+    for theta in theta_grid:
+        w, ess = weights(model, decisions, theta0, theta)
+        results.append((theta, reweighted_histogram(values, w, bin_sequence), ess))
+    return results
+
+def main():
+    if len(sys.argv) < 5:
+        print("Usage: python3 Importance_reweighting.py <decisionsFile> <He|Gomes|Boije> <theta0, comma separated> <gridFile (one theta per line)> [maxCount=30]")
+        print("theta order: He " + ",".join(parameter_names['He']) + "; Gomes " + ",".join(parameter_names['Gomes']) + "; Boije " + ",".join(parameter_names['Boije']))
+        sys.exit(1)
+    model = sys.argv[2]
+    theta0 = np.array([float(x) for x in sys.argv[3].split(',')])
+    theta_grid = np.loadtxt(sys.argv[4], ndmin=2)
+    max_count = int(sys.argv[5]) if len(sys.argv) > 5 else 30
+
+    seeds, counts, decisions = load_decisions(sys.argv[1])
+
+    print("\t".join(parameter_names[model]) + "\tESS\tMean count\t" + "\t".join("P(" + str(c) + ")" for c in range(1, max_count + 1)))
+    for theta in theta_grid:
+        w, ess = weights(model, decisions, theta0, theta)
+        histogram = reweighted_histogram(counts, w, np.arange(1, max_count + 2, 1))
+        mean_count = np.sum(w * counts) / np.sum(w) if np.sum(w) > 0 else float('nan')
+        print("\t".join("%g" % t for t in theta) + "\t" + "%.1f" % ess + "\t" + "%.4g" % mean_count + "\t" + "\t".join("%.4g" % p for p in histogram))
+
+if __name__ == "__main__":
+    main()
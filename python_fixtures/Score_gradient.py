@@ -0,0 +1,72 @@
+import sys
+
+import numpy as np
+
+#####################################################################
+# LIKELIHOOD-RATIO GRADIENTS FROM HESIMULATOR SCORE FUNCTION OUTPUT
+# HeSimulator outputMode 5 writes one row per lineage: Entry, Seed, Count, then the lineage's score,
+# the sum over its mode draws of d log P(mode)/d theta, theta = (pPP1, pPD1, pPP2, pPD2, pPP3, pPD3).
+# For any lineage output f, E[f * score] = d E[f]/d theta, so one run at theta estimates the gradient of the
+# count & rate histograms (and so of the SPSA fixture's AIC) for the mode probabilities.
+# Run with outputMode 05 (counts & scores) or 15 (events & scores), so all outputs see the same lineages.
+#####################################################################
+
+score_columns = ['pPP1', 'pPD1', 'pPP2', 'pPD2', 'pPP3', 'pPD3']
+
+def load_scores(filename):
+    #returns seeds, end counts & the (lineages x 6) score matrix
+    table = np.loadtxt(filename, skiprows=1, ndmin=2)
+    return table[:,1].astype(int), table[:,2], table[:,3:]
+
+def histogram_gradient(values, scores, bin_sequence):
+    #probability histogram of per-lineage values, & its gradient (bins x parameters)
+    #the bin's probability is subtracted from its indicator as a baseline: E[score] = 0, so this only lowers the variance
+    lineages = len(values)
+    prob = np.zeros(len(bin_sequence)-1)
+    gradient = np.zeros((len(bin_sequence)-1, scores.shape[1]))
+    bins = np.digitize(values, bin_sequence) - 1
+    for b in range(0, len(prob)):
+        indicator = (bins == b).astype(float)
+        prob[b] = np.mean(indicator)
+        gradient[b,:] = np.dot(indicator - prob[b], scores) / lineages
+    return prob, gradient
+
+def event_rate_gradient(events_filename, seeds, scores, mode, rate_bin_sequence, bin_width=5):
+    #hourly per-lineage event probabilities of a mitotic mode, as the SPSA fixture's rate histograms, & their gradient
+    events = np.loadtxt(events_filename, skiprows=1, usecols=(0,1,3), ndmin=2)
+    events = events[np.where(events[:,2]==mode)]
+    row_of_seed = { seed : i for i, seed in enumerate(seeds) }
+    per_lineage = np.zeros((len(seeds), len(rate_bin_sequence)-1))
+    for i in range(0, len(seeds)):
+        lineage_events = events[np.where(events[:,1]==seeds[i])]
+        per_lineage[i,:], bin_edges = np.histogram(lineage_events[:,0], rate_bin_sequence, density=False)
+    per_lineage = per_lineage / bin_width
+    rate = np.mean(per_lineage, axis=0)
+    gradient = np.dot((per_lineage - rate).T, scores) / len(seeds)
+    return rate, gradient
+
+def rss_gradient(prob, gradient, empirical_prob, weight=1):
+    #residual sum of squares against an empirical histogram, & its gradient
+    residual = prob - empirical_prob[0:len(prob)]
+    return weight * np.sum(np.square(residual)), weight * 2 * np.dot(residual, gradient)
+
+def aic_gradient(number_params, number_comparisons, rss, rss_gradient):
+    #AIC = 2k + n log(RSS), as the SPSA fixture, & its gradient
+    return 2 * number_params + number_comparisons * np.log(rss), number_comparisons * rss_gradient / rss
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: python3 Score_gradient.py <scoresFile> [maxCount=30]")
+        sys.exit(1)
+    max_count = int(sys.argv[2]) if len(sys.argv) > 2 else 30
+
+    seeds, counts, scores = load_scores(sys.argv[1])
+    prob, gradient = histogram_gradient(counts, scores, np.arange(1, max_count + 2, 1))
+
+    print("Count\tP\t" + "\t".join("dP/d" + name for name in score_columns))
+    for b in range(0, len(prob)):
+        print(str(b+1) + "\t" + "%.4g" % prob[b] + "\t" + "\t".join("%.4g" % g for g in gradient[b,:]))
+    print("Mean count " + "%.4g" % np.mean(counts) + "; d/dtheta " + "\t".join("%.4g" % g for g in np.dot(counts - np.mean(counts), scores) / len(counts)))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,79 @@
+import os
+import subprocess
+import time
+import filecmp
+
+import numpy as np
+
+#Times HeSimulator process startup with & without --serial (PETSc/MPI initialisation skipped)
+#and checks that both startup paths write identical output
+
+executable = '/home/main/chaste_build/projects/ISP/apps/HeSimulator'
+
+if not(os.path.isfile(executable)):
+    raise Exception('Could not find executable: ' + executable)
+
+if 'CHASTE_TEST_OUTPUT' not in os.environ:
+    raise Exception('CHASTE_TEST_OUTPUT must be set to find simulator output')
+
+#########################
+# BENCHMARK PARAMETERS
+#########################
+
+repeats = 100 #processes launched per startup path
+directory_name = "StartupBenchmark"
+file_name = "HeStartup"
+
+#One short lineage per process, so process startup dominates
+start_seed = 0
+end_seed = 0
+output_mode = "0" #counts
+deterministic_mode = 0
+fixture = 0
+ath5founder = 0
+debug_output = 0
+induction_time = 32
+earliest_lineage_start_time = 23.0
+latest_lineage_start_time = 39.0
+end_time = 72.0
+he_params = "8 7 1.0 0.0 0.2 0.4 0.2 0.0"
+
+def main():
+    base_command = executable\
+                +" "+directory_name+" "+file_name+"{0} "\
+                +output_mode+" "+str(deterministic_mode)+" "+str(fixture)+" "+str(ath5founder)+" "+str(debug_output)+" "\
+                +str(start_seed)+" "+str(end_seed)+" "+str(induction_time)+" "\
+                +str(earliest_lineage_start_time)+" "+str(latest_lineage_start_time)+" "+str(end_time)+" "\
+                +he_params
+
+    full_times = time_startup(base_command.format("Full"), repeats)
+    serial_times = time_startup(base_command.format("Serial") + " --serial", repeats)
+
+    print("Startup path\tMedian (ms)\tMean (ms)\tMin (ms)")
+    print("Full\t" + summary(full_times))
+    print("--serial\t" + summary(serial_times))
+
+    output_directory = os.path.join(os.environ['CHASTE_TEST_OUTPUT'], directory_name)
+    if filecmp.cmp(os.path.join(output_directory, file_name + "Full"), os.path.join(output_directory, file_name + "Serial"), shallow=False):
+        print("Output identical")
+    else:
+        raise Exception('--serial output differs from full startup output')
+
+def time_startup(command, repeats):
+    times = np.zeros(repeats)
+    for i in range(0, repeats):
+        start = time.perf_counter()
+        if execute_command(command) != 0:
+            raise Exception('Simulator failed: ' + command)
+        times[i] = (time.perf_counter() - start) * 1000
+
+    return times
+
+def summary(times):
+    return "{0:.1f}\t{1:.1f}\t{2:.1f}".format(np.median(times), np.mean(times), np.min(times))
+
+def execute_command(cmd):
+    return subprocess.call(cmd, shell=True, stdout=subprocess.DEVNULL)
+
+if __name__ == "__main__":
+    main()
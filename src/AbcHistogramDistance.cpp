@@ -0,0 +1,71 @@
+#include "AbcHistogramDistance.hpp"
+#include "Exception.hpp"
+
+#include <algorithm>
+
+AbcHistogramDistance::AbcHistogramDistance(const std::vector<double>& rObserved, unsigned numLineages)
+    : mObserved(rObserved),
+      mNumLineages(numLineages),
+      mNumAdded(0)
+{
+    if (mObserved.empty() || mNumLineages == 0)
+    {
+        EXCEPTION("AbcHistogramDistance needs an observed histogram & at least one lineage per candidate");
+    }
+    double total = 0;
+    for (unsigned i = 0; i < mObserved.size(); i++)
+    {
+        total += mObserved[i];
+    }
+    mObserved.push_back(std::max(0.0, 1.0 - total));
+    mBinCounts.assign(mObserved.size(), 0);
+}
+
+void AbcHistogramDistance::Reset()
+{
+    std::fill(mBinCounts.begin(), mBinCounts.end(), 0);
+    mNumAdded = 0;
+}
+
+void AbcHistogramDistance::AddLineage(unsigned count)
+{
+    unsigned overflow = mObserved.size() - 1;
+    mBinCounts[(count == 0 || count > overflow) ? overflow : count - 1]++;
+    mNumAdded++;
+}
+
+unsigned AbcHistogramDistance::GetNumAdded() const
+{
+    return mNumAdded;
+}
+
+double AbcHistogramDistance::GetLowerBound() const
+{
+    //residuals at the current counts; the remaining mass can only raise bins
+    std::vector<double> residuals(mObserved.size());
+    for (unsigned i = 0; i < mObserved.size(); i++)
+    {
+        residuals[i] = double(mBinCounts[i]) / mNumLineages - mObserved[i];
+    }
+    double remaining = double(mNumLineages - std::min(mNumAdded, mNumLineages)) / mNumLineages;
+
+    //water-fill: raise the k lowest residuals to a common level, for the smallest k whose level stays below the next
+    std::vector<double> sorted(residuals);
+    std::sort(sorted.begin(), sorted.end());
+    double level = sorted[0];
+    double filled_sum = 0;
+    for (unsigned k = 1; k <= sorted.size(); k++)
+    {
+        filled_sum += sorted[k - 1];
+        level = (remaining + filled_sum) / k;
+        if (k == sorted.size() || level <= sorted[k]) break;
+    }
+
+    double rss = 0;
+    for (unsigned i = 0; i < residuals.size(); i++)
+    {
+        double final_residual = std::max(residuals[i], level);
+        rss += final_residual * final_residual;
+    }
+    return rss;
+}
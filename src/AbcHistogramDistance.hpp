@@ -0,0 +1,45 @@
+#ifndef ABCHISTOGRAMDISTANCE_HPP_
+#define ABCHISTOGRAMDISTANCE_HPP_
+
+#include <vector>
+
+/***********************************
+ * ABC HISTOGRAM DISTANCE
+ * Distance between a candidate's lineage count histogram & an observed one, kept up to date as the candidate's
+ * lineages are simulated, so AbcSampler can abandon a candidate as soon as it cannot be accepted.
+ *
+ * The distance is the fixtures' RSS: sum over counts of (P_candidate(count) - P_observed(count))^2, over counts
+ * 1..K of the observed histogram & one overflow bin for every other count (observed mass 1 - sum of the histogram).
+ *
+ * After n of N lineages, each bin's final probability is at least its current count/N, and the remaining (N-n)/N
+ * of probability is still to be placed. GetLowerBound() is the smallest RSS any placement of it could reach
+ * (water-filling the bins furthest below the observed histogram), so a candidate whose bound exceeds the
+ * tolerance would certainly be rejected with all N lineages. With all N lineages, the bound is the RSS.
+ ************************************/
+
+class AbcHistogramDistance
+{
+private:
+    std::vector<double> mObserved; //P(count = i + 1) for i < K; mObserved[K] is the overflow bin
+    unsigned mNumLineages; //N
+    std::vector<unsigned> mBinCounts;
+    unsigned mNumAdded;
+
+public:
+    /**
+     * @param rObserved P(count = 1), P(count = 2), ... P(count = K)
+     * @param numLineages lineages simulated per candidate
+     */
+    AbcHistogramDistance(const std::vector<double>& rObserved, unsigned numLineages);
+
+    //Start a new candidate
+    void Reset();
+
+    void AddLineage(unsigned count);
+    unsigned GetNumAdded() const;
+
+    //Smallest RSS the candidate can reach with its remaining lineages; its RSS once all are added
+    double GetLowerBound() const;
+};
+
+#endif /*ABCHISTOGRAMDISTANCE_HPP_*/
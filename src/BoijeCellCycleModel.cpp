@@ -1,8 +1,10 @@
 #include "BoijeCellCycleModel.hpp"
 
+std::vector<unsigned> BoijeCellCycleModel::mLineageDecisionCounts(6, 0);
+
 BoijeCellCycleModel::BoijeCellCycleModel() :
         AbstractSimpleCellCycleModel(), mOutput(false), mEventStartTime(), mSequenceSampler(false), mSeqSamplerLabelSister(
-                false), mDebug(false), mTimeID(), mVarIDs(), mDebugWriter(), mGeneration(0), mPhase2gen(3), mPhase3gen(
+                false), mPathOnly(false), mDebug(false), mLineageTree(false), mParentId(0), mCountDecisions(false), mGeneration(0), mPhase2gen(3), mPhase3gen(
                 5), mprobAtoh7(0.32), mprobPtf1a(0.30), mprobng(0.80), mAtoh7Signal(false), mPtf1aSignal(false), mNgSignal(
                 false), mMitoticMode(0), mSeed(0), mp_PostMitoticType(), mp_RGC_Type(), mp_AC_HC_Type(), mp_PR_BC_Type(), mp_label_Type()
 {
@@ -10,14 +12,13 @@ BoijeCellCycleModel::BoijeCellCycleModel() :
 
 BoijeCellCycleModel::BoijeCellCycleModel(const BoijeCellCycleModel& rModel) :
         AbstractSimpleCellCycleModel(rModel), mOutput(rModel.mOutput), mEventStartTime(rModel.mEventStartTime), mSequenceSampler(
-                rModel.mSequenceSampler), mSeqSamplerLabelSister(rModel.mSeqSamplerLabelSister), mDebug(rModel.mDebug), mTimeID(
-                rModel.mTimeID), mVarIDs(rModel.mVarIDs), mDebugWriter(rModel.mDebugWriter), mGeneration(
+                rModel.mSequenceSampler), mSeqSamplerLabelSister(rModel.mSeqSamplerLabelSister), mPathOnly(rModel.mPathOnly), mDebug(rModel.mDebug), mLineageTree(rModel.mLineageTree), mParentId(rModel.mParentId), mCountDecisions(rModel.mCountDecisions), mGeneration(
                 rModel.mGeneration), mPhase2gen(rModel.mPhase2gen), mPhase3gen(rModel.mPhase3gen), mprobAtoh7(
                 rModel.mprobAtoh7), mprobPtf1a(rModel.mprobPtf1a), mprobng(rModel.mprobng), mAtoh7Signal(
                 rModel.mAtoh7Signal), mPtf1aSignal(rModel.mPtf1aSignal), mNgSignal(rModel.mNgSignal), mMitoticMode(
                 rModel.mMitoticMode), mSeed(rModel.mSeed), mp_PostMitoticType(rModel.mp_PostMitoticType), mp_RGC_Type(
                 rModel.mp_RGC_Type), mp_AC_HC_Type(rModel.mp_AC_HC_Type), mp_PR_BC_Type(rModel.mp_PR_BC_Type), mp_label_Type(
-                rModel.mp_label_Type)
+                rModel.mp_label_Type), mRandomStream(rModel.mRandomStream)
 {
 }
 
@@ -42,12 +43,13 @@ void BoijeCellCycleModel::SetCellCycleDuration()
 
 void BoijeCellCycleModel::ResetForDivision()
 {
+    //the daughter's model is copied from this one after ResetForDivision(), so it inherits the parent's ID
+    if (mLineageTree) mParentId = mpCell->GetCellId();
+
     mGeneration++; //increment generation counter
     //the first division is ascribed to generation "1"
 
-    RandomNumberGenerator* p_random_number_generator = RandomNumberGenerator::Instance();
-
-    mMitoticMode = 0; //0=PP;1=PD;2=DD
+    const LineageRandomStream* p_random_number_generator = &mRandomStream;
 
     /************************************************
      * TRANSCRIPTION FACTOR RANDOM VARIABLES & RULES
@@ -62,7 +64,8 @@ void BoijeCellCycleModel::ResetForDivision()
 
 
     //PHASE & TF SIGNAL RULES
-    if (mGeneration > mPhase2gen && mGeneration <= mPhase3gen) //if the cell is in the 2nd model phase, all signals have nonzero probabilities at each division
+    unsigned phase = LineageModelRules::GetBoijePhase(mGeneration, mPhase2gen, mPhase3gen);
+    if (phase == 2) //if the cell is in the 2nd model phase, all signals have nonzero probabilities at each division
     {
         //RVs take values evenly distributed across 0-1
         atoh7RV = p_random_number_generator->ranf();
@@ -81,9 +84,16 @@ void BoijeCellCycleModel::ResetForDivision()
         {
             mNgSignal = true;
         }
+
+        if (mCountDecisions)
+        {
+            mLineageDecisionCounts[mAtoh7Signal ? 0 : 1]++;
+            mLineageDecisionCounts[mPtf1aSignal ? 2 : 3]++;
+            mLineageDecisionCounts[mNgSignal ? 4 : 5]++;
+        }
     }
 
-    if (mGeneration > mPhase3gen) //if the cell is in the 3rd model phase, only ng signal has a nonzero probability
+    if (phase == 3) //if the cell is in the 3rd model phase, only ng signal has a nonzero probability
     {
         ngRV = p_random_number_generator->ranf();
         //roll a probability die for the ng signal
@@ -91,6 +101,7 @@ void BoijeCellCycleModel::ResetForDivision()
         {
             mNgSignal = true;
         }
+        if (mCountDecisions) mLineageDecisionCounts[mNgSignal ? 4 : 5]++;
     }
 
     /****************
@@ -98,23 +109,20 @@ void BoijeCellCycleModel::ResetForDivision()
      * -(additional asymmetric postmitotic rules specified in InitialiseDaughterCell();)
      * *************/
 
-    if(mAtoh7Signal == true)
-    {
-        mMitoticMode = 1;
-    }
-
-    if (mPtf1aSignal == true && mAtoh7Signal == false) //Ptf1A alone gives a symmetrical postmitotic AC/HC division
-    {
-        mMitoticMode = 2;
-        mpCell->SetCellProliferativeType(mp_PostMitoticType);
-        mpCell->AddCellProperty(mp_AC_HC_Type);
-    }
+    mMitoticMode = LineageModelRules::GetBoijeMode(mAtoh7Signal, mPtf1aSignal, mNgSignal);
 
-    if (mPtf1aSignal == false && mAtoh7Signal == false && mNgSignal == true) //ng alone gives a symmetrical postmitotic PR/BC division
+    if (mMitoticMode == 2)
     {
-        mMitoticMode = 2;
+        //Ptf1A alone gives a symmetrical postmitotic AC/HC division, ng alone a symmetrical postmitotic PR/BC division
         mpCell->SetCellProliferativeType(mp_PostMitoticType);
-        mpCell->AddCellProperty(mp_PR_BC_Type);
+        if (mPtf1aSignal)
+        {
+            mpCell->AddCellProperty(mp_AC_HC_Type);
+        }
+        else
+        {
+            mpCell->AddCellProperty(mp_PR_BC_Type);
+        }
     }
 
     /****************
@@ -144,12 +152,13 @@ void BoijeCellCycleModel::ResetForDivision()
     {
         if (mpCell->HasCellProperty<CellLabel>())
         {
-            (*LogFile::Instance()) << mMitoticMode;
+            LineageOutput::Instance()->rGetStream(LineageOutput::SEQUENCE, mSeed) << mMitoticMode;
             double labelRV = p_random_number_generator->ranf();
             if (labelRV <= .5)
             {
                 mSeqSamplerLabelSister = true;
                 mpCell->RemoveCellProperty<CellLabel>();
+                if (mPathOnly) mpCell->Kill(); //the label passes to the daughter; this cell's lineage is not sampled
             }
             else
             {
@@ -166,6 +175,11 @@ void BoijeCellCycleModel::ResetForDivision()
 
 void BoijeCellCycleModel::InitialiseDaughterCell()
 {
+    if (mLineageTree)
+    {
+        LineageTreeRecorder::Instance()->RecordDivision(mSeed, mParentId, mpCell->GetCellId(), mMitoticMode);
+    }
+
     //Asymmetric specification rules
 
     if (mAtoh7Signal == true)
@@ -195,6 +209,7 @@ void BoijeCellCycleModel::InitialiseDaughterCell()
         else
         {
             mpCell->RemoveCellProperty<CellLabel>();
+            if (mPathOnly) mpCell->Kill();
         }
     }
 }
@@ -245,51 +260,68 @@ void BoijeCellCycleModel::WriteModeEventOutput()
     double currentTime = SimulationTime::Instance()->GetTime() + mEventStartTime;
     CellPtr currentCell = GetCell();
     double currentCellID = (double) currentCell->GetCellId();
-    (*LogFile::Instance()) << currentTime << "\t" << mSeed << "\t" << currentCellID << "\t" << mMitoticMode << "\n";
+    LineageOutput::Instance()->rGetStream(LineageOutput::EVENTS, mSeed) << currentTime << "\t" << mSeed << "\t" << currentCellID << "\t" << mMitoticMode << "\n";
 }
 
-void BoijeCellCycleModel::EnableSequenceSampler(boost::shared_ptr<AbstractCellProperty> label)
+void BoijeCellCycleModel::EnableSequenceSampler(boost::shared_ptr<AbstractCellProperty> label, unsigned seed)
 {
     mSequenceSampler = true;
     mp_label_Type = label;
+    mSeed = seed;
 }
 
-void BoijeCellCycleModel::EnableModelDebugOutput(boost::shared_ptr<ColumnDataWriter> debugWriter)
+void BoijeCellCycleModel::EnablePathOnlySampling()
+{
+    mPathOnly = true;
+}
+
+void BoijeCellCycleModel::SetRandomStream(const LineageRandomStream& rStream)
+{
+    mRandomStream = rStream;
+}
+
+void BoijeCellCycleModel::EnableModelDebugOutput(unsigned seed)
 {
     mDebug = true;
-    mDebugWriter = debugWriter;
-
-    mTimeID = mDebugWriter->DefineUnlimitedDimension("Time", "h");
-    mVarIDs.push_back(mDebugWriter->DefineVariable("CellID", "No"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("Generation", "No"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("MitoticMode", "Mode"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("atoh7Set", "Percentile"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("atoh7RV", "Percentile"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("ptf1aSet", "Percentile"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("ptf1aRV", "Percentile"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("ngSet", "Percentile"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("ngRV", "Percentile"));
-
-    mDebugWriter->EndDefineMode();
+    mSeed = seed;
 }
 
-void BoijeCellCycleModel::WriteDebugData(double atoh7RV, double ptf1aRV, double ngRV)
+void BoijeCellCycleModel::EnableLineageTreeRecorder(unsigned seed)
 {
-    double currentTime = SimulationTime::Instance()->GetTime();
-    CellPtr currentCell = GetCell();
-    double currentCellID = (double) currentCell->GetCellId();
+    mLineageTree = true;
+    mSeed = seed;
+}
 
-    mDebugWriter->PutVariable(mTimeID, currentTime);
-    mDebugWriter->PutVariable(mVarIDs[0], currentCellID);
-    mDebugWriter->PutVariable(mVarIDs[1], mGeneration);
-    mDebugWriter->PutVariable(mVarIDs[2], mMitoticMode);
-    mDebugWriter->PutVariable(mVarIDs[3], mprobAtoh7);
-    mDebugWriter->PutVariable(mVarIDs[4], atoh7RV);
-    mDebugWriter->PutVariable(mVarIDs[5], mprobPtf1a);
-    mDebugWriter->PutVariable(mVarIDs[6], ptf1aRV);
-    mDebugWriter->PutVariable(mVarIDs[7], mprobng);
-    mDebugWriter->PutVariable(mVarIDs[8], ngRV);
-    mDebugWriter->AdvanceAlongUnlimitedDimension();
+void BoijeCellCycleModel::EnableDecisionCounts()
+{
+    mCountDecisions = true;
+}
+
+void BoijeCellCycleModel::ResetDecisionCounts()
+{
+    mLineageDecisionCounts.assign(6, 0);
+}
+
+const std::vector<unsigned>& BoijeCellCycleModel::rGetDecisionCounts()
+{
+    return mLineageDecisionCounts;
+}
+
+void BoijeCellCycleModel::WriteDebugData(double atoh7RV, double ptf1aRV, double ngRV)
+{
+    CellCycleTraceRecord record(CellCycleTrace::BOIJE, mSeed, SimulationTime::Instance()->GetTime());
+
+    record.Put(0, GetCell()->GetCellId());
+    record.Put(1, mGeneration);
+    record.Put(2, mMitoticMode);
+    record.Put(3, mprobAtoh7);
+    record.Put(4, atoh7RV);
+    record.Put(5, mprobPtf1a);
+    record.Put(6, ptf1aRV);
+    record.Put(7, mprobng);
+    record.Put(8, ngRV);
+
+    CellCycleTrace::Instance()->Record(record);
 }
 
 /******************
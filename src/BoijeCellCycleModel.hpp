@@ -6,8 +6,11 @@
 #include "Cell.hpp"
 #include "DifferentiatedCellProliferativeType.hpp"
 #include "SmartPointers.hpp"
-#include "ColumnDataWriter.hpp"
-#include "LogFile.hpp"
+#include "CellCycleTrace.hpp"
+#include "LineageOutput.hpp"
+#include "LineageTreeRecorder.hpp"
+#include "LineageRandomStream.hpp"
+#include "LineageModelRules.hpp"
 #include "CellLabel.hpp"
 
 #include "BoijeRetinalNeuralFates.hpp"
@@ -26,13 +29,18 @@
 * to clocktime!!
  *
  * 2 per-model-event output modes:
- * EnableModeEventOutput() enables mitotic mode event logging-all cells will write to the singleton log file
- * EnableModelDebugOutput() enables more detailed debug output, each seed will have its own file written to
- * by a ColumnDataWriter passed to it from the test
- * (eg. by the SetupDebugOutput helper function in the project simulator)
+ * EnableModeEventOutput() enables mitotic mode event logging-all cells will write to the LineageOutput events sink
+ * EnableModelDebugOutput() enables more detailed debug output, written to the singleton CellCycleTrace
+ * (opened once per run by the project simulator; convert to per-seed files with TraceConverter)
  *
  * 1 mitotic-event-sequence sampler (only samples one "path" through the lineage):
- * EnableSequenceSampler() - one "sequence" of progenitors writes mitotic event type to a string in the singleton log file
+ * EnableSequenceSampler() - one "sequence" of progenitors writes mitotic event type to a string in the LineageOutput sequence sink
+ * EnablePathOnlySampling() - with the sampler, the unlabelled cell of each labelled division is killed at once,
+ * so only the labelled path is simulated (sequence output only- counts, events etc. would see the pruned lineage)
+ *
+ * 1 whole-lineage recorder:
+ * EnableLineageTreeRecorder() - every division (parent, daughter, timestep, mode) goes to the singleton LineageTreeRecorder;
+ * query all paths, clone sizes & sampled paths from its archive with LineageTreeQuery
  *
  *********************************/
 
@@ -71,11 +79,14 @@ protected:
     double mEventStartTime;
     bool mSequenceSampler;
     bool mSeqSamplerLabelSister;
-    //debug writer stuff
+    bool mPathOnly; //sampler kills unlabelled cells at division
+    //debug trace switch
     bool mDebug;
-    int mTimeID;
-    std::vector<int> mVarIDs;
-    boost::shared_ptr<ColumnDataWriter> mDebugWriter;
+    //lineage tree recorder switch; mParentId carries the dividing cell's ID to its daughter's model
+    bool mLineageTree;
+    unsigned mParentId;
+    //decision statistics switch, see EnableDecisionCounts()
+    bool mCountDecisions;
     //model parameters and state memory vars
     unsigned mGeneration;
     unsigned mPhase2gen;
@@ -93,6 +104,7 @@ protected:
     boost::shared_ptr<AbstractCellProperty> mp_AC_HC_Type;
     boost::shared_ptr<AbstractCellProperty> mp_PR_BC_Type;
     boost::shared_ptr<AbstractCellProperty> mp_label_Type;
+    LineageRandomStream mRandomStream; //the lineage's draws, see SetRandomStream()
 
     /**
      * Protected copy-constructor for use by CreateCellCycleModel().
@@ -110,6 +122,9 @@ protected:
      */
     BoijeCellCycleModel(const BoijeCellCycleModel& rModel);
 
+    //Decision counts of the current lineage, see EnableDecisionCounts()
+    static std::vector<unsigned> mLineageDecisionCounts;
+
 public:
 
     /**
@@ -168,13 +183,29 @@ public:
     void SetSpecifiedTypes(boost::shared_ptr<AbstractCellProperty> p_RGC_Type, boost::shared_ptr<AbstractCellProperty> p_AC_HC_Type, boost::shared_ptr<AbstractCellProperty> p_PR_BC_Type);
     
     //Functions to enable per-cell mitotic mode logging for mode rate & sequence sampling fixtures
-    //Uses singleton logfile
+    //Uses singleton LineageOutput; output is buffered under the seed until the simulator commits it
     void EnableModeEventOutput(double eventStart, unsigned seed);
-    void EnableSequenceSampler(boost::shared_ptr<AbstractCellProperty> label);
+    void EnableSequenceSampler(boost::shared_ptr<AbstractCellProperty> label, unsigned seed);
+    void EnablePathOnlySampling();
+
+    //Founder of a packed run (--pack): draw from this stream, seeded with the founder's seed, instead of the
+    //RandomNumberGenerator singleton; inherited by its descendants. Call before InitialiseCellCycleModel()
+    void SetRandomStream(const LineageRandomStream& rStream);
+
+    //More detailed debug output. Records go to the singleton CellCycleTrace, which must be Open()ed by the simulator
+    //Records are tagged with seed
+    void EnableModelDebugOutput(unsigned seed);
 
-    //More detailed debug output. Needs a ColumnDataWriter passed to it
-    //Only declare ColumnDataWriter directory, filename, etc; do not set up otherwise
-    void EnableModelDebugOutput(boost::shared_ptr<ColumnDataWriter> debugWriter);
+    //Whole division tree output. Divisions go to the singleton LineageTreeRecorder, which must be Open()ed by the simulator
+    void EnableLineageTreeRecorder(unsigned seed);
+
+    /**
+     * Decision sufficient statistics: each transcription factor draw counts its signal as on or off (atoh7, ptf1a, ng),
+     * in counts shared by all the process's Boije models; the simulator resets them before each lineage & reads them after.
+     */
+    void EnableDecisionCounts();
+    static void ResetDecisionCounts();
+    static const std::vector<unsigned>& rGetDecisionCounts();
 
     /**
      * Overridden GetAverageTransitCellCycleTime() method.
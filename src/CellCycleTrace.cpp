@@ -0,0 +1,244 @@
+#include "CellCycleTrace.hpp"
+#include "OutputFileHandler.hpp"
+#include "Exception.hpp"
+#include <cstring>
+
+namespace
+{
+    const char TRACE_MAGIC[8] = { 'I', 'S', 'P', 'T', 'R', 'C', '0', '1' };
+    const char INDEX_MAGIC[8] = { 'I', 'S', 'P', 'I', 'D', 'X', '0', '1' };
+    const std::streamoff HEADER_BYTES = sizeof(TRACE_MAGIC) + sizeof(uint32_t);
+    const std::streamoff FOOTER_BYTES = sizeof(uint64_t) + sizeof(INDEX_MAGIC);
+}
+
+CellCycleTraceRecord::CellCycleTraceRecord(unsigned model, unsigned seed, double time)
+    : mTime(time),
+      mSeed(seed),
+      mSetMask(0),
+      mModel(model),
+      mPadding(0)
+{
+    memset(mValues, 0, sizeof(mValues));
+}
+
+void CellCycleTraceRecord::Put(unsigned column, double value)
+{
+    mValues[column] = value;
+    mSetMask |= (1u << column);
+}
+
+CellCycleTrace* CellCycleTrace::mpInstance = NULL;
+
+CellCycleTrace::CellCycleTrace()
+    : mOpen(false),
+      mRecordsWritten(0)
+{
+}
+
+CellCycleTrace* CellCycleTrace::Instance()
+{
+    if (mpInstance == NULL)
+    {
+        mpInstance = new CellCycleTrace;
+    }
+    return mpInstance;
+}
+
+void CellCycleTrace::Destroy()
+{
+    if (mpInstance)
+    {
+        mpInstance->Close();
+        delete mpInstance;
+        mpInstance = NULL;
+    }
+}
+
+void CellCycleTrace::Open(const std::string& rDirectory, const std::string& rFilename)
+{
+    if (mOpen)
+    {
+        EXCEPTION("CellCycleTrace is already open; Close() the current trace first");
+    }
+
+    OutputFileHandler handler(rDirectory, false);
+    std::string full_path = handler.GetOutputDirectoryFullPath() + rFilename;
+    mFile.open(full_path.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!mFile.is_open())
+    {
+        EXCEPTION("Could not open trace file " + full_path);
+    }
+
+    uint32_t record_size = sizeof(CellCycleTraceRecord);
+    mFile.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    mFile.write(reinterpret_cast<const char*>(&record_size), sizeof(record_size));
+
+    mRecordsWritten = 0;
+    mIndex.clear();
+    mBuffer.clear();
+    mBuffer.reserve(BUFFER_RECORDS);
+    mOpen = true;
+}
+
+bool CellCycleTrace::IsOpen() const
+{
+    return mOpen;
+}
+
+void CellCycleTrace::Record(const CellCycleTraceRecord& rRecord)
+{
+    if (!mOpen) return;
+
+    mBuffer.push_back(rRecord);
+    if (mBuffer.size() >= BUFFER_RECORDS)
+    {
+        WriteBuffer();
+    }
+}
+
+void CellCycleTrace::EndSeed()
+{
+    if (!mOpen) return;
+
+    WriteBuffer();
+}
+
+void CellCycleTrace::WriteBuffer()
+{
+    if (mBuffer.empty()) return;
+
+    mFile.write(reinterpret_cast<const char*>(&mBuffer[0]), mBuffer.size() * sizeof(CellCycleTraceRecord));
+
+    //Index contiguous runs of one seed, extending the previous entry where a seed continues across flushes
+    for (unsigned i = 0; i < mBuffer.size(); i++)
+    {
+        uint64_t record_number = mRecordsWritten + i;
+        if (!mIndex.empty() && mIndex.back().mSeed == mBuffer[i].mSeed
+                && mIndex.back().mFirstRecord + mIndex.back().mNumRecords == record_number)
+        {
+            mIndex.back().mNumRecords++;
+        }
+        else
+        {
+            CellCycleTraceIndexEntry entry;
+            entry.mSeed = mBuffer[i].mSeed;
+            entry.mPadding = 0;
+            entry.mFirstRecord = record_number;
+            entry.mNumRecords = 1;
+            mIndex.push_back(entry);
+        }
+    }
+
+    mRecordsWritten += mBuffer.size();
+    mBuffer.clear();
+}
+
+void CellCycleTrace::Close()
+{
+    if (!mOpen) return;
+
+    WriteBuffer();
+
+    uint64_t num_entries = mIndex.size();
+    if (num_entries > 0)
+    {
+        mFile.write(reinterpret_cast<const char*>(&mIndex[0]), num_entries * sizeof(CellCycleTraceIndexEntry));
+    }
+    mFile.write(reinterpret_cast<const char*>(&num_entries), sizeof(num_entries));
+    mFile.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    mFile.close();
+
+    mIndex.clear();
+    mOpen = false;
+}
+
+std::vector<std::pair<std::string, std::string> > CellCycleTrace::GetColumns(unsigned model)
+{
+    std::vector<std::pair<std::string, std::string> > columns;
+
+    switch (model)
+    {
+        case HE:
+        case WAN:
+            columns.push_back(std::make_pair("CellID", "No"));
+            columns.push_back(std::make_pair("TiL", "h"));
+            columns.push_back(std::make_pair("CycleDuration", "h"));
+            columns.push_back(std::make_pair("Phase2Boundary", "h"));
+            columns.push_back(std::make_pair("Phase3Boundary", "h"));
+            columns.push_back(std::make_pair("Phase", "No"));
+            columns.push_back(std::make_pair("MitoticModeRV", "Percentile"));
+            columns.push_back(std::make_pair("MitoticMode", "Mode"));
+            columns.push_back(std::make_pair("Label", "binary"));
+            break;
+        case GOMES:
+            columns.push_back(std::make_pair("CellID", "No"));
+            columns.push_back(std::make_pair("CycleDuration", "h"));
+            columns.push_back(std::make_pair("PP", "Percentile"));
+            columns.push_back(std::make_pair("PD", "Percentile"));
+            columns.push_back(std::make_pair("Dieroll", "Percentile"));
+            columns.push_back(std::make_pair("MitoticMode", "Mode"));
+            break;
+        case BOIJE:
+            columns.push_back(std::make_pair("CellID", "No"));
+            columns.push_back(std::make_pair("Generation", "No"));
+            columns.push_back(std::make_pair("MitoticMode", "Mode"));
+            columns.push_back(std::make_pair("atoh7Set", "Percentile"));
+            columns.push_back(std::make_pair("atoh7RV", "Percentile"));
+            columns.push_back(std::make_pair("ptf1aSet", "Percentile"));
+            columns.push_back(std::make_pair("ptf1aRV", "Percentile"));
+            columns.push_back(std::make_pair("ngSet", "Percentile"));
+            columns.push_back(std::make_pair("ngRV", "Percentile"));
+            break;
+        default:
+            EXCEPTION("Unknown cell cycle trace model id");
+    }
+
+    return columns;
+}
+
+bool CellCycleTrace::ReadIndex(const std::string& rFullPath, std::vector<CellCycleTraceIndexEntry>& rIndex)
+{
+    std::ifstream file(rFullPath.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    char magic[8];
+    uint32_t record_size;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&record_size), sizeof(record_size));
+    if (!file || memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0 || record_size != sizeof(CellCycleTraceRecord)) return false;
+
+    //Footer: number of index entries & index magic; an unclosed trace has none
+    uint64_t num_entries;
+    file.seekg(-FOOTER_BYTES, std::ios::end);
+    file.read(reinterpret_cast<char*>(&num_entries), sizeof(num_entries));
+    file.read(magic, sizeof(magic));
+    if (!file || memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0) return false;
+
+    rIndex.resize(num_entries);
+    file.seekg(-(FOOTER_BYTES + std::streamoff(num_entries * sizeof(CellCycleTraceIndexEntry))), std::ios::end);
+    if (num_entries > 0)
+    {
+        file.read(reinterpret_cast<char*>(&rIndex[0]), num_entries * sizeof(CellCycleTraceIndexEntry));
+    }
+    return bool(file);
+}
+
+bool CellCycleTrace::ReadSeed(const std::string& rFullPath, const std::vector<CellCycleTraceIndexEntry>& rIndex,
+                              unsigned seed, std::vector<CellCycleTraceRecord>& rRecords)
+{
+    std::ifstream file(rFullPath.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    rRecords.clear();
+    for (unsigned i = 0; i < rIndex.size(); i++)
+    {
+        if (rIndex[i].mSeed != seed) continue;
+
+        unsigned first = rRecords.size();
+        rRecords.resize(first + rIndex[i].mNumRecords);
+        file.seekg(HEADER_BYTES + std::streamoff(rIndex[i].mFirstRecord * sizeof(CellCycleTraceRecord)), std::ios::beg);
+        file.read(reinterpret_cast<char*>(&rRecords[first]), rIndex[i].mNumRecords * sizeof(CellCycleTraceRecord));
+        if (!file) return false;
+    }
+    return true;
+}
@@ -0,0 +1,112 @@
+#ifndef CELLCYCLETRACE_HPP_
+#define CELLCYCLETRACE_HPP_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <stdint.h>
+
+/***********************************
+ * CELL CYCLE TRACE
+ * Low-overhead debug output shared by the He, Gomes, Boije and Wan stem cell cycle models.
+ * Replaces the per-seed ColumnDataWriter "DEBUG_<seed>" files.
+ *
+ * Each mitotic event is one fixed-size CellCycleTraceRecord, appended to a buffer.
+ * The buffer is flushed to a single binary file per run when full and at the end of every seed.
+ * Close() appends a seed index (seed -> runs of records), so one seed can be recovered without scanning the file.
+ *
+ * USE: the simulator calls Open(<directory>, <filename>) once per run, EndSeed() after every seed & Close() at the end.
+ * Cell cycle models call EnableModelDebugOutput(seed) and write their records with Record().
+ * The TraceConverter app rewrites a trace in the original per-seed ColumnDataWriter layout.
+ * Single-threaded, as the simulators: record only from the thread that opens & closes the trace.
+ *
+ * File layout: header (magic, record size), records, index entries, footer (number of index entries, magic)
+ ************************************/
+
+/**
+ * One mitotic event. Column meanings depend on the model, see CellCycleTrace::GetColumns().
+ */
+struct CellCycleTraceRecord
+{
+    double mTime;
+    double mValues[9];
+    uint32_t mSeed;
+    uint16_t mSetMask; //bit i is set if mValues[i] was written; unset columns are left out by the converter
+    uint8_t mModel;
+    uint8_t mPadding;
+
+    CellCycleTraceRecord(unsigned model = 0, unsigned seed = 0, double time = 0.0);
+
+    //Write value to column
+    void Put(unsigned column, double value);
+};
+
+/**
+ * Entry of the seed index written at the end of a trace file.
+ */
+struct CellCycleTraceIndexEntry
+{
+    uint32_t mSeed;
+    uint32_t mPadding;
+    uint64_t mFirstRecord;
+    uint64_t mNumRecords;
+};
+
+class CellCycleTrace
+{
+private:
+    static CellCycleTrace* mpInstance;
+
+    bool mOpen;
+    std::ofstream mFile;
+    uint64_t mRecordsWritten;
+    std::vector<CellCycleTraceIndexEntry> mIndex;
+    std::vector<CellCycleTraceRecord> mBuffer;
+
+    CellCycleTrace();
+
+    //Writes the buffer to file & extends the index
+    void WriteBuffer();
+
+public:
+    //Model identifiers stored in each record- Wan stem records share the He column layout
+    static const unsigned HE = 0;
+    static const unsigned GOMES = 1;
+    static const unsigned BOIJE = 2;
+    static const unsigned WAN = 3;
+
+    //Records held before the buffer is flushed to file
+    static const unsigned BUFFER_RECORDS = 4096;
+
+    static CellCycleTrace* Instance();
+    static void Destroy();
+
+    /**
+     * Open the trace file for this run. Relative to CHASTE_TEST_OUTPUT, as for LogFile & ColumnDataWriter.
+     */
+    void Open(const std::string& rDirectory, const std::string& rFilename);
+    bool IsOpen() const;
+
+    //Append a record to the buffer, flushing it if full
+    void Record(const CellCycleTraceRecord& rRecord);
+
+    //Flush the buffer; called by simulators after each seed
+    void EndSeed();
+
+    //Flush the buffer & write the seed index
+    void Close();
+
+    //(name, unit) of each column of a model's records, matching the old ColumnDataWriter variables
+    static std::vector<std::pair<std::string, std::string> > GetColumns(unsigned model);
+
+    /**
+     * Read the index & the records of one seed from a closed trace file (full path).
+     * Returns false if the file is missing or not a complete trace.
+     */
+    static bool ReadIndex(const std::string& rFullPath, std::vector<CellCycleTraceIndexEntry>& rIndex);
+    static bool ReadSeed(const std::string& rFullPath, const std::vector<CellCycleTraceIndexEntry>& rIndex,
+                         unsigned seed, std::vector<CellCycleTraceRecord>& rRecords);
+};
+
+#endif /*CELLCYCLETRACE_HPP_*/
@@ -1,25 +1,36 @@
 #include "GomesCellCycleModel.hpp"
 #include "GomesRetinalNeuralFates.hpp"
 
+std::vector<unsigned> GomesCellCycleModel::mLineageDecisionCounts(7, 0);
+
 GomesCellCycleModel::GomesCellCycleModel() :
         AbstractSimpleCellCycleModel(), mOutput(false), mEventStartTime(), mSequenceSampler(false), mSeqSamplerLabelSister(
-                false), mDebug(false), mTimeID(), mVarIDs(), mDebugWriter(), mNormalMu(3.9716), mNormalSigma(0.32839), mPP(
+                false), mPathOnly(false), mDebug(false), mLineageTree(false), mParentId(0), mCountDecisions(false), mNormalMu(3.9716), mNormalSigma(0.32839), mPP(
                 .055), mPD(0.221), mpBC(.128), mpAC(.106), mpMG(.028), mMitoticMode(), mSeed(), mp_PostMitoticType(), mp_RPh_Type(), mp_BC_Type(), mp_AC_Type(), mp_MG_Type(), mp_label_Type()
 {
 }
 
 GomesCellCycleModel::GomesCellCycleModel(const GomesCellCycleModel& rModel) :
         AbstractSimpleCellCycleModel(rModel), mOutput(rModel.mOutput), mEventStartTime(rModel.mEventStartTime), mSequenceSampler(
-                rModel.mSequenceSampler), mSeqSamplerLabelSister(rModel.mSeqSamplerLabelSister), mDebug(rModel.mDebug), mTimeID(
-                rModel.mTimeID), mVarIDs(rModel.mVarIDs), mDebugWriter(rModel.mDebugWriter), mNormalMu(
+                rModel.mSequenceSampler), mSeqSamplerLabelSister(rModel.mSeqSamplerLabelSister), mPathOnly(rModel.mPathOnly), mDebug(rModel.mDebug), mLineageTree(rModel.mLineageTree), mParentId(rModel.mParentId), mCountDecisions(rModel.mCountDecisions), mNormalMu(
                 rModel.mNormalMu), mNormalSigma(rModel.mNormalSigma), mPP(rModel.mPP), mPD(rModel.mPD), mpBC(
                 rModel.mpBC), mpAC(rModel.mpAC), mpMG(rModel.mpMG), mMitoticMode(rModel.mMitoticMode), mSeed(
                 rModel.mSeed), mp_PostMitoticType(rModel.mp_PostMitoticType), mp_RPh_Type(rModel.mp_RPh_Type), mp_BC_Type(
                 rModel.mp_BC_Type), mp_AC_Type(rModel.mp_AC_Type), mp_MG_Type(rModel.mp_MG_Type), mp_label_Type(
-                rModel.mp_label_Type)
+                rModel.mp_label_Type), mRandomStream(rModel.mRandomStream)
 {
 }
 
+void GomesCellCycleModel::CountFateDecision(double specificationRV)
+{
+    //in the order of the specification rules: MG, AC, BC, RPh
+    unsigned fate = 3;
+    if (specificationRV <= mpMG + mpAC + mpBC) fate = 2;
+    if (specificationRV <= mpMG + mpAC) fate = 1;
+    if (specificationRV <= mpMG) fate = 0;
+    mLineageDecisionCounts[3 + fate]++;
+}
+
 AbstractCellCycleModel* GomesCellCycleModel::CreateCellCycleModel()
 {
     return new GomesCellCycleModel(*this);
@@ -31,7 +42,7 @@ void GomesCellCycleModel::SetCellCycleDuration()
      * CELL CYCLE DURATION RANDOM VARIABLE
      *************************************/
 
-    RandomNumberGenerator* p_random_number_generator = RandomNumberGenerator::Instance();
+    const LineageRandomStream* p_random_number_generator = &mRandomStream;
 
     //Gomes cell cycle length determined by lognormal distribution with default mean 56 hr, std 18.9 hrs.
     mCellCycleDuration = exp(p_random_number_generator->NormalRandomDeviate(mNormalMu, mNormalSigma));
@@ -39,28 +50,21 @@ void GomesCellCycleModel::SetCellCycleDuration()
 
 void GomesCellCycleModel::ResetForDivision()
 {
+    //the daughter's model is copied from this one after ResetForDivision(), so it inherits the parent's ID
+    if (mLineageTree) mParentId = mpCell->GetCellId();
+
     /****************
      * Mitotic mode rules
      * *************/
-    RandomNumberGenerator* p_random_number_generator = RandomNumberGenerator::Instance();
-
-    //Check time in lineage and determine current mitotic mode phase
-    mMitoticMode = 0; //0=PP;1=PD;2=DD
+    const LineageRandomStream* p_random_number_generator = &mRandomStream;
 
     /******************************
      * MITOTIC MODE RANDOM VARIABLE
      ******************************/
     //initialise mitoticmode random variable, set mitotic mode appropriately after comparing to mode probability array
     double mitoticModeRV = p_random_number_generator->ranf();
-
-    if (mitoticModeRV > mPP && mitoticModeRV <= mPP + mPD)
-    {
-        mMitoticMode = 1;
-    }
-    if (mitoticModeRV > mPP + mPD)
-    {
-        mMitoticMode = 2;
-    }
+    mMitoticMode = LineageModelRules::GetMitoticMode(mitoticModeRV, mPP, mPD); //0=PP;1=PD;2=DD
+    if (mCountDecisions) mLineageDecisionCounts[mMitoticMode]++;
 
     /****************
      * Write mitotic event to file if appropriate
@@ -94,6 +98,7 @@ void GomesCellCycleModel::ResetForDivision()
          * SPECIFICATION RANDOM VARIABLE
          *****************************/
         double specificationRV = p_random_number_generator->ranf();
+        if (mCountDecisions) CountFateDecision(specificationRV);
         if (specificationRV <= mpMG)
         {
             mpCell->AddCellProperty(mp_MG_Type);
@@ -121,12 +126,13 @@ void GomesCellCycleModel::ResetForDivision()
     {
         if (mpCell->HasCellProperty<CellLabel>())
         {
-            (*LogFile::Instance()) << mMitoticMode;
+            LineageOutput::Instance()->rGetStream(LineageOutput::SEQUENCE, mSeed) << mMitoticMode;
             double labelRV = p_random_number_generator->ranf();
             if (labelRV <= .5)
             {
                 mSeqSamplerLabelSister = true;
                 mpCell->RemoveCellProperty<CellLabel>();
+                if (mPathOnly) mpCell->Kill(); //the label passes to the daughter; this cell's lineage is not sampled
             }
             else
             {
@@ -143,6 +149,11 @@ void GomesCellCycleModel::ResetForDivision()
 
 void GomesCellCycleModel::InitialiseDaughterCell()
 {
+    if (mLineageTree)
+    {
+        LineageTreeRecorder::Instance()->RecordDivision(mSeed, mParentId, mpCell->GetCellId(), mMitoticMode);
+    }
+
     if (mMitoticMode == 0)
     {
         //daughter cell's mCellCycleDuration is copied from parent; reset to new value from gamma PDF here
@@ -155,13 +166,14 @@ void GomesCellCycleModel::InitialiseDaughterCell()
 
     if (mMitoticMode == 1)
     {
-        RandomNumberGenerator* p_random_number_generator = RandomNumberGenerator::Instance();
+        const LineageRandomStream* p_random_number_generator = &mRandomStream;
         mpCell->SetCellProliferativeType(mp_PostMitoticType);
         mCellCycleDuration = DBL_MAX;
         /*********************
          * SPECIFICATION RULES
          ********************/
         double specificationRV = p_random_number_generator->ranf();
+        if (mCountDecisions) CountFateDecision(specificationRV);
         if (specificationRV <= mpMG)
         {
             mpCell->AddCellProperty(mp_MG_Type);
@@ -182,7 +194,7 @@ void GomesCellCycleModel::InitialiseDaughterCell()
 
     if (mMitoticMode == 2)
     {
-        RandomNumberGenerator* p_random_number_generator = RandomNumberGenerator::Instance();
+        const LineageRandomStream* p_random_number_generator = &mRandomStream;
         //remove the fate assigned to the parent cell in ResetForDivision, then assign the sister fate as usual
         mpCell->RemoveCellProperty<AbstractCellProperty>();
         mpCell->SetCellProliferativeType(mp_PostMitoticType);
@@ -191,6 +203,7 @@ void GomesCellCycleModel::InitialiseDaughterCell()
          * SPECIFICATION RULES
          ********************/
         double specificationRV = p_random_number_generator->ranf();
+        if (mCountDecisions) CountFateDecision(specificationRV);
         if (specificationRV <= mpMG)
         {
             mpCell->AddCellProperty(mp_MG_Type);
@@ -222,6 +235,7 @@ void GomesCellCycleModel::InitialiseDaughterCell()
         else
         {
             mpCell->RemoveCellProperty<CellLabel>();
+            if (mPathOnly) mpCell->Kill();
         }
     }
 }
@@ -268,45 +282,65 @@ void GomesCellCycleModel::WriteModeEventOutput()
     double currentTime = SimulationTime::Instance()->GetTime() + mEventStartTime;
     CellPtr currentCell = GetCell();
     double currentCellID = (double) currentCell->GetCellId();
-    (*LogFile::Instance()) << currentTime << "\t" << mSeed << "\t" << currentCellID << "\t" << mMitoticMode << "\n";
+    LineageOutput::Instance()->rGetStream(LineageOutput::EVENTS, mSeed) << currentTime << "\t" << mSeed << "\t" << currentCellID << "\t" << mMitoticMode << "\n";
 }
 
-void GomesCellCycleModel::EnableSequenceSampler(boost::shared_ptr<AbstractCellProperty> label)
+void GomesCellCycleModel::EnableSequenceSampler(boost::shared_ptr<AbstractCellProperty> label, unsigned seed)
 {
     mSequenceSampler = true;
     mp_label_Type = label;
+    mSeed = seed;
+}
+
+void GomesCellCycleModel::EnablePathOnlySampling()
+{
+    mPathOnly = true;
 }
 
-void GomesCellCycleModel::EnableModelDebugOutput(boost::shared_ptr<ColumnDataWriter> debugWriter)
+void GomesCellCycleModel::SetRandomStream(const LineageRandomStream& rStream)
+{
+    mRandomStream = rStream;
+}
+
+void GomesCellCycleModel::EnableModelDebugOutput(unsigned seed)
 {
     mDebug = true;
-    mDebugWriter = debugWriter;
+    mSeed = seed;
+}
+
+void GomesCellCycleModel::EnableLineageTreeRecorder(unsigned seed)
+{
+    mLineageTree = true;
+    mSeed = seed;
+}
 
-    mTimeID = mDebugWriter->DefineUnlimitedDimension("Time", "h");
-    mVarIDs.push_back(mDebugWriter->DefineVariable("CellID", "No"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("CycleDuration", "h"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("PP", "Percentile"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("PD", "Percentile"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("Dieroll", "Percentile"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("MitoticMode", "Mode"));
+void GomesCellCycleModel::EnableDecisionCounts()
+{
+    mCountDecisions = true;
+}
 
-    mDebugWriter->EndDefineMode();
+void GomesCellCycleModel::ResetDecisionCounts()
+{
+    mLineageDecisionCounts.assign(7, 0);
+}
+
+const std::vector<unsigned>& GomesCellCycleModel::rGetDecisionCounts()
+{
+    return mLineageDecisionCounts;
 }
 
 void GomesCellCycleModel::WriteDebugData(double percentileRoll)
 {
-    double currentTime = SimulationTime::Instance()->GetTime();
-    CellPtr currentCell = GetCell();
-    double currentCellID = (double) currentCell->GetCellId();
+    CellCycleTraceRecord record(CellCycleTrace::GOMES, mSeed, SimulationTime::Instance()->GetTime());
+
+    record.Put(0, GetCell()->GetCellId());
+    record.Put(1, mCellCycleDuration);
+    record.Put(2, mPP);
+    record.Put(3, mPD);
+    record.Put(4, percentileRoll);
+    record.Put(5, mMitoticMode);
 
-    mDebugWriter->PutVariable(mTimeID, currentTime);
-    mDebugWriter->PutVariable(mVarIDs[0], currentCellID);
-    mDebugWriter->PutVariable(mVarIDs[1], mCellCycleDuration);
-    mDebugWriter->PutVariable(mVarIDs[2], mPP);
-    mDebugWriter->PutVariable(mVarIDs[3], mPD);
-    mDebugWriter->PutVariable(mVarIDs[4], percentileRoll);
-    mDebugWriter->PutVariable(mVarIDs[5], mMitoticMode);
-    mDebugWriter->AdvanceAlongUnlimitedDimension();
+    CellCycleTrace::Instance()->Record(record);
 }
 
 /******************
@@ -1,9 +1,12 @@
 #include "HeCellCycleModel.hpp"
 
+std::vector<double> HeCellCycleModel::mLineageScore(6, 0.0);
+std::vector<unsigned> HeCellCycleModel::mLineageDecisionCounts(9, 0);
+
 HeCellCycleModel::HeCellCycleModel() :
         AbstractSimpleCellCycleModel(), mKillSpecified(false), mDeterministic(false), mOutput(false), mEventStartTime(
-                24.0), mSequenceSampler(false), mSeqSamplerLabelSister(false), mDebug(false), mTimeID(), mVarIDs(), mDebugWriter(), mTiLOffset(
-                0.0), mGammaShift(4.0), mGammaShape(2.0), mGammaScale(1.0), mSisterShiftWidth(1), mMitoticModePhase2(
+                24.0), mSequenceSampler(false), mSeqSamplerLabelSister(false), mPathOnly(false), mDebug(false), mLineageTree(false), mParentId(0), mCountDecisions(false), mScoreFunction(false), mTiLOffset(
+                0.0), mStartDelay(0.0), mGammaShift(LineageModelRules::HE_GAMMA_SHIFT), mGammaShape(LineageModelRules::HE_GAMMA_SHAPE), mGammaScale(LineageModelRules::HE_GAMMA_SCALE), mSisterShiftWidth(LineageModelRules::HE_SISTER_SHIFT), mMitoticModePhase2(
                 8.0), mMitoticModePhase3(15.0), mPhaseShiftWidth(2.0), mPhase1PP(1.0), mPhase1PD(0.0), mPhase2PP(0.2), mPhase2PD(
                 0.4), mPhase3PP(0.2), mPhase3PD(0.0), mMitoticMode(0), mSeed(0), mTimeDependentCycleDuration(false), mPeakRateTime(), mIncreasingRateSlope(), mDecreasingRateSlope(), mBaseGammaScale()
 {
@@ -13,9 +16,8 @@ HeCellCycleModel::HeCellCycleModel() :
 HeCellCycleModel::HeCellCycleModel(const HeCellCycleModel& rModel) :
         AbstractSimpleCellCycleModel(rModel), mKillSpecified(rModel.mKillSpecified), mDeterministic(
                 rModel.mDeterministic), mOutput(rModel.mOutput), mEventStartTime(rModel.mEventStartTime), mSequenceSampler(
-                rModel.mSequenceSampler), mSeqSamplerLabelSister(rModel.mSeqSamplerLabelSister), mDebug(rModel.mDebug), mTimeID(
-                rModel.mTimeID), mVarIDs(rModel.mVarIDs), mDebugWriter(rModel.mDebugWriter), mTiLOffset(
-                rModel.mTiLOffset), mGammaShift(rModel.mGammaShift), mGammaShape(rModel.mGammaShape), mGammaScale(
+                rModel.mSequenceSampler), mSeqSamplerLabelSister(rModel.mSeqSamplerLabelSister), mPathOnly(rModel.mPathOnly), mDebug(rModel.mDebug), mLineageTree(rModel.mLineageTree), mParentId(rModel.mParentId), mCountDecisions(rModel.mCountDecisions), mScoreFunction(rModel.mScoreFunction), mTiLOffset(
+                rModel.mTiLOffset), mStartDelay(rModel.mStartDelay), mGammaShift(rModel.mGammaShift), mGammaShape(rModel.mGammaShape), mGammaScale(
                 rModel.mGammaScale), mSisterShiftWidth(rModel.mSisterShiftWidth), mMitoticModePhase2(
                 rModel.mMitoticModePhase2), mMitoticModePhase3(rModel.mMitoticModePhase3), mPhaseShiftWidth(
                 rModel.mPhaseShiftWidth), mPhase1PP(rModel.mPhase1PP), mPhase1PD(rModel.mPhase1PD), mPhase2PP(
@@ -23,7 +25,7 @@ HeCellCycleModel::HeCellCycleModel(const HeCellCycleModel& rModel) :
                 rModel.mPhase3PD), mMitoticMode(rModel.mMitoticMode), mSeed(rModel.mSeed), mTimeDependentCycleDuration(
                 rModel.mTimeDependentCycleDuration), mPeakRateTime(rModel.mPeakRateTime), mIncreasingRateSlope(
                 rModel.mIncreasingRateSlope), mDecreasingRateSlope(rModel.mDecreasingRateSlope), mBaseGammaScale(
-                rModel.mBaseGammaScale)
+                rModel.mBaseGammaScale), mRandomStream(rModel.mRandomStream)
 {
 }
 
@@ -34,7 +36,7 @@ AbstractCellCycleModel* HeCellCycleModel::CreateCellCycleModel()
 
 void HeCellCycleModel::SetCellCycleDuration()
 {
-    RandomNumberGenerator* p_random_number_generator = RandomNumberGenerator::Instance();
+    const LineageRandomStream* p_random_number_generator = &mRandomStream;
 
     /**************************************
      * CELL CYCLE DURATION RANDOM VARIABLE
@@ -72,51 +74,40 @@ void HeCellCycleModel::SetCellCycleDuration()
 
 void HeCellCycleModel::ResetForDivision()
 {
+    //the daughter's model is copied from this one after ResetForDivision(), so it inherits the parent's ID
+    if (mLineageTree) mParentId = mpCell->GetCellId();
+
     /****************************************************
      * TIME IN LINEAGE DEPENDENT MITOTIC MODE PHASE RULES
      * **************************************************/
-    RandomNumberGenerator* p_random_number_generator = RandomNumberGenerator::Instance();
+    const LineageRandomStream* p_random_number_generator = &mRandomStream;
 
-    double currentTiL = SimulationTime::Instance()->GetTime() + mTiLOffset;
+    double currentTiL = SimulationTime::Instance()->GetTime() - mStartDelay + mTiLOffset;
 
-    /*Rule logic defaults to phase 1 behaviour, checks for currentTiL > phaseBoundaries and changes
-     currentPhase and subsequently mMitoticMode as appropriate*/
-    unsigned currentPhase = 1;
+    //Phase by time in lineage; mMitoticMode defaults to PP
+    unsigned currentPhase = LineageModelRules::GetHePhase(currentTiL, mMitoticModePhase2, mMitoticModePhase3);
     mMitoticMode = 0;
 
-    //Check time in lineage and determine current mitotic mode phase
     /**************
-     * Phase boundary & deterministic mitotic mode rules
+     * Deterministic mitotic mode rules
      **************/
-    if (currentTiL > mMitoticModePhase2 && currentTiL < mMitoticModePhase3)
+    if (mDeterministic && currentPhase == 2)
     {
-        //if current TiL is > phase 2 boundary time, set the currentPhase appropriately
-        currentPhase = 2;
-
-        //if deterministic mode is enabled, PD divisions are guaranteed unless this is an Ath5 morphant
-        if (mDeterministic)
+        //PD divisions are guaranteed unless this is an Ath5 morphant
+        mMitoticMode = 1; //0=PP;1=PD;2=DD
+        if (mpCell->HasCellProperty<Ath5Mo>()) //Ath5 morphants undergo PP rather than PD divisions in 80% of cases
         {
-            mMitoticMode = 1; //0=PP;1=PD;2=DD
-            if (mpCell->HasCellProperty<Ath5Mo>()) //Ath5 morphants undergo PP rather than PD divisions in 80% of cases
+            double ath5RV = p_random_number_generator->ranf();
+            if (ath5RV <= .8)
             {
-                double ath5RV = p_random_number_generator->ranf();
-                if (ath5RV <= .8)
-                {
-                    mMitoticMode = 0;
-                }
+                mMitoticMode = 0;
             }
         }
     }
-
-    if (currentTiL > mMitoticModePhase3)
+    if (mDeterministic && currentPhase == 3)
     {
-        //if current TiL is > phase 3 boundary time, set the currentPhase appropriately
-        currentPhase = 3;
-        if (mDeterministic)
-        {
-            //if deterministic mode is enabled, DD divisions are guaranteed
-            mMitoticMode = 2;
-        }
+        //DD divisions are guaranteed
+        mMitoticMode = 2;
     }
 
     /******************************
@@ -130,26 +121,44 @@ void HeCellCycleModel::ResetForDivision()
         //construct 3x2 matrix of mode probabilities arranged by phase
         double modeProbabilityMatrix[3][2] = { { mPhase1PP, mPhase1PD }, { mPhase2PP, mPhase2PD }, { mPhase3PP,
                                                                                                      mPhase3PD } };
+        double phasePP = modeProbabilityMatrix[currentPhase - 1][0];
+        double phasePD = modeProbabilityMatrix[currentPhase - 1][1];
+        unsigned drawnMode = LineageModelRules::GetMitoticMode(mitoticModeRV, phasePP, phasePD);
+
+        if (mCountDecisions)
+        {
+            //the drawn mode, before the Ath5 morphant's PD->PP switch (which does not depend on the phase probabilities)
+            mLineageDecisionCounts[3 * (currentPhase - 1) + drawnMode]++;
+        }
 
-        //if the RV is > currentPhasePP && <= currentPhasePD, change mMitoticMode from PP to PD
-        if (mitoticModeRV > modeProbabilityMatrix[currentPhase - 1][0]
-                && mitoticModeRV
-                        <= modeProbabilityMatrix[currentPhase - 1][0] + modeProbabilityMatrix[currentPhase - 1][1])
+        if (mScoreFunction)
         {
-            mMitoticMode = 1;
-            if (mpCell->HasCellProperty<Ath5Mo>()) //Ath5 morphants undergo PP rather than PD divisions in 80% of cases
+            //d log P/d pPP & d pPD of the drawn mode: PP = pPP, PD = pPD, DD = 1 - pPP - pPD
+            unsigned index = 2 * (currentPhase - 1);
+            if (drawnMode == 0)
+            {
+                mLineageScore[index] += 1.0 / phasePP;
+            }
+            else if (drawnMode == 1)
+            {
+                mLineageScore[index + 1] += 1.0 / phasePD;
+            }
+            else
             {
-                double ath5RV = p_random_number_generator->ranf();
-                if (ath5RV <= .8)
-                {
-                    mMitoticMode = 0;
-                }
+                mLineageScore[index] -= 1.0 / (1.0 - phasePP - phasePD);
+                mLineageScore[index + 1] -= 1.0 / (1.0 - phasePP - phasePD);
             }
         }
-        //if the RV is > currentPhasePP + currentPhasePD, change mMitoticMode from PP to DD
-        if (mitoticModeRV > modeProbabilityMatrix[currentPhase - 1][0] + modeProbabilityMatrix[currentPhase - 1][1])
+
+        mMitoticMode = drawnMode;
+        if (mMitoticMode == 1 && mpCell->HasCellProperty<Ath5Mo>())
         {
-            mMitoticMode = 2;
+            //Ath5 morphants undergo PP rather than PD divisions in 80% of cases
+            double ath5RV = p_random_number_generator->ranf();
+            if (ath5RV <= .8)
+            {
+                mMitoticMode = 0;
+            }
         }
     }
 
@@ -195,12 +204,13 @@ void HeCellCycleModel::ResetForDivision()
     {
         if (mpCell->HasCellProperty<CellLabel>())
         {
-            (*LogFile::Instance()) << mMitoticMode;
+            LineageOutput::Instance()->rGetStream(LineageOutput::SEQUENCE, mSeed) << mMitoticMode;
             double labelRV = p_random_number_generator->ranf();
             if (labelRV <= .5)
             {
                 mSeqSamplerLabelSister = true;
                 mpCell->RemoveCellProperty<CellLabel>();
+                if (mPathOnly) mpCell->Kill(); //the label passes to the daughter; this cell's lineage is not sampled
             }
             else
             {
@@ -236,7 +246,7 @@ void HeCellCycleModel::Initialise()
     {
         mReadyToDivide = false;
 
-        RandomNumberGenerator* p_random_number_generator = RandomNumberGenerator::Instance();
+        const LineageRandomStream* p_random_number_generator = &mRandomStream;
 
         /**
          * This calculation "runs time forward" by subtracting appropriately generated cell lengths from TiLOffset
@@ -253,11 +263,22 @@ void HeCellCycleModel::Initialise()
                 + c;
     }
 
+    //packed founders wait out their start delay: a founder ready at once divides at the delay, others a delay later
+    if (mStartDelay > 0.0)
+    {
+        mCellCycleDuration = mReadyToDivide ? mStartDelay : mCellCycleDuration + mStartDelay;
+        mReadyToDivide = false;
+    }
 }
 
 void HeCellCycleModel::InitialiseDaughterCell()
 {
-    RandomNumberGenerator* p_random_number_generator = RandomNumberGenerator::Instance();
+    if (mLineageTree)
+    {
+        LineageTreeRecorder::Instance()->RecordDivision(mSeed, mParentId, mpCell->GetCellId(), mMitoticMode);
+    }
+
+    const LineageRandomStream* p_random_number_generator = &mRandomStream;
 
     /************
      * PD-type division & shifted sister cycle length & boundary adjustments
@@ -307,6 +328,7 @@ void HeCellCycleModel::InitialiseDaughterCell()
         else
         {
             mpCell->RemoveCellProperty<CellLabel>();
+            if (mPathOnly) mpCell->Kill();
         }
     }
 
@@ -333,6 +355,20 @@ void HeCellCycleModel::SetModelParameters(double tiLOffset, double mitoticModePh
     mSisterShiftWidth = sisterShift;
 }
 
+void HeCellCycleModel::SetMitoticModeParameters(double mitoticModePhase2, double mitoticModePhase3, double phase1PP,
+                                                double phase1PD, double phase2PP, double phase2PD, double phase3PP,
+                                                double phase3PD)
+{
+    mMitoticModePhase2 = mitoticModePhase2;
+    mMitoticModePhase3 = mitoticModePhase3;
+    mPhase1PP = phase1PP;
+    mPhase1PD = phase1PD;
+    mPhase2PP = phase2PP;
+    mPhase2PD = phase2PD;
+    mPhase3PP = phase3PP;
+    mPhase3PD = phase3PD;
+}
+
 void HeCellCycleModel::SetDeterministicMode(double tiLOffset, double mitoticModePhase2, double mitoticModePhase3,
                                             double phaseShiftWidth, double gammaShift, double gammaShape,
                                             double gammaScale, double sisterShift)
@@ -358,6 +394,11 @@ void HeCellCycleModel::SetTimeDependentCycleDuration(double peakRateTime, double
     mBaseGammaScale = mGammaScale;
 }
 
+void HeCellCycleModel::SetStartDelay(double delay)
+{
+    mStartDelay = delay;
+}
+
 void HeCellCycleModel::EnableKillSpecified()
 {
     mKillSpecified = true;
@@ -375,70 +416,89 @@ void HeCellCycleModel::WriteModeEventOutput()
     double currentTime = SimulationTime::Instance()->GetTime() + mEventStartTime;
     CellPtr currentCell = GetCell();
     double currentCellID = (double) currentCell->GetCellId();
-    (*LogFile::Instance()) << currentTime << "\t" << mSeed << "\t" << currentCellID << "\t" << mMitoticMode << "\n";
+    LineageOutput::Instance()->rGetStream(LineageOutput::EVENTS, mSeed) << currentTime << "\t" << mSeed << "\t" << currentCellID << "\t" << mMitoticMode << "\n";
 }
 
-void HeCellCycleModel::EnableSequenceSampler()
+//The founder's CellLabel is added by the simulator; the model has no cell yet when this is called
+void HeCellCycleModel::EnableSequenceSampler(unsigned seed)
 {
     mSequenceSampler = true;
-    boost::shared_ptr<AbstractCellProperty> p_label_type =
-            mpCell->rGetCellPropertyCollection().GetCellPropertyRegistry()->Get<CellLabel>();
-    mpCell->AddCellProperty(p_label_type);
+    mSeed = seed;
 }
 
-void HeCellCycleModel::PassDebugWriter(boost::shared_ptr<ColumnDataWriter> debugWriter, int timeID,
-                                       std::vector<int> varIDs)
+void HeCellCycleModel::EnablePathOnlySampling()
 {
-    mDebug = true;
-    mDebugWriter = debugWriter;
-    mTimeID = timeID;
-    mVarIDs = varIDs;
+    mPathOnly = true;
+}
+
+void HeCellCycleModel::SetRandomStream(const LineageRandomStream& rStream)
+{
+    mRandomStream = rStream;
 }
 
-void HeCellCycleModel::EnableModelDebugOutput(boost::shared_ptr<ColumnDataWriter> debugWriter)
+void HeCellCycleModel::EnableModelDebugOutput(unsigned seed)
 {
     mDebug = true;
-    mDebugWriter = debugWriter;
+    mSeed = seed;
+}
 
-    mTimeID = mDebugWriter->DefineUnlimitedDimension("Time", "h");
+void HeCellCycleModel::EnableLineageTreeRecorder(unsigned seed)
+{
+    mLineageTree = true;
+    mSeed = seed;
+}
 
-    mVarIDs.push_back(mDebugWriter->DefineVariable("CellID", "No"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("TiL", "h"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("CycleDuration", "h"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("Phase2Boundary", "h"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("Phase3Boundary", "h"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("Phase", "No"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("MitoticModeRV", "Percentile"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("MitoticMode", "Mode"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("Label", "binary"));
+void HeCellCycleModel::EnableDecisionCounts()
+{
+    mCountDecisions = true;
+}
+
+void HeCellCycleModel::ResetDecisionCounts()
+{
+    mLineageDecisionCounts.assign(9, 0);
+}
 
-    mDebugWriter->EndDefineMode();
+const std::vector<unsigned>& HeCellCycleModel::rGetDecisionCounts()
+{
+    return mLineageDecisionCounts;
+}
+
+void HeCellCycleModel::EnableScoreFunction()
+{
+    mScoreFunction = true;
+}
+
+void HeCellCycleModel::ResetLineageScore()
+{
+    mLineageScore.assign(6, 0.0);
+}
+
+const std::vector<double>& HeCellCycleModel::rGetLineageScore()
+{
+    return mLineageScore;
 }
 
 void HeCellCycleModel::WriteDebugData(double currentTiL, unsigned phase, double mitoticModeRV)
 {
-    double currentTime = SimulationTime::Instance()->GetTime();
-    double currentCellID = mpCell->GetCellId();
-    unsigned label = 0;
-    if (mpCell->HasCellProperty<CellLabel>()) label = 1;
-
-    mDebugWriter->PutVariable(mTimeID, currentTime);
-    mDebugWriter->PutVariable(mVarIDs[0], currentCellID);
-    mDebugWriter->PutVariable(mVarIDs[1], currentTiL);
-    mDebugWriter->PutVariable(mVarIDs[2], mCellCycleDuration);
-    mDebugWriter->PutVariable(mVarIDs[3], mMitoticModePhase2);
-    mDebugWriter->PutVariable(mVarIDs[4], mMitoticModePhase3);
-    mDebugWriter->PutVariable(mVarIDs[5], phase);
+    CellCycleTraceRecord record(CellCycleTrace::HE, mSeed, SimulationTime::Instance()->GetTime());
+
+    record.Put(0, mpCell->GetCellId());
+    record.Put(1, currentTiL);
+    record.Put(2, mCellCycleDuration);
+    record.Put(3, mMitoticModePhase2);
+    record.Put(4, mMitoticModePhase3);
+    record.Put(5, phase);
     if (!mDeterministic)
     {
-        mDebugWriter->PutVariable(mVarIDs[6], mitoticModeRV);
+        record.Put(6, mitoticModeRV);
     }
-    mDebugWriter->PutVariable(mVarIDs[7], mMitoticMode);
+    record.Put(7, mMitoticMode);
     if (mSequenceSampler)
     {
-        mDebugWriter->PutVariable(mVarIDs[8], label);
+        record.Put(8, mpCell->HasCellProperty<CellLabel>() ? 1 : 0);
     }
-    mDebugWriter->AdvanceAlongUnlimitedDimension();
+
+    CellCycleTrace::Instance()->Record(record);
 }
 
 /******************
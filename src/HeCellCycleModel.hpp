@@ -7,10 +7,13 @@
 #include "TransitCellProliferativeType.hpp"
 #include "DifferentiatedCellProliferativeType.hpp"
 #include "SmartPointers.hpp"
-#include "ColumnDataWriter.hpp"
-#include "LogFile.hpp"
+#include "CellCycleTrace.hpp"
+#include "LineageOutput.hpp"
+#include "LineageTreeRecorder.hpp"
+#include "LineageRandomStream.hpp"
 #include "CellLabel.hpp"
 #include "HeAth5Mo.hpp"
+#include "LineageModelRules.hpp"
 
 /***********************************
  * HE CELL CYCLE MODEL
@@ -26,13 +29,18 @@
  * Enable deterministic model alternative with EnableDeterministicMode(<params>);
  *
  * 2 per-model-event output modes:
- * EnableModeEventOutput() enables mitotic mode event logging-all cells will write to the singleton log file
- * EnableModelDebugOutput() enables more detailed debug output, each seed will have its own file written to
- * by a ColumnDataWriter passed to it from the test
- * (eg. by the SetupDebugOutput helper function in the project simulator)
+ * EnableModeEventOutput() enables mitotic mode event logging-all cells will write to the LineageOutput events sink
+ * EnableModelDebugOutput() enables more detailed debug output, written to the singleton CellCycleTrace
+ * (opened once per run by the project simulator; convert to per-seed files with TraceConverter)
  *
  * 1 mitotic-event-sequence sampler (only samples one "path" through the lineage):
- * EnableSequenceSampler() - one "sequence" of progenitors writes mitotic event type to a string in the singleton log file
+ * EnableSequenceSampler() - one "sequence" of progenitors writes mitotic event type to a string in the LineageOutput sequence sink
+ * EnablePathOnlySampling() - with the sampler, the unlabelled cell of each labelled division is killed at once,
+ * so only the labelled path is simulated (sequence output only- counts, events etc. would see the pruned lineage)
+ *
+ * 1 whole-lineage recorder:
+ * EnableLineageTreeRecorder() - every division (parent, daughter, timestep, mode) goes to the singleton LineageTreeRecorder;
+ * query all paths, clone sizes & sampled paths from its archive with LineageTreeQuery
  *
  ************************************/
 
@@ -59,6 +67,41 @@ private:
                 RandomNumberGenerator::Instance()->GetSerializationWrapper();
         archive & p_wrapper;
         archive & mCellCycleDuration;
+        //mode switches & parameters, so a checkpointed lineage resumes as it was (see WanSimulator --checkpoint-interval)
+        archive & mKillSpecified;
+        archive & mDeterministic;
+        archive & mOutput;
+        archive & mEventStartTime;
+        archive & mSequenceSampler;
+        archive & mSeqSamplerLabelSister;
+        archive & mPathOnly;
+        archive & mDebug;
+        archive & mLineageTree;
+        archive & mParentId;
+        archive & mScoreFunction;
+        archive & mCountDecisions;
+        archive & mTiLOffset;
+        archive & mGammaShift;
+        archive & mGammaShape;
+        archive & mGammaScale;
+        archive & mSisterShiftWidth;
+        archive & mMitoticModePhase2;
+        archive & mMitoticModePhase3;
+        archive & mPhaseShiftWidth;
+        archive & mPhase1PP;
+        archive & mPhase1PD;
+        archive & mPhase2PP;
+        archive & mPhase2PD;
+        archive & mPhase3PP;
+        archive & mPhase3PD;
+        archive & mMitoticMode;
+        archive & mSeed;
+        archive & mTimeDependentCycleDuration;
+        archive & mPeakRateTime;
+        archive & mIncreasingRateSlope;
+        archive & mDecreasingRateSlope;
+        archive & mBaseGammaScale;
+        archive & mStartDelay;
     }
 
     //Private write functions for models
@@ -73,13 +116,19 @@ protected:
     double mEventStartTime;
     bool mSequenceSampler;
     bool mSeqSamplerLabelSister;
-    //debug writer stuff
+    bool mPathOnly; //sampler kills unlabelled cells at division
+    //debug trace switch
     bool mDebug;
-    int mTimeID;
-    std::vector<int> mVarIDs;
-    boost::shared_ptr<ColumnDataWriter> mDebugWriter;
+    //lineage tree recorder switch; mParentId carries the dividing cell's ID to its daughter's model
+    bool mLineageTree;
+    unsigned mParentId;
+    //decision statistics switch, see EnableDecisionCounts()
+    bool mCountDecisions;
+    //score function switch: each stochastic mode draw adds its d log P(mode)/d(pPP, pPD) to mLineageScore
+    bool mScoreFunction;
     //model parameters and state memory vars
     double mTiLOffset;
+    double mStartDelay; //simulation time before the founder's lineage begins, see SetStartDelay()
     double mGammaShift;
     double mGammaShape;
     double mGammaScale;
@@ -100,6 +149,7 @@ protected:
     double mIncreasingRateSlope;
     double mDecreasingRateSlope;
     double mBaseGammaScale;
+    LineageRandomStream mRandomStream; //the lineage's draws, see SetRandomStream()
 
     /**
      * Protected copy-constructor for use by CreateCellCycleModel().
@@ -117,6 +167,12 @@ protected:
      */
     HeCellCycleModel(const HeCellCycleModel& rModel);
 
+    //Decision counts of the current lineage, see EnableDecisionCounts()
+    static std::vector<unsigned> mLineageDecisionCounts;
+
+    //Score of the current lineage, see EnableScoreFunction()
+    static std::vector<double> mLineageScore;
+
 public:
 
     /**
@@ -165,27 +221,64 @@ public:
      */
     void SetModelParameters(double tiLOffset = 0, double mitoticModePhase2 = 8, double mitoticModePhase3 = 15,
                             double phase1PP = 1, double phase1PD = 0, double phase2PP = .2, double phase2PD = .4,
-                            double phase3PP = .2, double phase3PD = 0, double gammaShift = 4, double gammaShape = 2,
-                            double gammaScale = 1, double sisterShift = 1);
+                            double phase3PP = .2, double phase3PD = 0,
+                            double gammaShift = LineageModelRules::HE_GAMMA_SHIFT,
+                            double gammaShape = LineageModelRules::HE_GAMMA_SHAPE,
+                            double gammaScale = LineageModelRules::HE_GAMMA_SCALE,
+                            double sisterShift = LineageModelRules::HE_SISTER_SHIFT);
     void SetDeterministicMode(double tiLOffset = 0, double mitoticModePhase2 = 8, double mitoticModePhase3 = 15,
-                              double phaseShiftWidth = 1, double gammaShift = 4, double gammaShape = 2,
-                              double gammaScale = 1, double sisterShift = 1);
+                              double phaseShiftWidth = 1, double gammaShift = LineageModelRules::HE_GAMMA_SHIFT,
+                              double gammaShape = LineageModelRules::HE_GAMMA_SHAPE,
+                              double gammaScale = LineageModelRules::HE_GAMMA_SCALE,
+                              double sisterShift = LineageModelRules::HE_SISTER_SHIFT);
+    //Change the mitotic mode parameters of a running model (eg. a SimulationSnapshot's restored cells), leaving its TiL offset
+    void SetMitoticModeParameters(double mitoticModePhase2, double mitoticModePhase3, double phase1PP, double phase1PD,
+                                  double phase2PP, double phase2PD, double phase3PP, double phase3PD);
     void SetTimeDependentCycleDuration(double peakRateTime, double increasingSlope, double decreasingSlope);
 
+    //Founder of a packed run (--pack): its lineage begins delay h into the shared simulation, so its first division
+    //& its TiL are shifted by the delay; inherited by its descendants. Call before InitialiseCellCycleModel()
+    void SetStartDelay(double delay);
+
+    //Founder of a packed run (--pack): draw from this stream, seeded with the founder's seed, instead of the
+    //RandomNumberGenerator singleton; inherited by its descendants. Call before InitialiseCellCycleModel()
+    void SetRandomStream(const LineageRandomStream& rStream);
+
     //Function to set mKillSpecified = true; marks specified neurons for death and removal from population
     //Intended to help w/ resource consumption for WanSimulator
     void EnableKillSpecified();
 
     //Functions to enable per-cell mitotic mode logging for mode rate & sequence sampling fixtures
-    //Uses singleton logfile
+    //Uses singleton LineageOutput; output is buffered under the seed until the simulator commits it
     void EnableModeEventOutput(double eventStart, unsigned seed);
-    void EnableSequenceSampler();
+    void EnableSequenceSampler(unsigned seed);
+    void EnablePathOnlySampling();
+
+    //More detailed debug output. Records go to the singleton CellCycleTrace, which must be Open()ed by the simulator
+    //Records are tagged with seed
+    void EnableModelDebugOutput(unsigned seed);
 
-    //More detailed debug output. Needs a ColumnDataWriter passed to it
-    //Only declare ColumnDataWriter directory, filename, etc; do not set up otherwise
-    //Use PassDebugWriter if the writer is already enabled elsewhere (ie. in a Wan stem cell cycle model)
-    void EnableModelDebugOutput(boost::shared_ptr<ColumnDataWriter> debugWriter);
-    void PassDebugWriter(boost::shared_ptr<ColumnDataWriter> debugWriter, int timeID, std::vector<int> varIDs);
+    //Whole division tree output. Divisions go to the singleton LineageTreeRecorder, which must be Open()ed by the simulator
+    void EnableLineageTreeRecorder(unsigned seed);
+
+    /**
+     * Decision sufficient statistics, stochastic mode only: each mode draw counts its phase & mode (PP1, PD1, DD1, ... DD3)
+     * in counts shared by all the process's He models; the simulator resets them before each lineage & reads them after.
+     * The lineage's likelihood under any phase probabilities follows from them, for importance reweighting.
+     */
+    void EnableDecisionCounts();
+    static void ResetDecisionCounts();
+    static const std::vector<unsigned>& rGetDecisionCounts();
+
+    /**
+     * Likelihood-ratio (score function) gradient output, stochastic mode only. Each mode draw adds d log P(mode)/d theta
+     * for theta = (pPP1, pPD1, pPP2, pPD2, pPP3, pPD3) to a lineage score shared by all the process's He models;
+     * the simulator resets it before each lineage & reads it after. E[f(lineage) * score] is the gradient of E[f(lineage)].
+     * The Ath5 morphant's PD->PP switch does not depend on theta, so adds nothing.
+     */
+    void EnableScoreFunction();
+    static void ResetLineageScore();
+    static const std::vector<double>& rGetLineageScore();
 
     //Not used, but must be overwritten lest HeCellCycleModels be abstract
     double GetAverageTransitCellCycleTime();
@@ -0,0 +1,330 @@
+#include "LineageBatch.hpp"
+#include "ModelLineage.hpp"
+#include "LineageModelRules.hpp"
+#include "Exception.hpp"
+
+#include <boost/random/gamma_distribution.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_01.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+const int32_t LineageBatch::NEVER = std::numeric_limits<int32_t>::max();
+
+LineageBatch::LineageBatch(const std::string& rModel)
+    : mModel(0),
+      mHasRun(false)
+{
+    if (!ModelLineage::IsLineageModel(rModel))
+    {
+        EXCEPTION("LineageBatch runs He, Gomes or Boije lineages, not " + rModel);
+    }
+    mModel = (rModel == "He") ? 0 : ((rModel == "Gomes") ? 1 : 2);
+}
+
+unsigned LineageBatch::AddLineage(const std::vector<double>& rTheta, unsigned seed)
+{
+    static const char* MODELS[3] = { "He", "Gomes", "Boije" };
+    if (mHasRun)
+    {
+        EXCEPTION("LineageBatch lineages must all be added before Run()");
+    }
+    if (rTheta.size() != ModelLineage::GetParameterNames(MODELS[mModel]).size())
+    {
+        EXCEPTION("LineageBatch::AddLineage needs one parameter per " + std::string(MODELS[mModel]) + " parameter name");
+    }
+
+    unsigned lineage = mTheta.size();
+    mTheta.push_back(rTheta);
+    mGenerators.push_back(boost::random::mt19937(seed));
+    boost::random::mt19937& r_gen = mGenerators.back();
+    boost::random::uniform_01<double> uniform;
+
+    //founder setup as ModelLineage: lineage start & TiL offset (He), simulated time & timestep
+    double tiLOffset = 0.0;
+    double simEndTime, dt;
+    if (mModel == 0)
+    {
+        double inductionTime = rTheta[0];
+        double lineageStartTime = (uniform(r_gen) * (rTheta[2] - rTheta[1])) + rTheta[1];
+        simEndTime = rTheta[3] - lineageStartTime;
+        if (lineageStartTime < inductionTime)
+        {
+            tiLOffset = inductionTime - lineageStartTime;
+            simEndTime = rTheta[3] - inductionTime;
+        }
+        dt = LineageModelRules::HE_DT;
+    }
+    else
+    {
+        simEndTime = rTheta[0];
+        dt = (mModel == 1) ? LineageModelRules::GOMES_DT : LineageModelRules::BOIJE_DT;
+    }
+
+    //AbstractCellBasedSimulation rounds the run to a whole number of steps & stretches dt to fit
+    int32_t numSteps = int32_t(simEndTime / dt + 0.5);
+    mDt.push_back(numSteps > 0 ? simEndTime / numSteps : dt);
+    mLastStep.push_back(numSteps);
+    mTiLOffset.push_back(tiLOffset);
+    mCount.push_back(1);
+    mNumMitotic.push_back(1);
+
+    //founder's first division
+    if (mModel == 0)
+    {
+        boost::random::gamma_distribution<double> gamma(LineageModelRules::HE_GAMMA_SHAPE,
+                                                    LineageModelRules::HE_GAMMA_SCALE);
+        if (tiLOffset > 0.0)
+        {
+            //HeCellCycleModel::Initialise(): run time forward through the TiL offset to the current cycle's remainder
+            double c = tiLOffset;
+            while (c > 0)
+            {
+                c = c - (LineageModelRules::HE_GAMMA_SHIFT + gamma(r_gen));
+            }
+            double duration = (LineageModelRules::HE_GAMMA_SHIFT + gamma(r_gen)) + c;
+            AddCell(lineage, GetDivisionStep(lineage, 0, duration), true, 0);
+        }
+        else
+        {
+            //the He founder is ready to divide at once, so divides at the first step it has any age
+            AddCell(lineage, GetDivisionStep(lineage, 0, 0.0), true, 0);
+        }
+    }
+    else if (mModel == 1)
+    {
+        boost::random::normal_distribution<double> normal(rTheta[1], rTheta[2]);
+        double duration = exp(normal(r_gen));
+        AddCell(lineage, GetDivisionStep(lineage, 0, duration), true, 0);
+    }
+    else
+    {
+        AddCell(lineage, GetDivisionStep(lineage, 0, 1.0), true, 0);
+    }
+
+    return lineage;
+}
+
+int32_t LineageBatch::GetDivisionStep(unsigned lineage, int32_t birthStep, double duration) const
+{
+    double dt = mDt[lineage];
+    if (duration > (mLastStep[lineage] - birthStep + 1) * dt)
+    {
+        return NEVER;
+    }
+
+    //ReadyToDivide() at step k when k*dt - birth time >= duration, & DoCellBirth() skips cells of age 0;
+    //the estimate is corrected for rounding
+    double birthTime = birthStep * dt;
+    int32_t step = birthStep + std::max(1, int32_t(std::ceil(duration / dt)) - 1);
+    while (step * dt - birthTime < duration)
+    {
+        step++;
+    }
+    while (step > birthStep + 1 && (step - 1) * dt - birthTime >= duration)
+    {
+        step--;
+    }
+    return (step > mLastStep[lineage]) ? NEVER : step;
+}
+
+void LineageBatch::AddCell(unsigned lineage, int32_t divisionStep, bool mitotic, unsigned generation)
+{
+    if (divisionStep == NEVER) return;
+    mDivisionStep.push_back(divisionStep);
+    mLineage.push_back(lineage);
+    mMitotic.push_back(mitotic);
+    mGeneration.push_back(generation);
+}
+
+bool LineageBatch::DivideHe(unsigned i, int32_t step)
+{
+    unsigned lineage = mLineage[i];
+    const std::vector<double>& r_theta = mTheta[lineage];
+    boost::random::mt19937& r_gen = mGenerators[lineage];
+    boost::random::uniform_01<double> uniform;
+    boost::random::gamma_distribution<double> gamma(LineageModelRules::HE_GAMMA_SHAPE,
+                                                    LineageModelRules::HE_GAMMA_SCALE);
+
+    //HeCellCycleModel::ResetForDivision(): phase by TiL, mode by the phase's probabilities, new parent duration
+    double currentTiL = step * mDt[lineage] + mTiLOffset[lineage];
+    unsigned phase = LineageModelRules::GetHePhase(currentTiL, r_theta[4], r_theta[4] + r_theta[5]);
+    unsigned mode = LineageModelRules::GetMitoticMode(uniform(r_gen), r_theta[6 + 2 * (phase - 1)],
+                                                      r_theta[7 + 2 * (phase - 1)]);
+    mCount[lineage]++;
+
+    if (mode == 2)
+    {
+        //DD: parent & daughter post-mitotic
+        mNumMitotic[lineage]--;
+        return false;
+    }
+
+    double duration = LineageModelRules::HE_GAMMA_SHIFT + gamma(r_gen);
+    if (mode == 0)
+    {
+        //PP: the daughter's copied duration gets a sister shift, respecting the refractory period
+        boost::random::normal_distribution<double> normal(0, LineageModelRules::HE_SISTER_SHIFT);
+        double sisterDuration = std::max(LineageModelRules::HE_GAMMA_SHIFT, duration + normal(r_gen));
+        mNumMitotic[lineage]++;
+        AddCell(lineage, GetDivisionStep(lineage, step, sisterDuration), true, 0);
+    }
+
+    mDivisionStep[i] = GetDivisionStep(lineage, step, duration);
+    return mDivisionStep[i] != NEVER;
+}
+
+bool LineageBatch::DivideGomes(unsigned i, int32_t step)
+{
+    unsigned lineage = mLineage[i];
+    const std::vector<double>& r_theta = mTheta[lineage];
+    boost::random::mt19937& r_gen = mGenerators[lineage];
+    boost::random::uniform_01<double> uniform;
+    boost::random::normal_distribution<double> normal(r_theta[1], r_theta[2]);
+
+    //GomesCellCycleModel: fixed mode probabilities, lognormal durations; fate draws do not change counts
+    unsigned mode = LineageModelRules::GetMitoticMode(uniform(r_gen), r_theta[3], r_theta[4]);
+    mCount[lineage]++;
+
+    if (mode == 2)
+    {
+        mNumMitotic[lineage]--;
+        return false;
+    }
+
+    double duration = exp(normal(r_gen));
+    if (mode == 0)
+    {
+        //PP: the daughter draws its own duration
+        double daughterDuration = exp(normal(r_gen));
+        mNumMitotic[lineage]++;
+        AddCell(lineage, GetDivisionStep(lineage, step, daughterDuration), true, 0);
+    }
+
+    mDivisionStep[i] = GetDivisionStep(lineage, step, duration);
+    return mDivisionStep[i] != NEVER;
+}
+
+bool LineageBatch::DivideBoije(unsigned i, int32_t step)
+{
+    unsigned lineage = mLineage[i];
+    const std::vector<double>& r_theta = mTheta[lineage];
+    boost::random::mt19937& r_gen = mGenerators[lineage];
+    boost::random::uniform_01<double> uniform;
+
+    //BoijeCellCycleModel::ResetForDivision(): generation, phase & transcription factor signals
+    unsigned generation = mGeneration[i] + 1;
+    unsigned phase = LineageModelRules::GetBoijePhase(generation, unsigned(r_theta[1]), unsigned(r_theta[2]));
+    bool atoh7 = false, ptf1a = false, ng = false;
+    if (phase == 2)
+    {
+        atoh7 = uniform(r_gen) < r_theta[3];
+        ptf1a = uniform(r_gen) < r_theta[4];
+        ng = uniform(r_gen) < r_theta[5];
+    }
+    if (phase == 3)
+    {
+        ng = uniform(r_gen) < r_theta[5];
+    }
+    mCount[lineage]++;
+
+    //DD: the parent is post-mitotic & its cycle never ends
+    bool parentMitotic = mMitotic[i] && LineageModelRules::GetBoijeMode(atoh7, ptf1a, ng) != 2;
+    if (mMitotic[i] && !parentMitotic)
+    {
+        mNumMitotic[lineage]--;
+    }
+    if (!parentMitotic)
+    {
+        //the daughter copies the post-mitotic type & infinite duration
+        return false;
+    }
+
+    //The daughter copies the parent's 1 generation cycle; atoh7 (PD) makes it post-mitotic without resetting it, &
+    //AbstractSimpleCellCycleModel divides on age alone, so the post-mitotic daughter divides once more
+    if (!atoh7)
+    {
+        mNumMitotic[lineage]++;
+    }
+    AddCell(lineage, GetDivisionStep(lineage, step, 1.0), !atoh7, generation);
+
+    mGeneration[i] = generation;
+    mDivisionStep[i] = GetDivisionStep(lineage, step, 1.0);
+    return mDivisionStep[i] != NEVER;
+}
+
+void LineageBatch::Run()
+{
+    mHasRun = true;
+
+    std::vector<unsigned> due;
+    std::vector<unsigned> retired;
+    while (true)
+    {
+        //earliest division step pending anywhere in the batch
+        int32_t step = NEVER;
+        const int32_t* p_steps = mDivisionStep.data();
+        unsigned numCells = mDivisionStep.size();
+        for (unsigned i = 0; i < numCells; i++)
+        {
+            step = std::min(step, p_steps[i]);
+        }
+        if (step == NEVER) break;
+
+        //the cells due at it; daughters are appended behind them & divide at later steps
+        due.clear();
+        for (unsigned i = 0; i < numCells; i++)
+        {
+            if (p_steps[i] == step) due.push_back(i);
+        }
+
+        retired.clear();
+        for (unsigned j = 0; j < due.size(); j++)
+        {
+            unsigned i = due[j];
+            unsigned lineage = mLineage[i];
+            bool pending = false;
+            if (step <= mLastStep[lineage])
+            {
+                if (mModel == 0) pending = DivideHe(i, step);
+                else if (mModel == 1) pending = DivideGomes(i, step);
+                else pending = DivideBoije(i, step);
+
+                //OffLatticeSimulationPropertyStop: with no mitotic cells left, the next step's update is the last
+                if (mNumMitotic[lineage] == 0)
+                {
+                    mLastStep[lineage] = std::min(mLastStep[lineage], step + 1);
+                }
+            }
+            if (!pending) retired.push_back(i);
+        }
+
+        //drop cells that will not divide again, last first so the swapped-in cells are live
+        for (unsigned j = retired.size(); j-- > 0;)
+        {
+            unsigned i = retired[j];
+            unsigned last = mDivisionStep.size() - 1;
+            mDivisionStep[i] = mDivisionStep[last];
+            mLineage[i] = mLineage[last];
+            mMitotic[i] = mMitotic[last];
+            mGeneration[i] = mGeneration[last];
+            mDivisionStep.pop_back();
+            mLineage.pop_back();
+            mMitotic.pop_back();
+            mGeneration.pop_back();
+        }
+    }
+}
+
+unsigned LineageBatch::GetNumLineages() const
+{
+    return mTheta.size();
+}
+
+unsigned LineageBatch::GetCount(unsigned lineage) const
+{
+    return mCount.at(lineage);
+}
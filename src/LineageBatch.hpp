@@ -0,0 +1,81 @@
+#ifndef LINEAGEBATCH_HPP_
+#define LINEAGEBATCH_HPP_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <boost/random/mersenne_twister.hpp>
+
+/***********************************
+ * LINEAGE BATCH
+ * Many independent He, Gomes or Boije lineages (different seeds, different theta, or both) advanced together without
+ * Chaste Cell objects, for calibration ensembles where setting up each lineage's cell population & simulator
+ * dominates the run time.
+ *
+ * The only per-cell state the lineage models' count rules read is the cell's next division step, whether it is
+ * mitotic & (Boije) its generation; these are held in flat arrays over every lineage in the batch, with each
+ * lineage's theta, time grid, TiL offset & counts. Run() is an event loop over those arrays: it finds the earliest
+ * pending division step (a min-reduction & an equality scan, plain loops the compiler may vectorise), then divides
+ * the cells due at it one at a time by the LineageModelRules of HeCellCycleModel, GomesCellCycleModel or
+ * BoijeCellCycleModel. Divisions are not vectorised; the speed-up over ModelLineage comes from skipping Chaste's
+ * cells, mesh & per-step population update, & from jumping over steps with no divisions. As under
+ * OffLatticeSimulationPropertyStop, each lineage keeps its simulator's time grid (dt adjusted to a whole number of
+ * steps to the end time), cells divide on age alone, & a lineage left without mitotic cells gets one more division
+ * step before it stops.
+ *
+ * theta is in ModelLineage's order (He: stochastic mode, fixture 0, wild type founders). Each lineage draws from its
+ * own Mersenne twister seeded with its seed rather than Chaste's RandomNumberGenerator, & only the draws that decide
+ * counts are made, so end counts match ModelLineage::Simulate in distribution, not seed for seed.
+ ************************************/
+
+class LineageBatch
+{
+private:
+    static const int32_t NEVER; //division step of a cell that will not divide before its lineage stops
+
+    unsigned mModel; //0 = He, 1 = Gomes, 2 = Boije
+    bool mHasRun;
+
+    //per lineage
+    std::vector<std::vector<double> > mTheta;
+    std::vector<double> mDt;
+    std::vector<int32_t> mLastStep; //the end step, brought forward once the lineage has no mitotic cells left
+    std::vector<double> mTiLOffset;
+    std::vector<unsigned> mCount;
+    std::vector<unsigned> mNumMitotic;
+    std::vector<boost::random::mt19937> mGenerators;
+
+    //per pending cell (one that may still divide)
+    std::vector<int32_t> mDivisionStep;
+    std::vector<uint32_t> mLineage;
+    std::vector<uint8_t> mMitotic;
+    std::vector<uint32_t> mGeneration;
+
+    //First step on the lineage's grid at which a cell born at birthStep is old enough to divide; NEVER if past its last step
+    int32_t GetDivisionStep(unsigned lineage, int32_t birthStep, double duration) const;
+
+    void AddCell(unsigned lineage, int32_t divisionStep, bool mitotic, unsigned generation);
+
+    //Divide pending cell i at step; returns false if the parent will not divide again
+    bool DivideHe(unsigned i, int32_t step);
+    bool DivideGomes(unsigned i, int32_t step);
+    bool DivideBoije(unsigned i, int32_t step);
+
+public:
+    //rModel: He, Gomes or Boije
+    LineageBatch(const std::string& rModel);
+
+    //Add a single-founder lineage at theta, drawing from its own generator seeded with seed; returns its index
+    unsigned AddLineage(const std::vector<double>& rTheta, unsigned seed);
+
+    //Advance every lineage to its end time or stop; lineages must all be added first
+    void Run();
+
+    unsigned GetNumLineages() const;
+
+    //End count of a lineage: every cell of its clone, as OffLatticeSimulationPropertyStop's final cell count
+    unsigned GetCount(unsigned lineage) const;
+};
+
+#endif /*LINEAGEBATCH_HPP_*/
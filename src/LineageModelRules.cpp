@@ -0,0 +1,49 @@
+#include "LineageModelRules.hpp"
+
+#include <cmath>
+
+const double LineageModelRules::HE_GAMMA_SHIFT = 4.0;
+const double LineageModelRules::HE_GAMMA_SHAPE = 2.0;
+const double LineageModelRules::HE_GAMMA_SCALE = 1.0;
+const double LineageModelRules::HE_SISTER_SHIFT = 1.0;
+
+const double LineageModelRules::HE_DT = 0.05;
+const double LineageModelRules::GOMES_DT = 0.25;
+const double LineageModelRules::BOIJE_DT = 0.25;
+const double LineageModelRules::WAN_DT = 1.0;
+
+const double LineageModelRules::WAN_RETINA_AGE_AT_START = 72.0;
+
+unsigned LineageModelRules::GetHePhase(double currentTiL, double phase2Boundary, double phase3Boundary)
+{
+    unsigned phase = 1;
+    if (currentTiL > phase2Boundary && currentTiL < phase3Boundary) phase = 2;
+    if (currentTiL > phase3Boundary) phase = 3;
+    return phase;
+}
+
+unsigned LineageModelRules::GetMitoticMode(double mitoticModeRV, double pPP, double pPD)
+{
+    if (mitoticModeRV <= pPP) return 0;
+    if (mitoticModeRV <= pPP + pPD) return 1;
+    return 2;
+}
+
+unsigned LineageModelRules::GetBoijePhase(unsigned generation, unsigned phase2Generation, unsigned phase3Generation)
+{
+    if (generation > phase3Generation) return 3;
+    if (generation > phase2Generation) return 2;
+    return 1;
+}
+
+unsigned LineageModelRules::GetBoijeMode(bool atoh7Signal, bool ptf1aSignal, bool ngSignal)
+{
+    if (atoh7Signal) return 1;
+    if (ptf1aSignal || ngSignal) return 2;
+    return 0;
+}
+
+double LineageModelRules::GetLensGrowthFactor(double retinaAge)
+{
+    return .09256 * pow(retinaAge, .52728);
+}
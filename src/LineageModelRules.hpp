@@ -0,0 +1,48 @@
+#ifndef LINEAGEMODELRULES_HPP_
+#define LINEAGEMODELRULES_HPP_
+
+/***********************************
+ * LINEAGE MODEL RULES
+ * The He, Gomes, Boije & Wan stem models' mode rules, the He 2012 cycle defaults & the simulators' timesteps, in one
+ * place for the cell cycle models & the engines that reproduce them without Chaste cells (LineageBatch,
+ * WanEventEngine, WanMeanField).
+ *
+ * Modes are numbered as the models' mMitoticMode: 0 = PP, 1 = PD, 2 = DD.
+ ************************************/
+
+class LineageModelRules
+{
+public:
+    //HeCellCycleModel defaults, from [He2012]: cycles of HE_GAMMA_SHIFT + Gamma(HE_GAMMA_SHAPE, HE_GAMMA_SCALE) hours,
+    //PP sisters shifted by Normal(0, HE_SISTER_SHIFT)
+    static const double HE_GAMMA_SHIFT;
+    static const double HE_GAMMA_SHAPE;
+    static const double HE_GAMMA_SCALE;
+    static const double HE_SISTER_SHIFT;
+
+    //simulator timesteps
+    static const double HE_DT;
+    static const double GOMES_DT;
+    static const double BOIJE_DT;
+    static const double WAN_DT;
+
+    //WanStemCellCycleModel's default mEventStartTime: simulated time 0 is 3dpf
+    static const double WAN_RETINA_AGE_AT_START;
+
+    //HeCellCycleModel mode phase (1-3) at a TiL; as the model, a TiL exactly on the phase 3 boundary is in phase 1
+    static unsigned GetHePhase(double currentTiL, double phase2Boundary, double phase3Boundary);
+
+    //He or Gomes mode drawn by a uniform random variable against the PP & PD probabilities
+    static unsigned GetMitoticMode(double mitoticModeRV, double pPP, double pPD);
+
+    //BoijeCellCycleModel phase (1-3) of a division's generation
+    static unsigned GetBoijePhase(unsigned generation, unsigned phase2Generation, unsigned phase3Generation);
+
+    //BoijeCellCycleModel mode from the transcription factor signals: atoh7 PD, ptf1a or ng alone DD, otherwise PP
+    static unsigned GetBoijeMode(bool atoh7Signal, bool ptf1aSignal, bool ngSignal);
+
+    //WanStemCellCycleModel's power law fit for lens growth, at a retina age in hours post fertilisation
+    static double GetLensGrowthFactor(double retinaAge);
+};
+
+#endif /*LINEAGEMODELRULES_HPP_*/
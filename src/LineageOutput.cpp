@@ -0,0 +1,356 @@
+#include "LineageOutput.hpp"
+#include "SeedJournal.hpp"
+#include "Exception.hpp"
+#include <cstring>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+LineageOutput* LineageOutput::mpInstance = NULL;
+
+LineageOutput::LineageOutput()
+    : mOpen(false),
+      mForwarding(false),
+      mCapturing(false),
+      mpJournal(NULL),
+      mEnabled(NUM_SINKS, false),
+      mFiles(NUM_SINKS),
+      mFileSizes(NUM_SINKS, 0),
+      mBuffers(NUM_SINKS),
+      mNullStream(NULL)
+{
+}
+
+LineageOutput* LineageOutput::Instance()
+{
+    if (mpInstance == NULL)
+    {
+        mpInstance = new LineageOutput;
+    }
+    return mpInstance;
+}
+
+void LineageOutput::Destroy()
+{
+    if (mpInstance)
+    {
+        mpInstance->Close();
+        delete mpInstance;
+        mpInstance = NULL;
+    }
+}
+
+std::string LineageOutput::GetSinkName(unsigned sink)
+{
+    switch (sink)
+    {
+        case COUNTS:
+            return "Counts";
+        case EVENTS:
+            return "Events";
+        case SEQUENCE:
+            return "Sequence";
+        case SNAPSHOTS:
+            return "Snapshots";
+        case TRIE:
+            return "Trie";
+        case SCORES:
+            return "Scores";
+        case DECISIONS:
+            return "Decisions";
+        default:
+            EXCEPTION("Unknown lineage output sink");
+    }
+}
+
+void LineageOutput::Open(const std::string& rDirectory, const std::string& rFilename, const std::vector<bool>& rEnabled)
+{
+    if (mOpen)
+    {
+        EXCEPTION("LineageOutput is already open; Close() the current output first");
+    }
+    if (rEnabled.size() != NUM_SINKS)
+    {
+        EXCEPTION("LineageOutput::Open needs one bool per sink");
+    }
+
+    unsigned num_enabled = 0;
+    for (unsigned sink = 0; sink < NUM_SINKS; sink++)
+    {
+        if (rEnabled[sink]) num_enabled++;
+    }
+
+    mTrie.Clear();
+    for (unsigned sink = 0; sink < NUM_SINKS; sink++)
+    {
+        mEnabled[sink] = rEnabled[sink];
+        mBuffers[sink].clear();
+    }
+
+    //forwarding ranks hand their output to the writing rank, so open nothing
+    if (!mForwarding)
+    {
+        OutputFileHandler handler(rDirectory, false);
+        for (unsigned sink = 0; sink < NUM_SINKS; sink++)
+        {
+            mFileSizes[sink] = 0;
+            if (mEnabled[sink])
+            {
+                //a lone sink keeps the plain filename, so single-output runs write the same file as before
+                std::string filename = (num_enabled == 1) ? rFilename : rFilename + GetSinkName(sink);
+                if (mResumeFileSizes.empty())
+                {
+                    mFiles[sink] = handler.OpenOutputFile(filename);
+                }
+                else
+                {
+                    //drop anything written after the last journaled seed, then append
+                    std::string path = handler.GetOutputDirectoryFullPath() + filename;
+                    struct stat file_stat;
+                    if (stat(path.c_str(), &file_stat) != 0 || file_stat.st_size < mResumeFileSizes[sink]
+                            || truncate(path.c_str(), mResumeFileSizes[sink]) != 0)
+                    {
+                        EXCEPTION("Cannot resume " + path + "; it is missing or shorter than its journal records");
+                    }
+                    mFiles[sink] = handler.OpenOutputFile(filename, std::ios::app);
+                    mFileSizes[sink] = mResumeFileSizes[sink];
+                }
+            }
+        }
+    }
+
+    mOpen = true;
+}
+
+bool LineageOutput::IsOpen() const
+{
+    return mOpen;
+}
+
+bool LineageOutput::IsEnabled(unsigned sink) const
+{
+    return mOpen && mEnabled[sink];
+}
+
+void LineageOutput::WriteHeader(unsigned sink, const std::string& rHeader)
+{
+    //a resumed file already has its header
+    if (IsEnabled(sink) && mFiles[sink] && mResumeFileSizes.empty())
+    {
+        (*mFiles[sink]) << rHeader;
+        mFileSizes[sink] += rHeader.size();
+    }
+}
+
+std::ostream& LineageOutput::rGetStream(unsigned sink, unsigned seed)
+{
+    if (!IsEnabled(sink) && !(sink == SEQUENCE && IsEnabled(TRIE)))
+    {
+        return mNullStream;
+    }
+    return mBuffers[sink][seed];
+}
+
+void LineageOutput::CommitSeed(unsigned seed)
+{
+    if (mForwarding || mCapturing)
+    {
+        //the sequence buffer is packed even if only the trie is enabled; it is the trie's input
+        std::vector<std::string> texts(NUM_SINKS);
+        for (unsigned sink = 0; sink < NUM_SINKS; sink++)
+        {
+            std::map<unsigned, std::ostringstream>::iterator it = mBuffers[sink].find(seed);
+            if (it != mBuffers[sink].end())
+            {
+                texts[sink] = it->second.str();
+            }
+        }
+
+        //captured before forwarding, so a worker rank's ResultCache stores the seeds it simulated
+        if (mCapturing) PackSeed(seed, texts, mCaptured);
+        if (mForwarding)
+        {
+            PackSeed(seed, texts, mForwarded);
+            DiscardSeed(seed);
+            return;
+        }
+    }
+
+    if (IsEnabled(TRIE))
+    {
+        //the sequence is the last field of the seed's sequence line(s)
+        std::map<unsigned, std::ostringstream>::iterator it = mBuffers[SEQUENCE].find(seed);
+        if (it != mBuffers[SEQUENCE].end())
+        {
+            std::istringstream lines(it->second.str());
+            std::string line;
+            while (std::getline(lines, line))
+            {
+                mTrie.Insert(line.substr(line.find_last_of('\t') + 1));
+            }
+            if (!IsEnabled(SEQUENCE)) mBuffers[SEQUENCE].erase(it);
+        }
+    }
+
+    for (unsigned sink = 0; sink < NUM_SINKS; sink++)
+    {
+        if (!IsEnabled(sink)) continue;
+
+        std::map<unsigned, std::ostringstream>::iterator it = mBuffers[sink].find(seed);
+        if (it != mBuffers[sink].end())
+        {
+            std::string text = it->second.str();
+            (*mFiles[sink]) << text;
+            mFiles[sink]->flush();
+            mFileSizes[sink] += text.size();
+            mBuffers[sink].erase(it);
+        }
+    }
+
+    //journaled once the seed's output is flushed, so a resumed run never loses a journaled seed
+    if (mpJournal) mpJournal->RecordSeed(seed, mFileSizes);
+}
+
+void LineageOutput::EnableForwarding()
+{
+    if (mOpen)
+    {
+        EXCEPTION("LineageOutput::EnableForwarding() must be called before Open()");
+    }
+    mForwarding = true;
+}
+
+std::string LineageOutput::TakeForwarded()
+{
+    std::string packed;
+    packed.swap(mForwarded);
+    return packed;
+}
+
+void LineageOutput::CommitForwarded(const std::string& rPacked)
+{
+    size_t pos = 0;
+    unsigned seed;
+    std::vector<std::string> texts;
+    while (UnpackSeed(rPacked, pos, seed, texts))
+    {
+        for (unsigned sink = 0; sink < NUM_SINKS; sink++)
+        {
+            if (!texts[sink].empty())
+            {
+                mBuffers[sink][seed] << texts[sink];
+            }
+        }
+        CommitSeed(seed);
+    }
+}
+
+void LineageOutput::ResumeFrom(const std::vector<long long>& rFileSizes)
+{
+    if (mOpen)
+    {
+        EXCEPTION("LineageOutput::ResumeFrom() must be called before Open()");
+    }
+    if (!rFileSizes.empty() && rFileSizes.size() != NUM_SINKS)
+    {
+        EXCEPTION("LineageOutput::ResumeFrom needs one file size per sink");
+    }
+    mResumeFileSizes = rFileSizes;
+}
+
+void LineageOutput::SetJournal(SeedJournal* pJournal)
+{
+    mpJournal = pJournal;
+}
+
+void LineageOutput::EnableCapture()
+{
+    mCapturing = true;
+}
+
+std::string LineageOutput::TakeCaptured()
+{
+    std::string packed;
+    packed.swap(mCaptured);
+    return packed;
+}
+
+void LineageOutput::PackSeed(unsigned seed, const std::vector<std::string>& rTexts, std::string& rPacked)
+{
+    //seed, then each sink's text, length-prefixed (empty if none)
+    uint32_t packed_seed = seed;
+    rPacked.append(reinterpret_cast<const char*>(&packed_seed), sizeof(packed_seed));
+    for (unsigned sink = 0; sink < NUM_SINKS; sink++)
+    {
+        uint32_t length = rTexts[sink].size();
+        rPacked.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        rPacked.append(rTexts[sink]);
+    }
+}
+
+bool LineageOutput::UnpackSeed(const std::string& rPacked, size_t& rPos, unsigned& rSeed, std::vector<std::string>& rTexts)
+{
+    if (rPos + sizeof(uint32_t) > rPacked.size()) return false;
+
+    uint32_t seed;
+    memcpy(&seed, rPacked.data() + rPos, sizeof(seed));
+    size_t pos = rPos + sizeof(seed);
+
+    rTexts.assign(NUM_SINKS, "");
+    for (unsigned sink = 0; sink < NUM_SINKS; sink++)
+    {
+        uint32_t length;
+        if (pos + sizeof(length) > rPacked.size()) return false;
+        memcpy(&length, rPacked.data() + pos, sizeof(length));
+        pos += sizeof(length);
+        if (pos + length > rPacked.size()) return false;
+        rTexts[sink] = rPacked.substr(pos, length);
+        pos += length;
+    }
+
+    rSeed = seed;
+    rPos = pos;
+    return true;
+}
+
+bool LineageOutput::HasEntryColumn(unsigned sink)
+{
+    return sink == COUNTS || sink == SEQUENCE || sink == SNAPSHOTS || sink == SCORES || sink == DECISIONS;
+}
+
+void LineageOutput::DiscardSeed(unsigned seed)
+{
+    for (unsigned sink = 0; sink < NUM_SINKS; sink++)
+    {
+        mBuffers[sink].erase(seed);
+    }
+}
+
+const SequenceTrie& LineageOutput::rGetTrie() const
+{
+    return mTrie;
+}
+
+void LineageOutput::Close()
+{
+    if (!mOpen) return;
+
+    if (mEnabled[TRIE] && mFiles[TRIE])
+    {
+        mTrie.Write(*mFiles[TRIE]);
+    }
+
+    for (unsigned sink = 0; sink < NUM_SINKS; sink++)
+    {
+        if (mFiles[sink])
+        {
+            mFiles[sink]->close();
+            mFiles[sink].reset();
+        }
+        mBuffers[sink].clear();
+        mEnabled[sink] = false;
+    }
+    mResumeFileSizes.clear();
+    mpJournal = NULL;
+    mOpen = false;
+}
@@ -0,0 +1,131 @@
+#ifndef LINEAGEOUTPUT_HPP_
+#define LINEAGEOUTPUT_HPP_
+
+#include <string>
+#include <sstream>
+#include <map>
+#include <vector>
+#include "OutputFileHandler.hpp"
+#include "SequenceTrie.hpp"
+
+class SeedJournal;
+
+/***********************************
+ * LINEAGE OUTPUT
+ * Results sinks shared by the project simulators and cell cycle models.
+ * Each sink (counts, mitotic events, sequences, snapshots) is enabled independently, so all observe the same simulated lineages.
+ *
+ * USE: the simulator calls Open(<directory>, <filename>, <enabled sinks>) once per run and writes each sink's header.
+ * The simulator & cell cycle models write a seed's output to rGetStream(<sink>, <seed>);
+ * output is buffered per seed and appended to the sink's file by CommitSeed(<seed>), so each seed's lines are contiguous.
+ *
+ * The sequence trie sink takes each committed sequence (the sequence sink's "Entry\tSeed\tSequence" line) into a SequenceTrie
+ * instead of a line per seed, & writes the trie's (sequence, count, prefix count) table on Close().
+ * Models & simulators write sequences to the sequence sink's stream whenever either sink is enabled.
+ *
+ * Under MPI (see SeedRangeRunner), worker ranks EnableForwarding() before Open(): they open no files, and CommitSeed()
+ * packs the seed's buffers for TakeForwarded(); the writing rank commits them in seed order with CommitForwarded().
+ * With EnableCapture(), CommitSeed() also keeps a packed copy of each seed for TakeCaptured() (see ResultCache), forwarded
+ * or not.
+ * With SetJournal(), CommitSeed() records each seed & the files' sizes in a SeedJournal; ResumeFrom() those sizes
+ * before Open() truncates the files to them & appends, without headers (--resume).
+ *
+ * With one sink enabled, it is written to <filename>, as the old exclusive outputMode wrote the LogFile.
+ * With more than one, each sink is written to <filename><SinkName> (eg. "fooCounts", "fooEvents").
+ ************************************/
+
+class LineageOutput
+{
+private:
+    static LineageOutput* mpInstance;
+
+    bool mOpen;
+    bool mForwarding;
+    std::string mForwarded; //packed seeds committed since the last TakeForwarded()
+    bool mCapturing;
+    std::string mCaptured; //packed copies of seeds committed since the last TakeCaptured()
+    SeedJournal* mpJournal; //not owned
+    std::vector<long long> mResumeFileSizes; //empty unless resuming
+    std::vector<bool> mEnabled;
+    std::vector<out_stream> mFiles;
+    std::vector<long long> mFileSizes; //bytes in each sink's file, for the journal
+    std::vector<std::map<unsigned, std::ostringstream> > mBuffers;
+    std::ostream mNullStream; //swallows writes to disabled sinks
+    SequenceTrie mTrie;
+
+    LineageOutput();
+
+public:
+    static const unsigned COUNTS = 0;
+    static const unsigned EVENTS = 1;
+    static const unsigned SEQUENCE = 2;
+    static const unsigned SNAPSHOTS = 3;
+    static const unsigned TRIE = 4;
+    static const unsigned SCORES = 5;
+    static const unsigned DECISIONS = 6;
+    static const unsigned NUM_SINKS = 7;
+
+    static LineageOutput* Instance();
+    static void Destroy();
+
+    //Suffix used to name a sink's file when more than one sink is enabled
+    static std::string GetSinkName(unsigned sink);
+
+    /**
+     * Open files for the enabled sinks. Relative to CHASTE_TEST_OUTPUT, as for LogFile.
+     * @param rEnabled one bool per sink, indexed by COUNTS, EVENTS, SEQUENCE, SNAPSHOTS, TRIE, SCORES, DECISIONS
+     */
+    void Open(const std::string& rDirectory, const std::string& rFilename, const std::vector<bool>& rEnabled);
+    bool IsOpen() const;
+    bool IsEnabled(unsigned sink) const;
+
+    //Written straight to the sink's file, unbuffered; only for headers
+    void WriteHeader(unsigned sink, const std::string& rHeader);
+
+    //Buffered per-seed output; a disabled sink returns a stream that discards writes
+    //(the sequence sink's stream is buffered if either sequence or trie output is enabled)
+    std::ostream& rGetStream(unsigned sink, unsigned seed);
+
+    //Append a seed's buffered output to each sink's file & discard the buffers
+    void CommitSeed(unsigned seed);
+
+    //Worker ranks: commit seeds to a packed string instead of the files; call before Open()
+    void EnableForwarding();
+
+    //Packed seeds committed since the last call, in commit order
+    std::string TakeForwarded();
+
+    //Commit packed seeds from TakeForwarded() on another rank, as if they had been written here
+    void CommitForwarded(const std::string& rPacked);
+
+    //Resume a journaled run: sink file sizes from SeedJournal::rGetResumeFileSizes(); call before Open()
+    void ResumeFrom(const std::vector<long long>& rFileSizes);
+
+    //Record committed seeds in the journal (writing rank only); NULL to stop
+    void SetJournal(SeedJournal* pJournal);
+
+    //Keep a packed copy of each committed seed, as well as writing it
+    void EnableCapture();
+
+    //Packed copies of seeds committed since the last call, in commit order
+    std::string TakeCaptured();
+
+    //Append one seed's per-sink texts to rPacked, in the format of TakeForwarded()
+    static void PackSeed(unsigned seed, const std::vector<std::string>& rTexts, std::string& rPacked);
+
+    //Read the seed at rPos & advance past it; false at the end of rPacked or if it is truncated
+    static bool UnpackSeed(const std::string& rPacked, size_t& rPos, unsigned& rSeed, std::vector<std::string>& rTexts);
+
+    //Sinks whose lines start with the simulator's entry number
+    static bool HasEntryColumn(unsigned sink);
+
+    //Discard a seed's buffered output without writing it
+    void DiscardSeed(unsigned seed);
+
+    //Sequences committed to the trie sink so far
+    const SequenceTrie& rGetTrie() const;
+
+    void Close();
+};
+
+#endif /*LINEAGEOUTPUT_HPP_*/
@@ -0,0 +1,54 @@
+#include "LineageRandomStream.hpp"
+#include "RandomNumberGenerator.hpp"
+
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/gamma_distribution.hpp>
+
+LineageRandomStream::LineageRandomStream()
+    : mpGenerator()
+{
+}
+
+void LineageRandomStream::Seed(unsigned seed)
+{
+    mpGenerator.reset(new boost::random::mt19937(seed));
+}
+
+bool LineageRandomStream::IsSeeded() const
+{
+    return bool(mpGenerator);
+}
+
+double LineageRandomStream::ranf() const
+{
+    if (!mpGenerator) return RandomNumberGenerator::Instance()->ranf();
+
+    boost::random::uniform_01<double> distribution;
+    return distribution(*mpGenerator);
+}
+
+unsigned LineageRandomStream::randMod(unsigned base) const
+{
+    if (!mpGenerator) return RandomNumberGenerator::Instance()->randMod(base);
+
+    boost::random::uniform_int_distribution<unsigned> distribution(0, base - 1);
+    return distribution(*mpGenerator);
+}
+
+double LineageRandomStream::NormalRandomDeviate(double mean, double sd) const
+{
+    if (!mpGenerator) return RandomNumberGenerator::Instance()->NormalRandomDeviate(mean, sd);
+
+    boost::random::normal_distribution<double> distribution(mean, sd);
+    return distribution(*mpGenerator);
+}
+
+double LineageRandomStream::GammaRandomDeviate(double shape, double scale) const
+{
+    if (!mpGenerator) return RandomNumberGenerator::Instance()->GammaRandomDeviate(shape, scale);
+
+    boost::random::gamma_distribution<double> distribution(shape, scale);
+    return distribution(*mpGenerator);
+}
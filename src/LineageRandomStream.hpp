@@ -0,0 +1,49 @@
+#ifndef LINEAGERANDOMSTREAM_HPP_
+#define LINEAGERANDOMSTREAM_HPP_
+
+#include <boost/shared_ptr.hpp>
+#include <boost/random/mersenne_twister.hpp>
+
+/***********************************
+ * LINEAGE RANDOM STREAM
+ * The random draws of one lineage's cell cycle models, with RandomNumberGenerator's ranf(), randMod(),
+ * NormalRandomDeviate() & GammaRandomDeviate().
+ *
+ * An unseeded stream forwards every draw to the RandomNumberGenerator singleton, so single-seed runs draw exactly as
+ * before. Seed() gives the stream its own Mersenne twister; copies share it, so a founder's model passes the stream
+ * on to every descendant's model at division. The founders of a packed run (--pack, see SimulatorRun) each get one
+ * seeded with their seed, as LineageBatch's lineages do, so the draws that decide a seed's lineage (its cell cycle
+ * times & mitotic modes) do not depend on which seeds share its pack.
+ *
+ * Only the draws made through a stream are covered. Draws made directly from the singleton during the same Solve(),
+ * eg. Chaste's placement of daughter cells, & WanStemCellCycleModel's, still interleave across the pack; clone
+ * inductions use a stream only when given one (OffLatticeSimulationPropertyStop::SetRandomStream()).
+ *
+ * Streams are not archived with their models: a restored model draws from RandomNumberGenerator.
+ ************************************/
+
+class LineageRandomStream
+{
+private:
+    boost::shared_ptr<boost::random::mt19937> mpGenerator; //NULL until seeded
+
+public:
+    LineageRandomStream();
+
+    //Draw from a Mersenne twister seeded with seed from now on, shared with any later copies of this stream
+    void Seed(unsigned seed);
+
+    bool IsSeeded() const;
+
+    //Uniform on [0,1)
+    double ranf() const;
+
+    //Uniform on {0, ..., base - 1}
+    unsigned randMod(unsigned base) const;
+
+    double NormalRandomDeviate(double mean, double sd) const;
+
+    double GammaRandomDeviate(double shape, double scale) const;
+};
+
+#endif /*LINEAGERANDOMSTREAM_HPP_*/
@@ -0,0 +1,394 @@
+#include "LineageTreeRecorder.hpp"
+#include "OutputFileHandler.hpp"
+#include "SimulationTime.hpp"
+#include "Exception.hpp"
+#include <cstring>
+#include <cmath>
+#include <stdint.h>
+
+namespace
+{
+    const char ARCHIVE_MAGIC[8] = { 'I', 'S', 'P', 'L', 'T', 'R', '0', '1' };
+
+    //LEB128 unsigned varints
+    void PutVarint(std::string& rBlock, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            rBlock.push_back(char((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        rBlock.push_back(char(value));
+    }
+
+    void PutDouble(std::string& rBlock, double value)
+    {
+        rBlock.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    //Decoders return false on running off the end of the block
+    bool GetVarint(const std::string& rBlock, size_t& rPos, uint64_t& rValue)
+    {
+        rValue = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            if (rPos >= rBlock.size()) return false;
+            uint8_t byte = uint8_t(rBlock[rPos++]);
+            rValue |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool GetDouble(const std::string& rBlock, size_t& rPos, double& rValue)
+    {
+        if (rPos + sizeof(rValue) > rBlock.size()) return false;
+        memcpy(&rValue, rBlock.data() + rPos, sizeof(rValue));
+        rPos += sizeof(rValue);
+        return true;
+    }
+
+    bool DecodeBlock(const std::string& rBlock, LineageTree& rTree)
+    {
+        size_t pos = 0;
+        uint64_t seed, founder, num_divisions, num_final;
+        if (!GetVarint(rBlock, pos, seed) || !GetVarint(rBlock, pos, founder)) return false;
+        if (!GetDouble(rBlock, pos, rTree.mStartTime) || !GetDouble(rBlock, pos, rTree.mDt)) return false;
+        rTree.mSeed = seed;
+        rTree.mFounderId = founder;
+
+        if (!GetVarint(rBlock, pos, num_divisions)) return false;
+        rTree.mDivisions.clear();
+        rTree.mDivisions.reserve(num_divisions);
+        unsigned prev_daughter = rTree.mFounderId;
+        unsigned prev_step = 0;
+        for (uint64_t i = 0; i < num_divisions; i++)
+        {
+            uint64_t parent_delta, daughter_mode, step_delta;
+            if (!GetVarint(rBlock, pos, parent_delta) || !GetVarint(rBlock, pos, daughter_mode)
+                    || !GetVarint(rBlock, pos, step_delta)) return false;
+            LineageTreeDivision division;
+            division.mParentId = rTree.mFounderId + parent_delta;
+            division.mDaughterId = prev_daughter + (daughter_mode >> 2);
+            division.mMode = daughter_mode & 3;
+            division.mTimeStep = prev_step + step_delta;
+            prev_daughter = division.mDaughterId;
+            prev_step = division.mTimeStep;
+            rTree.mDivisions.push_back(division);
+        }
+
+        if (!GetVarint(rBlock, pos, num_final)) return false;
+        rTree.mFinalFates.clear();
+        unsigned prev_id = rTree.mFounderId;
+        for (uint64_t i = 0; i < num_final; i++)
+        {
+            uint64_t id_delta, fate;
+            if (!GetVarint(rBlock, pos, id_delta) || !GetVarint(rBlock, pos, fate)) return false;
+            prev_id += id_delta;
+            rTree.mFinalFates[prev_id] = fate;
+        }
+        return pos == rBlock.size();
+    }
+
+    //Reads the next block; false at the end of the file
+    bool ReadBlock(std::ifstream& rFile, std::string& rBlock)
+    {
+        uint32_t block_bytes;
+        if (!rFile.read(reinterpret_cast<char*>(&block_bytes), sizeof(block_bytes))) return false;
+        rBlock.resize(block_bytes);
+        return bool(rFile.read(&rBlock[0], block_bytes));
+    }
+
+    bool OpenArchive(const std::string& rFullPath, std::ifstream& rFile)
+    {
+        rFile.open(rFullPath.c_str(), std::ios::in | std::ios::binary);
+        if (!rFile.is_open()) return false;
+        char magic[sizeof(ARCHIVE_MAGIC)];
+        if (!rFile.read(magic, sizeof(magic))) return false;
+        return memcmp(magic, ARCHIVE_MAGIC, sizeof(magic)) == 0;
+    }
+}
+
+LineageTree::LineageTree()
+    : mSeed(0),
+      mFounderId(0),
+      mStartTime(0.0),
+      mDt(0.0)
+{
+}
+
+std::map<unsigned, std::vector<unsigned> > LineageTree::GetDivisionsByParent() const
+{
+    std::map<unsigned, std::vector<unsigned> > by_parent;
+    for (unsigned i = 0; i < mDivisions.size(); i++)
+    {
+        by_parent[mDivisions[i].mParentId].push_back(i);
+    }
+    return by_parent;
+}
+
+double LineageTree::GetDivisionTime(unsigned division) const
+{
+    return mStartTime + mDivisions[division].mTimeStep * mDt;
+}
+
+void LineageTree::GetModeSequences(std::vector<unsigned>& rLeafIds, std::vector<std::string>& rSequences,
+                                   std::vector<double>& rWeights) const
+{
+    rLeafIds.clear();
+    rSequences.clear();
+    rWeights.clear();
+
+    std::map<unsigned, std::vector<unsigned> > by_parent = GetDivisionsByParent();
+
+    //(cell ID, index of its next division, modes so far); each division branches to the parent & the daughter
+    struct PathState
+    {
+        unsigned mCellId;
+        unsigned mNextDivision;
+        std::string mSequence;
+    };
+    std::vector<PathState> stack(1);
+    stack[0].mCellId = mFounderId;
+    stack[0].mNextDivision = 0;
+
+    while (!stack.empty())
+    {
+        PathState state = stack.back();
+        stack.pop_back();
+
+        std::map<unsigned, std::vector<unsigned> >::const_iterator it = by_parent.find(state.mCellId);
+        if (it == by_parent.end() || state.mNextDivision == it->second.size())
+        {
+            rLeafIds.push_back(state.mCellId);
+            rWeights.push_back(pow(0.5, state.mSequence.size()));
+            rSequences.push_back(state.mSequence);
+            continue;
+        }
+
+        const LineageTreeDivision& r_division = mDivisions[it->second[state.mNextDivision]];
+        std::string sequence = state.mSequence + char('0' + r_division.mMode);
+
+        PathState daughter = { r_division.mDaughterId, 0, sequence };
+        PathState parent = { state.mCellId, state.mNextDivision + 1, sequence };
+        stack.push_back(daughter);
+        stack.push_back(parent);
+    }
+}
+
+unsigned LineageTree::GetCloneSize(double time) const
+{
+    //timestep of time, to the nearest step, as counts at count times are taken
+    double steps = (time - mStartTime) / mDt;
+    if (steps < -0.5) return 0;
+    unsigned step = unsigned(steps + 0.5);
+
+    //birth & last division timestep of each cell
+    std::map<unsigned, std::pair<unsigned, unsigned> > events;
+    events[mFounderId] = std::make_pair(0u, 0u);
+    for (unsigned i = 0; i < mDivisions.size(); i++)
+    {
+        events[mDivisions[i].mDaughterId] = std::make_pair(mDivisions[i].mTimeStep, mDivisions[i].mTimeStep);
+        events[mDivisions[i].mParentId].second = mDivisions[i].mTimeStep;
+    }
+
+    unsigned count = 0;
+    for (std::map<unsigned, std::pair<unsigned, unsigned> >::iterator it = events.begin(); it != events.end(); ++it)
+    {
+        if (it->second.first > step) continue;
+        if (mFinalFates.count(it->first) || it->second.second > step) count++;
+    }
+    return count;
+}
+
+std::string LineageTree::SamplePath(RandomNumberGenerator* pRandomNumberGenerator) const
+{
+    std::map<unsigned, std::vector<unsigned> > by_parent = GetDivisionsByParent();
+
+    std::string sequence;
+    unsigned cell_id = mFounderId;
+    unsigned next_division = 0;
+    std::map<unsigned, std::vector<unsigned> >::const_iterator it = by_parent.find(cell_id);
+    while (it != by_parent.end() && next_division < it->second.size())
+    {
+        const LineageTreeDivision& r_division = mDivisions[it->second[next_division]];
+        sequence += char('0' + r_division.mMode);
+        //the label passes to the daughter with probability .5, as in the models' samplers
+        if (pRandomNumberGenerator->ranf() <= .5)
+        {
+            cell_id = r_division.mDaughterId;
+            next_division = 0;
+            it = by_parent.find(cell_id);
+        }
+        else
+        {
+            next_division++;
+        }
+    }
+    return sequence;
+}
+
+LineageTreeRecorder* LineageTreeRecorder::mpInstance = NULL;
+
+LineageTreeRecorder::LineageTreeRecorder()
+    : mOpen(false)
+{
+}
+
+LineageTreeRecorder* LineageTreeRecorder::Instance()
+{
+    if (mpInstance == NULL)
+    {
+        mpInstance = new LineageTreeRecorder;
+    }
+    return mpInstance;
+}
+
+void LineageTreeRecorder::Destroy()
+{
+    if (mpInstance)
+    {
+        mpInstance->Close();
+        delete mpInstance;
+        mpInstance = NULL;
+    }
+}
+
+void LineageTreeRecorder::Open(const std::string& rDirectory, const std::string& rFilename)
+{
+    if (mOpen)
+    {
+        EXCEPTION("LineageTreeRecorder is already open; Close() the current archive first");
+    }
+
+    OutputFileHandler handler(rDirectory, false);
+    std::string full_path = handler.GetOutputDirectoryFullPath() + rFilename;
+    mFile.open(full_path.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!mFile.is_open())
+    {
+        EXCEPTION("Could not open lineage tree archive " + full_path);
+    }
+    mFile.write(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+
+    mTrees.clear();
+    mOpen = true;
+}
+
+bool LineageTreeRecorder::IsOpen() const
+{
+    return mOpen;
+}
+
+void LineageTreeRecorder::BeginSeed(unsigned seed, unsigned founderId, double startTime, double dt)
+{
+    if (!mOpen) return;
+
+    LineageTree& r_tree = mTrees[seed];
+    r_tree = LineageTree();
+    r_tree.mSeed = seed;
+    r_tree.mFounderId = founderId;
+    r_tree.mStartTime = startTime;
+    r_tree.mDt = dt;
+}
+
+void LineageTreeRecorder::RecordDivision(unsigned seed, unsigned parentId, unsigned daughterId, unsigned mode)
+{
+    if (!mOpen) return;
+
+    LineageTreeDivision division;
+    division.mParentId = parentId;
+    division.mDaughterId = daughterId;
+    division.mTimeStep = SimulationTime::Instance()->GetTimeStepsElapsed();
+    division.mMode = mode;
+    mTrees[seed].mDivisions.push_back(division);
+}
+
+void LineageTreeRecorder::CommitSeed(unsigned seed)
+{
+    if (!mOpen) return;
+
+    std::map<unsigned, LineageTree>::iterator it = mTrees.find(seed);
+    if (it == mTrees.end()) return;
+    const LineageTree& r_tree = it->second;
+
+    std::string block;
+    PutVarint(block, r_tree.mSeed);
+    PutVarint(block, r_tree.mFounderId);
+    PutDouble(block, r_tree.mStartTime);
+    PutDouble(block, r_tree.mDt);
+
+    //cell IDs are handed out in division order, so daughter IDs & timesteps only increase
+    PutVarint(block, r_tree.mDivisions.size());
+    unsigned prev_daughter = r_tree.mFounderId;
+    unsigned prev_step = 0;
+    for (unsigned i = 0; i < r_tree.mDivisions.size(); i++)
+    {
+        const LineageTreeDivision& r_division = r_tree.mDivisions[i];
+        PutVarint(block, r_division.mParentId - r_tree.mFounderId);
+        PutVarint(block, (uint64_t(r_division.mDaughterId - prev_daughter) << 2) | (r_division.mMode & 3));
+        PutVarint(block, r_division.mTimeStep - prev_step);
+        prev_daughter = r_division.mDaughterId;
+        prev_step = r_division.mTimeStep;
+    }
+
+    PutVarint(block, r_tree.mFinalFates.size());
+    unsigned prev_id = r_tree.mFounderId;
+    for (std::map<unsigned, unsigned>::const_iterator fate_it = r_tree.mFinalFates.begin(); fate_it != r_tree.mFinalFates.end(); ++fate_it)
+    {
+        PutVarint(block, fate_it->first - prev_id);
+        PutVarint(block, fate_it->second);
+        prev_id = fate_it->first;
+    }
+
+    uint32_t block_bytes = block.size();
+    mFile.write(reinterpret_cast<const char*>(&block_bytes), sizeof(block_bytes));
+    mFile.write(block.data(), block.size());
+    mFile.flush();
+
+    mTrees.erase(it);
+}
+
+void LineageTreeRecorder::Close()
+{
+    if (!mOpen) return;
+
+    mFile.close();
+    mTrees.clear();
+    mOpen = false;
+}
+
+bool LineageTreeRecorder::ReadArchive(const std::string& rFullPath, std::vector<LineageTree>& rTrees)
+{
+    rTrees.clear();
+    std::ifstream file;
+    if (!OpenArchive(rFullPath, file)) return false;
+
+    std::string block;
+    while (ReadBlock(file, block))
+    {
+        LineageTree tree;
+        if (!DecodeBlock(block, tree)) return false;
+        rTrees.push_back(tree);
+    }
+    return true;
+}
+
+bool LineageTreeRecorder::ReadSeed(const std::string& rFullPath, unsigned seed, LineageTree& rTree)
+{
+    std::ifstream file;
+    if (!OpenArchive(rFullPath, file)) return false;
+
+    //the seed leads each block, so other seeds are skipped without decoding them
+    std::string block;
+    while (ReadBlock(file, block))
+    {
+        size_t pos = 0;
+        uint64_t block_seed;
+        if (!GetVarint(block, pos, block_seed)) return false;
+        if (block_seed == seed)
+        {
+            return DecodeBlock(block, rTree);
+        }
+    }
+    return false;
+}
@@ -0,0 +1,161 @@
+#ifndef LINEAGETREERECORDER_HPP_
+#define LINEAGETREERECORDER_HPP_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <boost/shared_ptr.hpp>
+
+#include "AbstractCellPopulation.hpp"
+#include "AbstractCellProperty.hpp"
+#include "RandomNumberGenerator.hpp"
+
+/***********************************
+ * LINEAGE TREE RECORDER
+ * Records the whole division tree of each seed's lineage, rather than the one labelled path of the sequence samplers.
+ * Shared by the He, Gomes and Boije cell cycle models.
+ *
+ * USE: the simulator calls Open(<directory>, <filename>) once per run, BeginSeed() before each seed's Solve(),
+ * RecordFinalCells() after it & CommitSeed(); Close() at the end.
+ * Cell cycle models call EnableLineageTreeRecorder(seed) and write each division with RecordDivision(),
+ * from the daughter's InitialiseDaughterCell().
+ * The LineageTreeQuery app reads an archive back through LineageTree's queries.
+ *
+ * File layout: magic, then one block per seed: block length (uint32), seed, founder ID, start time & dt (raw doubles),
+ * divisions, final cells. Divisions are varint deltas: parent ID - founder ID, (daughter ID delta << 2 | mode), timestep delta.
+ * Final cells are varint cell ID deltas & fates.
+ ************************************/
+
+/**
+ * One division. The parent keeps its cell ID; the daughter gets a new one.
+ */
+struct LineageTreeDivision
+{
+    unsigned mParentId;
+    unsigned mDaughterId;
+    unsigned mTimeStep; //simulation timesteps elapsed at the division
+    unsigned mMode; //0=PP;1=PD;2=DD
+};
+
+/**
+ * One seed's division tree, with the queries downstream statistics need.
+ * Each cell is a leaf after its last division, so there is one root-to-leaf path per cell.
+ */
+class LineageTree
+{
+private:
+    //Indices into mDivisions of each cell's divisions as parent, in time order
+    std::map<unsigned, std::vector<unsigned> > GetDivisionsByParent() const;
+
+public:
+    unsigned mSeed;
+    unsigned mFounderId;
+    double mStartTime; //time (hpf, h or generations) of simulation time 0
+    double mDt;
+    std::vector<LineageTreeDivision> mDivisions; //in order of occurrence
+    std::map<unsigned, unsigned> mFinalFates; //cells alive at the end -> fate (0 = none of the recorded fates, i = fate i-1)
+
+    LineageTree();
+
+    double GetDivisionTime(unsigned division) const;
+
+    /**
+     * Every root-to-leaf mode sequence, one per cell, as mode digits (the sequence output's format).
+     * rWeights holds the probability that the sequence sampler's 50:50 labelled path follows each sequence.
+     */
+    void GetModeSequences(std::vector<unsigned>& rLeafIds, std::vector<std::string>& rSequences,
+                          std::vector<double>& rWeights) const;
+
+    /**
+     * Cells in the lineage at time (same units as mStartTime). Cells missing from mFinalFates were killed,
+     * which the models only do at division, so they are removed at their last division (or birth).
+     */
+    unsigned GetCloneSize(double time) const;
+
+    //One mode sequence sampled as the sequence sampler would, choosing each daughter with probability .5
+    std::string SamplePath(RandomNumberGenerator* pRandomNumberGenerator) const;
+};
+
+class LineageTreeRecorder
+{
+private:
+    static LineageTreeRecorder* mpInstance;
+
+    bool mOpen;
+    std::ofstream mFile;
+    std::map<unsigned, LineageTree> mTrees; //seeds begun but not yet committed
+
+    LineageTreeRecorder();
+
+public:
+    static LineageTreeRecorder* Instance();
+    static void Destroy();
+
+    /**
+     * Open the archive for this run. Relative to CHASTE_TEST_OUTPUT, as for LogFile & CellCycleTrace.
+     */
+    void Open(const std::string& rDirectory, const std::string& rFilename);
+    bool IsOpen() const;
+
+    /**
+     * Start a seed's tree.
+     * @param founderId the founder's cell ID
+     * @param startTime time of simulation time 0 in the simulator's units (eg. lineage start hpf)
+     * @param dt the simulation timestep
+     */
+    void BeginSeed(unsigned seed, unsigned founderId, double startTime, double dt);
+
+    //Called by the daughter's cell cycle model, at the current timestep
+    void RecordDivision(unsigned seed, unsigned parentId, unsigned daughterId, unsigned mode);
+
+    /**
+     * Record the fate of each cell alive at the end of the seed's simulation.
+     * @param rFates fate properties; a cell's fate is the first it has, matched by property type
+     */
+    template<unsigned DIM>
+    void RecordFinalCells(unsigned seed, AbstractCellPopulation<DIM,DIM>& rCellPopulation,
+                          const std::vector<boost::shared_ptr<AbstractCellProperty> >& rFates);
+
+    //Encode a seed's tree & append it to the archive
+    void CommitSeed(unsigned seed);
+
+    void Close();
+
+    /**
+     * Read every seed's tree, or one seed's, from an archive (full path).
+     * Returns false if the file is missing, not an archive, or (ReadSeed) has no such seed.
+     */
+    static bool ReadArchive(const std::string& rFullPath, std::vector<LineageTree>& rTrees);
+    static bool ReadSeed(const std::string& rFullPath, unsigned seed, LineageTree& rTree);
+};
+
+template<unsigned DIM>
+void LineageTreeRecorder::RecordFinalCells(unsigned seed, AbstractCellPopulation<DIM,DIM>& rCellPopulation,
+                                           const std::vector<boost::shared_ptr<AbstractCellProperty> >& rFates)
+{
+    if (!mOpen) return;
+
+    LineageTree& r_tree = mTrees[seed];
+    for (typename AbstractCellPopulation<DIM,DIM>::Iterator cell_iter = rCellPopulation.Begin();
+         cell_iter != rCellPopulation.End();
+         ++cell_iter)
+    {
+        unsigned fate = 0;
+        CellPropertyCollection& r_properties = (*cell_iter)->rGetCellPropertyCollection();
+        for (unsigned i = 0; i < rFates.size() && fate == 0; i++)
+        {
+            for (CellPropertyCollection::Iterator prop_iter = r_properties.Begin(); prop_iter != r_properties.End(); ++prop_iter)
+            {
+                if ((*prop_iter)->IsSame(rFates[i]))
+                {
+                    fate = i + 1;
+                    break;
+                }
+            }
+        }
+        r_tree.mFinalFates[(*cell_iter)->GetCellId()] = fate;
+    }
+}
+
+#endif /*LINEAGETREERECORDER_HPP_*/
@@ -0,0 +1,282 @@
+#include "ModelLineage.hpp"
+#include "Exception.hpp"
+
+#include "HeCellCycleModel.hpp"
+#include "GomesCellCycleModel.hpp"
+#include "BoijeCellCycleModel.hpp"
+#include "WanStemCellCycleModel.hpp"
+#include "LineageModelRules.hpp"
+#include "OffLatticeSimulationPropertyStop.hpp"
+
+#include "WildTypeCellMutationState.hpp"
+#include "StemCellProliferativeType.hpp"
+#include "TransitCellProliferativeType.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+#include "GomesRetinalNeuralFates.hpp"
+#include "BoijeRetinalNeuralFates.hpp"
+#include "CellPropertyRegistry.hpp"
+
+#include "HoneycombMeshGenerator.hpp"
+#include "NodesOnlyMesh.hpp"
+#include "NodeBasedCellPopulation.hpp"
+#include "RandomNumberGenerator.hpp"
+
+#include <cmath>
+
+namespace
+{
+    //Single-founder lineage of He, Gomes or Boije; returns its end count
+    double SimulateLineage(const std::string& rModel, const std::vector<double>& rTheta)
+    {
+        RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+
+        MAKE_PTR(WildTypeCellMutationState, p_state);
+        MAKE_PTR(TransitCellProliferativeType, p_Mitotic);
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_PostMitotic);
+
+        AbstractCellCycleModel* p_model;
+        double dt, simEndTime;
+        if (rModel == "He")
+        {
+            //He 2012-type fixture, as HeSimulator fixture 0
+            double inductionTime = rTheta[0];
+            double lineageStartTime = (p_RNG->ranf() * (rTheta[2] - rTheta[1])) + rTheta[1];
+            double currTiL = 0.0;
+            simEndTime = rTheta[3] - lineageStartTime;
+            if (lineageStartTime < inductionTime)
+            {
+                currTiL = inductionTime - lineageStartTime;
+                simEndTime = rTheta[3] - inductionTime;
+            }
+            HeCellCycleModel* p_he_model = new HeCellCycleModel;
+            p_he_model->SetDimension(2);
+            p_he_model->SetModelParameters(currTiL, rTheta[4], rTheta[4] + rTheta[5], rTheta[6], rTheta[7], rTheta[8],
+                                           rTheta[9], rTheta[10], rTheta[11]);
+            p_model = p_he_model;
+            dt = LineageModelRules::HE_DT;
+        }
+        else if (rModel == "Gomes")
+        {
+            MAKE_PTR(RodPhotoreceptor, p_RPh_fate);
+            MAKE_PTR(AmacrineCell, p_AC_fate);
+            MAKE_PTR(BipolarCell, p_BC_fate);
+            MAKE_PTR(MullerGlia, p_MG_fate);
+            GomesCellCycleModel* p_gomes_model = new GomesCellCycleModel;
+            p_gomes_model->SetDimension(2);
+            p_gomes_model->SetPostMitoticType(p_PostMitotic);
+            p_gomes_model->SetModelParameters(rTheta[1], rTheta[2], rTheta[3], rTheta[4], rTheta[5], rTheta[6], rTheta[7]);
+            p_gomes_model->SetModelProperties(p_RPh_fate, p_AC_fate, p_BC_fate, p_MG_fate);
+            p_model = p_gomes_model;
+            dt = LineageModelRules::GOMES_DT;
+            simEndTime = rTheta[0];
+        }
+        else
+        {
+            MAKE_PTR(RetinalGanglion, p_RGC_fate);
+            MAKE_PTR(AmacrineHorizontal, p_AC_HC_fate);
+            MAKE_PTR(ReceptorBipolar, p_PR_BC_fate);
+            BoijeCellCycleModel* p_boije_model = new BoijeCellCycleModel;
+            p_boije_model->SetDimension(2);
+            p_boije_model->SetPostMitoticType(p_PostMitotic);
+            p_boije_model->SetModelParameters(unsigned(rTheta[1]), unsigned(rTheta[2]), rTheta[3], rTheta[4], rTheta[5]);
+            p_boije_model->SetSpecifiedTypes(p_RGC_fate, p_AC_HC_fate, p_PR_BC_fate);
+            p_model = p_boije_model;
+            dt = LineageModelRules::BOIJE_DT;
+            simEndTime = rTheta[0];
+        }
+
+        std::vector<CellPtr> cells;
+        CellPtr p_cell(new Cell(p_state, p_model));
+        p_cell->SetCellProliferativeType(p_Mitotic);
+        p_cell->InitialiseCellCycleModel();
+        cells.push_back(p_cell);
+
+        //Generate 1x1 mesh for single-cell colony
+        HoneycombMeshGenerator generator(1, 1);
+        MutableMesh<2, 2>* p_generating_mesh = generator.GetMesh();
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(*p_generating_mesh, 1.5);
+
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+        OffLatticeSimulationPropertyStop<2> simulator(cell_population);
+        simulator.SetStopProperty(p_Mitotic); //simulation to stop if no mitotic cells are left
+        simulator.SetDt(dt);
+        simulator.SetEndTime(simEndTime);
+        simulator.DisableSimulationOutput();
+        simulator.Solve();
+        return cell_population.GetNumRealCells();
+    }
+
+    //Wan CMZ population, as WanSimulator; returns its stem, RPC & post-mitotic cells at the end time
+    std::vector<double> SimulateWan(const std::vector<double>& rTheta)
+    {
+        RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+
+        boost::shared_ptr<AbstractCellProperty> p_state(CellPropertyRegistry::Instance()->Get<WildTypeCellMutationState>());
+        boost::shared_ptr<AbstractCellProperty> p_Transit(
+                CellPropertyRegistry::Instance()->Get<TransitCellProliferativeType>());
+
+        double cmzResidencyTime = rTheta[0], stemDivisor = rTheta[1], progenitorMean = rTheta[2], progenitorStd = rTheta[3];
+        double mitoticModePhase2 = rTheta[11], mitoticModePhase3 = rTheta[12];
+        std::vector<double> stemOffspringParams = { mitoticModePhase2, mitoticModePhase2 + mitoticModePhase3, rTheta[13],
+                                                    rTheta[14], rTheta[15], rTheta[16], rTheta[17], rTheta[18],
+                                                    rTheta[7], rTheta[8], rTheta[9], rTheta[10] };
+
+        unsigned numberProgenitors = int(std::round(p_RNG->NormalRandomDeviate(progenitorMean, progenitorStd)));
+        unsigned numberStem = int(std::round(numberProgenitors / stemDivisor));
+
+        std::vector<CellPtr> stems;
+        std::vector<CellPtr> cells;
+        for (unsigned i = 0; i < numberStem; i++)
+        {
+            WanStemCellCycleModel* p_stem_model = new WanStemCellCycleModel;
+            p_stem_model->SetDimension(2);
+            p_stem_model->SetModelParameters(rTheta[4], rTheta[5], rTheta[6], stemOffspringParams);
+
+            CellPtr p_cell(new Cell(p_state, p_stem_model));
+            p_cell->InitialiseCellCycleModel();
+            stems.push_back(p_cell);
+            cells.push_back(p_cell);
+        }
+        for (unsigned i = 0; i < numberProgenitors; i++)
+        {
+            double currTiL = p_RNG->ranf() * cmzResidencyTime;
+
+            HeCellCycleModel* p_prog_model = new HeCellCycleModel;
+            p_prog_model->SetDimension(2);
+            p_prog_model->SetModelParameters(currTiL, mitoticModePhase2, mitoticModePhase2 + mitoticModePhase3, rTheta[13],
+                                             rTheta[14], rTheta[15], rTheta[16], rTheta[17], rTheta[18]);
+            p_prog_model->EnableKillSpecified();
+
+            CellPtr p_cell(new Cell(p_state, p_prog_model));
+            p_cell->InitialiseCellCycleModel();
+            cells.push_back(p_cell);
+        }
+
+        //Generate 1x#cells mesh for abstract colony
+        HoneycombMeshGenerator generator(1, (numberProgenitors + numberStem));
+        MutableMesh<2, 2>* p_generating_mesh = generator.GetMesh();
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(*p_generating_mesh, 1.5);
+
+        boost::shared_ptr<NodeBasedCellPopulation<2> > cell_population(new NodeBasedCellPopulation<2>(mesh, cells));
+        for (auto p_cell : stems)
+        {
+            WanStemCellCycleModel* p_cycle_model = dynamic_cast<WanStemCellCycleModel*>(p_cell->GetCellCycleModel());
+            p_cycle_model->EnableExpandingStemPopulation(numberStem, cell_population);
+        }
+
+        std::vector<double> outputs(3, 0.0);
+        {
+            OffLatticeSimulationPropertyStop<2> simulator(*cell_population);
+            simulator.SetStopProperty(p_Transit); //simulation to stop if no RPCs are left
+            simulator.SetDt(1);
+            simulator.SetEndTime(rTheta[19]);
+            simulator.DisableSimulationOutput();
+            simulator.Solve();
+
+            for (AbstractCellPopulation<2>::Iterator cell_iter = cell_population->Begin();
+                    cell_iter != cell_population->End(); ++cell_iter)
+            {
+                if ((*cell_iter)->GetCellProliferativeType()->IsType<StemCellProliferativeType>()) outputs[0]++;
+                else if ((*cell_iter)->GetCellProliferativeType()->IsType<TransitCellProliferativeType>()) outputs[1]++;
+                else outputs[2]++;
+
+                //the stem models hold the population; detached, it & its cells are freed before the next seed
+                WanStemCellCycleModel* p_stem_model = dynamic_cast<WanStemCellCycleModel*>((*cell_iter)->GetCellCycleModel());
+                if (p_stem_model) p_stem_model->SetPopulation(boost::shared_ptr<AbstractCellPopulation<2> >());
+            }
+        }
+        return outputs;
+    }
+}
+
+std::vector<std::string> ModelLineage::GetParameterNames(const std::string& rModel)
+{
+    if (rModel == "He")
+    {
+        return { "inductionTime", "earliestLineageStartTime", "latestLineageStartTime", "endTime",
+                 "mitoticModePhase2", "mitoticModePhase3", "pPP1", "pPD1", "pPP2", "pPD2", "pPP3", "pPD3" };
+    }
+    if (rModel == "Gomes")
+    {
+        return { "endTime", "normalMu", "normalSigma", "pPP", "pPD", "pBC", "pAC", "pMG" };
+    }
+    if (rModel == "Boije")
+    {
+        return { "endGeneration", "phase2Generation", "phase3Generation", "pAtoh7", "pPtf1a", "png" };
+    }
+    if (rModel == "Wan")
+    {
+        return { "cmzResidencyTime", "stemDivisor", "progenitorMean", "progenitorStd", "stemGammaShift",
+                 "stemGammaShape", "stemGammaScale", "progenitorGammaShift", "progenitorGammaShape",
+                 "progenitorGammaScale", "progenitorGammaSister", "mitoticModePhase2", "mitoticModePhase3",
+                 "pPP1", "pPD1", "pPP2", "pPD2", "pPP3", "pPD3", "endTime" };
+    }
+    return { };
+}
+
+bool ModelLineage::IsIntegerParameter(const std::string& rModel, unsigned index)
+{
+    return rModel == "Boije" && index < 3;
+}
+
+bool ModelLineage::IsValidParameters(const std::string& rModel, const std::vector<double>& rTheta)
+{
+    if (rModel == "He")
+    {
+        return rTheta[1] <= rTheta[2] && rTheta[2] < rTheta[3] && rTheta[4] > 0 && rTheta[5] > 0
+                && rTheta[6] + rTheta[7] <= 1 && rTheta[8] + rTheta[9] <= 1 && rTheta[10] + rTheta[11] <= 1;
+    }
+    if (rModel == "Gomes")
+    {
+        return rTheta[2] > 0 && rTheta[3] + rTheta[4] <= 1 && rTheta[5] + rTheta[6] + rTheta[7] <= 1;
+    }
+    if (rModel == "Boije")
+    {
+        return rTheta[1] <= rTheta[2];
+    }
+    return rTheta[0] > 0 && rTheta[1] > 0 && rTheta[2] > 0 && rTheta[3] > 0 && rTheta[5] > 0 && rTheta[6] > 0
+            && rTheta[8] > 0 && rTheta[9] > 0 && rTheta[13] + rTheta[14] <= 1 && rTheta[15] + rTheta[16] <= 1
+            && rTheta[17] + rTheta[18] <= 1 && rTheta[19] > 0;
+}
+
+bool ModelLineage::IsLineageModel(const std::string& rModel)
+{
+    return rModel == "He" || rModel == "Gomes" || rModel == "Boije";
+}
+
+std::vector<std::string> ModelLineage::GetOutputNames(const std::string& rModel)
+{
+    if (rModel == "Wan")
+    {
+        return { "Stem", "RPC", "PostMitotic" };
+    }
+    return { "Count" };
+}
+
+std::vector<double> ModelLineage::Simulate(const std::string& rModel, const std::vector<double>& rTheta, unsigned seed)
+{
+    if (rTheta.size() != GetParameterNames(rModel).size())
+    {
+        EXCEPTION("ModelLineage::Simulate needs one parameter per " + rModel + " parameter name");
+    }
+
+    //initialise SimulationTime (permits cellcyclemodel setup), number cells from 0 & reseed, as the simulators
+    SimulationTime::Instance()->SetStartTime(0.0);
+    CellId::ResetMaxCellId();
+    RandomNumberGenerator::Instance()->Reseed(seed);
+
+    std::vector<double> outputs;
+    if (IsLineageModel(rModel))
+    {
+        outputs.push_back(SimulateLineage(rModel, rTheta));
+    }
+    else
+    {
+        outputs = SimulateWan(rTheta);
+    }
+
+    SimulationTime::Destroy();
+    return outputs;
+}
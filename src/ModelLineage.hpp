@@ -0,0 +1,42 @@
+#ifndef MODELLINEAGE_HPP_
+#define MODELLINEAGE_HPP_
+
+#include <string>
+#include <vector>
+
+/***********************************
+ * MODEL LINEAGE
+ * One seed of the He, Gomes, Boije or Wan model at a parameter vector theta, simulated in-process, for drivers that
+ * run many parameter sets in one process (AbcSampler, SobolSweep) instead of one simulator command line per set.
+ *
+ * theta holds the model's parameters in its simulator's argument order (GetParameterNames()):
+ * He: stochastic mode, fixture 0, wild type founders; Gomes & Boije: as their simulators;
+ * Wan: as WanSimulator's arguments 4-22, then --end-time.
+ * No output files are written; Simulate() returns the seed's outputs, named by GetOutputNames():
+ * the end count for the lineage models; the stem, RPC & post-mitotic cells at the end time for Wan.
+ *
+ * Each call resets SimulationTime, the RNG & the cell ID counter, so seeds give the simulators' lineages.
+ ************************************/
+
+class ModelLineage
+{
+public:
+    //Parameter names in the simulator's argument order; empty for an unknown model
+    static std::vector<std::string> GetParameterNames(const std::string& rModel);
+
+    //Parameters the simulator takes as unsigned (Boije generations)
+    static bool IsIntegerParameter(const std::string& rModel, unsigned index);
+
+    //Whether theta passes the simulator's sanity checks
+    static bool IsValidParameters(const std::string& rModel, const std::vector<double>& rTheta);
+
+    //Whether the model simulates a single-founder lineage (He, Gomes, Boije) rather than a population (Wan)
+    static bool IsLineageModel(const std::string& rModel);
+
+    static std::vector<std::string> GetOutputNames(const std::string& rModel);
+
+    //Simulate one seed at theta; returns its outputs, in GetOutputNames() order
+    static std::vector<double> Simulate(const std::string& rModel, const std::vector<double>& rTheta, unsigned seed);
+};
+
+#endif /*MODELLINEAGE_HPP_*/
@@ -1,10 +1,14 @@
 #include "OffLatticeSimulationPropertyStop.hpp"
 
 #include <boost/make_shared.hpp>
+#include <algorithm>
+#include <cfloat>
 
 #include "CellBasedEventHandler.hpp"
 #include "ForwardEulerNumericalMethod.hpp"
 #include "StepSizeException.hpp"
+#include "AbstractCellBasedSimulationModifier.hpp"
+#include "CellAncestor.hpp"
 
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::OffLatticeSimulationPropertyStop(AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>& rCellPopulation,
@@ -12,7 +16,16 @@ OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::OffLatticeSimulationPro
                                                 bool initialiseCells
                                                 )
     : AbstractCellBasedSimulation<ELEMENT_DIM,SPACE_DIM>(rCellPopulation, deleteCellPopulationInDestructor, initialiseCells),
-    p_property()
+    p_property(),
+    mSimulationOutputDisabled(false),
+    mCountTimes(),
+    mCounts(),
+    mCountProperties(),
+    mPropertyCounts(),
+    mInductionTimes(),
+    mpInducibleType(),
+    mInduced(),
+    mRandomStream()
 {
     if (!dynamic_cast<AbstractOffLatticeCellPopulation<ELEMENT_DIM,SPACE_DIM>*>(&rCellPopulation))
     {
@@ -44,6 +57,266 @@ void OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::SetStopProperty(bo
 	 p_property = stopPropertySetting;
 }
 
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::DisableSimulationOutput()
+{
+    mSimulationOutputDisabled = true;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::SetCountTimes(std::vector<double> countTimes)
+{
+    std::sort(countTimes.begin(), countTimes.end());
+    mCountTimes = countTimes;
+    mCounts.clear();
+    mPropertyCounts.clear();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const std::vector<unsigned>& OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::rGetCounts() const
+{
+    return mCounts;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::AddCountProperty(boost::shared_ptr<AbstractCellProperty> pProperty)
+{
+    mCountProperties.push_back(pProperty);
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+const std::vector<std::vector<unsigned> >& OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::rGetPropertyCounts() const
+{
+    return mPropertyCounts;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+std::vector<unsigned> OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::CountCellsWithProperties()
+{
+    std::vector<unsigned> property_counts(mCountProperties.size(), 0);
+    if (mCountProperties.empty()) return property_counts;
+
+    // Population iterator skips dead cells
+    for (typename AbstractCellPopulation<ELEMENT_DIM, SPACE_DIM>::Iterator cell_iter = this->mrCellPopulation.Begin();
+         cell_iter != this->mrCellPopulation.End();
+         ++cell_iter)
+    {
+        CellPropertyCollection& r_collection = cell_iter->rGetCellPropertyCollection();
+        for (CellPropertyCollection::Iterator prop_iter = r_collection.Begin(); prop_iter != r_collection.End(); ++prop_iter)
+        {
+            for (unsigned i = 0; i < mCountProperties.size(); i++)
+            {
+                if ((*prop_iter)->IsSame(mCountProperties[i]))
+                {
+                    property_counts[i]++;
+                }
+            }
+        }
+    }
+    return property_counts;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::RecordCountsUntil(double time)
+{
+    while (mCounts.size() < mCountTimes.size() && mCountTimes[mCounts.size()] < time + 0.5 * this->mDt)
+    {
+        mCounts.push_back(this->mrCellPopulation.GetNumRealCells());
+        mPropertyCounts.push_back(CountCellsWithProperties());
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::SetInductionTimes(std::vector<double> inductionTimes, boost::shared_ptr<AbstractCellProperty> pInducibleType)
+{
+    // bit 31 is left clear so a full mask never reads as UNSIGNED_UNSET (no ancestor)
+    if (inductionTimes.size() > 31)
+    {
+        EXCEPTION("At most 31 induction times can be labelled in one simulation");
+    }
+    std::sort(inductionTimes.begin(), inductionTimes.end());
+    mInductionTimes = inductionTimes;
+    mpInducibleType = pInducibleType;
+    mInduced.clear();
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::SetRandomStream(const LineageRandomStream& rStream)
+{
+    mRandomStream = rStream;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::InduceClonesUntil(double time)
+{
+    while (mInduced.size() < mInductionTimes.size() && mInductionTimes[mInduced.size()] < time + 0.5 * this->mDt)
+    {
+        std::vector<CellPtr> inducible_cells;
+        for (typename AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>::Iterator cell_iter = this->mrCellPopulation.Begin();
+             cell_iter != this->mrCellPopulation.End();
+             ++cell_iter)
+        {
+            if ((*cell_iter)->GetCellProliferativeType()->IsSame(mpInducibleType))
+            {
+                inducible_cells.push_back(*cell_iter);
+            }
+        }
+
+        if (inducible_cells.empty())
+        {
+            mInduced.push_back(false);
+            continue;
+        }
+
+        CellPtr p_founder = inducible_cells[mRandomStream.randMod(inducible_cells.size())];
+        unsigned mask = p_founder->GetAncestor();
+        if (mask == UNSIGNED_UNSET) mask = 0;
+        mask |= (1u << mInduced.size());
+
+        // a fresh CellAncestor per labelling- the founder's old one is still shared with cells outside this clone
+        MAKE_PTR_ARGS(CellAncestor, p_clone, (mask));
+        if (p_founder->HasCellProperty<CellAncestor>()) p_founder->RemoveCellProperty<CellAncestor>();
+        p_founder->AddCellProperty(p_clone);
+        mInduced.push_back(true);
+    }
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+std::vector<unsigned> OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::CountClones()
+{
+    std::vector<unsigned> clone_sizes(mInductionTimes.size(), 0);
+    if (mInductionTimes.empty()) return clone_sizes;
+
+    for (typename AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>::Iterator cell_iter = this->mrCellPopulation.Begin();
+         cell_iter != this->mrCellPopulation.End();
+         ++cell_iter)
+    {
+        unsigned mask = (*cell_iter)->GetAncestor();
+        if (mask == UNSIGNED_UNSET) continue;
+        for (unsigned i = 0; i < mInduced.size(); i++)
+        {
+            if (mInduced[i] && (mask & (1u << i))) clone_sizes[i]++;
+        }
+    }
+    return clone_sizes;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+std::vector<unsigned> OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::CountCellsByAncestor(unsigned numFounders)
+{
+    std::vector<unsigned> counts(numFounders, 0);
+    for (typename AbstractCellPopulation<ELEMENT_DIM,SPACE_DIM>::Iterator cell_iter = this->mrCellPopulation.Begin();
+         cell_iter != this->mrCellPopulation.End();
+         ++cell_iter)
+    {
+        unsigned founder = (*cell_iter)->GetAncestor();
+        if (founder < numFounders) counts[founder]++;
+    }
+    return counts;
+}
+
+template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
+void OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::Solve()
+{
+    if (!mSimulationOutputDisabled)
+    {
+        if (!mInductionTimes.empty())
+        {
+            EXCEPTION("Induction times need DisableSimulationOutput()");
+        }
+        if (!mCountTimes.empty())
+        {
+            EXCEPTION("Count times need DisableSimulationOutput()");
+        }
+
+        AbstractCellBasedSimulation<ELEMENT_DIM,SPACE_DIM>::Solve();
+        return;
+    }
+
+    /**************
+     * No simulation output: this mirrors AbstractCellBasedSimulation::Solve() with the output directory,
+     * OutputFileHandler, visualizer setup file, results writers & parameter file removed
+     **************/
+    CellBasedEventHandler::BeginEvent(CellBasedEventHandler::EVERYTHING);
+    CellBasedEventHandler::BeginEvent(CellBasedEventHandler::SETUP);
+
+    SimulationTime* p_simulation_time = SimulationTime::Instance();
+    double current_time = p_simulation_time->GetTime();
+
+    unsigned num_time_steps = (unsigned) ((this->mEndTime - current_time) / this->mDt + 0.5);
+    if (current_time > 0) // use the reset function if Solve() is being called again to extend the simulation
+    {
+        p_simulation_time->ResetEndTimeAndNumberOfTimeSteps(this->mEndTime, num_time_steps);
+    }
+    else
+    {
+        if (p_simulation_time->IsEndTimeAndNumberOfTimeStepsSetUp())
+        {
+            EXCEPTION("End time and number of timesteps already setup. You should not use SimulationTime::SetEndTimeAndNumberOfTimeSteps in cell-based tests.");
+        }
+        p_simulation_time->SetEndTimeAndNumberOfTimeSteps(this->mEndTime, num_time_steps);
+    }
+
+    for (typename std::vector<boost::shared_ptr<AbstractCellBasedSimulationModifier<ELEMENT_DIM, SPACE_DIM> > >::iterator iter = this->mSimulationModifiers.begin();
+         iter != this->mSimulationModifiers.end();
+         ++iter)
+    {
+        (*iter)->SetupSolve(this->mrCellPopulation, this->mOutputDirectory);
+    }
+
+    SetupSolve();
+
+    // Count times already passed (eg. before a lineage's first mitosis) see the population as it stands
+    RecordCountsUntil(current_time - this->mDt);
+    InduceClonesUntil(current_time - this->mDt);
+
+    CellBasedEventHandler::EndEvent(CellBasedEventHandler::SETUP);
+
+    // Main time loop- identical to the base class, less the per-step writers
+    while (!(p_simulation_time->IsFinished() || StoppingEventHasOccurred()))
+    {
+        this->UpdateCellPopulation();
+
+        RecordCountsUntil(p_simulation_time->GetTime());
+        InduceClonesUntil(p_simulation_time->GetTime());
+
+        UpdateCellLocationsAndTopology();
+
+        this->mrCellPopulation.UpdateCellProcessLocation();
+
+        p_simulation_time->IncrementTimeOneStep();
+
+        CellBasedEventHandler::BeginEvent(CellBasedEventHandler::UPDATESIMULATION);
+        for (typename std::vector<boost::shared_ptr<AbstractCellBasedSimulationModifier<ELEMENT_DIM, SPACE_DIM> > >::iterator iter = this->mSimulationModifiers.begin();
+             iter != this->mSimulationModifiers.end();
+             ++iter)
+        {
+            (*iter)->UpdateAtEndOfTimeStep(this->mrCellPopulation);
+        }
+        CellBasedEventHandler::EndEvent(CellBasedEventHandler::UPDATESIMULATION);
+    }
+
+    // Final update so that the cell population is coherent (dead cells removed, final births done)
+    this->UpdateCellPopulation();
+
+    // Remaining count times: reached at the end time, or after a stopping event the population no longer changes
+    RecordCountsUntil(DBL_MAX);
+
+    // Induction times after a stopping event are never reached; their clones stay empty
+    InduceClonesUntil(p_simulation_time->GetTime());
+
+    CellBasedEventHandler::BeginEvent(CellBasedEventHandler::UPDATESIMULATION);
+    for (typename std::vector<boost::shared_ptr<AbstractCellBasedSimulationModifier<ELEMENT_DIM, SPACE_DIM> > >::iterator iter = this->mSimulationModifiers.begin();
+         iter != this->mSimulationModifiers.end();
+         ++iter)
+    {
+        (*iter)->UpdateAtEndOfSolve(this->mrCellPopulation);
+    }
+    CellBasedEventHandler::EndEvent(CellBasedEventHandler::UPDATESIMULATION);
+
+    CellBasedEventHandler::EndEvent(CellBasedEventHandler::EVERYTHING);
+}
+
 template<unsigned ELEMENT_DIM, unsigned SPACE_DIM>
 void OffLatticeSimulationPropertyStop<ELEMENT_DIM,SPACE_DIM>::AddForce(boost::shared_ptr<AbstractForce<ELEMENT_DIM,SPACE_DIM> > pForce)
 {
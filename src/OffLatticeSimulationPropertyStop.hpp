@@ -5,6 +5,7 @@
 #include "AbstractForce.hpp"
 #include "AbstractCellPopulationBoundaryCondition.hpp"
 #include "AbstractNumericalMethod.hpp"
+#include "LineageRandomStream.hpp"
 
 #include "ChasteSerialization.hpp"
 #include <boost/serialization/base_object.hpp>
@@ -55,10 +56,39 @@ private:
         archive & mForceCollection;
         archive & mBoundaryConditions;
         archive & mpNumericalMethod;
+        archive & mSimulationOutputDisabled;
     }
 
 protected:
     boost::shared_ptr<AbstractCellProperty> p_property;
+
+    /** Whether Solve() should skip the output directory and all visualizer/results/parameter writers. */
+    bool mSimulationOutputDisabled;
+
+    /** Simulation times at which Solve() records the number of real cells, ascending. */
+    std::vector<double> mCountTimes;
+
+    /** Cell counts recorded at mCountTimes so far. */
+    std::vector<unsigned> mCounts;
+
+    /** Properties (eg. fates) whose cell counts are recorded with each count; matched by property type. */
+    std::vector<boost::shared_ptr<AbstractCellProperty> > mCountProperties;
+
+    /** Per-property cell counts recorded at mCountTimes so far, one vector per count time. */
+    std::vector<std::vector<unsigned> > mPropertyCounts;
+
+    /** Simulation times at which Solve() labels a clone founder, ascending; clone i is marked by bit i of the cells' CellAncestor. */
+    std::vector<double> mInductionTimes;
+
+    /** Proliferative type of cells that may be labelled at an induction time. */
+    boost::shared_ptr<AbstractCellProperty> mpInducibleType;
+
+    /** Whether a cell was labelled at each induction time reached so far. */
+    std::vector<bool> mInduced;
+
+    /** The lineage's draws, from which each induction picks its cell; see SetRandomStream(). */
+    LineageRandomStream mRandomStream;
+
     /** The mechanics used to determine the new location of the cells, a list of the forces. */
     std::vector<boost::shared_ptr<AbstractForce<ELEMENT_DIM, SPACE_DIM> > > mForceCollection;
 
@@ -102,6 +132,21 @@ protected:
 
     bool StoppingEventHasOccurred();
 
+    /**
+     * Record the number of real cells for every count time within half a timestep of time, or earlier.
+     *
+     * @param time the current simulation time
+     */
+    void RecordCountsUntil(double time);
+
+    /**
+     * Label a random inducible cell for every induction time within half a timestep of time, or earlier.
+     * The cell's CellAncestor bitmask gains the induction's bit, which its descendants inherit.
+     *
+     * @param time the current simulation time
+     */
+    void InduceClonesUntil(double time);
+
 public:
 
     /**
@@ -120,6 +165,86 @@ public:
 
     bool HasStoppingEventOccurred();
 
+    /**
+     * Switch the simulation into "no simulation output" mode.
+     * Solve() will then not require an output directory, will not create one, and will not call
+     * any per-step or per-run writer (results files, visualizer setup file, simulation parameters).
+     * Intended for the lineage simulators, whose only output is their own result stream.
+     */
+    void DisableSimulationOutput();
+
+    /**
+     * Hides AbstractCellBasedSimulation::Solve().
+     * If simulation output is enabled this simply calls the base class Solve(), & count & induction times are
+     * refused; otherwise the same time loop is run with all file output removed.
+     */
+    void Solve();
+
+    /**
+     * Set simulation times at which Solve() records the lineage's cell count, so counts at several times
+     * come from one simulation rather than one simulation per end time.
+     * Each count is taken after the population update at the nearest timestep, which is what a simulation
+     * ending at that time would count. Count times before the start of Solve() see the population as it stands;
+     * count times after a stopping event see the final population.
+     * Needs DisableSimulationOutput().
+     *
+     * @param countTimes the count times (simulation time, not hpf)
+     */
+    void SetCountTimes(std::vector<double> countTimes);
+
+    /**
+     * @return the counts recorded at the count times, in ascending count time order
+     */
+    const std::vector<unsigned>& rGetCounts() const;
+
+    /**
+     * Add a property whose cell count is recorded with each count, for fate composition snapshots.
+     *
+     * @param pProperty the property; cells are matched by property type, so any instance will do
+     */
+    void AddCountProperty(boost::shared_ptr<AbstractCellProperty> pProperty);
+
+    /**
+     * @return the per-property counts recorded at the count times, in the order properties were added
+     */
+    const std::vector<std::vector<unsigned> >& rGetPropertyCounts() const;
+
+    /**
+     * @return the number of live cells with each count property, now
+     */
+    std::vector<unsigned> CountCellsWithProperties();
+
+    /**
+     * Set simulation times at which Solve() labels one live cell of the inducible type, so the clones induced
+     * at several times come from one simulated lineage rather than one founder per induction time.
+     * Induction times before the start of Solve() label a cell of the population as it stands.
+     * If no inducible cell is alive at an induction time (or the simulation has stopped), that clone is empty.
+     * Needs DisableSimulationOutput(). Cells' CellAncestor is used as the clone bitmask, so at most 31 times.
+     *
+     * @param inductionTimes the induction times (simulation time, not hpf)
+     * @param pInducibleType the proliferative type of cells which may be labelled (eg. transit/mitotic)
+     */
+    void SetInductionTimes(std::vector<double> inductionTimes, boost::shared_ptr<AbstractCellProperty> pInducibleType);
+
+    /**
+     * Pick the cell labelled at each induction time with draws from this stream, as the lineage's cell cycle models
+     * draw (see LineageRandomStream). Unset, the stream forwards to the RandomNumberGenerator singleton.
+     *
+     * @param rStream the lineage's stream, eg. the one given to its founder's cell cycle model
+     */
+    void SetRandomStream(const LineageRandomStream& rStream);
+
+    /**
+     * @return the number of live cells in the clone induced at each induction time, now; 0 for clones never induced
+     */
+    std::vector<unsigned> CountClones();
+
+    /**
+     * Packed runs (--pack) tag founder i with CellAncestor i, so one population holds several independent lineages.
+     * @return the number of live cells descended from each of numFounders founders, now
+     */
+    std::vector<unsigned> CountCellsByAncestor(unsigned numFounders);
+
     /**
      * Add a force to be used in this simulation (use this to set the mechanics system).
      *
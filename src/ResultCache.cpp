@@ -0,0 +1,219 @@
+#include "ResultCache.hpp"
+#include "LineageOutput.hpp"
+#include "OutputFileHandler.hpp"
+#include "ExecutableSupport.hpp"
+#include "Exception.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+namespace
+{
+    const std::string BLOCK_MAGIC = "ISPRC03\n"; //also part of every job description, so a format change misses old entries
+
+    bool ReadFile(const std::string& rPath, std::string& rContents)
+    {
+        std::ifstream file(rPath.c_str(), std::ios::binary);
+        if (!file.is_open()) return false;
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        rContents = contents.str();
+        return true;
+    }
+
+    //Replace the first field of every line with the entry number
+    std::string ReplaceEntries(const std::string& rText, unsigned entryNumber)
+    {
+        std::string replaced;
+        std::istringstream lines(rText);
+        std::string line;
+        while (std::getline(lines, line))
+        {
+            size_t tab = line.find('\t');
+            replaced += (tab == std::string::npos) ? line : std::to_string(entryNumber) + line.substr(tab);
+            replaced += "\n";
+        }
+        return replaced;
+    }
+}
+
+ResultCache::ResultCache()
+    : mEnabled(false)
+{
+}
+
+void ResultCache::Open(const std::string& rDirectory, const std::string& rJobDescription)
+{
+    OutputFileHandler handler(rDirectory, false);
+    mDirectoryPath = handler.GetOutputDirectoryFullPath();
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long)Hash(rJobDescription));
+    mKey = key;
+
+    //the job file guards against hash collisions: a different job with the same key is not cached
+    std::string job_path = mDirectoryPath + mKey + ".job";
+    std::string cached_job;
+    if (ReadFile(job_path, cached_job))
+    {
+        if (cached_job != rJobDescription)
+        {
+            ExecutableSupport::Print("Result cache key " + mKey + " belongs to another job; not caching this run");
+            return;
+        }
+    }
+    else
+    {
+        WriteFile(job_path, rJobDescription);
+    }
+
+    mEnabled = true;
+    LineageOutput::Instance()->EnableCapture();
+}
+
+bool ResultCache::IsEnabled() const
+{
+    return mEnabled;
+}
+
+bool ResultCache::Replay(unsigned seed, unsigned entryNumber)
+{
+    if (!mEnabled) return false;
+
+    const std::map<unsigned, std::string>& r_block = rGetCachedBlock(seed / BLOCK_SIZE);
+    std::map<unsigned, std::string>::const_iterator it = r_block.find(seed);
+    if (it == r_block.end()) return false;
+
+    size_t pos = 0;
+    unsigned cached_seed;
+    std::vector<std::string> texts;
+    LineageOutput::UnpackSeed(it->second, pos, cached_seed, texts);
+    for (unsigned sink = 0; sink < LineageOutput::NUM_SINKS; sink++)
+    {
+        if (LineageOutput::HasEntryColumn(sink))
+        {
+            texts[sink] = ReplaceEntries(texts[sink], entryNumber);
+        }
+    }
+
+    std::string packed;
+    LineageOutput::PackSeed(seed, texts, packed);
+    LineageOutput::Instance()->CommitForwarded(packed);
+    LineageOutput::Instance()->TakeCaptured(); //already cached
+    return true;
+}
+
+void ResultCache::Store(unsigned seed)
+{
+    if (!mEnabled) return;
+
+    unsigned block = seed / BLOCK_SIZE;
+    std::pair<unsigned, std::string>& r_pending = mPendingBlocks[block];
+    r_pending.first++;
+    r_pending.second += LineageOutput::Instance()->TakeCaptured();
+
+    if (r_pending.first == BLOCK_SIZE)
+    {
+        WriteFile(GetBlockPath(block), BLOCK_MAGIC + r_pending.second);
+        mPendingBlocks.erase(block);
+    }
+}
+
+std::string ResultCache::GetBlockPath(unsigned block) const
+{
+    return mDirectoryPath + mKey + "_" + std::to_string(block) + ".block";
+}
+
+const std::map<unsigned, std::string>& ResultCache::rGetCachedBlock(unsigned block)
+{
+    std::map<unsigned, std::map<unsigned, std::string> >::iterator it = mCachedBlocks.find(block);
+    if (it != mCachedBlocks.end()) return it->second;
+
+    std::map<unsigned, std::string>& r_block = mCachedBlocks[block];
+    std::string contents;
+    if (ReadFile(GetBlockPath(block), contents) && contents.compare(0, BLOCK_MAGIC.size(), BLOCK_MAGIC) == 0)
+    {
+        size_t pos = BLOCK_MAGIC.size();
+        size_t start = pos;
+        unsigned seed;
+        std::vector<std::string> texts;
+        while (LineageOutput::UnpackSeed(contents, pos, seed, texts))
+        {
+            r_block[seed] = contents.substr(start, pos - start);
+            start = pos;
+        }
+
+        //a truncated block is treated as missing, & is rewritten by the next run that simulates it
+        if (pos != contents.size() || r_block.size() != BLOCK_SIZE)
+        {
+            r_block.clear();
+        }
+    }
+    return r_block;
+}
+
+void ResultCache::WriteFile(const std::string& rPath, const std::string& rContents) const
+{
+    //written under a temporary name & renamed, so concurrent fixture processes never read a partial file
+    std::string temp_path = rPath + ".tmp" + std::to_string(getpid());
+    std::ofstream file(temp_path.c_str(), std::ios::binary);
+    file.write(rContents.data(), rContents.size());
+    file.close();
+    if (!file || std::rename(temp_path.c_str(), rPath.c_str()) != 0)
+    {
+        std::remove(temp_path.c_str());
+        EXCEPTION("Could not write result cache file " + rPath);
+    }
+}
+
+std::string ResultCache::MakeJobDescription(int argc, char* argv[], const std::vector<int>& rSkippedArguments)
+{
+    std::string executable(argv[0]);
+    size_t slash = executable.find_last_of('/');
+    std::string description = BLOCK_MAGIC + executable.substr(slash == std::string::npos ? 0 : slash + 1);
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if (arg == "--serial" || arg == "--resume") continue;
+        if (arg == "--cache")
+        {
+            i++; //and its directory
+            continue;
+        }
+        bool skipped = false;
+        for (unsigned j = 0; j < rSkippedArguments.size(); j++)
+        {
+            if (rSkippedArguments[j] == i) skipped = true;
+        }
+        if (skipped) continue;
+
+        //decimals are written at full precision, so equal values written differently share a key;
+        //integers are left alone, as outputMode digit strings ("01") are not numbers
+        char* p_end;
+        double value = strtod(arg.c_str(), &p_end);
+        if (!arg.empty() && *p_end == '\0' && arg.find_first_of(".eE") != std::string::npos)
+        {
+            char number[32];
+            snprintf(number, sizeof(number), "%.17g", value);
+            arg = number;
+        }
+        description += " " + arg;
+    }
+    return description;
+}
+
+uint64_t ResultCache::Hash(const std::string& rText)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned i = 0; i < rText.size(); i++)
+    {
+        hash ^= (unsigned char)rText[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,73 @@
+#ifndef RESULTCACHE_HPP_
+#define RESULTCACHE_HPP_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+/***********************************
+ * RESULT CACHE
+ * On-disk cache of simulator output, so fixtures re-evaluating a parameterisation (eg. SPSA's projected thetas,
+ * the Kolmogorov & output fixtures' reference runs) replay it instead of simulating it again.
+ *
+ * USE: the simulator calls Open(<cache directory>, MakeJobDescription(...)) after LineageOutput is open, then for each seed
+ * if (cache.Replay(seed, entry_number)) continue; before simulating it, & cache.Store(seed) after LineageOutput::CommitSeed(seed).
+ *
+ * A job is everything that determines a seed's output: simulator, outputMode & model/fixture arguments & options, but not the
+ * output directory, filename or seed range. Its FNV-1a hash names the cache files, so the cache is content-addressed.
+ * Output is cached in blocks of BLOCK_SIZE seeds (block b = seeds b*BLOCK_SIZE..(b+1)*BLOCK_SIZE-1), holding each seed's
+ * packed LineageOutput buffers; any seed range replays the blocks it overlaps. A block is written once all its seeds have
+ * been simulated by one process, so ranges that only partly cover a block, & MPI workers' partial blocks, do not fill it.
+ * Replayed lines get the current run's entry numbers.
+ *
+ * Only LineageOutput is cached- debug traces & lineage tree archives are not, so the simulators refuse those with a cache.
+ * The cache does not know about model code: clear it after changing a cell cycle model.
+ ************************************/
+
+class ResultCache
+{
+private:
+    bool mEnabled;
+    std::string mDirectoryPath; //full path, ending in '/'
+    std::string mKey; //hex hash of the job description
+
+    //Blocks read from the cache: block -> seed -> packed seed; a missing block maps to an empty map
+    std::map<unsigned, std::map<unsigned, std::string> > mCachedBlocks;
+
+    //Blocks being simulated this run: block -> (seeds stored, packed seeds)
+    std::map<unsigned, std::pair<unsigned, std::string> > mPendingBlocks;
+
+    std::string GetBlockPath(unsigned block) const;
+    const std::map<unsigned, std::string>& rGetCachedBlock(unsigned block);
+    void WriteFile(const std::string& rPath, const std::string& rContents) const;
+
+public:
+    static const unsigned BLOCK_SIZE = 50;
+
+    ResultCache();
+
+    /**
+     * Enable the cache for this job; relative to CHASTE_TEST_OUTPUT, as for LineageOutput.
+     * Also enables LineageOutput capture, so committed seeds can be stored.
+     */
+    void Open(const std::string& rDirectory, const std::string& rJobDescription);
+    bool IsEnabled() const;
+
+    //Commit the seed's cached output to LineageOutput with this run's entry number; false if it is not cached
+    bool Replay(unsigned seed, unsigned entryNumber);
+
+    //Keep the seed's just-committed LineageOutput; writes its block once the block is complete
+    void Store(unsigned seed);
+
+    /**
+     * Canonical job description from the simulator's command line: the executable name, positional arguments except
+     * rSkippedArguments (argv indices), then options except --cache, --serial & --resume. Decimals are reformatted, so "0.2" & "0.20" match.
+     */
+    static std::string MakeJobDescription(int argc, char* argv[], const std::vector<int>& rSkippedArguments);
+
+    //64 bit FNV-1a
+    static uint64_t Hash(const std::string& rText);
+};
+
+#endif /*RESULTCACHE_HPP_*/
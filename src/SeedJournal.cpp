@@ -0,0 +1,147 @@
+#include "SeedJournal.hpp"
+#include "ResultCache.hpp"
+#include "OutputFileHandler.hpp"
+#include "Exception.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+SeedJournal::SeedJournal()
+    : mFileDescriptor(-1),
+      mWholeLinesSize(0)
+{
+}
+
+SeedJournal::~SeedJournal()
+{
+    Close();
+}
+
+void SeedJournal::Open(const std::string& rDirectory, const std::string& rFilename, const std::string& rJobDescription,
+                       bool resume, bool writer)
+{
+    OutputFileHandler handler(rDirectory, false);
+    std::string path = handler.GetOutputDirectoryFullPath() + rFilename;
+
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)ResultCache::Hash(rJobDescription));
+    std::string job_line = "#job " + std::string(hash) + "\n";
+
+    mCompleted.clear();
+    mResumeFileSizes.clear();
+    mWholeLinesSize = 0;
+    if (resume)
+    {
+        Read(path, job_line);
+    }
+
+    if (writer)
+    {
+        int flags = O_WRONLY | O_CREAT | O_APPEND;
+        if (!resume || mCompleted.empty())
+        {
+            flags |= O_TRUNC;
+        }
+        else if (truncate(path.c_str(), mWholeLinesSize) != 0) //drop a partly written last line, so appends start a new line
+        {
+            EXCEPTION("Could not truncate seed journal " + path);
+        }
+        mFileDescriptor = open(path.c_str(), flags, 0644);
+        if (mFileDescriptor < 0)
+        {
+            EXCEPTION("Could not open seed journal " + path);
+        }
+        if (flags & O_TRUNC)
+        {
+            if (write(mFileDescriptor, job_line.data(), job_line.size()) != (ssize_t)job_line.size())
+            {
+                EXCEPTION("Could not write seed journal " + path);
+            }
+        }
+    }
+}
+
+void SeedJournal::Read(const std::string& rPath, const std::string& rJobLine)
+{
+    std::ifstream file(rPath.c_str());
+    if (!file.is_open()) return; //nothing to resume
+
+    std::ostringstream contents_stream;
+    contents_stream << file.rdbuf();
+    std::string contents = contents_stream.str();
+
+    if (contents.empty()) return;
+    if (contents.compare(0, rJobLine.size(), rJobLine) != 0)
+    {
+        EXCEPTION("Seed journal " + rPath + " was written by a different simulator command line; cannot resume it");
+    }
+
+    //only whole lines: the last may have been cut off by the crash
+    size_t pos = rJobLine.size();
+    size_t end;
+    while ((end = contents.find('\n', pos)) != std::string::npos)
+    {
+        std::istringstream line(contents.substr(pos, end - pos));
+        unsigned seed;
+        if (line >> seed)
+        {
+            mCompleted.insert(seed);
+            mResumeFileSizes.clear();
+            long long size;
+            while (line >> size)
+            {
+                mResumeFileSizes.push_back(size);
+            }
+        }
+        pos = end + 1;
+    }
+    mWholeLinesSize = pos;
+}
+
+bool SeedJournal::IsComplete(unsigned seed) const
+{
+    return mCompleted.count(seed) > 0;
+}
+
+unsigned SeedJournal::GetNumCompleted() const
+{
+    return mCompleted.size();
+}
+
+const std::vector<long long>& SeedJournal::rGetResumeFileSizes() const
+{
+    return mResumeFileSizes;
+}
+
+void SeedJournal::RecordSeed(unsigned seed, const std::vector<long long>& rFileSizes)
+{
+    if (mFileDescriptor < 0) return;
+
+    std::ostringstream line;
+    line << seed;
+    for (unsigned i = 0; i < rFileSizes.size(); i++)
+    {
+        line << "\t" << rFileSizes[i];
+    }
+    line << "\n";
+
+    //one write per line, so a crash leaves at most one partial line & concurrent appends do not interleave
+    std::string text = line.str();
+    if (write(mFileDescriptor, text.data(), text.size()) != (ssize_t)text.size())
+    {
+        EXCEPTION("Could not write seed journal");
+    }
+    mCompleted.insert(seed);
+}
+
+void SeedJournal::Close()
+{
+    if (mFileDescriptor >= 0)
+    {
+        close(mFileDescriptor);
+        mFileDescriptor = -1;
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef SEEDJOURNAL_HPP_
+#define SEEDJOURNAL_HPP_
+
+#include <string>
+#include <vector>
+#include <set>
+
+/***********************************
+ * SEED JOURNAL
+ * Progress journal for a simulator run, so a killed or crashed run over a long seed range can be resumed (--resume)
+ * instead of restarted from startSeed.
+ *
+ * USE: the simulator opens the journal next to its output (<filename>.journal) before LineageOutput, then
+ * skips seeds for which IsComplete(); see LineageOutput::ResumeFrom() & SetJournal(). LineageOutput records each
+ * committed seed, with its sink files' sizes after the commit. Simulators without LineageOutput (WanSimulator)
+ * call RecordSeed() themselves.
+ *
+ * File layout (text): "#job <hash>" (see ResultCache::MakeJobDescription), then one line per committed seed,
+ * "<seed>\t<file size>...". Each line is appended with one write(); a partly written last line is ignored & cut off on resume.
+ * On resume, output written after the last journaled seed is truncated away, so those seeds are simulated again.
+ ************************************/
+
+class SeedJournal
+{
+private:
+    int mFileDescriptor; //-1 if this process does not write the journal
+    std::set<unsigned> mCompleted;
+    std::vector<long long> mResumeFileSizes; //file sizes recorded with the last journaled seed
+    long long mWholeLinesSize; //bytes of a resumed journal up to the end of its last whole line
+
+    //Read a previous run's journal; throws if it belongs to another job
+    void Read(const std::string& rPath, const std::string& rJobLine);
+
+public:
+    SeedJournal();
+    ~SeedJournal();
+
+    /**
+     * Open the journal; relative to CHASTE_TEST_OUTPUT, as for LineageOutput.
+     * @param rJobDescription the run's command line, as ResultCache::MakeJobDescription(); resuming another job is an error
+     * @param resume read the completed seeds & append; otherwise start a new journal
+     * @param writer whether this process records seeds (false for MPI worker ranks, which only read it to skip seeds)
+     */
+    void Open(const std::string& rDirectory, const std::string& rFilename, const std::string& rJobDescription,
+              bool resume, bool writer);
+
+    bool IsComplete(unsigned seed) const;
+    unsigned GetNumCompleted() const;
+
+    //Sink file sizes to resume LineageOutput from; empty if nothing was journaled
+    const std::vector<long long>& rGetResumeFileSizes() const;
+
+    void RecordSeed(unsigned seed, const std::vector<long long>& rFileSizes = std::vector<long long>());
+
+    void Close();
+};
+
+#endif /*SEEDJOURNAL_HPP_*/
@@ -0,0 +1,198 @@
+#include "SeedRangeRunner.hpp"
+#include "LineageOutput.hpp"
+#include "PetscTools.hpp"
+#include "Exception.hpp"
+
+#include <map>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+
+namespace
+{
+    const int TAG_REQUEST = 1; //worker -> rank 0: finished chunk (start, end) & its packed output
+    const int TAG_ASSIGN = 2; //rank 0 -> worker: next chunk (start, end); start > end means stop
+
+    //Smallest chunk; chunks are remaining seeds / (2 * workers), so the last seeds go out singly
+    const unsigned MIN_CHUNK = 1;
+}
+
+SeedRangeRunner::SeedRangeRunner(unsigned startSeed, unsigned endSeed, bool gatherOutput, unsigned packSize)
+    : mStartSeed(startSeed),
+      mEndSeed(endSeed),
+      mPackSize(std::max(1u, packSize)),
+      mGatherOutput(gatherOutput),
+      mRank(0),
+      mNumProcs(1),
+      mChunkStart(1),
+      mChunkEnd(0),
+      mNextSeed(1),
+      mFinished(false)
+{
+    //one process, rank 0, if PETSc was not initialised (--serial)
+    mRank = PetscTools::GetMyRank();
+    mNumProcs = PetscTools::GetNumProcs();
+
+    if (mNumProcs == 1)
+    {
+        mChunkStart = mStartSeed;
+        mChunkEnd = mEndSeed;
+        mNextSeed = mStartSeed;
+    }
+    else
+    {
+        //every rank runs its own serial simulations, with its own output file handling
+        PetscTools::IsolateProcesses(true);
+        if (mRank != 0 && mGatherOutput)
+        {
+            LineageOutput::Instance()->EnableForwarding();
+        }
+    }
+}
+
+bool SeedRangeRunner::IsParallel() const
+{
+    return mNumProcs > 1;
+}
+
+bool SeedRangeRunner::RunsSimulations() const
+{
+    return !IsParallel() || mRank != 0;
+}
+
+bool SeedRangeRunner::IsWriter() const
+{
+    return mRank == 0;
+}
+
+std::string SeedRangeRunner::GetRankSuffix() const
+{
+    return IsParallel() ? "_" + std::to_string(mRank) : "";
+}
+
+bool SeedRangeRunner::GetNextSeed(unsigned& rSeed)
+{
+    if (mFinished) return false;
+
+    if (IsParallel() && mRank == 0)
+    {
+        Coordinate();
+        mFinished = true;
+        return false;
+    }
+
+    if (mNextSeed > mChunkEnd || mNextSeed < mChunkStart)
+    {
+        if (!IsParallel() || !RequestChunk())
+        {
+            mFinished = true;
+            return false;
+        }
+    }
+
+    rSeed = mNextSeed;
+    if (mNextSeed == mChunkEnd)
+    {
+        //mark the chunk used up without wrapping at the top of the seed range
+        mNextSeed = mChunkStart - 1;
+    }
+    else
+    {
+        mNextSeed++;
+    }
+    return true;
+}
+
+bool SeedRangeRunner::GetNextPack(std::vector<unsigned>& rSeeds)
+{
+    rSeeds.clear();
+    unsigned seed;
+    if (!GetNextSeed(seed)) return false;
+    rSeeds.push_back(seed);
+
+    //stop at the end of the pack, or of the range; chunks are whole packs, so that is never past the end of the chunk
+    while ((seed - mStartSeed + 1) % mPackSize != 0 && mNextSeed >= mChunkStart && mNextSeed <= mChunkEnd)
+    {
+        GetNextSeed(seed);
+        rSeeds.push_back(seed);
+    }
+    return true;
+}
+
+bool SeedRangeRunner::RequestChunk()
+{
+    //a worker's first request carries no chunk (start > end)
+    uint32_t finished_chunk[2] = { mChunkStart, mChunkEnd };
+    std::string message(reinterpret_cast<const char*>(finished_chunk), sizeof(finished_chunk));
+    if (mGatherOutput) message += LineageOutput::Instance()->TakeForwarded();
+    MPI_Send(const_cast<char*>(message.data()), message.size(), MPI_CHAR, 0, TAG_REQUEST, PETSC_COMM_WORLD);
+
+    uint32_t chunk[2];
+    MPI_Recv(chunk, 2, MPI_UNSIGNED, 0, TAG_ASSIGN, PETSC_COMM_WORLD, MPI_STATUS_IGNORE);
+    if (chunk[0] > chunk[1]) return false;
+
+    mChunkStart = chunk[0];
+    mChunkEnd = chunk[1];
+    mNextSeed = mChunkStart;
+    return true;
+}
+
+void SeedRangeRunner::Coordinate()
+{
+    unsigned num_workers = mNumProcs - 1;
+    unsigned active_workers = num_workers;
+    uint64_t next_unassigned = mStartSeed; //64 bit, so a range ending at UINT_MAX terminates
+    uint64_t next_to_commit = mStartSeed;
+
+    //finished chunks waiting for earlier chunks: start -> (end, packed output)
+    std::map<uint64_t, std::pair<uint64_t, std::string> > pending;
+
+    while (active_workers > 0)
+    {
+        MPI_Status status;
+        MPI_Probe(MPI_ANY_SOURCE, TAG_REQUEST, PETSC_COMM_WORLD, &status);
+        int num_bytes;
+        MPI_Get_count(&status, MPI_CHAR, &num_bytes);
+        std::vector<char> message(num_bytes);
+        MPI_Recv(&message[0], num_bytes, MPI_CHAR, status.MPI_SOURCE, TAG_REQUEST, PETSC_COMM_WORLD, MPI_STATUS_IGNORE);
+
+        uint32_t finished_chunk[2];
+        memcpy(finished_chunk, &message[0], sizeof(finished_chunk));
+        if (finished_chunk[0] <= finished_chunk[1])
+        {
+            pending[finished_chunk[0]] = std::make_pair(uint64_t(finished_chunk[1]),
+                    std::string(message.begin() + sizeof(finished_chunk), message.end()));
+        }
+
+        //commit every chunk that is next in seed order
+        std::map<uint64_t, std::pair<uint64_t, std::string> >::iterator it;
+        while ((it = pending.find(next_to_commit)) != pending.end())
+        {
+            if (mGatherOutput) LineageOutput::Instance()->CommitForwarded(it->second.second);
+            next_to_commit = it->second.first + 1;
+            pending.erase(it);
+        }
+
+        uint32_t chunk[2] = { 1, 0 };
+        if (next_unassigned <= mEndSeed)
+        {
+            uint64_t remaining = mEndSeed - next_unassigned + 1;
+            uint64_t chunk_size = std::max<uint64_t>(MIN_CHUNK, remaining / (2 * num_workers));
+            chunk_size = ((chunk_size + mPackSize - 1) / mPackSize) * mPackSize; //whole packs, see GetNextPack()
+            chunk[0] = next_unassigned;
+            chunk[1] = next_unassigned + std::min(chunk_size, remaining) - 1;
+            next_unassigned = uint64_t(chunk[1]) + 1;
+        }
+        else
+        {
+            active_workers--;
+        }
+        MPI_Send(chunk, 2, MPI_UNSIGNED, status.MPI_SOURCE, TAG_ASSIGN, PETSC_COMM_WORLD);
+    }
+
+    if (!pending.empty())
+    {
+        EXCEPTION("SeedRangeRunner: chunks left uncommitted after all workers finished");
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef SEEDRANGERUNNER_HPP_
+#define SEEDRANGERUNNER_HPP_
+
+#include <string>
+#include <vector>
+
+/***********************************
+ * SEED RANGE RUNNER
+ * Hands out a simulator's seed range, serially or across MPI ranks (eg. mpirun -np 4 HeSimulator ...).
+ *
+ * USE: construct with the seed range after the arguments are checked & before any output is opened, then
+ * while (runner.GetNextSeed(seed)) { <simulate seed; commit its LineageOutput> }
+ *
+ * With one process, seeds are simply returned in order.
+ * With N>1 processes, rank 0 only coordinates: workers (ranks 1..N-1) pull chunks of consecutive seeds from it,
+ * shrinking as the range runs out (guided self-scheduling), so heavy-tailed lineage sizes even out.
+ * With a pack size K (--pack), chunks are whole packs, so packs are always startSeed + k*K .. startSeed + (k+1)*K - 1
+ * (the last may be shorter), whichever worker runs them.
+ * Each worker's LineageOutput forwards its committed seeds to rank 0 with its next chunk request;
+ * rank 0 commits chunks in seed order, so the output files are those of a serial run.
+ * Processes are isolated (PetscTools::IsolateProcesses) so each rank runs its own simulations & singletons;
+ * per-run binary files (debug trace, lineage tree archive) are written per rank, named with GetRankSuffix().
+ ************************************/
+
+class SeedRangeRunner
+{
+private:
+    unsigned mStartSeed;
+    unsigned mEndSeed;
+    unsigned mPackSize;
+    bool mGatherOutput;
+    int mRank;
+    int mNumProcs;
+
+    //Seeds of the current chunk not yet handed out are mNextSeed..mChunkEnd; an empty chunk has mNextSeed > mChunkEnd
+    unsigned mChunkStart;
+    unsigned mChunkEnd;
+    unsigned mNextSeed;
+    bool mFinished;
+
+    //Rank 0: serve chunk requests & commit forwarded output until every worker has been stopped
+    void Coordinate();
+
+    //Worker: send the finished chunk's output to rank 0 & receive the next chunk; false when there are no seeds left
+    bool RequestChunk();
+
+public:
+    /**
+     * @param gatherOutput forward workers' LineageOutput to rank 0; false for simulators that write
+     * per-seed results themselves (WanSimulator)
+     * @param packSize seeds per pack for GetNextPack(); chunks are whole packs
+     */
+    SeedRangeRunner(unsigned startSeed, unsigned endSeed, bool gatherOutput = true, unsigned packSize = 1);
+
+    //Next seed for this process to simulate; false when this process is done
+    bool GetNextSeed(unsigned& rSeed);
+
+    //Next pack of seeds for runs that simulate several seeds together (--pack): startSeed + k*packSize onwards, the
+    //same packs in serial & under MPI, as chunks are whole packs. False when this process is done
+    bool GetNextPack(std::vector<unsigned>& rSeeds);
+
+    bool IsParallel() const;
+
+    //False for the coordinating rank 0 under MPI, which only gathers output
+    bool RunsSimulations() const;
+
+    //Rank 0 writes the gathered LineageOutput; in serial the only process does
+    bool IsWriter() const;
+
+    //"" in serial, "_<rank>" under MPI; appended to per-process file names
+    std::string GetRankSuffix() const;
+};
+
+#endif /*SEEDRANGERUNNER_HPP_*/
@@ -0,0 +1,89 @@
+#include "SequenceTrie.hpp"
+#include "Exception.hpp"
+
+SequenceTrie::SequenceTrie()
+{
+    Clear();
+}
+
+void SequenceTrie::Clear()
+{
+    //value-initialised nodes have no children & zero counts
+    mNodes.assign(1, Node());
+}
+
+uint32_t SequenceTrie::FindNode(const std::string& rSequence) const
+{
+    uint32_t node = 0;
+    for (unsigned i = 0; i < rSequence.size(); i++)
+    {
+        if (rSequence[i] < '0' || rSequence[i] > '2') return 0;
+        node = mNodes[node].mChildren[rSequence[i] - '0'];
+        if (node == 0) return 0;
+    }
+    return node;
+}
+
+void SequenceTrie::Insert(const std::string& rSequence)
+{
+    for (unsigned i = 0; i < rSequence.size(); i++)
+    {
+        if (rSequence[i] < '0' || rSequence[i] > '2')
+        {
+            EXCEPTION("Mitotic mode sequence \"" + rSequence + "\" contains a character other than 0, 1 or 2");
+        }
+    }
+
+    uint32_t node = 0;
+    mNodes[0].mPrefixCount++;
+    for (unsigned i = 0; i < rSequence.size(); i++)
+    {
+        unsigned mode = rSequence[i] - '0';
+        if (mNodes[node].mChildren[mode] == 0)
+        {
+            mNodes.push_back(Node());
+            mNodes[node].mChildren[mode] = mNodes.size() - 1;
+        }
+        node = mNodes[node].mChildren[mode];
+        mNodes[node].mPrefixCount++;
+    }
+    mNodes[node].mCount++;
+}
+
+uint64_t SequenceTrie::GetCount(const std::string& rSequence) const
+{
+    uint32_t node = FindNode(rSequence);
+    return (node == 0 && !rSequence.empty()) ? 0 : mNodes[node].mCount;
+}
+
+uint64_t SequenceTrie::GetPrefixCount(const std::string& rSequence) const
+{
+    uint32_t node = FindNode(rSequence);
+    return (node == 0 && !rSequence.empty()) ? 0 : mNodes[node].mPrefixCount;
+}
+
+uint64_t SequenceTrie::GetNumSequences() const
+{
+    return mNodes[0].mPrefixCount;
+}
+
+void SequenceTrie::Write(std::ostream& rStream) const
+{
+    std::string sequence;
+    WriteNode(rStream, 0, sequence);
+}
+
+void SequenceTrie::WriteNode(std::ostream& rStream, uint32_t node, std::string& rSequence) const
+{
+    rStream << (rSequence.empty() ? "-" : rSequence) << "\t" << mNodes[node].mCount << "\t" << mNodes[node].mPrefixCount << "\n";
+    for (unsigned mode = 0; mode < 3; mode++)
+    {
+        uint32_t child = mNodes[node].mChildren[mode];
+        if (child != 0)
+        {
+            rSequence.push_back(char('0' + mode));
+            WriteNode(rStream, child, rSequence);
+            rSequence.erase(rSequence.size() - 1);
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef SEQUENCETRIE_HPP_
+#define SEQUENCETRIE_HPP_
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <stdint.h>
+
+/***********************************
+ * SEQUENCE TRIE
+ * Prefix trie of mitotic mode sequences (strings of 0=PP, 1=PD, 2=DD digits), counting the sampled sequences
+ * that end at & pass through each node. Built by LineageOutput's sequence trie sink in place of one line per seed.
+ *
+ * Write() gives a flat table, one row per node in depth-first (lexicographic) order:
+ * Sequence \t Count (sequences equal to it) \t PrefixCount (sequences starting with it)
+ * The root (empty sequence, PrefixCount = number of sequences) is written as "-".
+ ************************************/
+
+class SequenceTrie
+{
+private:
+    struct Node
+    {
+        uint32_t mChildren[3]; //node index of the child for each mode; 0 = none (the root is never a child)
+        uint64_t mCount;
+        uint64_t mPrefixCount;
+    };
+
+    std::vector<Node> mNodes;
+
+    //Index of the node for rSequence, or 0 if it is not in the trie (and rSequence is not empty)
+    uint32_t FindNode(const std::string& rSequence) const;
+
+    void WriteNode(std::ostream& rStream, uint32_t node, std::string& rSequence) const;
+
+public:
+    SequenceTrie();
+
+    void Clear();
+
+    //Count one sequence; throws if it contains anything other than mode digits
+    void Insert(const std::string& rSequence);
+
+    uint64_t GetCount(const std::string& rSequence) const;
+    uint64_t GetPrefixCount(const std::string& rSequence) const;
+    uint64_t GetNumSequences() const;
+
+    void Write(std::ostream& rStream) const;
+};
+
+#endif /*SEQUENCETRIE_HPP_*/
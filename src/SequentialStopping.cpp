@@ -0,0 +1,157 @@
+#include "SequentialStopping.hpp"
+#include "Exception.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    const double Z_95 = 1.959963984540054;
+
+    //RSS floor, so a histogram matching the reference exactly has a finite log RSS
+    const double MIN_RSS = 1e-300;
+
+    //Width of the Wilson score interval for a binomial proportion
+    double WilsonWidth(double p, double n)
+    {
+        double z2 = Z_95 * Z_95;
+        return 2.0 * Z_95 * std::sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n)) / (1.0 + z2 / n);
+    }
+}
+
+SequentialStopping::SequentialStopping()
+    : mEnabled(false),
+      mBlockSize(50),
+      mCiWidth(0),
+      mLogRssChange(0),
+      mNumLineages(0),
+      mLastLogRss(0),
+      mHasLastLogRss(false),
+      mConverged(false)
+{
+}
+
+void SequentialStopping::Enable(unsigned blockSize, double ciWidth, double logRssChange, const std::string& rReferenceFile)
+{
+    if (blockSize == 0)
+    {
+        EXCEPTION("Sequential stopping block size must be > 0");
+    }
+    if (ciWidth <= 0 && logRssChange <= 0)
+    {
+        EXCEPTION("Sequential stopping needs a CI width or AIC change criterion");
+    }
+    if (logRssChange > 0)
+    {
+        std::ifstream reference(rReferenceFile.c_str());
+        if (!reference.is_open())
+        {
+            EXCEPTION("Could not open sequential stopping reference histogram " + rReferenceFile);
+        }
+        double probability;
+        while (reference >> probability)
+        {
+            mReference.push_back(probability);
+        }
+        if (mReference.empty())
+        {
+            EXCEPTION("Sequential stopping reference histogram " + rReferenceFile + " is empty");
+        }
+    }
+
+    mEnabled = true;
+    mBlockSize = blockSize;
+    mCiWidth = ciWidth;
+    mLogRssChange = logRssChange;
+}
+
+bool SequentialStopping::IsEnabled() const
+{
+    return mEnabled;
+}
+
+bool SequentialStopping::AddLineage(unsigned count)
+{
+    if (!mEnabled) return false;
+
+    mLineagesByCount[count]++;
+    mNumLineages++;
+    if (mNumLineages % mBlockSize != 0) return false;
+
+    bool converged = true;
+    if (mCiWidth > 0 && GetMaxCiWidth() > mCiWidth)
+    {
+        converged = false;
+    }
+    if (mLogRssChange > 0)
+    {
+        double log_rss = GetLogRss();
+        double change = std::fabs(log_rss - mLastLogRss);
+        if (!mHasLastLogRss || !std::isfinite(change) || change > mLogRssChange)
+        {
+            converged = false;
+        }
+        mLastLogRss = log_rss;
+        mHasLastLogRss = true;
+    }
+    mConverged = converged;
+    return mConverged;
+}
+
+unsigned SequentialStopping::GetNumLineages() const
+{
+    return mNumLineages;
+}
+
+bool SequentialStopping::HasConverged() const
+{
+    return mConverged;
+}
+
+double SequentialStopping::GetMaxCiWidth() const
+{
+    if (mNumLineages == 0) return 1.0;
+
+    double n = mNumLineages;
+    double max_width = WilsonWidth(0.0, n); //counts not yet seen
+    for (std::map<unsigned, unsigned>::const_iterator it = mLineagesByCount.begin(); it != mLineagesByCount.end(); ++it)
+    {
+        max_width = std::max(max_width, WilsonWidth(it->second / n, n));
+    }
+    return max_width;
+}
+
+double SequentialStopping::GetLogRss() const
+{
+    double n = mNumLineages;
+    double rss = 0;
+    for (unsigned i = 0; i < mReference.size(); i++)
+    {
+        std::map<unsigned, unsigned>::const_iterator it = mLineagesByCount.find(i + 1);
+        double p = (it == mLineagesByCount.end() || n == 0) ? 0.0 : it->second / n;
+        rss += (p - mReference[i]) * (p - mReference[i]);
+    }
+    //counts beyond the reference have reference probability 0
+    for (std::map<unsigned, unsigned>::const_iterator it = mLineagesByCount.begin(); it != mLineagesByCount.end(); ++it)
+    {
+        if (it->first == 0 || it->first > mReference.size())
+        {
+            rss += (it->second / n) * (it->second / n);
+        }
+    }
+    return std::log(std::max(rss, MIN_RSS));
+}
+
+std::string SequentialStopping::GetReport() const
+{
+    std::ostringstream report;
+    report << "Sequential stopping: " << (mConverged ? "converged" : "did not converge") << " after " << mNumLineages
+           << " seed(s); widest count CI " << GetMaxCiWidth();
+    if (mLogRssChange > 0)
+    {
+        report << ", log RSS " << GetLogRss();
+    }
+    return report.str();
+}
@@ -0,0 +1,67 @@
+#ifndef SEQUENTIALSTOPPING_HPP_
+#define SEQUENTIALSTOPPING_HPP_
+
+#include <string>
+#include <vector>
+#include <map>
+
+/***********************************
+ * SEQUENTIAL STOPPING
+ * Stops a simulator's seed loop once its lineage count histogram has converged, instead of always running the
+ * fixture's fixed seed range; endSeed becomes a cap. Tight count distributions then finish in a few blocks, broad
+ * ones get the seeds they need.
+ *
+ * USE: the simulator calls Enable() from its --stop-* options, then AddLineage(count) after each seed, & stops
+ * when it returns true. Convergence is only checked at the end of each block of seeds.
+ *
+ * Criteria (all given criteria must be met):
+ * CI width: every count's 95% Wilson interval for its probability is at most this wide. A count not yet seen
+ * has p = 0, so its interval (~3.84/n) sets a floor on the number of seeds.
+ * AIC change: with a reference histogram (P(count = 1), P(count = 2), ... one per line), log RSS of the estimate
+ * against it changed by at most this much over the last block. The fixtures' AIC is 2k + n log(sum of RSS),
+ * so its change is at most n times this.
+ ************************************/
+
+class SequentialStopping
+{
+private:
+    bool mEnabled;
+    unsigned mBlockSize;
+    double mCiWidth; //0 if not a criterion
+    double mLogRssChange; //0 if not a criterion
+    std::vector<double> mReference; //mReference[i] = P(count = i + 1)
+
+    std::map<unsigned, unsigned> mLineagesByCount;
+    unsigned mNumLineages;
+    double mLastLogRss; //at the end of the previous block
+    bool mHasLastLogRss;
+    bool mConverged;
+
+public:
+    SequentialStopping();
+
+    /**
+     * @param blockSize seeds between convergence checks
+     * @param ciWidth maximum 95% interval width of any count's probability; 0 = not used
+     * @param logRssChange maximum change in log RSS against rReferenceFile over a block; 0 = not used
+     */
+    void Enable(unsigned blockSize, double ciWidth, double logRssChange, const std::string& rReferenceFile);
+    bool IsEnabled() const;
+
+    //Add a seed's lineage count; true once the histogram has converged & the run should stop
+    bool AddLineage(unsigned count);
+
+    unsigned GetNumLineages() const;
+    bool HasConverged() const;
+
+    //Widest 95% Wilson interval of any count's probability, including counts not yet seen
+    double GetMaxCiWidth() const;
+
+    //log of the residual sum of squares against the reference histogram; floored at 1e-300, so an exact match stays finite
+    double GetLogRss() const;
+
+    //One line for the simulator log: seeds used, and the criteria's current values
+    std::string GetReport() const;
+};
+
+#endif /*SEQUENTIALSTOPPING_HPP_*/
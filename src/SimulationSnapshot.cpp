@@ -0,0 +1,166 @@
+#include "SimulationSnapshot.hpp"
+
+#include <sstream>
+
+#include "CheckpointArchiveTypes.hpp"
+#include "Exception.hpp"
+#include "SimulationTime.hpp"
+#include "RandomNumberGenerator.hpp"
+#include "NodesOnlyMesh.hpp"
+#include "CellId.hpp"
+#include "CellData.hpp"
+#include "AbstractCellMutationState.hpp"
+
+template<unsigned DIM>
+SimulationSnapshot<DIM>::SimulationSnapshot(NodeBasedCellPopulation<DIM>& rCellPopulation)
+    : mInteractionDistance(rCellPopulation.rGetMesh().GetMaximumInteractionDistance())
+{
+    // Population iterator skips dead cells
+    for (typename AbstractCellPopulation<DIM>::Iterator cell_iter = rCellPopulation.Begin();
+         cell_iter != rCellPopulation.End();
+         ++cell_iter)
+    {
+        if ((*cell_iter)->HasApoptosisBegun())
+        {
+            EXCEPTION("Cannot snapshot a population with cells undergoing apoptosis");
+        }
+
+        CellState state;
+        state.mpMutationState = (*cell_iter)->GetMutationState();
+        state.mpCellCycleModel = (*cell_iter)->GetCellCycleModel()->CreateCellCycleModel();
+        state.mpSrnModel = (*cell_iter)->GetSrnModel()->CreateSrnModel();
+        state.mProperties = CopyProperties((*cell_iter)->rGetCellPropertyCollection());
+        state.mLogged = (*cell_iter)->IsLogged();
+        Node<DIM>* p_node = rCellPopulation.GetNodeCorrespondingToCell(*cell_iter);
+        state.mLocation = p_node->rGetLocation();
+        state.mRadius = p_node->GetRadius();
+        mCells.push_back(state);
+    }
+
+    SimulationTime* p_simulation_time = SimulationTime::Instance();
+    mStartTime = p_simulation_time->GetStartTime();
+    mTime = p_simulation_time->GetTime();
+    mTimeStepsElapsed = p_simulation_time->IsEndTimeAndNumberOfTimeStepsSetUp() ? p_simulation_time->GetTimeStepsElapsed() : 0;
+
+    CellId cell_id;
+    mMaxCellId = cell_id.GetMaxCellId();
+
+    std::ostringstream rng_stream;
+    {
+        boost::archive::text_oarchive rng_archive(rng_stream);
+        SerializableSingleton<RandomNumberGenerator>* const p_wrapper = RandomNumberGenerator::Instance()->GetSerializationWrapper();
+        rng_archive << p_wrapper;
+    }
+    mRngState = rng_stream.str();
+}
+
+template<unsigned DIM>
+SimulationSnapshot<DIM>::~SimulationSnapshot()
+{
+    for (unsigned i = 0; i < mCells.size(); i++)
+    {
+        delete mCells[i].mpCellCycleModel;
+        delete mCells[i].mpSrnModel;
+    }
+}
+
+template<unsigned DIM>
+CellPropertyCollection SimulationSnapshot<DIM>::CopyProperties(const CellPropertyCollection& rProperties)
+{
+    CellPropertyCollection properties = rProperties;
+    CellPropertyCollection copy;
+    for (CellPropertyCollection::Iterator prop_iter = properties.Begin(); prop_iter != properties.End(); ++prop_iter)
+    {
+        if ((*prop_iter)->IsSubType<AbstractCellMutationState>()) continue;
+
+        if ((*prop_iter)->IsType<CellData>())
+        {
+            //cell data is per cell, so each copy needs its own
+            boost::shared_ptr<CellData> p_data = boost::static_pointer_cast<CellData>(*prop_iter);
+            boost::shared_ptr<CellData> p_data_copy(new CellData);
+            std::vector<std::string> keys = p_data->GetKeys();
+            for (unsigned i = 0; i < keys.size(); i++)
+            {
+                p_data_copy->SetItem(keys[i], p_data->GetItem(keys[i]));
+            }
+            copy.AddProperty(p_data_copy);
+        }
+        else
+        {
+            copy.AddProperty(*prop_iter);
+        }
+    }
+    return copy;
+}
+
+template<unsigned DIM>
+double SimulationSnapshot<DIM>::GetTime() const
+{
+    return mTime;
+}
+
+template<unsigned DIM>
+unsigned SimulationSnapshot<DIM>::GetNumCells() const
+{
+    return mCells.size();
+}
+
+template<unsigned DIM>
+NodeBasedCellPopulation<DIM>* SimulationSnapshot<DIM>::Restore() const
+{
+    //Step through the snapshotted run's timestep times, so a continued run sees the same times as the original
+    SimulationTime::Destroy();
+    SimulationTime* p_simulation_time = SimulationTime::Instance();
+    p_simulation_time->SetStartTime(mStartTime);
+    if (mTimeStepsElapsed > 0)
+    {
+        p_simulation_time->SetEndTimeAndNumberOfTimeSteps(mTime, mTimeStepsElapsed);
+        for (unsigned i = 0; i < mTimeStepsElapsed; i++)
+        {
+            p_simulation_time->IncrementTimeOneStep();
+        }
+    }
+
+    //Cell IDs continue from the snapshot's next ID
+    CellId::ResetMaxCellId();
+    CellId cell_id;
+    for (unsigned i = 0; i < mMaxCellId; i++)
+    {
+        cell_id.AssignCellId();
+    }
+
+    std::istringstream rng_stream(mRngState);
+    boost::archive::text_iarchive rng_archive(rng_stream);
+    SerializableSingleton<RandomNumberGenerator>* p_wrapper;
+    rng_archive >> p_wrapper;
+
+    std::vector<CellPtr> cells;
+    std::vector<Node<DIM>*> nodes;
+    for (unsigned i = 0; i < mCells.size(); i++)
+    {
+        const CellState& r_state = mCells[i];
+        CellPtr p_cell(new Cell(r_state.mpMutationState, r_state.mpCellCycleModel->CreateCellCycleModel(),
+                                r_state.mpSrnModel->CreateSrnModel(), false, CopyProperties(r_state.mProperties)));
+        if (r_state.mLogged) p_cell->SetLogged();
+        cells.push_back(p_cell);
+
+        Node<DIM>* p_node = new Node<DIM>(i, r_state.mLocation);
+        p_node->SetRadius(r_state.mRadius);
+        nodes.push_back(p_node);
+    }
+
+    //the mesh copies the nodes
+    NodesOnlyMesh<DIM>* p_mesh = new NodesOnlyMesh<DIM>;
+    p_mesh->ConstructNodesWithoutMesh(nodes, mInteractionDistance);
+    for (unsigned i = 0; i < nodes.size(); i++)
+    {
+        delete nodes[i];
+    }
+
+    return new NodeBasedCellPopulation<DIM>(*p_mesh, cells, std::vector<unsigned>(), true); //population deletes the mesh
+}
+
+// Explicit instantiation
+template class SimulationSnapshot<1>;
+template class SimulationSnapshot<2>;
+template class SimulationSnapshot<3>;
@@ -0,0 +1,75 @@
+#ifndef SIMULATIONSNAPSHOT_HPP_
+#define SIMULATIONSNAPSHOT_HPP_
+
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "NodeBasedCellPopulation.hpp"
+#include "AbstractCellCycleModel.hpp"
+#include "AbstractSrnModel.hpp"
+#include "AbstractCellProperty.hpp"
+#include "CellPropertyCollection.hpp"
+
+/***********************************
+ * SIMULATION SNAPSHOT
+ * In-memory copy of a running node-based simulation- its cells (cell cycle & SRN model state, properties, IDs),
+ * node locations, SimulationTime, the RNG state & the cell ID counter- so that parameter variants sharing an early
+ * trajectory (eg. SPSA perturbations of late-phase He parameters) simulate the shared prefix once.
+ *
+ * USE: Solve() to the fork time, construct a snapshot of the population, then for each variant:
+ * Restore() (which also resets SimulationTime, the RNG & the cell ID counter to the snapshot), change the parameters
+ * of the restored cells' cycle models, and continue it with a new simulator constructed with initialiseCells = false
+ * (initialising the cycle models would redraw their cycle durations).
+ *
+ * The snapshot holds no Cell objects, as live cells are counted by their properties (OffLatticeSimulationPropertyStop's
+ * stopping event): a population must be deleted before the next is restored. Cells undergoing apoptosis are not supported.
+ ************************************/
+
+template<unsigned DIM>
+class SimulationSnapshot
+{
+private:
+    //per-cell state, in population order; node i of a restored mesh carries cell i
+    struct CellState
+    {
+        boost::shared_ptr<AbstractCellProperty> mpMutationState;
+        AbstractCellCycleModel* mpCellCycleModel;
+        AbstractSrnModel* mpSrnModel;
+        CellPropertyCollection mProperties; //all but the mutation state; CellData is a copy
+        bool mLogged;
+        c_vector<double, DIM> mLocation;
+        double mRadius;
+    };
+    std::vector<CellState> mCells;
+    double mInteractionDistance;
+
+    double mStartTime;
+    double mTime;
+    unsigned mTimeStepsElapsed;
+    unsigned mMaxCellId;
+    std::string mRngState; //text archive
+
+    //Properties as a new collection: the mutation state is left out (Cell adds it), CellData is deep-copied
+    static CellPropertyCollection CopyProperties(const CellPropertyCollection& rProperties);
+
+    //Not copyable: owns its cell cycle & SRN models
+    SimulationSnapshot(const SimulationSnapshot&);
+    SimulationSnapshot& operator=(const SimulationSnapshot&);
+
+public:
+    //Snapshot the population as it stands, at the current simulation time
+    SimulationSnapshot(NodeBasedCellPopulation<DIM>& rCellPopulation);
+    ~SimulationSnapshot();
+
+    double GetTime() const;
+    unsigned GetNumCells() const;
+
+    /**
+     * Reset SimulationTime, the RNG & the cell ID counter to the snapshot, and return a new population of copies of
+     * the snapshot's cells. The caller deletes the population, which deletes its mesh. May be called any number of times.
+     */
+    NodeBasedCellPopulation<DIM>* Restore() const;
+};
+
+#endif /*SIMULATIONSNAPSHOT_HPP_*/
@@ -0,0 +1,162 @@
+#include "SimulatorOptions.hpp"
+#include "LineageOutput.hpp"
+#include "CommandLineArguments.hpp"
+#include "ExecutableSupport.hpp"
+#include "CellBasedEventHandler.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <climits>
+
+void SimulatorOptions::Startup(int* pArgc, char*** pArgv)
+{
+    //CommandLineArguments is not set up yet, so look for the option directly
+    bool serial = false;
+    for (int i = 1; i < *pArgc; i++)
+    {
+        if (strcmp((*pArgv)[i], "--serial") == 0)
+        {
+            serial = true;
+        }
+    }
+
+    if (serial)
+    {
+        //PetscTools reports one process when PETSc is not initialised, so everything else runs as normal
+        CommandLineArguments::Instance()->p_argc = pArgc;
+        CommandLineArguments::Instance()->p_argv = pArgv;
+        CellBasedEventHandler::Disable();
+    }
+    else
+    {
+        ExecutableSupport::StartupWithoutShowingCopyright(pArgc, pArgv);
+    }
+}
+
+int SimulatorOptions::GetNumPositionalArguments(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if (arg.size() > 2 && arg.substr(0, 2) == "--")
+        {
+            return i;
+        }
+    }
+    return argc;
+}
+
+bool SimulatorOptions::ParseOutputModes(const std::string& rModes, std::vector<bool>& rEnabled)
+{
+    rEnabled.assign(LineageOutput::NUM_SINKS, false);
+    if (rModes.empty()) return false;
+
+    for (unsigned i = 0; i < rModes.size(); i++)
+    {
+        if (rModes[i] < '0' || rModes[i] >= char('0' + LineageOutput::NUM_SINKS))
+        {
+            return false;
+        }
+        rEnabled[rModes[i] - '0'] = true;
+    }
+    return true;
+}
+
+std::vector<double> SimulatorOptions::GetCountTimes()
+{
+    return GetSortedDoubles("--count-times");
+}
+
+std::vector<double> SimulatorOptions::GetInductionTimes()
+{
+    return GetSortedDoubles("--induction-times");
+}
+
+bool SimulatorOptions::GetLineageTreeOutput()
+{
+    return CommandLineArguments::Instance()->OptionExists("--lineage-tree");
+}
+
+bool SimulatorOptions::GetPathOnlySampling()
+{
+    return CommandLineArguments::Instance()->OptionExists("--path-only");
+}
+
+bool SimulatorOptions::GetBatched()
+{
+    return CommandLineArguments::Instance()->OptionExists("--batched");
+}
+
+bool SimulatorOptions::GetEventQueue()
+{
+    return CommandLineArguments::Instance()->OptionExists("--event-queue");
+}
+
+bool SimulatorOptions::GetMeanField()
+{
+    return CommandLineArguments::Instance()->OptionExists("--mean-field");
+}
+
+std::string SimulatorOptions::GetCacheDirectory()
+{
+    if (CommandLineArguments::Instance()->OptionExists("--cache"))
+    {
+        return CommandLineArguments::Instance()->GetStringCorrespondingToOption("--cache");
+    }
+    return "";
+}
+
+bool SimulatorOptions::GetResume()
+{
+    return CommandLineArguments::Instance()->OptionExists("--resume");
+}
+
+double SimulatorOptions::GetDoubleOption(const std::string& rOption, double defaultValue)
+{
+    if (CommandLineArguments::Instance()->OptionExists(rOption))
+    {
+        return CommandLineArguments::Instance()->GetDoubleCorrespondingToOption(rOption);
+    }
+    return defaultValue;
+}
+
+bool SimulatorOptions::GetUnsignedOption(const std::string& rOption, unsigned defaultValue, unsigned& rValue)
+{
+    rValue = defaultValue;
+    if (!CommandLineArguments::Instance()->OptionExists(rOption))
+    {
+        return true;
+    }
+
+    //Read as a double so "2.5", "-1" & "1e3" are seen whole, rather than wrapped or truncated by an unsigned conversion
+    std::string text = CommandLineArguments::Instance()->GetStringCorrespondingToOption(rOption);
+    char* p_end = NULL;
+    double value = strtod(text.c_str(), &p_end);
+    if (text.empty() || *p_end != '\0' || !std::isfinite(value) || value < 0 || value != std::floor(value) || value > UINT_MAX)
+    {
+        return false;
+    }
+    rValue = unsigned(value);
+    return true;
+}
+
+std::string SimulatorOptions::GetStringOption(const std::string& rOption)
+{
+    if (CommandLineArguments::Instance()->OptionExists(rOption))
+    {
+        return CommandLineArguments::Instance()->GetStringCorrespondingToOption(rOption);
+    }
+    return "";
+}
+
+std::vector<double> SimulatorOptions::GetSortedDoubles(const std::string& rOption)
+{
+    std::vector<double> values;
+    if (CommandLineArguments::Instance()->OptionExists(rOption))
+    {
+        values = CommandLineArguments::Instance()->GetDoublesCorrespondingToOption(rOption);
+        std::sort(values.begin(), values.end());
+    }
+    return values;
+}
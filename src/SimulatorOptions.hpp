@@ -0,0 +1,81 @@
+#ifndef SIMULATOROPTIONS_HPP_
+#define SIMULATOROPTIONS_HPP_
+
+#include <string>
+#include <vector>
+
+/***********************************
+ * SIMULATOR OPTIONS
+ * Helpers for the project simulators' command lines.
+ * Simulators take fixed positional arguments, optionally followed by "--option <values>" pairs,
+ * which are read through Chaste's CommandLineArguments singleton (set up by Startup()).
+ *
+ * "--serial" skips PETSc/MPI initialisation for single-process runs launched in bulk by the python fixtures;
+ * only CommandLineArguments is set up & Chaste's MPI-timed CellBasedEventHandler is disabled. Output is unchanged.
+ * Not for mpirun: every rank would run the whole seed range.
+ *
+ * outputMode is a string of sink digits: "0"=counts, "1"=events, "2"=sequence, "3"=snapshots, "4"=sequence trie,
+ * "5"=mode score functions (HeSimulator only), "6"=decision statistics;
+ * "01" enables counts & events together.
+ * A single digit behaves as the old exclusive outputMode.
+ ************************************/
+
+class SimulatorOptions
+{
+public:
+    //Replaces ExecutableSupport::StartupWithoutShowingCopyright() in the simulators; see "--serial" above
+    static void Startup(int* pArgc, char*** pArgv);
+
+    //Number of entries in argv (including argv[0]) before the first "--option"
+    static int GetNumPositionalArguments(int argc, char* argv[]);
+
+    /**
+     * Parse an outputMode string into one bool per LineageOutput sink.
+     * Returns false if the string is empty or contains anything other than sink digits.
+     */
+    static bool ParseOutputModes(const std::string& rModes, std::vector<bool>& rEnabled);
+
+    //Times at which to record extra lineage counts & snapshots, from "--count-times t1 t2 ..."; sorted, empty if not given
+    static std::vector<double> GetCountTimes();
+
+    //Times (hpf) at which HeSimulator fixture 0 labels a clone in each lineage, from "--induction-times t1 t2 ..."; sorted, empty if not given
+    static std::vector<double> GetInductionTimes();
+
+    //Whether "--lineage-tree" was given: record each lineage's whole division tree with LineageTreeRecorder
+    static bool GetLineageTreeOutput();
+
+    //Result cache directory from "--cache <directory>" (see ResultCache); empty if not given
+    static std::string GetCacheDirectory();
+
+    //Whether "--resume" was given: skip seeds recorded in the run's SeedJournal & append to its output
+    static bool GetResume();
+
+    //Value of a single-valued "--option <value>"; defaultValue if not given
+    static double GetDoubleOption(const std::string& rOption, double defaultValue);
+
+    /**
+     * Value of a single-valued "--option <value>" that must be a whole number, eg. a count of seeds or threads.
+     * rValue is defaultValue if the option is not given; false if the value is negative, fractional, too large or not a number.
+     */
+    static bool GetUnsignedOption(const std::string& rOption, unsigned defaultValue, unsigned& rValue);
+
+    //Value of a single-valued "--option <value>"; empty if not given
+    static std::string GetStringOption(const std::string& rOption);
+
+    //Whether "--path-only" was given: sequence sampling simulates only the labelled path, killing unlabelled sisters
+    static bool GetPathOnlySampling();
+
+    //Whether "--batched" was given: sweeps & samplers run lineage model seeds together in a LineageBatch
+    static bool GetBatched();
+
+    //Whether "--event-queue" was given: WanSimulator runs each seed in a WanEventEngine
+    static bool GetEventQueue();
+
+    //Whether "--mean-field" was given: WanSimulator writes WanMeanField's expected counts instead of running seeds
+    static bool GetMeanField();
+
+private:
+    static std::vector<double> GetSortedDoubles(const std::string& rOption);
+};
+
+#endif /*SIMULATOROPTIONS_HPP_*/
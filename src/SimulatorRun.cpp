@@ -0,0 +1,407 @@
+#include "SimulatorRun.hpp"
+#include "SimulatorOptions.hpp"
+#include "LineageOutput.hpp"
+#include "CellCycleTrace.hpp"
+#include "LineageTreeRecorder.hpp"
+#include "ExecutableSupport.hpp"
+#include "PetscTools.hpp"
+#include "RandomNumberGenerator.hpp"
+#include "SimulationTime.hpp"
+#include "CellId.hpp"
+#include "HoneycombMeshGenerator.hpp"
+#include "NodesOnlyMesh.hpp"
+#include "NodeBasedCellPopulation.hpp"
+
+#include <sstream>
+
+SimulatorRun::SimulatorRun(const std::string& rOutputModes, bool debugOutput)
+    : mOutputSinks(),
+      mModesParsed(false),
+      mDebugOutput(debugOutput),
+      mStartSeed(0)
+{
+    mModesParsed = SimulatorOptions::ParseOutputModes(rOutputModes, mOutputSinks);
+    mCountTimes = SimulatorOptions::GetCountTimes();
+    mTreeOutput = SimulatorOptions::GetLineageTreeOutput();
+    mPathOnly = SimulatorOptions::GetPathOnlySampling();
+    mCacheDirectory = SimulatorOptions::GetCacheDirectory();
+    mResume = SimulatorOptions::GetResume();
+    mStopCiWidth = SimulatorOptions::GetDoubleOption("--stop-ci-width", 0);
+    mStopAicChange = SimulatorOptions::GetDoubleOption("--stop-aic-change", 0);
+    mStopBlockValid = SimulatorOptions::GetUnsignedOption("--stop-block", 50, mStopBlock);
+    mStopReference = SimulatorOptions::GetStringOption("--stop-reference");
+    mPackValid = SimulatorOptions::GetUnsignedOption("--pack", 1, mPackSize);
+}
+
+bool SimulatorRun::CheckOptions(double countTimeLimit, const std::string& rCountTimeLimitName)
+{
+    bool sane = 1;
+
+    if (!mModesParsed)
+    {
+        ExecutableSupport::PrintError(
+                "Bad outputMode (argument 3). Must be digits from 0 (counts) 1 (mitotic events) 2 (sequence sampling) 3 (snapshots) 4 (sequence trie) 5 (mode score functions, HeSimulator only) 6 (decision statistics), eg. 0 or 06");
+        sane = 0;
+    }
+    bool countOutput = IsOutput(LineageOutput::COUNTS);
+    bool eventOutput = IsOutput(LineageOutput::EVENTS);
+    bool trieOutput = IsOutput(LineageOutput::TRIE);
+    bool snapshotOutput = IsOutput(LineageOutput::SNAPSHOTS);
+    bool decisionOutput = IsOutput(LineageOutput::DECISIONS);
+    bool scoreOutput = IsOutput(LineageOutput::SCORES);
+
+    if (!mCountTimes.empty() && !countOutput && !snapshotOutput)
+    {
+        ExecutableSupport::PrintError("--count-times given without counts or snapshot output (outputMode 0 or 3)");
+        sane = 0;
+    }
+
+    if (!mCountTimes.empty() && mCountTimes.back() > countTimeLimit)
+    {
+        ExecutableSupport::PrintError("Bad --count-times. Must be <= " + rCountTimeLimitName);
+        sane = 0;
+    }
+
+    if (mPathOnly && (countOutput || eventOutput || snapshotOutput || decisionOutput || scoreOutput || !mCountTimes.empty() || mTreeOutput))
+    {
+        ExecutableSupport::PrintError("--path-only prunes the lineage, so needs sequence output alone (outputMode 2, 4 or 24, no --count-times or --lineage-tree)");
+        sane = 0;
+    }
+
+    if (!mCacheDirectory.empty() && (mDebugOutput || mTreeOutput))
+    {
+        ExecutableSupport::PrintError("--cache replays lineage output only, so cannot be combined with debug output or --lineage-tree");
+        sane = 0;
+    }
+
+    if (mResume && (trieOutput || mDebugOutput || mTreeOutput))
+    {
+        ExecutableSupport::PrintError("--resume appends to the lineage output files only, so cannot be combined with trie output (outputMode 4), debug output or --lineage-tree");
+        sane = 0;
+    }
+
+    if (IsSequentialStopping())
+    {
+        if (mPathOnly)
+        {
+            ExecutableSupport::PrintError("Sequential stopping follows the end count histogram, so cannot be combined with --path-only");
+            sane = 0;
+        }
+        if (!mCacheDirectory.empty() || mResume)
+        {
+            ExecutableSupport::PrintError("Sequential stopping counts every seed it runs, so cannot be combined with --cache or --resume");
+            sane = 0;
+        }
+        if (mStopAicChange > 0 && mStopReference.empty())
+        {
+            ExecutableSupport::PrintError("--stop-aic-change needs a reference count histogram (--stop-reference <histogramFile>)");
+            sane = 0;
+        }
+        if (!mStopBlockValid || mStopBlock < 1)
+        {
+            ExecutableSupport::PrintError("Bad --stop-block. Must be a whole number of seeds >0");
+            sane = 0;
+        }
+        if (PetscTools::IsParallel())
+        {
+            ExecutableSupport::PrintError("Sequential stopping needs each seed's count in seed order, so cannot be run under mpirun");
+            sane = 0;
+        }
+    }
+
+    if (!mPackValid || mPackSize < 1)
+    {
+        ExecutableSupport::PrintError("Bad --pack. Must be a whole number of seeds >0");
+        sane = 0;
+    }
+    if (mPackSize > 1 && (snapshotOutput || decisionOutput || scoreOutput || !mCountTimes.empty() || mDebugOutput || mTreeOutput
+            || !mCacheDirectory.empty() || mResume || IsSequentialStopping()))
+    {
+        ExecutableSupport::PrintError("--pack splits end counts, events & sequences back out per seed, so needs outputMode digits 0, 1, 2 & 4 only, without --count-times, debug output, --lineage-tree, --cache, --resume or sequential stopping");
+        sane = 0;
+    }
+
+    return sane;
+}
+
+void SimulatorRun::Open(int argc, char* argv[], const std::string& rDirectory, const std::string& rFilename,
+                        unsigned startSeed, unsigned endSeed, const std::vector<int>& rCacheSkippedArguments)
+{
+    mStartSeed = startSeed;
+
+    //Hand out the seed range- in order in serial; in chunks to worker ranks under mpirun, with their output gathered on rank 0
+    //with --pack, chunks are whole packs, so each seed's pack is the same whichever process runs it
+    mpRunner.reset(new SeedRangeRunner(startSeed, endSeed, true, mPackSize));
+
+    //Sequential stopping- seeds run from startSeed until the count histogram has converged, endSeed is then a cap, see SequentialStopping
+    if (IsSequentialStopping()) mStopping.Enable(mStopBlock, mStopCiWidth, mStopAicChange, mStopReference);
+
+    //Seed journal- committed seeds are recorded in <filename>.journal, so a killed run can be resumed, see SeedJournal
+    mJournal.Open(rDirectory, rFilename + ".journal", ResultCache::MakeJobDescription(argc, argv, { }), mResume,
+                  mpRunner->IsWriter());
+
+    //Singleton LineageOutput- one file per enabled output, suffixed with the output name if more than one
+    LineageOutput* p_output = LineageOutput::Instance();
+    if (mResume) p_output->ResumeFrom(mJournal.rGetResumeFileSizes());
+    p_output->SetJournal(&mJournal);
+    p_output->Open(rDirectory, rFilename, mOutputSinks);
+    if (mResume) ExecutableSupport::Print("Resuming: " + std::to_string(mJournal.GetNumCompleted()) + " seed(s) already complete");
+
+    ExecutableSupport::Print("Simulator writing file " + rFilename + " to directory " + rDirectory);
+
+    //Singleton CellCycleTrace for debug output- one binary file per simulating process, see TraceConverter
+    if (mDebugOutput && mpRunner->RunsSimulations())
+    {
+        CellCycleTrace::Instance()->Open(rDirectory, rFilename + "DEBUG" + mpRunner->GetRankSuffix() + ".trace");
+    }
+
+    //Singleton LineageTreeRecorder for whole-lineage output- one archive per simulating process, see LineageTreeQuery
+    if (mTreeOutput && mpRunner->RunsSimulations())
+    {
+        LineageTreeRecorder::Instance()->Open(rDirectory, rFilename + "TREE" + mpRunner->GetRankSuffix() + ".ltree");
+    }
+
+    //Result cache- seeds already simulated by an identical job are replayed, see ResultCache. Each simulating process
+    //replays & stores its own seeds; under mpirun rank 0 only commits the workers' forwarded output
+    if (!mCacheDirectory.empty() && mpRunner->RunsSimulations())
+    {
+        mCache.Open(mCacheDirectory, ResultCache::MakeJobDescription(argc, argv, rCacheSkippedArguments));
+    }
+}
+
+void SimulatorRun::WriteHeaders(const std::string& rCountLeadingColumns, const std::string& rCountTimeUnit)
+{
+    mCountHeader = "Entry\t" + rCountLeadingColumns + "Seed\tCount";
+    for (unsigned i = 0; i < mCountTimes.size(); i++)
+    {
+        std::ostringstream countColumn;
+        countColumn << "\tCount " << mCountTimes[i] << rCountTimeUnit;
+        mCountHeader += countColumn.str();
+    }
+
+    LineageOutput* p_output = LineageOutput::Instance();
+    p_output->WriteHeader(LineageOutput::COUNTS, mCountHeader + "\n");
+    p_output->WriteHeader(LineageOutput::EVENTS, "Time (hpf)\tSeed\tCellID\tMitotic Mode (0=PP;1=PD;2=DD)\n");
+    p_output->WriteHeader(LineageOutput::SEQUENCE, "Entry\tSeed\tSequence\n");
+    p_output->WriteHeader(LineageOutput::TRIE, "Sequence\tCount\tPrefixCount\n");
+}
+
+const std::string& SimulatorRun::rGetCountHeader() const
+{
+    return mCountHeader;
+}
+
+bool SimulatorRun::IsOutput(unsigned sink) const
+{
+    if (sink == LineageOutput::SEQUENCE && mOutputSinks[LineageOutput::TRIE]) return true;
+    return mOutputSinks[sink];
+}
+
+const std::vector<double>& SimulatorRun::rGetCountTimes() const
+{
+    return mCountTimes;
+}
+
+bool SimulatorRun::IsTreeOutput() const
+{
+    return mTreeOutput;
+}
+
+bool SimulatorRun::IsPathOnly() const
+{
+    return mPathOnly;
+}
+
+bool SimulatorRun::IsCached() const
+{
+    return !mCacheDirectory.empty();
+}
+
+bool SimulatorRun::IsResumed() const
+{
+    return mResume;
+}
+
+bool SimulatorRun::IsSequentialStopping() const
+{
+    return mStopCiWidth > 0 || mStopAicChange > 0;
+}
+
+bool SimulatorRun::IsPacked() const
+{
+    return mPackSize > 1;
+}
+
+bool SimulatorRun::RunsSimulations() const
+{
+    return mpRunner->RunsSimulations();
+}
+
+unsigned SimulatorRun::GetEntryNumber(unsigned seed) const
+{
+    return seed - mStartSeed + 1;
+}
+
+bool SimulatorRun::GetNextPack(std::vector<unsigned>& rPack)
+{
+    if (mPackSize < 2 || !mpRunner->GetNextPack(rPack)) return false;
+
+    //initialise SimulationTime (permits cellcyclemodel setup) & number the pack's cells from 0
+    SimulationTime::Instance()->SetStartTime(0.0);
+    CellId::ResetMaxCellId();
+
+    if (IsOutput(LineageOutput::SEQUENCE))
+    {
+        for (unsigned i = 0; i < rPack.size(); i++)
+        {
+            LineageOutput::Instance()->rGetStream(LineageOutput::SEQUENCE, rPack[i]) << GetEntryNumber(rPack[i]) << "\t" << rPack[i] << "\t";
+        }
+    }
+    return true;
+}
+
+void SimulatorRun::SolvePack(const std::vector<unsigned>& rPack, std::vector<CellPtr>& rFounders,
+                             boost::shared_ptr<AbstractCellProperty> pStopProperty, double dt, double endTime,
+                             const std::string& rCountLeadingColumns)
+{
+    //Generate 1xK mesh for the pack's founders
+    HoneycombMeshGenerator generator(1, rFounders.size());
+    MutableMesh<2, 2>* p_generating_mesh = generator.GetMesh();
+    NodesOnlyMesh<2> mesh;
+    mesh.ConstructNodesWithoutMesh(*p_generating_mesh, 1.5);
+
+    //Setup cell population
+    NodeBasedCellPopulation<2>* cell_population(new NodeBasedCellPopulation<2>(mesh, rFounders));
+
+    //Setup simulator & run simulation; it stops once no lineage in the pack has cells with the stop property left
+    {
+        OffLatticeSimulationPropertyStop<2> simulator(*cell_population);
+        simulator.SetStopProperty(pStopProperty);
+        simulator.SetDt(dt);
+        simulator.SetEndTime(endTime);
+        simulator.DisableSimulationOutput();
+        simulator.Solve();
+
+        //Split the pack's output back out per seed, committed in seed order
+        std::vector<unsigned> counts = simulator.CountCellsByAncestor(rPack.size());
+        for (unsigned i = 0; i < rPack.size(); i++)
+        {
+            if (IsOutput(LineageOutput::COUNTS)) WriteCounts(rPack[i], rCountLeadingColumns, counts[i]);
+            if (IsOutput(LineageOutput::SEQUENCE)) LineageOutput::Instance()->rGetStream(LineageOutput::SEQUENCE, rPack[i]) << "\n";
+            LineageOutput::Instance()->CommitSeed(rPack[i]);
+        }
+    }
+
+    //Reset for next pack
+    SimulationTime::Destroy();
+    delete cell_population;
+}
+
+bool SimulatorRun::GetNextSeed(unsigned& rSeed)
+{
+    while (mpRunner->GetNextSeed(rSeed))
+    {
+        if (!mJournal.IsComplete(rSeed) && !mCache.Replay(rSeed, GetEntryNumber(rSeed))) return true;
+    }
+    return false;
+}
+
+void SimulatorRun::BeginSeed(unsigned seed)
+{
+    //write seed to output - sequence written by cellcyclemodel objects
+    if (IsOutput(LineageOutput::SEQUENCE))
+    {
+        LineageOutput::Instance()->rGetStream(LineageOutput::SEQUENCE, seed) << GetEntryNumber(seed) << "\t" << seed << "\t";
+    }
+
+    //initialise SimulationTime (permits cellcyclemodel setup)
+    SimulationTime::Instance()->SetStartTime(0.0);
+
+    //Number cells from 0 in each seed, so cell IDs in the output do not depend on which seeds a process ran before
+    CellId::ResetMaxCellId();
+
+    RandomNumberGenerator::Instance()->Reseed(seed);
+}
+
+void SimulatorRun::WriteCounts(unsigned seed, const std::string& rLeadingColumns, unsigned count,
+                               const std::vector<unsigned>& rCountTimeCounts)
+{
+    std::ostream& r_counts = LineageOutput::Instance()->rGetStream(LineageOutput::COUNTS, seed);
+    r_counts << GetEntryNumber(seed) << "\t" << rLeadingColumns << seed << "\t" << count;
+    for (unsigned i = 0; i < rCountTimeCounts.size(); i++)
+    {
+        r_counts << "\t" << rCountTimeCounts[i];
+    }
+    r_counts << "\n";
+}
+
+void SimulatorRun::WriteStatistics(unsigned sink, unsigned seed, unsigned count, const std::vector<unsigned>& rValues)
+{
+    std::ostream& r_stream = LineageOutput::Instance()->rGetStream(sink, seed);
+    r_stream << GetEntryNumber(seed) << "\t" << seed << "\t" << count;
+    for (unsigned i = 0; i < rValues.size(); i++)
+    {
+        r_stream << "\t" << rValues[i];
+    }
+    r_stream << "\n";
+}
+
+void SimulatorRun::WriteStatistics(unsigned sink, unsigned seed, unsigned count, const std::vector<double>& rValues)
+{
+    std::ostream& r_stream = LineageOutput::Instance()->rGetStream(sink, seed);
+    r_stream << GetEntryNumber(seed) << "\t" << seed << "\t" << count;
+    for (unsigned i = 0; i < rValues.size(); i++)
+    {
+        r_stream << "\t" << rValues[i];
+    }
+    r_stream << "\n";
+}
+
+void SimulatorRun::WriteSnapshots(unsigned seed, unsigned count, OffLatticeSimulationPropertyStop<2>& rSimulator,
+                                  double endTime)
+{
+    unsigned entry_number = GetEntryNumber(seed);
+    std::ostream& r_snapshots = LineageOutput::Instance()->rGetStream(LineageOutput::SNAPSHOTS, seed);
+    for (unsigned i = 0; i < rSimulator.rGetCounts().size(); i++)
+    {
+        r_snapshots << entry_number << "\t" << seed << "\t" << mCountTimes[i] << "\t" << rSimulator.rGetCounts()[i];
+        for (unsigned j = 0; j < rSimulator.rGetPropertyCounts()[i].size(); j++)
+        {
+            r_snapshots << "\t" << rSimulator.rGetPropertyCounts()[i][j];
+        }
+        r_snapshots << "\n";
+    }
+    if (mCountTimes.empty() || mCountTimes.back() < endTime)
+    {
+        std::vector<unsigned> endPropertyCounts = rSimulator.CountCellsWithProperties();
+        r_snapshots << entry_number << "\t" << seed << "\t" << endTime << "\t" << count;
+        for (unsigned j = 0; j < endPropertyCounts.size(); j++)
+        {
+            r_snapshots << "\t" << endPropertyCounts[j];
+        }
+        r_snapshots << "\n";
+    }
+}
+
+bool SimulatorRun::CommitSeed(unsigned seed, unsigned count)
+{
+    LineageOutput::Instance()->CommitSeed(seed);
+    mCache.Store(seed);
+
+    if (mDebugOutput)
+    {
+        CellCycleTrace::Instance()->EndSeed();
+    }
+
+    return mStopping.AddLineage(count);
+}
+
+void SimulatorRun::Close()
+{
+    if (mStopping.IsEnabled()) ExecutableSupport::Print(mStopping.GetReport());
+
+    RandomNumberGenerator::Destroy();
+    LineageOutput::Destroy();
+    CellCycleTrace::Destroy();
+    LineageTreeRecorder::Destroy();
+}
@@ -0,0 +1,148 @@
+#ifndef SIMULATORRUN_HPP_
+#define SIMULATORRUN_HPP_
+
+#include <string>
+#include <vector>
+
+#include "SmartPointers.hpp"
+#include "Cell.hpp"
+#include "OffLatticeSimulationPropertyStop.hpp"
+#include "SeedRangeRunner.hpp"
+#include "SeedJournal.hpp"
+#include "ResultCache.hpp"
+#include "SequentialStopping.hpp"
+
+/***********************************
+ * SIMULATOR RUN
+ * The seed loop plumbing shared by HeSimulator, GomesSimulator & BoijeSimulator: the outputMode argument & the
+ * --count-times, --lineage-tree, --path-only, --cache, --resume, --stop-* & --pack options, their sanity checks,
+ * output setup (SeedRangeRunner, SeedJournal, LineageOutput, CellCycleTrace, LineageTreeRecorder, ResultCache,
+ * SequentialStopping), and each seed's or pack's commit. Simulators keep their model arguments & cell setup.
+ *
+ * USE: after the positional arguments are parsed,
+ * SimulatorRun run(outputModes, debugOutput);
+ * bool sane = run.CheckOptions(<count time limit>, <its argument name>); <the simulator's own checks>
+ * run.Open(argc, argv, directory, filename, startSeed, endSeed, <argv indices of directory, filename & seeds>);
+ * run.WriteHeaders(...); <the simulator's other headers>
+ * while (run.GetNextPack(pack)) { <one founder per seed, tagged CellAncestor(i)>; run.SolvePack(...); }
+ * while (run.GetNextSeed(seed)) { run.BeginSeed(seed); <simulate & write>; stop = run.CommitSeed(seed, count); <reset>; if (stop) break; }
+ * run.Close();
+ *
+ * Packs take every seed when --pack is given, so the per-seed loop then finds none left. Packs are startSeed + k*K
+ * onwards under mpirun too, and each founder is given a LineageRandomStream seeded with its seed, so a seed's count,
+ * events & sequence do not depend on the other seeds in its pack's draws; event cell IDs are numbered across the pack.
+ ************************************/
+
+class SimulatorRun
+{
+private:
+    std::vector<bool> mOutputSinks;
+    bool mModesParsed;
+    bool mDebugOutput;
+    std::vector<double> mCountTimes; //extra count times
+    bool mTreeOutput; //whole division tree archive
+    bool mPathOnly; //sequence sampling follows only the labelled path
+    std::string mCacheDirectory; //result cache, empty if none
+    bool mResume; //continue a killed run from its journal
+    double mStopCiWidth, mStopAicChange; //sequential stopping criteria, 0 if not used
+    unsigned mStopBlock; //seeds between sequential stopping checks
+    bool mStopBlockValid; //whether --stop-block was a whole number
+    std::string mStopReference; //reference count histogram for --stop-aic-change
+    unsigned mPackSize; //seeds simulated together in one population, see --pack
+    bool mPackValid; //whether --pack was a whole number
+    unsigned mStartSeed;
+    std::string mCountHeader;
+
+    boost::shared_ptr<SeedRangeRunner> mpRunner;
+    SequentialStopping mStopping;
+    SeedJournal mJournal;
+    ResultCache mCache;
+
+public:
+    //Parse outputMode (argument 3) & read the shared options
+    SimulatorRun(const std::string& rOutputModes, bool debugOutput);
+
+    /**
+     * Print an error for each bad or incompatible shared option; false if there were any.
+     * @param countTimeLimit latest allowed count time, the end time in the simulator's time units
+     * @param rCountTimeLimitName the end time argument, for the error message (eg. "endTime (argument 7)")
+     */
+    bool CheckOptions(double countTimeLimit, const std::string& rCountTimeLimitName);
+
+    /**
+     * Set up the seed range & output. Relative to CHASTE_TEST_OUTPUT, as for LineageOutput.
+     * @param rCacheSkippedArguments argv indices of the directory, filename & seed arguments, which are not part of a cached job
+     */
+    void Open(int argc, char* argv[], const std::string& rDirectory, const std::string& rFilename, unsigned startSeed,
+              unsigned endSeed, const std::vector<int>& rCacheSkippedArguments);
+
+    /**
+     * Write the counts, events, sequence & trie headers; extra count columns follow the end time count.
+     * @param rCountLeadingColumns tab-terminated column names between Entry & Seed in the counts output
+     * @param rCountTimeUnit appended to each count time's column name
+     */
+    void WriteHeaders(const std::string& rCountLeadingColumns, const std::string& rCountTimeUnit);
+
+    //Counts header line, without newline, as written by WriteHeaders()
+    const std::string& rGetCountHeader() const;
+
+    //Whether the sink's output is enabled; SEQUENCE also when only the trie is, as the trie is built from the sampled sequences
+    bool IsOutput(unsigned sink) const;
+    const std::vector<double>& rGetCountTimes() const;
+    bool IsTreeOutput() const;
+    bool IsPathOnly() const;
+    bool IsCached() const;
+    bool IsResumed() const;
+    bool IsSequentialStopping() const;
+    bool IsPacked() const;
+    bool RunsSimulations() const;
+
+    //Entry number of a seed's output rows, from the seed so it does not depend on which process ran it
+    unsigned GetEntryNumber(unsigned seed) const;
+
+    /**
+     * Next pack of seeds for this process (--pack), with SimulationTime started & cells numbered from 0 for its founders
+     * & each seed's sequence row begun; false when none are left, or without --pack
+     */
+    bool GetNextPack(std::vector<unsigned>& rPack);
+
+    /**
+     * Simulate a pack's founders together, one per seed of the pack & tagged with its index in it by CellAncestor, until
+     * endTime or until no cell has pStopProperty; split the end counts back out per seed & commit the pack in seed order.
+     * @param rCountLeadingColumns tab-terminated values between each counts row's entry number & seed
+     */
+    void SolvePack(const std::vector<unsigned>& rPack, std::vector<CellPtr>& rFounders,
+                   boost::shared_ptr<AbstractCellProperty> pStopProperty, double dt, double endTime,
+                   const std::string& rCountLeadingColumns);
+
+    //Next seed for this process to simulate, skipping seeds already journaled or replayed from the cache; false when done
+    bool GetNextSeed(unsigned& rSeed);
+
+    //Start a seed's simulation: SimulationTime from 0, cells numbered from 0, the RNG reseeded & its sequence row begun
+    void BeginSeed(unsigned seed);
+
+    //Counts row: entry number, rLeadingColumns (tab-terminated), seed, count & any count-time counts
+    void WriteCounts(unsigned seed, const std::string& rLeadingColumns, unsigned count,
+                     const std::vector<unsigned>& rCountTimeCounts = std::vector<unsigned>());
+
+    //Entry number, seed & count, then the seed's per-lineage statistics (decision counts, scores)
+    void WriteStatistics(unsigned sink, unsigned seed, unsigned count, const std::vector<unsigned>& rValues);
+    void WriteStatistics(unsigned sink, unsigned seed, unsigned count, const std::vector<double>& rValues);
+
+    /**
+     * One snapshot row per count time, and one at endTime unless a count time falls on it
+     * @param endTime in the simulator's time units, as the count times
+     */
+    void WriteSnapshots(unsigned seed, unsigned count, OffLatticeSimulationPropertyStop<2>& rSimulator, double endTime);
+
+    /**
+     * Commit the seed's output, store it in the cache & end its debug trace; true once sequential stopping has
+     * converged & the run should stop
+     */
+    bool CommitSeed(unsigned seed, unsigned count);
+
+    //Log the sequential stopping report & destroy the run's singletons
+    void Close();
+};
+
+#endif /*SIMULATORRUN_HPP_*/
@@ -0,0 +1,34 @@
+#include "SobolIndices.hpp"
+
+void SobolIndices::Estimate(const std::vector<double>& rValues, unsigned numBaseSamples, unsigned numSwept,
+                            std::vector<double>& rFirstOrder, std::vector<double>& rTotal)
+{
+    //variance over A & B
+    double sum = 0, sumSq = 0;
+    for (unsigned r = 0; r < 2 * numBaseSamples; r++)
+    {
+        sum += rValues[r];
+        sumSq += rValues[r] * rValues[r];
+    }
+    double mean = sum / (2 * numBaseSamples);
+    double variance = sumSq / (2 * numBaseSamples) - mean * mean;
+
+    rFirstOrder.assign(numSwept, 0.0);
+    rTotal.assign(numSwept, 0.0);
+    if (!(variance > 0)) return;
+
+    for (unsigned j = 0; j < numSwept; j++)
+    {
+        double first = 0, total = 0;
+        for (unsigned r = 0; r < numBaseSamples; r++)
+        {
+            double fA = rValues[r];
+            double fB = rValues[numBaseSamples + r];
+            double fABi = rValues[(j + 2) * numBaseSamples + r];
+            first += fB * (fABi - fA);
+            total += (fA - fABi) * (fA - fABi);
+        }
+        rFirstOrder[j] = first / numBaseSamples / variance;
+        rTotal[j] = total / (2 * numBaseSamples) / variance;
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef SOBOLINDICES_HPP_
+#define SOBOLINDICES_HPP_
+
+#include <vector>
+
+/***********************************
+ * SOBOL INDICES
+ * SobolSweep's estimators of first-order & total Sobol indices from one output over a Saltelli design: base matrices A
+ * & B of numBaseSamples rows each, & AB_i, A with swept parameter i's column from B. Values are given in the design's
+ * block order, A, B, AB_0, ..., AB_{d-1}, numBaseSamples * (d + 2) in all.
+ *
+ * Saltelli (2010) first order S1_i = mean(f_B (f_ABi - f_A)) / V & Jansen total ST_i = mean((f_A - f_ABi)^2) / 2V, V the
+ * variance of f over A & B; both are 0 where V is.
+ ************************************/
+
+class SobolIndices
+{
+public:
+    static void Estimate(const std::vector<double>& rValues, unsigned numBaseSamples, unsigned numSwept,
+                         std::vector<double>& rFirstOrder, std::vector<double>& rTotal);
+};
+
+#endif /*SOBOLINDICES_HPP_*/
@@ -0,0 +1,693 @@
+#include "WanEventEngine.hpp"
+#include "WanMeanField.hpp"
+#include "ModelLineage.hpp"
+#include "LineageModelRules.hpp"
+#include "RandomNumberGenerator.hpp"
+#include "Exception.hpp"
+
+#include <boost/random/gamma_distribution.hpp>
+#include <boost/random/normal_distribution.hpp>
+#include <boost/random/uniform_01.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+const int32_t WanEventEngine::NEVER = std::numeric_limits<int32_t>::max();
+
+//lanes are fixed, so counts do not depend on the number of threads
+const unsigned WanEventEngine::NUM_LANES = 64;
+
+//a day of steps between counts across the lanes
+const int32_t WanEventEngine::WINDOW_STEPS = 24;
+
+//binomial draws of up to this many trials are made one trial at a time
+const unsigned WanEventEngine::BINOMIAL_DIRECT_TRIALS = 64;
+
+unsigned WanEventEngine::BinomialRandomDeviate(unsigned n, double p)
+{
+    RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+    unsigned successes = 0;
+
+    //Knuth's beta splitting: the a-th smallest of n uniforms is Beta(a, b), & the successes on either side of it
+    //are binomial in the rest of the trials
+    while (n > BINOMIAL_DIRECT_TRIALS && p > 0 && p < 1)
+    {
+        unsigned a = 1 + n / 2;
+        unsigned b = n + 1 - a;
+        double ga = p_RNG->GammaRandomDeviate(a, 1);
+        double x = ga / (ga + p_RNG->GammaRandomDeviate(b, 1));
+        if (x >= p)
+        {
+            n = a - 1;
+            p = p / x;
+        }
+        else
+        {
+            successes += a;
+            n = b - 1;
+            p = (p - x) / (1 - x);
+        }
+    }
+
+    if (p <= 0) return successes;
+    if (p >= 1) return successes + n;
+    for (unsigned i = 0; i < n; i++)
+    {
+        if (p_RNG->ranf() < p) successes++;
+    }
+    return successes;
+}
+
+WanEventEngine::WanEventEngine(const std::vector<double>& rTheta)
+    : mTheta(rTheta),
+      mPhase2Boundary(0.0),
+      mPhase3Boundary(0.0),
+      mDt(LineageModelRules::WAN_DT),
+      mNumSteps(0),
+      mEndStep(0),
+      mBaseStemPopulation(0),
+      mNumStem(0),
+      mNumTransit(0),
+      mNextOrder(0),
+      mTauLeapTolerance(0.0),
+      mMinCohortCycle(1),
+      mNextCohortStep(NEVER),
+      mNumCohort(0),
+      mNumThreads(0),
+      mNextLane(0)
+{
+    if (rTheta.size() != ModelLineage::GetParameterNames("Wan").size())
+    {
+        EXCEPTION("WanEventEngine needs one parameter per Wan parameter name");
+    }
+
+    //phase boundaries as WanSimulator passes them: phase 3 starts mitoticModePhase3 after phase 2
+    mPhase2Boundary = rTheta[11];
+    mPhase3Boundary = rTheta[11] + rTheta[12];
+
+    mProgenitorShift[0] = LineageModelRules::HE_GAMMA_SHIFT;
+    mProgenitorShape[0] = LineageModelRules::HE_GAMMA_SHAPE;
+    mProgenitorScale[0] = LineageModelRules::HE_GAMMA_SCALE;
+    mProgenitorSister[0] = LineageModelRules::HE_SISTER_SHIFT;
+    mProgenitorShift[1] = rTheta[7];
+    mProgenitorShape[1] = rTheta[8];
+    mProgenitorScale[1] = rTheta[9];
+    mProgenitorSister[1] = rTheta[10];
+}
+
+double WanEventEngine::GetTime(int32_t step) const
+{
+    return (step == mNumSteps) ? mTheta[19] : step * mDt;
+}
+
+int32_t WanEventEngine::GetDivisionStep(int32_t birthStep, double duration) const
+{
+    if (duration > (mNumSteps - birthStep + 1) * mDt)
+    {
+        return NEVER;
+    }
+
+    //ReadyToDivide() at step k when k*dt - birth time >= duration, & DoCellBirth() skips cells of age 0
+    double birthTime = birthStep * mDt;
+    int32_t step = birthStep + std::max(1, int32_t(std::ceil(duration / mDt)) - 1);
+    while (step * mDt - birthTime < duration)
+    {
+        step++;
+    }
+    while (step > birthStep + 1 && (step - 1) * mDt - birthTime >= duration)
+    {
+        step--;
+    }
+    return (step > mNumSteps) ? NEVER : step;
+}
+
+void WanEventEngine::AddCell(uint8_t kind, double tiLOffset, int32_t birthStep, double duration)
+{
+    //under SetNumThreads(), progenitors go to the lanes in turn
+    if (mNumThreads > 0 && kind != STEM)
+    {
+        mNumTransit++;
+        AddLaneCell(mLanes[mNextLane], kind, tiLOffset, birthStep, duration);
+        mNextLane = (mNextLane + 1) % NUM_LANES;
+        return;
+    }
+
+    unsigned cell;
+    if (mFreeCells.empty())
+    {
+        cell = mKind.size();
+        mKind.push_back(kind);
+        mTiLOffset.push_back(tiLOffset);
+        mOrder.push_back(mNextOrder);
+    }
+    else
+    {
+        cell = mFreeCells.back();
+        mFreeCells.pop_back();
+        mKind[cell] = kind;
+        mTiLOffset[cell] = tiLOffset;
+        mOrder[cell] = mNextOrder;
+    }
+    mNextOrder++; //new cells join the end of the population
+
+    if (kind == STEM) mNumStem++;
+    else mNumTransit++;
+
+    Schedule(cell, birthStep, duration);
+}
+
+void WanEventEngine::Schedule(unsigned cell, int32_t birthStep, double duration)
+{
+    Division division;
+    division.step = GetDivisionStep(birthStep, duration);
+    division.order = mOrder[cell];
+    division.cell = cell;
+    if (division.step == NEVER)
+    {
+        return;
+    }
+
+    //hybrid mode: once a progenitor divides in phase 3, its lineage is left to the cohorts
+    if (mTauLeapTolerance > 0 && mKind[cell] != STEM && GetTime(division.step) + mTiLOffset[cell] > mPhase3Boundary)
+    {
+        JoinCohort(mKind[cell] - 1, division.step, 1);
+        mNumCohort++;
+        FreeCell(cell);
+    }
+    else
+    {
+        mDivisions.push(division);
+    }
+}
+
+void WanEventEngine::FreeCell(unsigned cell)
+{
+    mFreeCells.push_back(cell);
+}
+
+void WanEventEngine::DivideStem(unsigned cell, int32_t step)
+{
+    RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+    double time = GetTime(step);
+
+    //WanStemCellCycleModel::ResetForDivision(): stem-stem division while the stems are short of the lens growth target
+    double retinaAge = time + LineageModelRules::WAN_RETINA_AGE_AT_START;
+    double lensGrowthFactor = LineageModelRules::GetLensGrowthFactor(retinaAge);
+    unsigned currentPopulationTarget = int(std::round(mBaseStemPopulation * lensGrowthFactor));
+    bool symmetric = mNumStem < currentPopulationTarget;
+    Schedule(cell, step, mTheta[4] + p_RNG->GammaRandomDeviate(mTheta[5], mTheta[6]));
+
+    //InitialiseDaughterCell(): a new stem cycle, or a HeCellCycleModel progenitor whose TiL starts now
+    if (symmetric)
+    {
+        AddCell(STEM, 0.0, step, mTheta[4] + p_RNG->GammaRandomDeviate(mTheta[5], mTheta[6]));
+    }
+    else
+    {
+        AddCell(STEM_PROGENITOR, -time, step,
+                mProgenitorShift[1] + p_RNG->GammaRandomDeviate(mProgenitorShape[1], mProgenitorScale[1]));
+    }
+
+    p_RNG->ranf(); //the population's division direction
+}
+
+void WanEventEngine::DivideProgenitor(unsigned cell, int32_t step)
+{
+    RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+    unsigned params = mKind[cell] - 1;
+
+    double pPP, pPD;
+    GetModeProbabilities(step, mTiLOffset[cell], pPP, pPD);
+    unsigned mode = LineageModelRules::GetMitoticMode(p_RNG->ranf(), pPP, pPD);
+
+    //the parent's new cycle is drawn whatever the mode
+    double duration = mProgenitorShift[params] + p_RNG->GammaRandomDeviate(mProgenitorShape[params], mProgenitorScale[params]);
+
+    if (mode == 2)
+    {
+        //DD: parent & daughter are specified & killed
+        mNumTransit--;
+        FreeCell(cell);
+    }
+    else
+    {
+        Schedule(cell, step, duration);
+        if (mode == 0)
+        {
+            //PP: the daughter copies the parent's model & its duration, with a sister shift respecting the refractory period
+            double sisterShift = p_RNG->NormalRandomDeviate(0, mProgenitorSister[params]);
+            AddCell(mKind[cell], mTiLOffset[cell], step, std::max(mProgenitorShift[params], duration + sisterShift));
+        }
+        //PD: the daughter is specified & killed
+    }
+
+    p_RNG->ranf(); //the population's division direction
+}
+
+void WanEventEngine::GetModeProbabilities(int32_t step, double tiLOffset, double& rPP, double& rPD) const
+{
+    //HeCellCycleModel::ResetForDivision(): phase by TiL, mode by the phase's probabilities
+    double currentTiL = GetTime(step) + tiLOffset;
+    unsigned phase = LineageModelRules::GetHePhase(currentTiL, mPhase2Boundary, mPhase3Boundary);
+    rPP = mTheta[13 + 2 * (phase - 1)];
+    rPD = mTheta[14 + 2 * (phase - 1)];
+}
+
+void WanEventEngine::AddLaneCell(ProgenitorLane& rLane, uint8_t kind, double tiLOffset, int32_t birthStep,
+                                 double duration) const
+{
+    unsigned cell;
+    if (rLane.freeCells.empty())
+    {
+        cell = rLane.kind.size();
+        rLane.kind.push_back(kind);
+        rLane.tiLOffset.push_back(tiLOffset);
+    }
+    else
+    {
+        cell = rLane.freeCells.back();
+        rLane.freeCells.pop_back();
+        rLane.kind[cell] = kind;
+        rLane.tiLOffset[cell] = tiLOffset;
+    }
+    ScheduleLane(rLane, cell, birthStep, duration);
+}
+
+void WanEventEngine::ScheduleLane(ProgenitorLane& rLane, unsigned cell, int32_t birthStep, double duration) const
+{
+    Division division;
+    division.step = GetDivisionStep(birthStep, duration);
+    division.order = rLane.nextOrder++;
+    division.cell = cell;
+    if (division.step != NEVER)
+    {
+        rLane.divisions.push(division);
+        rLane.dueAtStep[division.step]++;
+    }
+}
+
+int WanEventEngine::DivideLaneProgenitor(ProgenitorLane& rLane, unsigned cell, int32_t step) const
+{
+    unsigned params = rLane.kind[cell] - 1;
+    double pPP, pPD;
+    GetModeProbabilities(step, rLane.tiLOffset[cell], pPP, pPD);
+
+    //the same draws as DivideProgenitor(), from the lane's stream
+    unsigned mode = LineageModelRules::GetMitoticMode(boost::random::uniform_01<double>()(rLane.generator), pPP, pPD);
+    boost::random::gamma_distribution<double> cycle(mProgenitorShape[params], mProgenitorScale[params]);
+    double duration = mProgenitorShift[params] + cycle(rLane.generator);
+
+    if (mode == 2)
+    {
+        rLane.freeCells.push_back(cell);
+        return -1;
+    }
+
+    ScheduleLane(rLane, cell, step, duration);
+    if (mode == 0)
+    {
+        boost::random::normal_distribution<double> sister(0, mProgenitorSister[params]);
+        double sisterShift = sister(rLane.generator);
+        AddLaneCell(rLane, rLane.kind[cell], rLane.tiLOffset[cell], step,
+                    std::max(mProgenitorShift[params], duration + sisterShift));
+        return 1;
+    }
+    return 0;
+}
+
+void WanEventEngine::RunLanes(int32_t windowStart, int32_t windowEnd)
+{
+    //thread t takes lanes t, t + mNumThreads, ...
+    auto run_lanes = [this, windowStart, windowEnd](unsigned firstLane)
+    {
+        for (unsigned lane = firstLane; lane < mLanes.size(); lane += mNumThreads)
+        {
+            ProgenitorLane& r_lane = mLanes[lane];
+            r_lane.transitChange.assign(windowEnd - windowStart, 0);
+            while (!r_lane.divisions.empty() && r_lane.divisions.top().step < windowEnd)
+            {
+                Division division = r_lane.divisions.top();
+                r_lane.divisions.pop();
+                r_lane.dueAtStep[division.step]--;
+                r_lane.transitChange[division.step - windowStart] += DivideLaneProgenitor(r_lane, division.cell, division.step);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned thread = 1; thread < mNumThreads; thread++)
+    {
+        workers.emplace_back(run_lanes, thread);
+    }
+    run_lanes(0);
+    for (auto& r_worker : workers)
+    {
+        r_worker.join();
+    }
+}
+
+void WanEventEngine::RunWindows(unsigned samplingMultiple)
+{
+    int32_t nextSample = samplingMultiple;
+    int32_t windowStart = 0;
+    std::vector<unsigned> stemAfterStep(WINDOW_STEPS);
+    std::vector<unsigned> birthsAfterStep(WINDOW_STEPS);
+
+    while (windowStart <= mEndStep)
+    {
+        //while every progenitor is due to divide within the window, one step at a time, so the stop falls where it should
+        int32_t windowEnd = std::min(windowStart + WINDOW_STEPS, mEndStep + 1);
+        unsigned numDue = 0;
+        for (unsigned lane = 0; lane < mLanes.size(); lane++)
+        {
+            for (int32_t step = windowStart; step < windowEnd; step++)
+            {
+                numDue += mLanes[lane].dueAtStep[step];
+            }
+        }
+        if (numDue == mNumTransit)
+        {
+            windowEnd = windowStart + 1;
+        }
+
+        //the stems' divisions, & their progenitor daughters, on this thread
+        unsigned transitAtStart = mNumTransit;
+        for (int32_t step = windowStart; step < windowEnd; step++)
+        {
+            while (!mDivisions.empty() && mDivisions.top().step == step)
+            {
+                unsigned cell = mDivisions.top().cell;
+                mDivisions.pop();
+                DivideStem(cell, step);
+            }
+            stemAfterStep[step - windowStart] = mNumStem;
+            birthsAfterStep[step - windowStart] = mNumTransit - transitAtStart;
+        }
+
+        RunLanes(windowStart, windowEnd);
+
+        //the counts after each step of the window
+        int laneChange = 0;
+        for (int32_t step = windowStart; step < windowEnd; step++)
+        {
+            for (unsigned lane = 0; lane < mLanes.size(); lane++)
+            {
+                laneChange += mLanes[lane].transitChange[step - windowStart];
+            }
+            mNumTransit = transitAtStart + birthsAfterStep[step - windowStart] + laneChange;
+
+            if (step + 1 == nextSample && nextSample <= mEndStep)
+            {
+                RecordSample(nextSample, stemAfterStep[step - windowStart], mNumTransit);
+                nextSample += samplingMultiple;
+            }
+
+            //with no progenitors left, the next step's update is the last
+            if (step < mEndStep && mNumTransit == 0)
+            {
+                mEndStep = step + 1;
+            }
+        }
+        windowStart = windowEnd;
+    }
+}
+
+void WanEventEngine::JoinCohort(unsigned cohort, int32_t divisionStep, unsigned numCells)
+{
+    mCohortDue[cohort][divisionStep] += numCells;
+    mNextCohortStep = std::min(mNextCohortStep, divisionStep);
+}
+
+void WanEventEngine::PlaceCohort(unsigned cohort, int32_t birthStep, unsigned numCells, const std::vector<double>& rCycle)
+{
+    //multinomial over the division steps, by binomial draws conditional on the cells not yet placed; cells left over
+    //divide after the end time
+    double remaining = 1.0;
+    for (unsigned k = 1; k < rCycle.size() && birthStep + int32_t(k) <= mNumSteps && numCells > 0 && remaining > 0; k++)
+    {
+        unsigned numDividing = BinomialRandomDeviate(numCells, std::min(1.0, rCycle[k] / remaining));
+        remaining -= rCycle[k];
+        if (numDividing > 0)
+        {
+            JoinCohort(cohort, birthStep + k, numDividing);
+            numCells -= numDividing;
+        }
+    }
+}
+
+int32_t WanEventEngine::LeapCohorts(int32_t step, int32_t limit)
+{
+    //phase 3 mode probabilities, & the mean & variance of the change in the cohort per division
+    double pPP = mTheta[17];
+    double pPD = mTheta[18];
+    double meanChange = pPP - (1 - pPP - pPD);
+    double varianceChange = pPP + (1 - pPP - pPD) - meanChange * meanChange;
+
+    //lengthen the leap while the expected change & its sd stay within tolerance of the cohort
+    double bound = std::max(mTauLeapTolerance * mNumCohort, 1.0);
+    int32_t maxEnd = std::min(limit, step + mMinCohortCycle);
+    int32_t end = step + 1;
+    double numDue = mCohortDue[0][step] + mCohortDue[1][step];
+    while (end < maxEnd)
+    {
+        double numWithNext = numDue + mCohortDue[0][end] + mCohortDue[1][end];
+        if (std::abs(numWithNext * meanChange) > bound || numWithNext * varianceChange > bound * bound) break;
+        numDue = numWithNext;
+        end++;
+    }
+
+    int32_t lastStep = step;
+    for (unsigned cohort = 0; cohort < 2; cohort++)
+    {
+        unsigned numDivisions = 0;
+        double stepSum = 0.0;
+        for (int32_t k = step; k < end; k++)
+        {
+            if (mCohortDue[cohort][k] == 0) continue;
+            numDivisions += mCohortDue[cohort][k];
+            stepSum += double(k) * mCohortDue[cohort][k];
+            mCohortDue[cohort][k] = 0;
+            lastStep = std::max(lastStep, k);
+        }
+        if (numDivisions == 0) continue;
+
+        unsigned numPP = BinomialRandomDeviate(numDivisions, pPP);
+        unsigned numPD = (pPP < 1) ? BinomialRandomDeviate(numDivisions - numPP, pPD / (1 - pPP)) : 0;
+        unsigned numDD = numDivisions - numPP - numPD;
+        mNumCohort = mNumCohort + numPP - numDD;
+        mNumTransit = mNumTransit + numPP - numDD;
+
+        //the leap's new cycles start at its mean division step (the step itself for a one step leap)
+        int32_t birthStep = int32_t(std::round(stepSum / numDivisions));
+        PlaceCohort(cohort, birthStep, numPP + numPD, mCohortCycle[cohort]);
+        PlaceCohort(cohort, birthStep, numPP, mCohortSisterCycle[cohort]);
+    }
+
+    //new cycles are at least mMinCohortCycle long, so nothing is due before the leap's end
+    mNextCohortStep = NEVER;
+    for (int32_t k = end; k <= mNumSteps; k++)
+    {
+        if (mCohortDue[0][k] > 0 || mCohortDue[1][k] > 0)
+        {
+            mNextCohortStep = k;
+            break;
+        }
+    }
+    return lastStep;
+}
+
+void WanEventEngine::RecordSample(int32_t step, unsigned numStem, unsigned numTransit)
+{
+    mSampleSteps.push_back(step);
+    mSampleStem.push_back(numStem);
+    mSampleTransit.push_back(numTransit);
+}
+
+void WanEventEngine::SetTauLeapTolerance(double tolerance)
+{
+    if (tolerance < 0)
+    {
+        EXCEPTION("WanEventEngine's tau-leap tolerance must not be negative");
+    }
+    mTauLeapTolerance = tolerance;
+}
+
+void WanEventEngine::SetNumThreads(unsigned numThreads)
+{
+    mNumThreads = numThreads;
+}
+
+void WanEventEngine::Run(unsigned samplingMultiple)
+{
+    RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+
+    mKind.clear();
+    mTiLOffset.clear();
+    mOrder.clear();
+    mFreeCells.clear();
+    mDivisions = std::priority_queue<Division, std::vector<Division>, std::greater<Division> >();
+    mSampleSteps.clear();
+    mSampleStem.clear();
+    mSampleTransit.clear();
+    mNumStem = 0;
+    mNumTransit = 0;
+    mNextOrder = 0;
+    samplingMultiple = std::max(1u, samplingMultiple);
+
+    //AbstractCellBasedSimulation rounds the run to a whole number of steps & stretches dt to fit
+    double endTime = mTheta[19];
+    mNumSteps = int32_t(endTime / LineageModelRules::WAN_DT + 0.5);
+    mDt = (mNumSteps > 0) ? endTime / mNumSteps : LineageModelRules::WAN_DT;
+
+    if (mNumThreads > 0 && mTauLeapTolerance > 0)
+    {
+        EXCEPTION("WanEventEngine does not tau-leap progenitors in lanes; set the threads or the tau-leap tolerance");
+    }
+
+    mNextLane = 0;
+    mLanes.assign(mNumThreads > 0 ? NUM_LANES : 0, ProgenitorLane());
+    for (unsigned lane = 0; lane < mLanes.size(); lane++)
+    {
+        mLanes[lane].nextOrder = 0;
+        mLanes[lane].dueAtStep.assign(mNumSteps + 1, 0);
+    }
+
+    mNumCohort = 0;
+    mNextCohortStep = NEVER;
+    if (mTauLeapTolerance > 0)
+    {
+        for (unsigned cohort = 0; cohort < 2; cohort++)
+        {
+            mCohortDue[cohort].assign(mNumSteps + 1, 0);
+            mCohortCycle[cohort] = WanMeanField::GetCycleDistribution(mProgenitorShift[cohort], mProgenitorShape[cohort],
+                                                                      mProgenitorScale[cohort], mDt, mNumSteps);
+            mCohortSisterCycle[cohort] = WanMeanField::GetSisterCycleDistribution(
+                    mProgenitorShift[cohort], mProgenitorShape[cohort], mProgenitorScale[cohort],
+                    mProgenitorSister[cohort], mDt, mNumSteps);
+        }
+
+        //the shortest cycle bounds the leaps
+        mMinCohortCycle = mNumSteps + 1;
+        for (unsigned cohort = 0; cohort < 2; cohort++)
+        {
+            for (const std::vector<double>* p_cycle : { &mCohortCycle[cohort], &mCohortSisterCycle[cohort] })
+            {
+                for (unsigned k = 1; k < p_cycle->size(); k++)
+                {
+                    if ((*p_cycle)[k] > 0)
+                    {
+                        mMinCohortCycle = std::min(mMinCohortCycle, int32_t(k));
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    //starting population, drawn as WanSimulator: stems first, then progenitors at uniform TiL in the CMZ
+    unsigned numberProgenitors = int(std::round(p_RNG->NormalRandomDeviate(mTheta[2], mTheta[3])));
+    unsigned numberStem = int(std::round(numberProgenitors / mTheta[1]));
+    mBaseStemPopulation = numberStem;
+
+    for (unsigned i = 0; i < numberStem; i++)
+    {
+        AddCell(STEM, 0.0, 0, mTheta[4] + p_RNG->GammaRandomDeviate(mTheta[5], mTheta[6]));
+    }
+
+    for (unsigned i = 0; i < numberProgenitors; i++)
+    {
+        double currTiL = p_RNG->ranf() * mTheta[0];
+
+        //HeCellCycleModel::Initialise(): run time forward through the TiL to the current cycle's remainder
+        double c = currTiL;
+        while (c > 0)
+        {
+            c = c - (mProgenitorShift[0] + p_RNG->GammaRandomDeviate(mProgenitorShape[0], mProgenitorScale[0]));
+        }
+        double duration = (mProgenitorShift[0] + p_RNG->GammaRandomDeviate(mProgenitorShape[0], mProgenitorScale[0])) + c;
+        if (currTiL == 0)
+        {
+            duration = 0; //ready to divide at once
+        }
+        AddCell(FOUNDER_PROGENITOR, currTiL, 0, duration);
+    }
+
+    //OffLatticeSimulationPropertyStop: with no progenitors, only the final update is done
+    mEndStep = (mNumTransit == 0) ? 0 : mNumSteps;
+    RecordSample(0, mNumStem, mNumTransit);
+
+    if (mNumThreads > 0)
+    {
+        //each lane's stream is seeded once the starting population is drawn, so it matches the serial run's
+        for (unsigned lane = 0; lane < mLanes.size(); lane++)
+        {
+            mLanes[lane].generator.seed(uint32_t(p_RNG->ranf() * std::numeric_limits<uint32_t>::max()));
+        }
+        RunWindows(samplingMultiple);
+        return;
+    }
+
+    int32_t nextSample = samplingMultiple;
+
+    while (true)
+    {
+        int32_t step = mDivisions.empty() ? NEVER : mDivisions.top().step;
+        step = std::min(step, mNextCohortStep);
+        if (step > mEndStep) break;
+
+        //samples up to this step see the population before its divisions
+        for (; nextSample <= step; nextSample += samplingMultiple)
+        {
+            RecordSample(nextSample, mNumStem, mNumTransit);
+        }
+
+        //daughters are due at later steps, so this step's divisions are all queued
+        while (!mDivisions.empty() && mDivisions.top().step == step)
+        {
+            unsigned cell = mDivisions.top().cell;
+            mDivisions.pop();
+            if (mKind[cell] == STEM) DivideStem(cell, step);
+            else DivideProgenitor(cell, step);
+        }
+
+        //the cohorts' leap, from here to the next sample at most
+        int32_t lastStep = step;
+        if (mNextCohortStep == step)
+        {
+            lastStep = LeapCohorts(step, std::min(nextSample, mEndStep + 1));
+        }
+
+        //with no progenitors left, the next step's update is the last
+        if (lastStep < mEndStep && mNumTransit == 0)
+        {
+            mEndStep = lastStep + 1;
+        }
+    }
+
+    for (; nextSample <= mEndStep; nextSample += samplingMultiple)
+    {
+        RecordSample(nextSample, mNumStem, mNumTransit);
+    }
+}
+
+unsigned WanEventEngine::GetNumSamples() const
+{
+    return mSampleSteps.size();
+}
+
+double WanEventEngine::GetSampleTime(unsigned sample) const
+{
+    return GetTime(mSampleSteps.at(sample));
+}
+
+std::vector<unsigned> WanEventEngine::GetSampleCounts(unsigned sample) const
+{
+    return { mSampleStem.at(sample), mSampleTransit.at(sample), 0, 0 };
+}
+
+std::vector<unsigned> WanEventEngine::GetFinalCounts() const
+{
+    return { mNumStem, mNumTransit, 0, 0 };
+}
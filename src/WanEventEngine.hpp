@@ -0,0 +1,205 @@
+#ifndef WANEVENTENGINE_HPP_
+#define WANEVENTENGINE_HPP_
+
+#include <vector>
+#include <queue>
+#include <functional>
+#include <cstdint>
+
+#include <boost/random/mersenne_twister.hpp>
+
+/***********************************
+ * WAN EVENT ENGINE
+ * One seed of the Wan CMZ population (WanStemCellCycleModel stems & their HeCellCycleModel progenitors) run as a
+ * discrete-event simulation without Chaste Cell objects, for WanSimulator runs to 360dpf, where re-checking every cell
+ * of the NodeBasedCellPopulation each hour dominates the run time.
+ *
+ * The cells only interact through the stem count read in WanStemCellCycleModel::ResetForDivision(), so each cell is
+ * reduced to flat per-cell state (stem, founder progenitor or stem-derived progenitor & its TiL offset) plus one entry
+ * in a priority queue of division steps. Run() pops divisions in time order; the lens growth target is only evaluated
+ * when a stem divides. As under OffLatticeSimulationPropertyStop with SetDt(1), divisions fall on the simulator's time
+ * grid (dt adjusted to a whole number of steps to the end time), a cell divides at the first step at which its age is
+ * > 0 & >= its cycle duration, cells due at the same step divide in population order (oldest cell first), & the run
+ * stops one step after the last progenitor is lost.
+ *
+ * The starting population & every division draw from the RandomNumberGenerator (reseeded by the caller) in the order
+ * WanSimulator's population makes them, including the division direction drawn by the population when it places the
+ * daughter, so a seed follows its WanSimulator run.
+ *
+ * SetTauLeapTolerance() switches on a hybrid mode for large progenitor pools. Stems & phase 1 & 2 progenitors are
+ * still run division by division, but a progenitor due to divide in phase 3 (TiL past both phase boundaries, so every
+ * later division in its lineage is too) joins a cohort of phase 3 progenitors, one per cycle parameter set, held only as
+ * the number due to divide at each step. The cohorts are tau-leaped: the divisions due over a leap of steps are split
+ * into PP, PD & DD by multinomial draws with the phase 3 probabilities, & the new cycles of the parents & PP daughters
+ * are spread over the later steps by multinomial draws on the cycle's division step distribution, all started at the
+ * leap's mean division step. The leap is the longest for which the expected change in the cohort & its sd stay within
+ * tolerance * the cohort size (or one cell), as Cao, Gillespie & Petzold choose tau; it never ends past the next sample,
+ * & never lasts longer than the shortest cycle, so no cell divides twice in one leap. A one step leap is exact, but for
+ * a PP daughter's cycle being drawn independently of its sister's. Hybrid runs follow WanSimulator's in distribution,
+ * not seed for seed.
+ *
+ * SetNumThreads() spreads one seed's divisions over threads. Only stems read the stem count, so stems stay on the calling
+ * thread, divided exactly as above, & the progenitors are dealt out to NUM_LANES lanes (founders in turn, then each stem
+ * division's progenitor daughter in turn, PP daughters in their parent's lane), each with its own cells, division queue
+ * & random number stream seeded from the RandomNumberGenerator after the starting population is drawn. The run goes
+ * window by window: the stems' divisions over the window first, handing their progenitor daughters to the lanes, then
+ * the lanes over the window, shared out between the threads. The counts are summed at the end of the window, for the
+ * samples & the stop; a window in which every progenitor is due to divide (so the last could be lost) is cut to one
+ * step. Lanes never interact, so a seed's counts are the same on any number of threads; they follow WanSimulator's in
+ * distribution, not seed for seed. The threads are std::threads, so CMakeLists.txt links the thread library (pthread).
+ *
+ * theta is in ModelLineage's Wan order. Counts are sampled as CellProliferativeTypesCountWriter samples them
+ * (stem, transit, differentiated, default) at time 0 & every samplingMultiple steps, each sample seeing the divisions
+ * of the steps before it. Progenitors are killed at specification, so only stem & transit cells are counted.
+ ************************************/
+
+class WanEventEngine
+{
+private:
+    static const int32_t NEVER; //division step of a cell that will not divide before the end time
+
+    //cell kinds; founder progenitors keep HeCellCycleModel's default cycle parameters, stem offspring take theta's
+    static const uint8_t STEM = 0;
+    static const uint8_t FOUNDER_PROGENITOR = 1;
+    static const uint8_t STEM_PROGENITOR = 2;
+
+    struct Division
+    {
+        int32_t step;
+        unsigned order; //the cell's place in the population
+        unsigned cell;
+
+        bool operator>(const Division& rOther) const
+        {
+            return step > rOther.step || (step == rOther.step && order > rOther.order);
+        }
+    };
+
+    //progenitors dealt out by SetNumThreads()
+    struct ProgenitorLane
+    {
+        std::vector<uint8_t> kind;
+        std::vector<double> tiLOffset;
+        std::vector<unsigned> freeCells;
+        unsigned nextOrder;
+        std::priority_queue<Division, std::vector<Division>, std::greater<Division> > divisions;
+        std::vector<unsigned> dueAtStep; //the lane's progenitors due to divide at each step
+        std::vector<int> transitChange; //at each step of the window
+        boost::random::mt19937 generator;
+    };
+
+    static const unsigned NUM_LANES;
+    static const int32_t WINDOW_STEPS;
+
+    //parameters
+    std::vector<double> mTheta;
+    double mPhase2Boundary;
+    double mPhase3Boundary;
+    double mProgenitorShift[2]; //founder, stem-derived
+    double mProgenitorShape[2];
+    double mProgenitorScale[2];
+    double mProgenitorSister[2];
+
+    //time grid & run state
+    double mDt;
+    int32_t mNumSteps;
+    int32_t mEndStep; //the end step, brought forward once no progenitors are left
+    int mBaseStemPopulation;
+    unsigned mNumStem;
+    unsigned mNumTransit;
+    unsigned mNextOrder;
+
+    //hybrid mode; cohort 0 has HeCellCycleModel's default cycle parameters, cohort 1 theta's
+    double mTauLeapTolerance;
+    int32_t mMinCohortCycle; //the fewest steps a cohort cycle takes
+    int32_t mNextCohortStep; //the first step with cohort divisions due; NEVER if none
+    unsigned mNumCohort;
+    std::vector<unsigned> mCohortDue[2]; //phase 3 progenitors due to divide at each step
+    std::vector<double> mCohortCycle[2];
+    std::vector<double> mCohortSisterCycle[2];
+
+    //lanes; stems alone are per cell below
+    unsigned mNumThreads;
+    unsigned mNextLane;
+    std::vector<ProgenitorLane> mLanes;
+
+    //per cell
+    std::vector<uint8_t> mKind;
+    std::vector<double> mTiLOffset;
+    std::vector<unsigned> mOrder;
+    std::vector<unsigned> mFreeCells;
+
+    std::priority_queue<Division, std::vector<Division>, std::greater<Division> > mDivisions;
+
+    //samples
+    std::vector<int32_t> mSampleSteps;
+    std::vector<unsigned> mSampleStem;
+    std::vector<unsigned> mSampleTransit;
+
+    //SimulationTime at a step of the grid
+    double GetTime(int32_t step) const;
+
+    //First step at which a cell born at birthStep is old enough to divide; NEVER if past the end time
+    int32_t GetDivisionStep(int32_t birthStep, double duration) const;
+
+    void AddCell(uint8_t kind, double tiLOffset, int32_t birthStep, double duration);
+    void Schedule(unsigned cell, int32_t birthStep, double duration);
+    void FreeCell(unsigned cell);
+
+    void DivideStem(unsigned cell, int32_t step);
+    void DivideProgenitor(unsigned cell, int32_t step);
+
+    //HeCellCycleModel::ResetForDivision()'s PP & PD probabilities for a progenitor dividing at step
+    void GetModeProbabilities(int32_t step, double tiLOffset, double& rPP, double& rPD) const;
+
+    //Lane counterparts of AddCell(), Schedule() & DivideProgenitor(), using only the lane; the division returns the
+    //change in the lane's progenitors
+    void AddLaneCell(ProgenitorLane& rLane, uint8_t kind, double tiLOffset, int32_t birthStep, double duration) const;
+    void ScheduleLane(ProgenitorLane& rLane, unsigned cell, int32_t birthStep, double duration) const;
+    int DivideLaneProgenitor(ProgenitorLane& rLane, unsigned cell, int32_t step) const;
+
+    //Run the lanes' divisions from windowStart to before windowEnd, on mNumThreads threads
+    void RunLanes(int32_t windowStart, int32_t windowEnd);
+
+    //Run()'s division loop under SetNumThreads()
+    void RunWindows(unsigned samplingMultiple);
+
+    //Add numCells due to divide at a step to a cohort; spread numCells whose cycles start at birthStep over rCycle
+    void JoinCohort(unsigned cohort, int32_t divisionStep, unsigned numCells);
+    void PlaceCohort(unsigned cohort, int32_t birthStep, unsigned numCells, const std::vector<double>& rCycle);
+
+    //Leap the cohorts from step, ending before limit; returns the last step with divisions in the leap
+    int32_t LeapCohorts(int32_t step, int32_t limit);
+
+    void RecordSample(int32_t step, unsigned numStem, unsigned numTransit);
+
+public:
+    //BinomialRandomDeviate() draws up to this many trials one at a time, & splits larger draws
+    static const unsigned BINOMIAL_DIRECT_TRIALS;
+
+    //Binomial(n, p) deviate from the RandomNumberGenerator, for the cohorts' leaps
+    static unsigned BinomialRandomDeviate(unsigned n, double p);
+
+    //rTheta: WanSimulator's arguments 4-22, then the end time (ModelLineage::GetParameterNames("Wan"))
+    WanEventEngine(const std::vector<double>& rTheta);
+
+    //Hybrid tau-leaping of phase 3 progenitors, with leaps chosen by tolerance; 0 (the default) runs every division
+    void SetTauLeapTolerance(double tolerance);
+
+    //Run progenitor divisions in lanes on numThreads threads; 0 (the default) runs the seed as WanSimulator does
+    void SetNumThreads(unsigned numThreads);
+
+    //Draw a starting population & run it to the end time or stop, sampling counts every samplingMultiple steps
+    void Run(unsigned samplingMultiple = 1);
+
+    unsigned GetNumSamples() const;
+    double GetSampleTime(unsigned sample) const;
+
+    //Counts at a sample, as AbstractCellPopulation::GetCellProliferativeTypeCount()
+    std::vector<unsigned> GetSampleCounts(unsigned sample) const;
+
+    //Counts once the simulator's final population update is done
+    std::vector<unsigned> GetFinalCounts() const;
+};
+
+#endif /*WANEVENTENGINE_HPP_*/
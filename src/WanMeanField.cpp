@@ -0,0 +1,334 @@
+#include "WanMeanField.hpp"
+#include "ModelLineage.hpp"
+#include "LineageModelRules.hpp"
+#include "Exception.hpp"
+
+#include <boost/math/special_functions/gamma.hpp>
+#include <boost/math/distributions/gamma.hpp>
+#include <boost/math/distributions/normal.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    //cycle distributions are cut off once this little probability is left
+    const double TAIL = 1e-12;
+
+    //expected live progenitors below which a lineage is taken as lost (the cut-off tails leave a few 1e-12 undivided)
+    const double LOST_LINEAGE = 1e-9;
+
+    //widths of the starting progenitors' TiL bins & of the forward run's quadrature grid, hours
+    const double TIL_BIN_WIDTH = 0.25;
+    const double FORWARD_RUN_H = 0.05;
+
+    //P(shift + Gamma(shape, scale) <= x)
+    double ShiftedGammaCdf(double x, double shift, double shape, double scale)
+    {
+        return (x <= shift) ? 0.0 : boost::math::gamma_p(shape, (x - shift) / scale);
+    }
+
+    //A function tabulated at multiples of spacing from 0, linearly interpolated; held at its end values outside the table
+    double Interpolate(const std::vector<double>& rValues, double spacing, double x)
+    {
+        if (x <= 0) return rValues.front();
+        double position = x / spacing;
+        unsigned i = unsigned(position);
+        if (i + 1 >= rValues.size()) return rValues.back();
+        double fraction = position - i;
+        return rValues[i] * (1 - fraction) + rValues[i + 1] * fraction;
+    }
+}
+
+WanMeanField::WanMeanField(const std::vector<double>& rTheta)
+    : mTheta(rTheta),
+      mDt(LineageModelRules::WAN_DT),
+      mNumSteps(0)
+{
+    if (rTheta.size() != ModelLineage::GetParameterNames("Wan").size())
+    {
+        EXCEPTION("WanMeanField needs one parameter per Wan parameter name");
+    }
+}
+
+double WanMeanField::GetTime(unsigned step) const
+{
+    return (step == mNumSteps) ? mTheta[19] : step * mDt;
+}
+
+std::vector<double> WanMeanField::GetCycleDistribution(double shift, double shape, double scale, double dt,
+                                                       unsigned maxSteps)
+{
+    //a cycle started at step 0 ends at the first step k > 0 with k*dt >= its duration
+    std::vector<double> distribution(1, 0.0);
+    double previous = 0.0;
+    for (unsigned k = 1; k <= maxSteps && previous < 1 - TAIL; k++)
+    {
+        double cdf = ShiftedGammaCdf(k * dt, shift, shape, scale);
+        distribution.push_back(cdf - previous);
+        previous = cdf;
+    }
+    return distribution;
+}
+
+std::vector<double> WanMeanField::GetSisterCycleDistribution(double shift, double shape, double scale,
+                                                             double sisterShift, double dt, unsigned maxSteps)
+{
+    if (sisterShift <= 0)
+    {
+        return GetCycleDistribution(shift, shape, scale, dt, maxSteps);
+    }
+
+    //HeCellCycleModel::InitialiseDaughterCell(): max(shift, shift + G + N(0, sisterShift)); P(G + N <= y) by quadrature over N
+    const unsigned numPoints = 201;
+    boost::math::normal_distribution<double> normal(0, sisterShift);
+    double width = 16 * sisterShift / (numPoints - 1);
+
+    std::vector<double> distribution(1, 0.0);
+    double previous = 0.0;
+    for (unsigned k = 1; k <= maxSteps && previous < 1 - TAIL; k++)
+    {
+        double y = k * dt - shift;
+        double cdf = 0.0;
+        if (y >= 0)
+        {
+            for (unsigned i = 0; i < numPoints; i++)
+            {
+                double n = -8 * sisterShift + i * width;
+                cdf += boost::math::pdf(normal, n) * width * ShiftedGammaCdf(y - n, 0, shape, scale);
+            }
+            cdf = std::min(1.0, cdf);
+        }
+        distribution.push_back(std::max(0.0, cdf - previous));
+        previous = std::max(previous, cdf);
+    }
+    return distribution;
+}
+
+std::vector<double> WanMeanField::GetFounderCycleDistribution(double tiL, const std::vector<double>& rRenewalDensity,
+                                                              const std::vector<double>& rCycleDensity,
+                                                              const std::vector<double>& rCycleCdf, double h) const
+{
+    /**
+     * HeCellCycleModel::Initialise() draws cycles until they pass the TiL, then the first cycle is a new draw less the
+     * overshoot O. O has density f(tiL + y) + sum over renewals at s < tiL of u(s) f(tiL - s + y), with f the cycle
+     * density & u the renewal density; the first division is at the first step k > 0 with k*dt >= new cycle - O.
+     */
+    //the density table runs a longest cycle past the residency time, so past any overshoot
+    unsigned numOvershoot = unsigned((rCycleDensity.size() * h / 2 - tiL) / h);
+    unsigned numRenewals = std::min(unsigned(rRenewalDensity.size()), unsigned(std::ceil(tiL / h)));
+
+    std::vector<double> overshoot(numOvershoot, 0.0);
+    double mass = 0.0;
+    for (unsigned j = 0; j < numOvershoot; j++)
+    {
+        double y = (j + 0.5) * h;
+        double value = Interpolate(rCycleDensity, h / 2, tiL + y);
+        for (unsigned r = 1; r < numRenewals; r++)
+        {
+            if (rRenewalDensity[r] > 0) value += h * rRenewalDensity[r] * Interpolate(rCycleDensity, h / 2, tiL - r * h + y);
+        }
+        overshoot[j] = value * h;
+        mass += overshoot[j];
+    }
+
+    std::vector<double> distribution(1, 0.0);
+    double previous = 0.0;
+    for (unsigned k = 1; k <= mNumSteps && previous < 1 - TAIL; k++)
+    {
+        double value = 0.0;
+        for (unsigned j = 0; j < numOvershoot; j++)
+        {
+            if (overshoot[j] > 0) value += overshoot[j] * Interpolate(rCycleCdf, h / 2, k * mDt + (j + 0.5) * h);
+        }
+        value = (mass > 0) ? std::min(1.0, value / mass) : 1.0;
+        distribution.push_back(std::max(0.0, value - previous));
+        previous = std::max(previous, value);
+    }
+    return distribution;
+}
+
+std::vector<double> WanMeanField::SolveLineage(const std::vector<double>& rFirstCycle, double tiLAtBirth,
+                                               unsigned params) const
+{
+    const std::vector<double>& r_parent_cycle = mProgenitorCycle[params];
+    const std::vector<double>& r_sister_cycle = mSisterCycle[params];
+    double phase2 = mTheta[11];
+    double phase3 = mTheta[11] + mTheta[12];
+
+    std::vector<double> live(mNumSteps + 1, 0.0);
+    std::vector<double> divisions(mNumSteps + 1, 0.0);
+    for (unsigned k = 1; k < rFirstCycle.size() && k <= mNumSteps; k++)
+    {
+        divisions[k] = rFirstCycle[k];
+    }
+
+    double numLive = 1.0;
+    live[0] = numLive;
+    for (unsigned i = 0; i < mNumSteps; i++)
+    {
+        //HeCellCycleModel::ResetForDivision(): phase by TiL; PP adds a progenitor, DD loses one, PD keeps the parent
+        double currentTiL = tiLAtBirth + GetTime(i);
+        unsigned phase = LineageModelRules::GetHePhase(currentTiL, phase2, phase3);
+        double pPP = mTheta[13 + 2 * (phase - 1)];
+        double pPD = mTheta[14 + 2 * (phase - 1)];
+
+        numLive += divisions[i] * (pPP - (1 - pPP - pPD));
+        live[i + 1] = numLive;
+
+        //parents (PP & PD) start new cycles; PP daughters start sister-shifted ones
+        double parents = divisions[i] * (pPP + pPD);
+        double daughters = divisions[i] * pPP;
+        for (unsigned k = 1; k < r_parent_cycle.size() && i + k <= mNumSteps; k++)
+        {
+            divisions[i + k] += parents * r_parent_cycle[k];
+        }
+        for (unsigned k = 1; k < r_sister_cycle.size() && i + k <= mNumSteps; k++)
+        {
+            divisions[i + k] += daughters * r_sister_cycle[k];
+        }
+
+        //every pending division belongs to a live progenitor, so a lost lineage stays lost
+        if (numLive < LOST_LINEAGE) break;
+    }
+    return live;
+}
+
+void WanMeanField::Solve(unsigned samplingMultiple)
+{
+    samplingMultiple = std::max(1u, samplingMultiple);
+    mSampleSteps.clear();
+    mSampleStem.clear();
+    mSampleTransit.clear();
+
+    //AbstractCellBasedSimulation rounds the run to a whole number of steps & stretches dt to fit
+    double endTime = mTheta[19];
+    mNumSteps = unsigned(endTime / LineageModelRules::WAN_DT + 0.5);
+    mDt = (mNumSteps > 0) ? endTime / mNumSteps : LineageModelRules::WAN_DT;
+
+    mStemCycle = GetCycleDistribution(mTheta[4], mTheta[5], mTheta[6], mDt, mNumSteps);
+    mProgenitorCycle[0] = GetCycleDistribution(LineageModelRules::HE_GAMMA_SHIFT, LineageModelRules::HE_GAMMA_SHAPE,
+                                               LineageModelRules::HE_GAMMA_SCALE, mDt, mNumSteps);
+    mSisterCycle[0] = GetSisterCycleDistribution(LineageModelRules::HE_GAMMA_SHIFT, LineageModelRules::HE_GAMMA_SHAPE,
+                                                 LineageModelRules::HE_GAMMA_SCALE, LineageModelRules::HE_SISTER_SHIFT,
+                                                 mDt, mNumSteps);
+    mProgenitorCycle[1] = GetCycleDistribution(mTheta[7], mTheta[8], mTheta[9], mDt, mNumSteps);
+    mSisterCycle[1] = GetSisterCycleDistribution(mTheta[7], mTheta[8], mTheta[9], mTheta[10], mDt, mNumSteps);
+
+    /**************
+     * Stems: renewal equation with the lens growth feedback
+     **************/
+    double numStartingProgenitors = mTheta[2];
+    double baseStemPopulation = numStartingProgenitors / mTheta[1];
+
+    std::vector<double> stem(mNumSteps + 1, 0.0);
+    std::vector<double> progenitorBirths(mNumSteps + 1, 0.0);
+    std::vector<double> stemDivisions(mNumSteps + 1, 0.0);
+    for (unsigned k = 1; k < mStemCycle.size() && k <= mNumSteps; k++)
+    {
+        stemDivisions[k] = baseStemPopulation * mStemCycle[k];
+    }
+
+    double numStem = baseStemPopulation;
+    for (unsigned i = 0; i <= mNumSteps; i++)
+    {
+        stem[i] = numStem;
+
+        //WanStemCellCycleModel::ResetForDivision(): symmetric divisions until the lens growth target is reached
+        double retinaAge = GetTime(i) + LineageModelRules::WAN_RETINA_AGE_AT_START;
+        double lensGrowthFactor = LineageModelRules::GetLensGrowthFactor(retinaAge);
+        double target = baseStemPopulation * lensGrowthFactor;
+        double symmetric = std::min(stemDivisions[i], std::max(0.0, target - numStem));
+        numStem += symmetric;
+        progenitorBirths[i] = stemDivisions[i] - symmetric;
+
+        //parents & stem daughters start new stem cycles
+        double cycles = stemDivisions[i] + symmetric;
+        for (unsigned k = 1; k < mStemCycle.size() && i + k <= mNumSteps; k++)
+        {
+            stemDivisions[i + k] += cycles * mStemCycle[k];
+        }
+    }
+
+    /**************
+     * Progenitors: stem-derived lineages convolved with their births, plus the starting progenitors' TiL bins
+     **************/
+    std::vector<double> transit(mNumSteps + 1, 0.0);
+
+    std::vector<double> stemLineage = SolveLineage(mProgenitorCycle[1], 0.0, 1);
+    unsigned lineageLength = stemLineage.size();
+    while (lineageLength > 1 && stemLineage[lineageLength - 1] == 0.0)
+    {
+        lineageLength--;
+    }
+    for (unsigned j = 0; j < mNumSteps; j++)
+    {
+        if (progenitorBirths[j] == 0.0) continue;
+        //born during step j, so first seen at step j + 1
+        for (unsigned d = 1; d < lineageLength && j + d <= mNumSteps; d++)
+        {
+            transit[j + d] += progenitorBirths[j] * stemLineage[d];
+        }
+    }
+
+    //founders' forward run: cycle density & distribution on half its quadrature grid, to the longest cycle past the
+    //residency time, & the renewal density over the residency time
+    double cmzResidencyTime = mTheta[0];
+    double h = FORWARD_RUN_H;
+    boost::math::gamma_distribution<double> gamma(LineageModelRules::HE_GAMMA_SHAPE,
+                                                  LineageModelRules::HE_GAMMA_SCALE);
+    double maxCycle = LineageModelRules::HE_GAMMA_SHIFT + boost::math::quantile(boost::math::complement(gamma, TAIL));
+    std::vector<double> cycleDensity, cycleCdf;
+    for (unsigned i = 0; i * h / 2 <= cmzResidencyTime + maxCycle + h; i++)
+    {
+        double x = i * h / 2 - LineageModelRules::HE_GAMMA_SHIFT;
+        cycleDensity.push_back((x <= 0) ? 0.0 : boost::math::pdf(gamma, x));
+        cycleCdf.push_back((x <= 0) ? 0.0 : boost::math::cdf(gamma, x));
+    }
+
+    unsigned numRenewal = unsigned(std::ceil(cmzResidencyTime / h)) + 1;
+    std::vector<double> renewalDensity(numRenewal, 0.0);
+    for (unsigned i = 1; i < numRenewal; i++)
+    {
+        renewalDensity[i] = cycleDensity[2 * i];
+        for (unsigned r = 1; r < i; r++)
+        {
+            renewalDensity[i] += h * renewalDensity[r] * cycleDensity[2 * (i - r)];
+        }
+    }
+
+    unsigned numBins = std::max(1u, unsigned(std::ceil(cmzResidencyTime / TIL_BIN_WIDTH)));
+    double binWidth = cmzResidencyTime / numBins;
+    for (unsigned b = 0; b < numBins; b++)
+    {
+        double tiL = (b + 0.5) * binWidth;
+        std::vector<double> founderLineage = SolveLineage(GetFounderCycleDistribution(tiL, renewalDensity, cycleDensity, cycleCdf, h),
+                                                           tiL, 0);
+        for (unsigned i = 0; i <= mNumSteps; i++)
+        {
+            transit[i] += numStartingProgenitors / numBins * founderLineage[i];
+        }
+    }
+
+    for (unsigned i = 0; i <= mNumSteps; i += samplingMultiple)
+    {
+        mSampleSteps.push_back(i);
+        mSampleStem.push_back(stem[i]);
+        mSampleTransit.push_back(transit[i]);
+    }
+}
+
+unsigned WanMeanField::GetNumSamples() const
+{
+    return mSampleSteps.size();
+}
+
+double WanMeanField::GetSampleTime(unsigned sample) const
+{
+    return GetTime(mSampleSteps.at(sample));
+}
+
+std::vector<double> WanMeanField::GetSampleCounts(unsigned sample) const
+{
+    return { mSampleStem.at(sample), mSampleTransit.at(sample), 0.0, 0.0 };
+}
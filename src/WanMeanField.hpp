@@ -0,0 +1,89 @@
+#ifndef WANMEANFIELD_HPP_
+#define WANMEANFIELD_HPP_
+
+#include <vector>
+
+/***********************************
+ * WAN MEAN FIELD
+ * Expected stem & progenitor counts of the Wan CMZ model over the whole run, integrated deterministically, for
+ * screening stemDivisor, residency time & cycle parameters without stochastic trajectories.
+ *
+ * The equations are age structured on WanSimulator's time grid (SetDt(1), adjusted to a whole number of steps to the
+ * end time). Each cycle length is turned into the probability of dividing at each step after its start (the first step
+ * at which age > 0 & >= the shifted gamma duration, as under OffLatticeSimulationPropertyStop):
+ * - stems: a renewal equation for the expected stem divisions at each step, from the mean starting stems
+ *   (progenitorMean / stemDivisor) & every cycle started since. At each step the divisions are symmetric while the
+ *   expected stem count is short of WanStemCellCycleModel's lens growth target, & the rest give rise to progenitors.
+ * - progenitors: every progenitor's lineage follows HeCellCycleModel's rules from its TiL, so one stem-derived
+ *   progenitor's expected live descendants at each step after its birth form a kernel, convolved with the expected
+ *   progenitor births. PP daughters take the parent's cycle with a sister shift (max(shift, duration + N(0, sister))).
+ *   The mean starting progenitors are split into bins of TiL across the CMZ residency time; each bin's first division
+ *   follows HeCellCycleModel::Initialise()'s forward run through its TiL (a new cycle less the renewal overshoot) &
+ *   its lineage keeps the He model's default cycle parameters, as WanSimulator's founders do.
+ *
+ * Means are taken before WanSimulator's rounding of the starting populations & lens target, & the stop on losing every
+ * progenitor is not applied; progenitors are killed at specification, so only stem & transit cells are counted.
+ *
+ * theta is in ModelLineage's Wan order. Counts are sampled as CellProliferativeTypesCountWriter samples them
+ * (stem, transit, differentiated, default) at time 0 & every samplingMultiple steps, each sample seeing the divisions
+ * of the steps before it.
+ ************************************/
+
+class WanMeanField
+{
+private:
+    std::vector<double> mTheta;
+    double mDt;
+    unsigned mNumSteps;
+
+    //probability of dividing k steps after a cycle starts; founder-parameter & stem-derived progenitors
+    std::vector<double> mStemCycle;
+    std::vector<double> mProgenitorCycle[2];
+    std::vector<double> mSisterCycle[2];
+
+    std::vector<unsigned> mSampleSteps;
+    std::vector<double> mSampleStem;
+    std::vector<double> mSampleTransit;
+
+    //SimulationTime at a step of the grid
+    double GetTime(unsigned step) const;
+
+    /**
+     * Division step distribution of a starting progenitor's forward run through its TiL, from the renewal density (at
+     * multiples of h) & the He cycle density & distribution (at multiples of h/2)
+     */
+    std::vector<double> GetFounderCycleDistribution(double tiL, const std::vector<double>& rRenewalDensity,
+                                                    const std::vector<double>& rCycleDensity,
+                                                    const std::vector<double>& rCycleCdf, double h) const;
+
+    /**
+     * Expected live progenitors in one progenitor's lineage at each step after its birth (before that step's
+     * divisions), by the He rules from the TiL at its birth, with cycle parameters params (0 founder, 1 stem-derived).
+     */
+    std::vector<double> SolveLineage(const std::vector<double>& rFirstCycle, double tiLAtBirth, unsigned params) const;
+
+public:
+    /**
+     * Probability that a cycle of shift + Gamma(shape, scale) started at step 0 ends at step k (the first step k > 0 with
+     * k*dt >= its duration), for k up to maxSteps, cut off once the tail is negligible; & the same for a PP daughter's
+     * cycle, max(shift, shift + Gamma + N(0, sisterShift)), as HeCellCycleModel::InitialiseDaughterCell() draws it.
+     */
+    static std::vector<double> GetCycleDistribution(double shift, double shape, double scale, double dt,
+                                                    unsigned maxSteps);
+    static std::vector<double> GetSisterCycleDistribution(double shift, double shape, double scale, double sisterShift,
+                                                          double dt, unsigned maxSteps);
+
+    //rTheta: WanSimulator's arguments 4-22, then the end time (ModelLineage::GetParameterNames("Wan"))
+    WanMeanField(const std::vector<double>& rTheta);
+
+    //Integrate the expected counts to the end time, sampling every samplingMultiple steps
+    void Solve(unsigned samplingMultiple = 1);
+
+    unsigned GetNumSamples() const;
+    double GetSampleTime(unsigned sample) const;
+
+    //Expected counts at a sample, in AbstractCellPopulation::GetCellProliferativeTypeCount() order
+    std::vector<double> GetSampleCounts(unsigned sample) const;
+};
+
+#endif /*WANMEANFIELD_HPP_*/
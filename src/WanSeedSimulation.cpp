@@ -0,0 +1,207 @@
+#include "WanSeedSimulation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "WanStemCellCycleModel.hpp"
+#include "HeCellCycleModel.hpp"
+#include "LineageModelRules.hpp"
+#include "OffLatticeSimulationPropertyStop.hpp"
+#include "CellBasedSimulationArchiver.hpp"
+#include "CellPropertyRegistry.hpp"
+#include "WildTypeCellMutationState.hpp"
+#include "TransitCellProliferativeType.hpp"
+#include "CellProliferativeTypesCountWriter.hpp"
+#include "HoneycombMeshGenerator.hpp"
+#include "NodesOnlyMesh.hpp"
+#include "NodeBasedCellPopulation.hpp"
+#include "OutputFileHandler.hpp"
+#include "RandomNumberGenerator.hpp"
+#include "SimulationTime.hpp"
+
+WanSeedSimulation::WanSeedSimulation(const std::vector<double>& rTheta) :
+        mTheta(rTheta),
+        mSamplingMultiple(1),
+        mCheckpointInterval(0)
+{
+}
+
+void WanSeedSimulation::SetSamplingTimestepMultiple(unsigned samplingMultiple)
+{
+    mSamplingMultiple = samplingMultiple;
+}
+
+void WanSeedSimulation::SetCheckpointInterval(double checkpointInterval)
+{
+    mCheckpointInterval = checkpointInterval;
+}
+
+std::string WanSeedSimulation::GetCellTypesPath(const std::string& rDirectory, double segmentStartTime)
+{
+    //named as AbstractCellBasedSimulation::Solve() names its results directory
+    std::ostringstream time_string;
+    time_string << segmentStartTime;
+    OutputFileHandler results_handler(rDirectory + "/results_from_time_" + time_string.str(), false);
+    return results_handler.GetOutputDirectoryFullPath() + "celltypes.dat";
+}
+
+void WanSeedSimulation::TruncateCellTypes(const std::string& rDirectory, double restartTime)
+{
+    std::string path = GetCellTypesPath(rDirectory, 0.0);
+    std::vector<std::string> rows;
+    std::ifstream old_file(path.c_str());
+    std::string line;
+    while (std::getline(old_file, line))
+    {
+        if (!line.empty() && std::stod(line) < restartTime + 0.5) rows.push_back(line);
+    }
+    old_file.close();
+
+    std::ofstream new_file(path.c_str(), std::ios::trunc);
+    for (unsigned i = 0; i < rows.size(); i++)
+    {
+        new_file << rows[i] << "\n";
+    }
+}
+
+void WanSeedSimulation::AppendCellTypes(const std::string& rDirectory, double segmentStartTime)
+{
+    std::ifstream segment_file(GetCellTypesPath(rDirectory, segmentStartTime).c_str());
+    std::ofstream seed_file(GetCellTypesPath(rDirectory, 0.0).c_str(), std::ios::app);
+    std::string line;
+    while (std::getline(segment_file, line))
+    {
+        //the row at the segment start follows the previous segment's final update; the previous segment wrote it first
+        if (!line.empty() && std::stod(line) > segmentStartTime + 0.5) seed_file << line << "\n";
+    }
+}
+
+void WanSeedSimulation::Run(const std::string& rDirectory, double restartTime)
+{
+    RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+    boost::shared_ptr<AbstractCellProperty> p_state(CellPropertyRegistry::Instance()->Get<WildTypeCellMutationState>());
+    boost::shared_ptr<AbstractCellProperty> p_Transit(CellPropertyRegistry::Instance()->Get<TransitCellProliferativeType>());
+
+    double cmzResidencyTime = mTheta[0];
+    double stemDivisor = mTheta[1];
+    double mitoticModePhase2 = mTheta[11];
+    double mitoticModePhase3 = mTheta[12];
+    double endTime = mTheta[19];
+
+    NodesOnlyMesh<2> mesh;
+    boost::shared_ptr<NodeBasedCellPopulation<2> > cell_population;
+    boost::shared_ptr<OffLatticeSimulationPropertyStop<2> > p_simulator;
+
+    if (restartTime < 0)
+    {
+        std::vector<double> stemOffspringParams = { mitoticModePhase2, mitoticModePhase2 + mitoticModePhase3, mTheta[13],
+                                                    mTheta[14], mTheta[15], mTheta[16], mTheta[17], mTheta[18], mTheta[7],
+                                                    mTheta[8], mTheta[9], mTheta[10] };
+
+        unsigned numberProgenitors = int(std::round(p_RNG->NormalRandomDeviate(mTheta[2], mTheta[3])));
+        unsigned numberStem = int(std::round(numberProgenitors / stemDivisor));
+
+        std::vector<CellPtr> stems;
+        std::vector<CellPtr> cells;
+
+        for (unsigned i = 0; i < numberStem; i++)
+        {
+            WanStemCellCycleModel* p_stem_model = new WanStemCellCycleModel;
+            p_stem_model->SetDimension(2);
+            p_stem_model->SetModelParameters(mTheta[4], mTheta[5], mTheta[6], stemOffspringParams);
+
+            CellPtr p_cell(new Cell(p_state, p_stem_model));
+            p_cell->InitialiseCellCycleModel();
+            stems.push_back(p_cell);
+            cells.push_back(p_cell);
+        }
+
+        for (unsigned i = 0; i < numberProgenitors; i++)
+        {
+            double currTiL = p_RNG->ranf() * cmzResidencyTime;
+
+            HeCellCycleModel* p_prog_model = new HeCellCycleModel;
+            p_prog_model->SetDimension(2);
+            p_prog_model->SetModelParameters(currTiL, mitoticModePhase2, mitoticModePhase2 + mitoticModePhase3, mTheta[13],
+                                             mTheta[14], mTheta[15], mTheta[16], mTheta[17], mTheta[18]);
+            p_prog_model->EnableKillSpecified();
+
+            CellPtr p_cell(new Cell(p_state, p_prog_model));
+            p_cell->InitialiseCellCycleModel();
+            cells.push_back(p_cell);
+        }
+
+        //Generate 1x#cells mesh for abstract colony
+        HoneycombMeshGenerator generator(1, (numberProgenitors + numberStem));
+        MutableMesh<2, 2>* p_generating_mesh = generator.GetMesh();
+        mesh.ConstructNodesWithoutMesh(*p_generating_mesh, 1.5);
+
+        //Setup cell population
+        cell_population.reset(new NodeBasedCellPopulation<2>(mesh, cells));
+        cell_population->AddCellPopulationCountWriter<CellProliferativeTypesCountWriter>();
+
+        //Give Wan stem cells the population & base stem pop size
+        for (auto p_cell : stems)
+        {
+            WanStemCellCycleModel* p_cycle_model = dynamic_cast<WanStemCellCycleModel*>(p_cell->GetCellCycleModel());
+            p_cycle_model->EnableExpandingStemPopulation(numberStem, cell_population);
+        }
+
+        //Setup simulator
+        p_simulator.reset(new OffLatticeSimulationPropertyStop<2>(*cell_population));
+        p_simulator->SetDt(LineageModelRules::WAN_DT);
+        p_simulator->SetOutputDirectory(rDirectory);
+    }
+    else
+    {
+        //Load the seed's checkpoint (restores SimulationTime & the RNG); the loaded simulation owns its population
+        p_simulator.reset(CellBasedSimulationArchiver<2, OffLatticeSimulationPropertyStop<2>, 2>::Load(rDirectory, restartTime));
+
+        //Re-attach Wan stem cells to the population, which is not archived with them
+        boost::shared_ptr<AbstractCellPopulation<2> > p_population(&(p_simulator->rGetCellPopulation()),
+                                                                   [](AbstractCellPopulation<2>*){});
+        for (AbstractCellPopulation<2>::Iterator cell_iter = p_population->Begin(); cell_iter != p_population->End(); ++cell_iter)
+        {
+            WanStemCellCycleModel* p_stem_model = dynamic_cast<WanStemCellCycleModel*>((*cell_iter)->GetCellCycleModel());
+            if (p_stem_model) p_stem_model->SetPopulation(p_population);
+        }
+
+        TruncateCellTypes(rDirectory, SimulationTime::Instance()->GetTime());
+    }
+    p_simulator->SetStopProperty(p_Transit); //simulation to stop if no RPCs are left
+    p_simulator->SetSamplingTimestepMultiple(mSamplingMultiple);
+
+    //Run simulation, in segments ending at each checkpoint (multiples of mCheckpointInterval) if checkpointing
+    double currentTime = SimulationTime::Instance()->GetTime();
+    while (currentTime < endTime - 0.5)
+    {
+        double segmentStartTime = currentTime;
+        double segmentEndTime = endTime;
+        if (mCheckpointInterval > 0)
+        {
+            segmentEndTime = std::min(endTime, (std::floor(currentTime / mCheckpointInterval + 1e-9) + 1) * mCheckpointInterval);
+        }
+        p_simulator->SetEndTime(segmentEndTime);
+        p_simulator->Solve();
+        currentTime = SimulationTime::Instance()->GetTime();
+
+        if (segmentStartTime > 0.5) AppendCellTypes(rDirectory, segmentStartTime);
+        if (mCheckpointInterval > 0)
+        {
+            CellBasedSimulationArchiver<2, OffLatticeSimulationPropertyStop<2>, 2>::Save(p_simulator.get());
+        }
+        if (currentTime < segmentEndTime - 0.5) break; //stopped: no RPCs left
+    }
+
+    //the stem models hold the population; detached, it & its cells are freed with the simulator
+    AbstractCellPopulation<2>& r_population = p_simulator->rGetCellPopulation();
+    for (AbstractCellPopulation<2>::Iterator cell_iter = r_population.Begin(); cell_iter != r_population.End(); ++cell_iter)
+    {
+        WanStemCellCycleModel* p_stem_model = dynamic_cast<WanStemCellCycleModel*>((*cell_iter)->GetCellCycleModel());
+        if (p_stem_model) p_stem_model->SetPopulation(boost::shared_ptr<AbstractCellPopulation<2> >());
+    }
+    p_simulator.reset();
+    cell_population.reset();
+}
@@ -0,0 +1,61 @@
+#ifndef WANSEEDSIMULATION_HPP_
+#define WANSEEDSIMULATION_HPP_
+
+#include <string>
+#include <vector>
+
+/***********************************
+ * WAN SEED SIMULATION
+ * One seed of WanSimulator's Chaste path: the Wan CMZ population (WanStemCellCycleModel stems & their
+ * HeCellCycleModel progenitors) in a NodeBasedCellPopulation, run under OffLatticeSimulationPropertyStop with SetDt(1)
+ * until the end time or the loss of every progenitor, writing CellProliferativeTypesCountWriter counts every
+ * samplingMultiple steps.
+ *
+ * SetCheckpointInterval() runs the seed in segments ending at each multiple of the interval, saving the simulation with
+ * CellBasedSimulationArchiver after each. Run() with a restart time loads the seed's checkpoint at that time instead of
+ * drawing a starting population, & continues it to the end time.
+ *
+ * Each Solve() writes its counts to its own results_from_time_<segment start> directory, starting with a row at the
+ * segment start taken after the previous segment's final population update. That row is dropped & the rest appended to
+ * results_from_time_0/celltypes.dat, so the seed's counts are always one file, with one row per sample, as an
+ * uncheckpointed run writes them. A restart first drops the rows after its checkpoint. The checkpoint interval should
+ * be a whole multiple of the sampling interval, so the segments sample on the same steps as an uncheckpointed run.
+ *
+ * The caller starts SimulationTime at 0 & reseeds the RandomNumberGenerator before Run(), & destroys SimulationTime
+ * after it, as for the other simulators' seeds.
+ ************************************/
+
+class WanSeedSimulation
+{
+private:
+    std::vector<double> mTheta;
+    unsigned mSamplingMultiple;
+    double mCheckpointInterval;
+
+    //celltypes.dat written by the segment run from segmentStartTime
+    static std::string GetCellTypesPath(const std::string& rDirectory, double segmentStartTime);
+
+    //Drop the seed's rows after restartTime, which the restart writes again
+    static void TruncateCellTypes(const std::string& rDirectory, double restartTime);
+
+    //Append a segment's rows, less its first, to the seed's results_from_time_0/celltypes.dat
+    static void AppendCellTypes(const std::string& rDirectory, double segmentStartTime);
+
+public:
+    //rTheta: WanSimulator's arguments 4-22, then the end time (ModelLineage::GetParameterNames("Wan"))
+    WanSeedSimulation(const std::vector<double>& rTheta);
+
+    //Write cell type counts every samplingMultiple steps (default 1)
+    void SetSamplingTimestepMultiple(unsigned samplingMultiple);
+
+    //Save a checkpoint at each multiple of checkpointInterval hours; 0 (the default) runs the seed in one segment
+    void SetCheckpointInterval(double checkpointInterval);
+
+    /**
+     * Run one seed to the end time, writing its results under rDirectory (a path under the test output directory):
+     * from a new starting population, or from its checkpoint at restartTime if restartTime >= 0
+     */
+    void Run(const std::string& rDirectory, double restartTime = -1);
+};
+
+#endif /*WANSEEDSIMULATION_HPP_*/
@@ -2,7 +2,7 @@
 
 WanStemCellCycleModel::WanStemCellCycleModel() :
         AbstractSimpleCellCycleModel(), mExpandingStemPopulation(false), mPopulation(), mOutput(false), mEventStartTime(
-                72.0), mDebug(false), mTimeID(), mVarIDs(), mDebugWriter(), mBasePopulation(), mGammaShift(4.0), mGammaShape(
+                LineageModelRules::WAN_RETINA_AGE_AT_START), mDebug(false), mBasePopulation(), mGammaShift(4.0), mGammaShape(
                 2.0), mGammaScale(1.0), mMitoticMode(0), mSeed(0), mTimeDependentCycleDuration(false), mPeakRateTime(), mIncreasingRateSlope(), mDecreasingRateSlope(), mBaseGammaScale(), mHeParamVector(
                 { 8, 15, 1, 0, .2, .4, .2, 0, 4, 2, 1, 1 })
 {
@@ -11,7 +11,7 @@ WanStemCellCycleModel::WanStemCellCycleModel() :
 WanStemCellCycleModel::WanStemCellCycleModel(const WanStemCellCycleModel& rModel) :
         AbstractSimpleCellCycleModel(rModel), mExpandingStemPopulation(rModel.mExpandingStemPopulation), mPopulation(
                 rModel.mPopulation), mOutput(rModel.mOutput), mEventStartTime(rModel.mEventStartTime), mDebug(
-                rModel.mDebug), mTimeID(rModel.mTimeID), mVarIDs(rModel.mVarIDs), mDebugWriter(rModel.mDebugWriter), mBasePopulation(
+                rModel.mDebug), mBasePopulation(
                 rModel.mBasePopulation), mGammaShift(rModel.mGammaShift), mGammaShape(rModel.mGammaShape), mGammaScale(
                 rModel.mGammaScale), mMitoticMode(rModel.mMitoticMode), mSeed(rModel.mSeed), mTimeDependentCycleDuration(
                 rModel.mTimeDependentCycleDuration), mPeakRateTime(rModel.mPeakRateTime), mIncreasingRateSlope(
@@ -74,7 +74,7 @@ void WanStemCellCycleModel::ResetForDivision()
     if (mExpandingStemPopulation)
     {
         double currRetinaAge = SimulationTime::Instance()->GetTime() + mEventStartTime;
-        double lensGrowthFactor = .09256 * pow(currRetinaAge, .52728); // power law model fit for lens growth
+        double lensGrowthFactor = LineageModelRules::GetLensGrowthFactor(currRetinaAge);
         unsigned currentPopulationTarget = int(std::round(mBasePopulation * lensGrowthFactor));
 
         unsigned currentStemPopulation = (mPopulation->GetCellProliferativeTypeCount())[0];
@@ -132,7 +132,7 @@ void WanStemCellCycleModel::InitialiseDaughterCell()
         //if debug output is enabled for the stem cell, enable it for its progenitor offspring
         if (mDebug)
         {
-            p_cycle_model->PassDebugWriter(mDebugWriter, mTimeID, mVarIDs);
+            p_cycle_model->EnableModelDebugOutput(mSeed);
         }
 
         mpCell->SetCellCycleModel(p_cycle_model);
@@ -162,6 +162,14 @@ void WanStemCellCycleModel::EnableExpandingStemPopulation(int basePopulation,
     mPopulation = p_population;
 }
 
+void WanStemCellCycleModel::SetPopulation(boost::shared_ptr<AbstractCellPopulation<2>> p_population)
+{
+    if (mExpandingStemPopulation)
+    {
+        mPopulation = p_population;
+    }
+}
+
 void WanStemCellCycleModel::SetTimeDependentCycleDuration(double peakRateTime, double increasingSlope,
                                                           double decreasingSlope)
 {
@@ -184,42 +192,29 @@ void WanStemCellCycleModel::WriteModeEventOutput()
     double currentTime = SimulationTime::Instance()->GetTime() + mEventStartTime;
     CellPtr currentCell = GetCell();
     double currentCellID = (double) currentCell->GetCellId();
-    (*LogFile::Instance()) << currentTime << "\t" << mSeed << "\t" << currentCellID << "\t" << mMitoticMode << "\n"; //
+    LineageOutput::Instance()->rGetStream(LineageOutput::EVENTS, mSeed) << currentTime << "\t" << mSeed << "\t" << currentCellID << "\t" << mMitoticMode << "\n";
 }
 
-void WanStemCellCycleModel::EnableModelDebugOutput(boost::shared_ptr<ColumnDataWriter> debugWriter)
+void WanStemCellCycleModel::EnableModelDebugOutput(unsigned seed)
 {
     mDebug = true;
-    mDebugWriter = debugWriter;
-
-    mTimeID = mDebugWriter->DefineUnlimitedDimension("Time", "h");
-    mVarIDs.push_back(mDebugWriter->DefineVariable("CellID", "No"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("TiL", "h"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("CycleDuration", "h"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("Phase2Boundary", "h"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("Phase3Boundary", "h"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("Phase", "No"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("MitoticModeRV", "Percentile"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("MitoticMode", "Mode"));
-    mVarIDs.push_back(mDebugWriter->DefineVariable("Label", "binary"));
-
-    mDebugWriter->EndDefineMode();
+    mSeed = seed;
 }
 
 void WanStemCellCycleModel::WriteDebugData()
 {
-    double currentTime = SimulationTime::Instance()->GetTime();
-    double currentCellID = mpCell->GetCellId();
-
-    mDebugWriter->PutVariable(mTimeID, currentTime);
-    mDebugWriter->PutVariable(mVarIDs[0], currentCellID);
-    mDebugWriter->PutVariable(mVarIDs[1], 0);
-    mDebugWriter->PutVariable(mVarIDs[2], mCellCycleDuration);
-    mDebugWriter->PutVariable(mVarIDs[3], 0);
-    mDebugWriter->PutVariable(mVarIDs[4], 0);
-    mDebugWriter->PutVariable(mVarIDs[5], 0);
-    mDebugWriter->PutVariable(mVarIDs[7], mMitoticMode);
-    mDebugWriter->AdvanceAlongUnlimitedDimension();
+    //Stem records share the He layout so stem & progenitor events convert to one file; TiL, phase boundaries & phase are 0
+    CellCycleTraceRecord record(CellCycleTrace::WAN, mSeed, SimulationTime::Instance()->GetTime());
+
+    record.Put(0, mpCell->GetCellId());
+    record.Put(1, 0);
+    record.Put(2, mCellCycleDuration);
+    record.Put(3, 0);
+    record.Put(4, 0);
+    record.Put(5, 0);
+    record.Put(7, mMitoticMode);
+
+    CellCycleTrace::Instance()->Record(record);
 }
 
 /******************
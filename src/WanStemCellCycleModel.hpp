@@ -7,10 +7,12 @@
 #include "Cell.hpp"
 #include "StemCellProliferativeType.hpp"
 #include "SmartPointers.hpp"
-#include "ColumnDataWriter.hpp"
-#include "LogFile.hpp"
+#include <boost/serialization/vector.hpp>
+#include "CellCycleTrace.hpp"
+#include "LineageOutput.hpp"
 
 #include "HeCellCycleModel.hpp"
+#include "LineageModelRules.hpp"
 
 /***********************************
  * WAN STEM CELL CYCLE MODEL
@@ -24,13 +26,12 @@
  * Change default model parameters with SetModelParameters(<params>);
  *
  * 2 per-model-event output modes:
- * EnableModeEventOutput() enables mitotic mode event logging-all cells will write to the singleton log file
- * EnableModelDebugOutput() enables more detailed debug output, each seed will have its own file written to
- * by a ColumnDataWriter passed to it from the test
- * (eg. by the SetupDebugOutput helper function in the project simulator)
+ * EnableModeEventOutput() enables mitotic mode event logging-all cells will write to the LineageOutput events sink
+ * EnableModelDebugOutput() enables more detailed debug output, written to the singleton CellCycleTrace
+ * (opened once per run by the project simulator; convert to per-seed files with TraceConverter)
  *
  * 1 mitotic-event-sequence sampler (only samples one "path" through the lineage):
- * EnableSequenceSampler() - one "sequence" of progenitors writes mitotic event type to a string in the singleton log file
+ * EnableSequenceSampler() - one "sequence" of progenitors writes mitotic event type to a string in the LineageOutput sequence sink
  *
  ************************************/
 
@@ -57,6 +58,24 @@ private:
                 RandomNumberGenerator::Instance()->GetSerializationWrapper();
         archive & p_wrapper;
         archive & mCellCycleDuration;
+        //mode switches & parameters, so a checkpointed colony resumes as it was (see WanSimulator --checkpoint-interval);
+        //mPopulation is not archived- the population owns the cells, so it is re-attached with SetPopulation() after loading
+        archive & mExpandingStemPopulation;
+        archive & mOutput;
+        archive & mEventStartTime;
+        archive & mDebug;
+        archive & mBasePopulation;
+        archive & mGammaShift;
+        archive & mGammaShape;
+        archive & mGammaScale;
+        archive & mMitoticMode;
+        archive & mSeed;
+        archive & mTimeDependentCycleDuration;
+        archive & mPeakRateTime;
+        archive & mIncreasingRateSlope;
+        archive & mDecreasingRateSlope;
+        archive & mBaseGammaScale;
+        archive & mHeParamVector;
     }
 
     //Private write functions for models
@@ -69,11 +88,8 @@ protected:
     boost::shared_ptr<AbstractCellPopulation<2>> mPopulation;
     bool mOutput;
     double mEventStartTime;
-    //debug writer stuff
+    //debug trace switch
     bool mDebug;
-    int mTimeID;
-    std::vector<int> mVarIDs;
-    boost::shared_ptr<ColumnDataWriter> mDebugWriter;
     //model parameters and state memory vars
     int mBasePopulation;
     double mGammaShift;
@@ -150,15 +166,21 @@ public:
      */
     void SetModelParameters(double gammaShift = 4, double gammaShape = 2, double gammaScale = 1, std::vector<double> heParamVector = { 8, 15, 1, 0, .2, .4, .2, 0, 4, 2, 1, 1 });
     void EnableExpandingStemPopulation(int basePopulation, boost::shared_ptr<AbstractCellPopulation<2>> p_population);
+
+    /**
+     * Re-attach the population after loading a checkpoint (mPopulation is not archived).
+     * Does nothing unless the expanding stem population was enabled before the checkpoint.
+     */
+    void SetPopulation(boost::shared_ptr<AbstractCellPopulation<2>> p_population);
     void SetTimeDependentCycleDuration(double peakRateTime, double increasingSlope, double decreasingSlope);
 
     //Functions to enable per-cell mitotic mode logging for mode rate & sequence sampling fixtures
-    //Uses singleton logfile
+    //Uses singleton LineageOutput; output is buffered under the seed until the simulator commits it
     void EnableModeEventOutput(double eventStart, unsigned seed);
 
-    //More detailed debug output. Needs a ColumnDataWriter passed to it
-    //Only declare ColumnDataWriter directory, filename, etc; do not set up otherwise
-    void EnableModelDebugOutput(boost::shared_ptr<ColumnDataWriter> debugWriter);
+    //More detailed debug output. Records go to the singleton CellCycleTrace, which must be Open()ed by the simulator
+    //Records are tagged with seed
+    void EnableModelDebugOutput(unsigned seed);
 
     //Not used, but must be overwritten lest WanStemCellCycleModels be abstract
     double GetAverageTransitCellCycleTime();
@@ -0,0 +1,121 @@
+#ifndef SIMULATORRUNFIXTURE_HPP_
+#define SIMULATORRUNFIXTURE_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <climits>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CommandLineArgumentsMocker.hpp"
+#include "OutputFileHandler.hpp"
+#include "LineageOutput.hpp"
+#include "SimulatorRun.hpp"
+
+/***********************************
+ * SIMULATOR RUN FIXTURE
+ * Stand-in simulator for the output plumbing suites (TestResultCache, TestSeedJournal): seeds go through SimulatorRun's
+ * seed loop as HeSimulator's do, with outputMode 01, but each seed writes a count row & a few event rows computed from
+ * the seed instead of simulating a lineage. Output goes to <directory>/runCounts & runEvents.
+ ************************************/
+
+class SimulatorRunFixture
+{
+private:
+    //Stand-in simulator command line: directory, filename, outputMode, seeds & one model argument, then the options
+    static std::vector<std::string> MakeArguments(const std::string& rDirectory, const std::string& rJob,
+                                                  const std::string& rOptions, unsigned startSeed, unsigned endSeed)
+    {
+        std::vector<std::string> arguments = { "FixtureSimulator", rDirectory, "run", "01", std::to_string(startSeed),
+                                               std::to_string(endSeed), rJob };
+        std::istringstream options(rOptions);
+        std::string option;
+        while (options >> option)
+        {
+            arguments.push_back(option);
+        }
+        return arguments;
+    }
+
+public:
+    //Stand-in for a simulated seed: a count row & a few event rows, all depending on the seed
+    static unsigned WriteSeed(SimulatorRun& rRun, unsigned seed)
+    {
+        unsigned count = (seed * 7) % 13;
+        rRun.WriteCounts(seed, "", count);
+        for (unsigned i = 0; i < seed % 4; i++)
+        {
+            LineageOutput::Instance()->rGetStream(LineageOutput::EVENTS, seed) << 0.25 * i << "\t" << seed << "\t" << i << "\t" << i % 3 << "\n";
+        }
+        return count;
+    }
+
+    /**
+     * One run of seeds [startSeed, endSeed] through SimulatorRun, with the options (eg. "--cache <directory>"): journaled
+     * & cached seeds are skipped or replayed, the rest simulated. Stops after numSeeds seeds have been simulated, as if
+     * killed. With pForwarded, LineageOutput forwards as on a worker rank, & the forwarded seeds are appended to it.
+     * Returns the number of seeds simulated.
+     */
+    static unsigned Run(const std::string& rDirectory, const std::string& rJob, const std::string& rOptions,
+                        unsigned startSeed, unsigned endSeed, unsigned numSeeds = UINT_MAX, std::string* pForwarded = NULL)
+    {
+        std::vector<std::string> arguments = MakeArguments(rDirectory, rJob, rOptions, startSeed, endSeed);
+        std::vector<char*> argv;
+        for (unsigned i = 0; i < arguments.size(); i++)
+        {
+            argv.push_back(const_cast<char*>(arguments[i].c_str()));
+        }
+        CommandLineArgumentsMocker mocker(rOptions);
+
+        SimulatorRun run("01", false);
+        bool sane = run.CheckOptions(100, "endTime (argument 7)");
+        TS_ASSERT(sane);
+
+        if (pForwarded) LineageOutput::Instance()->EnableForwarding();
+        run.Open(argv.size(), argv.data(), rDirectory, "run", startSeed, endSeed, { 1, 2, 4, 5 });
+        run.WriteHeaders("", "h");
+
+        unsigned simulated = 0;
+        unsigned seed;
+        while (simulated < numSeeds && run.GetNextSeed(seed))
+        {
+            run.BeginSeed(seed);
+            unsigned count = WriteSeed(run, seed);
+            run.CommitSeed(seed, count);
+            simulated++;
+        }
+        if (pForwarded) *pForwarded += LineageOutput::Instance()->TakeForwarded(); //simulated & replayed seeds
+        run.Close();
+        return simulated;
+    }
+
+    //Job description of a Run() command line, as SimulatorRun gives it to ResultCache
+    static std::string GetJobDescription(const std::string& rJob, const std::string& rOptions)
+    {
+        std::vector<std::string> arguments = MakeArguments("", rJob, rOptions, 0, 0);
+        std::vector<char*> argv;
+        for (unsigned i = 0; i < arguments.size(); i++)
+        {
+            argv.push_back(const_cast<char*>(arguments[i].c_str()));
+        }
+        return ResultCache::MakeJobDescription(argv.size(), argv.data(), { 1, 2, 4, 5 });
+    }
+
+    static std::string FilePath(const std::string& rDirectory, const std::string& rFilename)
+    {
+        OutputFileHandler handler(rDirectory, false);
+        return handler.GetOutputDirectoryFullPath() + rFilename;
+    }
+
+    static std::string ReadFile(const std::string& rDirectory, const std::string& rFilename)
+    {
+        std::ifstream file(FilePath(rDirectory, rFilename).c_str());
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+};
+
+#endif /*SIMULATORRUNFIXTURE_HPP_*/
@@ -0,0 +1,138 @@
+#ifndef TESTABCHISTOGRAMDISTANCE_HPP_
+#define TESTABCHISTOGRAMDISTANCE_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <vector>
+
+#include "AbcHistogramDistance.hpp"
+#include "RandomNumberGenerator.hpp"
+
+class TestAbcHistogramDistance : public CxxTest::TestSuite
+{
+private:
+    //The fixtures' RSS of a complete candidate, computed directly: bins 1..K & an overflow bin for every other count
+    double GetRss(const std::vector<double>& rObserved, const std::vector<unsigned>& rCounts)
+    {
+        unsigned num_bins = rObserved.size() + 1;
+        std::vector<double> candidate(num_bins, 0.0);
+        for (unsigned i = 0; i < rCounts.size(); i++)
+        {
+            unsigned bin = (rCounts[i] == 0 || rCounts[i] > rObserved.size()) ? num_bins - 1 : rCounts[i] - 1;
+            candidate[bin] += 1.0 / rCounts.size();
+        }
+
+        double observed_total = 0;
+        double rss = 0;
+        for (unsigned i = 0; i < rObserved.size(); i++)
+        {
+            observed_total += rObserved[i];
+            rss += (candidate[i] - rObserved[i]) * (candidate[i] - rObserved[i]);
+        }
+        double overflow = std::max(0.0, 1.0 - observed_total);
+        rss += (candidate[num_bins - 1] - overflow) * (candidate[num_bins - 1] - overflow);
+        return rss;
+    }
+
+    //Random lineage count, including 0 & counts beyond the observed histogram (the overflow bin)
+    unsigned RandomCount(unsigned numObserved)
+    {
+        return RandomNumberGenerator::Instance()->randMod(numObserved + 3);
+    }
+
+public:
+    void TestLowerBoundNeverExceedsCompletedRss()
+    {
+        RandomNumberGenerator* p_rng = RandomNumberGenerator::Instance();
+        p_rng->Reseed(0);
+
+        for (unsigned trial = 0; trial < 500; trial++)
+        {
+            //observed histogram of 1-6 counts, summing to at most 1
+            std::vector<double> observed(1 + p_rng->randMod(6));
+            double total = 0;
+            for (unsigned i = 0; i < observed.size(); i++)
+            {
+                observed[i] = p_rng->ranf();
+                total += observed[i];
+            }
+            double scale = (0.5 + 0.5 * p_rng->ranf()) / total;
+            for (unsigned i = 0; i < observed.size(); i++)
+            {
+                observed[i] *= scale;
+            }
+
+            unsigned num_lineages = 1 + p_rng->randMod(30);
+            unsigned num_added = p_rng->randMod(num_lineages + 1);
+
+            AbcHistogramDistance distance(observed, num_lineages);
+            std::vector<unsigned> partial;
+            for (unsigned i = 0; i < num_added; i++)
+            {
+                partial.push_back(RandomCount(observed.size()));
+                distance.AddLineage(partial.back());
+            }
+            TS_ASSERT_EQUALS(distance.GetNumAdded(), num_added);
+            double bound = distance.GetLowerBound();
+
+            //random completions, & the completions putting every remaining lineage in one bin
+            std::vector<std::vector<unsigned> > completions;
+            for (unsigned i = 0; i < 20; i++)
+            {
+                std::vector<unsigned> completion(partial);
+                while (completion.size() < num_lineages)
+                {
+                    completion.push_back(RandomCount(observed.size()));
+                }
+                completions.push_back(completion);
+            }
+            for (unsigned count = 0; count <= observed.size() + 1; count++)
+            {
+                std::vector<unsigned> completion(partial);
+                completion.resize(num_lineages, count);
+                completions.push_back(completion);
+            }
+
+            for (unsigned i = 0; i < completions.size(); i++)
+            {
+                TS_ASSERT_LESS_THAN_EQUALS(bound, GetRss(observed, completions[i]) + 1e-12);
+            }
+
+            //with all N lineages added the bound is the RSS
+            for (unsigned i = num_added; i < num_lineages; i++)
+            {
+                distance.AddLineage(completions[0][i]);
+            }
+            TS_ASSERT_DELTA(distance.GetLowerBound(), GetRss(observed, completions[0]), 1e-12);
+
+            //Reset() starts a new candidate
+            distance.Reset();
+            TS_ASSERT_EQUALS(distance.GetNumAdded(), 0u);
+        }
+
+        RandomNumberGenerator::Destroy();
+    }
+
+    void TestBoundRisesAsLineagesAreAdded()
+    {
+        //each lineage only removes placements of the remaining mass, so the bound never falls
+        std::vector<double> observed;
+        observed.push_back(0.5);
+        observed.push_back(0.3);
+        observed.push_back(0.2);
+        AbcHistogramDistance distance(observed, 10);
+
+        unsigned counts[10] = { 4, 4, 1, 7, 4, 0, 2, 4, 9, 4 };
+        double previous = distance.GetLowerBound();
+        TS_ASSERT_DELTA(previous, 0.0, 1e-12); //nothing added: the observed histogram itself is reachable
+        for (unsigned i = 0; i < 10; i++)
+        {
+            distance.AddLineage(counts[i]);
+            double bound = distance.GetLowerBound();
+            TS_ASSERT_LESS_THAN_EQUALS(previous, bound + 1e-12);
+            previous = bound;
+        }
+    }
+};
+
+#endif /*TESTABCHISTOGRAMDISTANCE_HPP_*/
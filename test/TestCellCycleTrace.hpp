@@ -0,0 +1,184 @@
+#ifndef TESTCELLCYCLETRACE_HPP_
+#define TESTCELLCYCLETRACE_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CellCycleTrace.hpp"
+#include "OutputFileHandler.hpp"
+
+class TestCellCycleTrace : public CxxTest::TestSuite
+{
+private:
+    std::string GetTracePath(const std::string& rDirectory, const std::string& rFilename)
+    {
+        OutputFileHandler handler(rDirectory, false);
+        return handler.GetOutputDirectoryFullPath() + rFilename;
+    }
+
+    //Record i of a seed: its time & two columns follow from the seed & i, so a read back record can be checked
+    CellCycleTraceRecord MakeRecord(unsigned seed, unsigned i)
+    {
+        CellCycleTraceRecord record(seed % 4, seed, 0.5 * i);
+        record.Put(0, seed);
+        record.Put(2 + seed % 3, i);
+        return record;
+    }
+
+    void RecordSeed(unsigned seed, unsigned first, unsigned numRecords)
+    {
+        for (unsigned i = first; i < first + numRecords; i++)
+        {
+            CellCycleTrace::Instance()->Record(MakeRecord(seed, i));
+        }
+    }
+
+    //The seed's records, read back from a closed trace, are records 0, 1, ... numRecords - 1
+    void CheckSeed(const std::string& rPath, const std::vector<CellCycleTraceIndexEntry>& rIndex, unsigned seed,
+                   unsigned numRecords)
+    {
+        std::vector<CellCycleTraceRecord> records;
+        TS_ASSERT(CellCycleTrace::ReadSeed(rPath, rIndex, seed, records));
+        TS_ASSERT_EQUALS(records.size(), numRecords);
+        for (unsigned i = 0; i < std::min<unsigned>(records.size(), numRecords); i++)
+        {
+            CellCycleTraceRecord expected = MakeRecord(seed, i);
+            TS_ASSERT_EQUALS(records[i].mSeed, seed);
+            TS_ASSERT_EQUALS(records[i].mModel, expected.mModel);
+            TS_ASSERT_EQUALS(records[i].mTime, expected.mTime);
+            TS_ASSERT_EQUALS(records[i].mSetMask, expected.mSetMask);
+            for (unsigned j = 0; j < 9; j++)
+            {
+                TS_ASSERT_EQUALS(records[i].mValues[j], expected.mValues[j]);
+            }
+        }
+    }
+
+public:
+    void TestSeedsSpanningFlushes()
+    {
+        const unsigned buffer = CellCycleTrace::BUFFER_RECORDS;
+        OutputFileHandler clean("TestCellCycleTrace/Flushes", true);
+        CellCycleTrace* p_trace = CellCycleTrace::Instance();
+        p_trace->Open("TestCellCycleTrace/Flushes", "trace.bin");
+        TS_ASSERT(p_trace->IsOpen());
+        TS_ASSERT_THROWS_THIS(p_trace->Open("TestCellCycleTrace/Flushes", "other.bin"),
+                              "CellCycleTrace is already open; Close() the current trace first");
+
+        //seed 3 is flushed once part way through, as the buffer fills, & again at EndSeed(); seed 21 spans two full
+        //flushes & is only flushed by Close(); either way each seed's records are one run, so one index entry
+        RecordSeed(3, 0, buffer + 100);
+        p_trace->EndSeed();
+        RecordSeed(8, 0, 10);
+        p_trace->EndSeed();
+        p_trace->EndSeed(); //nothing buffered: no empty entry
+        RecordSeed(21, 0, 2 * buffer + 7);
+        CellCycleTrace::Destroy();
+
+        std::string path = GetTracePath("TestCellCycleTrace/Flushes", "trace.bin");
+        std::vector<CellCycleTraceIndexEntry> index;
+        TS_ASSERT(CellCycleTrace::ReadIndex(path, index));
+        TS_ASSERT_EQUALS(index.size(), 3u);
+        if (index.size() == 3u)
+        {
+            TS_ASSERT_EQUALS(index[0].mSeed, 3u);
+            TS_ASSERT_EQUALS(index[0].mFirstRecord, 0u);
+            TS_ASSERT_EQUALS(index[0].mNumRecords, buffer + 100u);
+            TS_ASSERT_EQUALS(index[1].mSeed, 8u);
+            TS_ASSERT_EQUALS(index[1].mFirstRecord, buffer + 100u);
+            TS_ASSERT_EQUALS(index[1].mNumRecords, 10u);
+            TS_ASSERT_EQUALS(index[2].mSeed, 21u);
+            TS_ASSERT_EQUALS(index[2].mFirstRecord, buffer + 110u);
+            TS_ASSERT_EQUALS(index[2].mNumRecords, 2 * buffer + 7u);
+        }
+
+        CheckSeed(path, index, 3, buffer + 100);
+        CheckSeed(path, index, 8, 10);
+        CheckSeed(path, index, 21, 2 * buffer + 7);
+        CheckSeed(path, index, 5, 0); //never recorded
+    }
+
+    void TestInterleavedSeed()
+    {
+        //a seed recorded again after another seed's records has two runs, read back in order
+        OutputFileHandler clean("TestCellCycleTrace/Interleaved", true);
+        CellCycleTrace* p_trace = CellCycleTrace::Instance();
+        p_trace->Open("TestCellCycleTrace/Interleaved", "trace.bin");
+        RecordSeed(1, 0, 5);
+        RecordSeed(2, 0, 3);
+        RecordSeed(1, 5, 4);
+        p_trace->Close();
+        TS_ASSERT(!p_trace->IsOpen());
+
+        std::string path = GetTracePath("TestCellCycleTrace/Interleaved", "trace.bin");
+        std::vector<CellCycleTraceIndexEntry> index;
+        TS_ASSERT(CellCycleTrace::ReadIndex(path, index));
+        TS_ASSERT_EQUALS(index.size(), 3u);
+        CheckSeed(path, index, 1, 9);
+        CheckSeed(path, index, 2, 3);
+
+        //records made while closed are dropped
+        RecordSeed(4, 0, 2);
+        TS_ASSERT(CellCycleTrace::ReadIndex(path, index));
+        TS_ASSERT_EQUALS(index.size(), 3u);
+        CellCycleTrace::Destroy();
+    }
+
+    void TestEmptyTrace()
+    {
+        OutputFileHandler clean("TestCellCycleTrace/Empty", true);
+        CellCycleTrace::Instance()->Open("TestCellCycleTrace/Empty", "trace.bin");
+        CellCycleTrace::Destroy();
+
+        std::vector<CellCycleTraceIndexEntry> index(1);
+        TS_ASSERT(CellCycleTrace::ReadIndex(GetTracePath("TestCellCycleTrace/Empty", "trace.bin"), index));
+        TS_ASSERT(index.empty());
+    }
+
+    void TestIncompleteTracesAreRejected()
+    {
+        OutputFileHandler clean("TestCellCycleTrace/Incomplete", true);
+        std::string path = GetTracePath("TestCellCycleTrace/Incomplete", "trace.bin");
+        std::vector<CellCycleTraceIndexEntry> index;
+
+        //an unclosed trace, as left by a killed run, has records but no index or footer
+        CellCycleTrace* p_trace = CellCycleTrace::Instance();
+        p_trace->Open("TestCellCycleTrace/Incomplete", "trace.bin");
+        RecordSeed(6, 0, CellCycleTrace::BUFFER_RECORDS + 1);
+        p_trace->EndSeed();
+        TS_ASSERT(!CellCycleTrace::ReadIndex(path, index));
+        CellCycleTrace::Destroy();
+        TS_ASSERT(CellCycleTrace::ReadIndex(path, index));
+
+        //a closed trace cut short loses its footer's magic
+        std::string contents;
+        {
+            std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+            std::ostringstream buffer;
+            buffer << file.rdbuf();
+            contents = buffer.str();
+        }
+        std::string truncated_path = GetTracePath("TestCellCycleTrace/Incomplete", "truncated.bin");
+        {
+            std::ofstream file(truncated_path.c_str(), std::ios::out | std::ios::binary);
+            file.write(contents.data(), contents.size() - 1);
+        }
+        TS_ASSERT(!CellCycleTrace::ReadIndex(truncated_path, index));
+
+        //missing & non-trace files
+        TS_ASSERT(!CellCycleTrace::ReadIndex(GetTracePath("TestCellCycleTrace/Incomplete", "missing.bin"), index));
+        std::string text_path = GetTracePath("TestCellCycleTrace/Incomplete", "text.bin");
+        {
+            std::ofstream file(text_path.c_str());
+            file << "not a cell cycle trace, but long enough to have a footer\n";
+        }
+        TS_ASSERT(!CellCycleTrace::ReadIndex(text_path, index));
+    }
+};
+
+#endif /*TESTCELLCYCLETRACE_HPP_*/
@@ -0,0 +1,120 @@
+#ifndef TESTLINEAGEBATCH_HPP_
+#define TESTLINEAGEBATCH_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "AbstractCellBasedTestSuite.hpp"
+#include "LineageBatch.hpp"
+#include "ModelLineage.hpp"
+
+class TestLineageBatch : public AbstractCellBasedTestSuite
+{
+private:
+    //seeds simulated each way per model
+    static const unsigned NUM_SEEDS = 300;
+
+    double GetMean(const std::vector<double>& rCounts)
+    {
+        double sum = 0;
+        for (unsigned i = 0; i < rCounts.size(); i++)
+        {
+            sum += rCounts[i];
+        }
+        return sum / rCounts.size();
+    }
+
+    double GetVariance(const std::vector<double>& rCounts)
+    {
+        double mean = GetMean(rCounts);
+        double sum = 0;
+        for (unsigned i = 0; i < rCounts.size(); i++)
+        {
+            sum += (rCounts[i] - mean) * (rCounts[i] - mean);
+        }
+        return sum / (rCounts.size() - 1);
+    }
+
+    //Two-sample Kolmogorov-Smirnov statistic: the largest gap between the samples' empirical distribution functions
+    double GetKolmogorovSmirnov(std::vector<double> a, std::vector<double> b)
+    {
+        std::sort(a.begin(), a.end());
+        std::sort(b.begin(), b.end());
+        double statistic = 0;
+        unsigned i = 0, j = 0;
+        while (i < a.size() && j < b.size())
+        {
+            double value = std::min(a[i], b[j]);
+            while (i < a.size() && a[i] == value) i++;
+            while (j < b.size() && b[j] == value) j++;
+            statistic = std::max(statistic, std::fabs(double(i) / a.size() - double(j) / b.size()));
+        }
+        return statistic;
+    }
+
+    /**
+     * End counts of seeds 0 to NUM_SEEDS - 1 through ModelLineage & through one LineageBatch, compared at fixed
+     * tolerances: the KS statistic below its 0.1% critical value, 1.95 sqrt(2 / NUM_SEEDS) (conservative for
+     * counts, which are discrete), & the means within 4 standard errors of their difference
+     */
+    void CompareCountDistributions(const std::string& rModel, const std::vector<double>& rTheta)
+    {
+        std::vector<double> lineage_counts, batch_counts;
+        LineageBatch batch(rModel);
+        for (unsigned seed = 0; seed < NUM_SEEDS; seed++)
+        {
+            lineage_counts.push_back(ModelLineage::Simulate(rModel, rTheta, seed)[0]);
+            TS_ASSERT_EQUALS(batch.AddLineage(rTheta, seed), seed);
+        }
+        batch.Run();
+        TS_ASSERT_EQUALS(batch.GetNumLineages(), NUM_SEEDS);
+        for (unsigned seed = 0; seed < NUM_SEEDS; seed++)
+        {
+            batch_counts.push_back(batch.GetCount(seed));
+        }
+
+        //the counts must vary, or neither comparison tests anything
+        TS_ASSERT_LESS_THAN(0.0, GetVariance(lineage_counts));
+
+        TS_ASSERT_LESS_THAN(GetKolmogorovSmirnov(lineage_counts, batch_counts), 1.95 * sqrt(2.0 / NUM_SEEDS));
+        double standard_error = sqrt((GetVariance(lineage_counts) + GetVariance(batch_counts)) / NUM_SEEDS);
+        TS_ASSERT_DELTA(GetMean(batch_counts), GetMean(lineage_counts), 4 * standard_error);
+    }
+
+public:
+    void TestHeCountsMatchModelLineage()
+    {
+        //He 2012 fit, lineages starting 23-39hpf & counted at 72hpf
+        CompareCountDistributions("He", { 24, 23, 39, 72, 8, 15, 1, 0, .2, .4, .2, 0 });
+    }
+
+    void TestGomesCountsMatchModelLineage()
+    {
+        //GomesCellCycleModel defaults, over a few cycles
+        CompareCountDistributions("Gomes", { 240, 3.9716, .32839, .055, .221, .128, .106, .028 });
+    }
+
+    void TestBoijeCountsMatchModelLineage()
+    {
+        //BoijeCellCycleModel defaults
+        CompareCountDistributions("Boije", { 10, 3, 5, .32, .30, .80 });
+    }
+
+    void TestLineagesAreAddedBeforeRun()
+    {
+        LineageBatch batch("Gomes");
+        TS_ASSERT_THROWS_THIS(batch.AddLineage({ 240, 3.9716, .32839 }, 0),
+                              "LineageBatch::AddLineage needs one parameter per Gomes parameter name");
+        batch.AddLineage({ 240, 3.9716, .32839, .055, .221, .128, .106, .028 }, 0);
+        batch.Run();
+        TS_ASSERT_THROWS_THIS(batch.AddLineage({ 240, 3.9716, .32839, .055, .221, .128, .106, .028 }, 1),
+                              "LineageBatch lineages must all be added before Run()");
+        TS_ASSERT_THROWS_THIS(LineageBatch("Wan"), "LineageBatch runs He, Gomes or Boije lineages, not Wan");
+    }
+};
+
+#endif /*TESTLINEAGEBATCH_HPP_*/
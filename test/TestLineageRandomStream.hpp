@@ -0,0 +1,158 @@
+#ifndef TESTLINEAGERANDOMSTREAM_HPP_
+#define TESTLINEAGERANDOMSTREAM_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <vector>
+
+#include "AbstractCellBasedTestSuite.hpp"
+#include "LineageRandomStream.hpp"
+#include "OffLatticeSimulationPropertyStop.hpp"
+#include "SimulationTime.hpp"
+#include "RandomNumberGenerator.hpp"
+#include "CellId.hpp"
+#include "SmartPointers.hpp"
+#include "CellPropertyRegistry.hpp"
+#include "WildTypeCellMutationState.hpp"
+#include "TransitCellProliferativeType.hpp"
+#include "NoCellCycleModel.hpp"
+#include "HoneycombMeshGenerator.hpp"
+#include "NodesOnlyMesh.hpp"
+#include "NodeBasedCellPopulation.hpp"
+
+class TestLineageRandomStream : public AbstractCellBasedTestSuite
+{
+private:
+    //One draw of each kind, in a fixed order
+    std::vector<double> Draw(const LineageRandomStream& rStream)
+    {
+        return { rStream.ranf(), double(rStream.randMod(7)), rStream.NormalRandomDeviate(1.0, 2.0),
+                 rStream.GammaRandomDeviate(2.0, 1.0) };
+    }
+
+    /**
+     * Eight transit cells that never divide, with one induction before the start of Solve(); the singleton is reseeded
+     * with singletonSeed first. Returns the index of the labelled cell, or 8 if none was.
+     */
+    unsigned InduceOneClone(const LineageRandomStream& rStream, unsigned singletonSeed)
+    {
+        SimulationTime::Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+        CellId::ResetMaxCellId();
+        RandomNumberGenerator::Instance()->Reseed(singletonSeed);
+
+        boost::shared_ptr<AbstractCellProperty> p_state(CellPropertyRegistry::Instance()->Get<WildTypeCellMutationState>());
+        MAKE_PTR(TransitCellProliferativeType, p_Mitotic);
+        std::vector<CellPtr> cells;
+        for (unsigned i = 0; i < 8; i++)
+        {
+            CellPtr p_cell(new Cell(p_state, new NoCellCycleModel));
+            p_cell->SetCellProliferativeType(p_Mitotic);
+            cells.push_back(p_cell);
+        }
+
+        HoneycombMeshGenerator generator(4, 2);
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(*generator.GetMesh(), 1.5);
+        NodeBasedCellPopulation<2> cell_population(mesh, cells);
+
+        OffLatticeSimulationPropertyStop<2> simulator(cell_population);
+        simulator.SetStopProperty(p_Mitotic);
+        simulator.SetDt(0.05);
+        simulator.SetEndTime(0.1);
+        simulator.DisableSimulationOutput();
+        simulator.SetInductionTimes(std::vector<double>(1, -1.0), p_Mitotic);
+        simulator.SetRandomStream(rStream);
+        simulator.Solve();
+
+        std::vector<unsigned> clone_sizes = simulator.CountClones();
+        TS_ASSERT_EQUALS(clone_sizes.size(), 1u);
+        TS_ASSERT_EQUALS(clone_sizes[0], 1u);
+
+        unsigned labelled = 8;
+        for (unsigned i = 0; i < cells.size(); i++)
+        {
+            if (cells[i]->GetAncestor() == 1u) labelled = i;
+        }
+        SimulationTime::Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+        return labelled;
+    }
+
+public:
+    void TestUnseededStreamForwardsToSingleton()
+    {
+        LineageRandomStream stream;
+        TS_ASSERT(!stream.IsSeeded());
+
+        RandomNumberGenerator::Instance()->Reseed(3);
+        std::vector<double> expected = { RandomNumberGenerator::Instance()->ranf(),
+                                         double(RandomNumberGenerator::Instance()->randMod(7)),
+                                         RandomNumberGenerator::Instance()->NormalRandomDeviate(1.0, 2.0),
+                                         RandomNumberGenerator::Instance()->GammaRandomDeviate(2.0, 1.0) };
+        RandomNumberGenerator::Instance()->Reseed(3);
+        std::vector<double> actual = Draw(stream);
+        for (unsigned i = 0; i < expected.size(); i++)
+        {
+            TS_ASSERT_EQUALS(actual[i], expected[i]);
+        }
+    }
+
+    void TestSeededStreamIgnoresSingleton()
+    {
+        LineageRandomStream first;
+        first.Seed(7);
+        TS_ASSERT(first.IsSeeded());
+        RandomNumberGenerator::Instance()->Reseed(1);
+        std::vector<double> first_draws = Draw(first);
+        std::vector<double> first_next = Draw(first);
+
+        //the same seed gives the same draws, whatever the singleton has drawn in between
+        LineageRandomStream second;
+        second.Seed(7);
+        RandomNumberGenerator::Instance()->Reseed(2);
+        RandomNumberGenerator::Instance()->ranf();
+        std::vector<double> second_draws = Draw(second);
+        for (unsigned i = 0; i < first_draws.size(); i++)
+        {
+            TS_ASSERT_EQUALS(second_draws[i], first_draws[i]);
+        }
+
+        //copies share the generator, so a copy continues the sequence
+        LineageRandomStream copy(second);
+        std::vector<double> copy_draws = Draw(copy);
+        for (unsigned i = 0; i < first_next.size(); i++)
+        {
+            TS_ASSERT_EQUALS(copy_draws[i], first_next[i]);
+        }
+
+        for (unsigned i = 0; i < 1000; i++)
+        {
+            TS_ASSERT_LESS_THAN(first.randMod(5), 5u);
+            double u = first.ranf();
+            TS_ASSERT_LESS_THAN_EQUALS(0.0, u);
+            TS_ASSERT_LESS_THAN(u, 1.0);
+        }
+    }
+
+    void TestInductionDrawsFromStream()
+    {
+        //a seeded stream picks the same cell whatever the singleton's seed: its first randMod(8)
+        LineageRandomStream reference;
+        reference.Seed(11);
+        unsigned expected = reference.randMod(8);
+        for (unsigned singleton_seed = 0; singleton_seed < 5; singleton_seed++)
+        {
+            LineageRandomStream stream;
+            stream.Seed(11);
+            TS_ASSERT_EQUALS(InduceOneClone(stream, singleton_seed), expected);
+        }
+
+        //unset, the pick is the singleton's, as before streams
+        RandomNumberGenerator::Instance()->Reseed(4);
+        unsigned singleton_pick = RandomNumberGenerator::Instance()->randMod(8);
+        TS_ASSERT_EQUALS(InduceOneClone(LineageRandomStream(), 4), singleton_pick);
+    }
+};
+
+#endif /*TESTLINEAGERANDOMSTREAM_HPP_*/
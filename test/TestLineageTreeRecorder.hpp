@@ -0,0 +1,298 @@
+#ifndef TESTLINEAGETREERECORDER_HPP_
+#define TESTLINEAGETREERECORDER_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <cmath>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "AbstractCellBasedTestSuite.hpp"
+#include "LineageTreeRecorder.hpp"
+#include "OutputFileHandler.hpp"
+#include "SimulationTime.hpp"
+#include "RandomNumberGenerator.hpp"
+#include "CellId.hpp"
+#include "SmartPointers.hpp"
+#include "CellPropertyRegistry.hpp"
+#include "WildTypeCellMutationState.hpp"
+#include "NoCellCycleModel.hpp"
+#include "HoneycombMeshGenerator.hpp"
+#include "NodesOnlyMesh.hpp"
+#include "NodeBasedCellPopulation.hpp"
+#include "GomesRetinalNeuralFates.hpp"
+
+class TestLineageTreeRecorder : public AbstractCellBasedTestSuite
+{
+private:
+    std::string GetArchivePath(const std::string& rDirectory, const std::string& rFilename)
+    {
+        OutputFileHandler handler(rDirectory, false);
+        return handler.GetOutputDirectoryFullPath() + rFilename;
+    }
+
+    void CompareDivisions(const LineageTree& rExpected, const LineageTree& rActual)
+    {
+        TS_ASSERT_EQUALS(rActual.mDivisions.size(), rExpected.mDivisions.size());
+        for (unsigned i = 0; i < std::min(rActual.mDivisions.size(), rExpected.mDivisions.size()); i++)
+        {
+            TS_ASSERT_EQUALS(rActual.mDivisions[i].mParentId, rExpected.mDivisions[i].mParentId);
+            TS_ASSERT_EQUALS(rActual.mDivisions[i].mDaughterId, rExpected.mDivisions[i].mDaughterId);
+            TS_ASSERT_EQUALS(rActual.mDivisions[i].mTimeStep, rExpected.mDivisions[i].mTimeStep);
+            TS_ASSERT_EQUALS(rActual.mDivisions[i].mMode, rExpected.mDivisions[i].mMode);
+        }
+    }
+
+public:
+    void TestSmallLineageRoundTrip()
+    {
+        /*
+         * Founder 0 divides PP (daughter 1) at step 2 & DD (daughter 3) at step 5; cell 1 divides PD (daughter 2) at
+         * step 4 & DD (daughter 4) at step 7. Daughter 2 is killed at once, as an unlabelled cell under --path-only;
+         * the others are alive at the end. Times are hpf from 10hpf, at dt 0.5.
+         */
+        struct Event
+        {
+            unsigned mStep, mParent, mDaughter, mMode;
+            bool mKilled;
+        };
+        std::vector<Event> events = { { 2, 0, 1, 0, false }, { 4, 1, 2, 1, true }, { 5, 0, 3, 2, false },
+                                      { 7, 1, 4, 2, false } };
+        const unsigned num_steps = 10;
+
+        OutputFileHandler clean("TestLineageTreeRecorder/Small", true);
+        LineageTreeRecorder* p_recorder = LineageTreeRecorder::Instance();
+        p_recorder->Open("TestLineageTreeRecorder/Small", "small.ltree");
+        TS_ASSERT(p_recorder->IsOpen());
+        TS_ASSERT_THROWS_THIS(p_recorder->Open("TestLineageTreeRecorder/Small", "other.ltree"),
+                              "LineageTreeRecorder is already open; Close() the current archive first");
+
+        //the cells, made in ID order; the killed daughter is left out of the final population
+        CellId::ResetMaxCellId();
+        boost::shared_ptr<AbstractCellProperty> p_state(CellPropertyRegistry::Instance()->Get<WildTypeCellMutationState>());
+        MAKE_PTR(RodPhotoreceptor, p_RPh_fate);
+        MAKE_PTR(AmacrineCell, p_AC_fate);
+        std::vector<CellPtr> all_cells, final_cells;
+        for (unsigned id = 0; id < 5; id++)
+        {
+            CellPtr p_cell(new Cell(p_state, new NoCellCycleModel));
+            TS_ASSERT_EQUALS(p_cell->GetCellId(), id);
+            all_cells.push_back(p_cell);
+            if (id != 2) final_cells.push_back(p_cell);
+        }
+        all_cells[1]->AddCellProperty(p_RPh_fate);
+        all_cells[3]->AddCellProperty(p_AC_fate);
+        all_cells[4]->AddCellProperty(p_RPh_fate);
+
+        //seeds 5 & 6 are recorded together; seed 6's founder never divides
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(5.0, num_steps);
+        p_recorder->BeginSeed(5, 0, 10.0, 0.5);
+        p_recorder->BeginSeed(6, 100, 10.0, 0.5);
+
+        //the live count at each step, kept alongside the recording
+        std::set<unsigned> live = { 0 };
+        std::vector<unsigned> live_counts(1, 1);
+        for (unsigned step = 1; step <= num_steps; step++)
+        {
+            SimulationTime::Instance()->IncrementTimeOneStep();
+            for (unsigned i = 0; i < events.size(); i++)
+            {
+                if (events[i].mStep != step) continue;
+                p_recorder->RecordDivision(5, events[i].mParent, events[i].mDaughter, events[i].mMode);
+                if (!events[i].mKilled) live.insert(events[i].mDaughter);
+            }
+            live_counts.push_back(live.size());
+        }
+
+        HoneycombMeshGenerator generator(2, 2);
+        NodesOnlyMesh<2> mesh;
+        mesh.ConstructNodesWithoutMesh(*generator.GetMesh(), 1.5);
+        NodeBasedCellPopulation<2> cell_population(mesh, final_cells);
+        std::vector<boost::shared_ptr<AbstractCellProperty> > fates = { p_RPh_fate, p_AC_fate };
+        p_recorder->RecordFinalCells(5, cell_population, fates);
+
+        //committed out of order; seed 7 was never begun, so commits nothing
+        p_recorder->CommitSeed(6);
+        p_recorder->CommitSeed(7);
+        p_recorder->CommitSeed(5);
+        LineageTreeRecorder::Destroy();
+
+        std::string path = GetArchivePath("TestLineageTreeRecorder/Small", "small.ltree");
+        std::vector<LineageTree> trees;
+        TS_ASSERT(LineageTreeRecorder::ReadArchive(path, trees));
+        TS_ASSERT_EQUALS(trees.size(), 2u);
+        TS_ASSERT_EQUALS(trees[0].mSeed, 6u);
+        TS_ASSERT_EQUALS(trees[0].mFounderId, 100u);
+        TS_ASSERT(trees[0].mDivisions.empty());
+        TS_ASSERT(trees[0].mFinalFates.empty());
+
+        LineageTree tree;
+        TS_ASSERT(!LineageTreeRecorder::ReadSeed(path, 7, tree));
+        TS_ASSERT(LineageTreeRecorder::ReadSeed(path, 5, tree));
+        TS_ASSERT_EQUALS(tree.mSeed, 5u);
+        TS_ASSERT_EQUALS(tree.mFounderId, 0u);
+        TS_ASSERT_EQUALS(tree.mStartTime, 10.0);
+        TS_ASSERT_EQUALS(tree.mDt, 0.5);
+
+        LineageTree expected;
+        for (unsigned i = 0; i < events.size(); i++)
+        {
+            LineageTreeDivision division = { events[i].mParent, events[i].mDaughter, events[i].mStep, events[i].mMode };
+            expected.mDivisions.push_back(division);
+        }
+        CompareDivisions(expected, tree);
+        TS_ASSERT_DELTA(tree.GetDivisionTime(2), 12.5, 1e-12);
+
+        std::map<unsigned, unsigned> expected_fates = { { 0, 0 }, { 1, 1 }, { 3, 2 }, { 4, 1 } };
+        TS_ASSERT(tree.mFinalFates == expected_fates);
+
+        //one mode sequence per cell, the killed daughter's included, each with the sampler's probability of following it
+        std::vector<unsigned> leaf_ids;
+        std::vector<std::string> sequences;
+        std::vector<double> weights;
+        tree.GetModeSequences(leaf_ids, sequences, weights);
+        std::map<unsigned, std::string> expected_sequences = { { 0, "02" }, { 1, "012" }, { 2, "01" }, { 3, "02" },
+                                                               { 4, "012" } };
+        TS_ASSERT_EQUALS(leaf_ids.size(), expected_sequences.size());
+        double total_weight = 0;
+        for (unsigned i = 0; i < leaf_ids.size(); i++)
+        {
+            TS_ASSERT_EQUALS(sequences[i], expected_sequences[leaf_ids[i]]);
+            TS_ASSERT_DELTA(weights[i], pow(0.5, sequences[i].size()), 1e-12);
+            total_weight += weights[i];
+        }
+        TS_ASSERT_DELTA(total_weight, 1.0, 1e-12);
+
+        //clone size at every step's time, & between steps (to the nearest step), against the live count
+        TS_ASSERT_EQUALS(tree.GetCloneSize(9.0), 0u);
+        for (unsigned step = 0; step <= num_steps; step++)
+        {
+            TS_ASSERT_EQUALS(tree.GetCloneSize(10.0 + 0.5 * step), live_counts[step]);
+            TS_ASSERT_EQUALS(tree.GetCloneSize(10.0 + 0.5 * step + 0.2), live_counts[step]);
+        }
+        TS_ASSERT_EQUALS(live_counts[num_steps], 4u);
+    }
+
+    void TestModeSequenceWeightsSumToOne()
+    {
+        //random trees: each division picks a live cell & a mode; every cell is a leaf, & the leaf weights sum to 1
+        RandomNumberGenerator* p_rng = RandomNumberGenerator::Instance();
+        p_rng->Reseed(3);
+        for (unsigned trial = 0; trial < 50; trial++)
+        {
+            LineageTree tree;
+            tree.mFounderId = 10;
+            tree.mDt = 1.0;
+            std::vector<unsigned> cells(1, tree.mFounderId);
+            unsigned num_divisions = p_rng->randMod(40);
+            for (unsigned i = 0; i < num_divisions; i++)
+            {
+                LineageTreeDivision division;
+                division.mParentId = cells[p_rng->randMod(cells.size())];
+                division.mDaughterId = tree.mFounderId + 1 + i;
+                division.mTimeStep = i + 1;
+                division.mMode = p_rng->randMod(3);
+                tree.mDivisions.push_back(division);
+                cells.push_back(division.mDaughterId);
+            }
+
+            std::vector<unsigned> leaf_ids;
+            std::vector<std::string> sequences;
+            std::vector<double> weights;
+            tree.GetModeSequences(leaf_ids, sequences, weights);
+            TS_ASSERT_EQUALS(leaf_ids.size(), num_divisions + 1);
+            TS_ASSERT_EQUALS(std::set<unsigned>(leaf_ids.begin(), leaf_ids.end()).size(), num_divisions + 1);
+            double total_weight = 0;
+            for (unsigned i = 0; i < weights.size(); i++)
+            {
+                total_weight += weights[i];
+            }
+            TS_ASSERT_DELTA(total_weight, 1.0, 1e-12);
+        }
+    }
+
+    void TestVarintsRoundTrip()
+    {
+        /*
+         * Seeds, founder IDs, parent deltas & (daughter ID delta << 2 | mode) are LEB128 varints. The seeds & shifted
+         * daughter deltas land just below & at 2^7 & 2^14, where a varint gains a byte, & the shifted daughter deltas
+         * just below & above 2^32, where they no longer fit an unsigned
+         */
+        std::vector<unsigned> seeds = { 0, 127, 128, 16383, 16384, 4294967295u };
+        std::vector<unsigned> daughter_deltas = { 31, 32, 4095, 4096, (1u << 30) - 1, 1u << 30 };
+        std::vector<unsigned> modes = { 2, 0, 2, 0, 2, 1 };
+
+        OutputFileHandler clean("TestLineageTreeRecorder/Varints", true);
+        LineageTreeRecorder* p_recorder = LineageTreeRecorder::Instance();
+        p_recorder->Open("TestLineageTreeRecorder/Varints", "varints.ltree");
+        SimulationTime::Instance()->SetEndTimeAndNumberOfTimeSteps(10.0, 10);
+
+        std::vector<LineageTree> expected(seeds.size());
+        for (unsigned s = 0; s < seeds.size(); s++)
+        {
+            expected[s].mSeed = seeds[s];
+            expected[s].mFounderId = 127 + seeds[s] / 4;
+            p_recorder->BeginSeed(seeds[s], expected[s].mFounderId, -1.5, 0.05);
+        }
+        for (unsigned i = 0; i < daughter_deltas.size(); i++)
+        {
+            SimulationTime::Instance()->IncrementTimeOneStep();
+            for (unsigned s = 0; s < seeds.size(); s++)
+            {
+                //each daughter divides next, so the parent deltas are as large as the daughter IDs
+                LineageTree& r_tree = expected[s];
+                LineageTreeDivision division;
+                division.mParentId = r_tree.mDivisions.empty() ? r_tree.mFounderId : r_tree.mDivisions.back().mDaughterId;
+                division.mDaughterId = (r_tree.mDivisions.empty() ? r_tree.mFounderId : r_tree.mDivisions.back().mDaughterId)
+                        + daughter_deltas[i];
+                division.mTimeStep = i + 1;
+                division.mMode = modes[i];
+                r_tree.mDivisions.push_back(division);
+                p_recorder->RecordDivision(seeds[s], division.mParentId, division.mDaughterId, division.mMode);
+            }
+        }
+        for (unsigned s = 0; s < seeds.size(); s++)
+        {
+            p_recorder->CommitSeed(seeds[s]);
+        }
+        LineageTreeRecorder::Destroy();
+
+        std::vector<LineageTree> trees;
+        TS_ASSERT(LineageTreeRecorder::ReadArchive(GetArchivePath("TestLineageTreeRecorder/Varints", "varints.ltree"),
+                                                   trees));
+        TS_ASSERT_EQUALS(trees.size(), seeds.size());
+        for (unsigned s = 0; s < std::min(trees.size(), seeds.size()); s++)
+        {
+            TS_ASSERT_EQUALS(trees[s].mSeed, expected[s].mSeed);
+            TS_ASSERT_EQUALS(trees[s].mFounderId, expected[s].mFounderId);
+            TS_ASSERT_EQUALS(trees[s].mStartTime, -1.5);
+            TS_ASSERT_EQUALS(trees[s].mDt, 0.05);
+            CompareDivisions(expected[s], trees[s]);
+        }
+
+        //the largest seed is found by ReadSeed's seed-only decode
+        LineageTree tree;
+        TS_ASSERT(LineageTreeRecorder::ReadSeed(GetArchivePath("TestLineageTreeRecorder/Varints", "varints.ltree"),
+                                                4294967295u, tree));
+        CompareDivisions(expected.back(), tree);
+    }
+
+    void TestNotAnArchive()
+    {
+        OutputFileHandler handler("TestLineageTreeRecorder/NotAnArchive", true);
+        out_stream p_file = handler.OpenOutputFile("counts.txt");
+        *p_file << "1\t2\t3\n";
+        p_file->close();
+
+        std::vector<LineageTree> trees;
+        LineageTree tree;
+        std::string path = GetArchivePath("TestLineageTreeRecorder/NotAnArchive", "counts.txt");
+        TS_ASSERT(!LineageTreeRecorder::ReadArchive(path, trees));
+        TS_ASSERT(!LineageTreeRecorder::ReadSeed(path, 0, tree));
+        TS_ASSERT(!LineageTreeRecorder::ReadArchive(path + ".missing", trees));
+    }
+};
+
+#endif /*TESTLINEAGETREERECORDER_HPP_*/
@@ -0,0 +1,176 @@
+#ifndef TESTRESULTCACHE_HPP_
+#define TESTRESULTCACHE_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <cstdio>
+#include <climits>
+
+#include "OutputFileHandler.hpp"
+#include "FileFinder.hpp"
+#include "LineageOutput.hpp"
+#include "ResultCache.hpp"
+#include "SimulatorRunFixture.hpp"
+
+class TestResultCache : public CxxTest::TestSuite
+{
+private:
+    std::string Key(const std::string& rJobDescription)
+    {
+        char key[17];
+        snprintf(key, sizeof(key), "%016llx", (unsigned long long)ResultCache::Hash(rJobDescription));
+        return key;
+    }
+
+    bool BlockExists(const std::string& rCacheDirectory, const std::string& rJob, unsigned block)
+    {
+        std::string job_description = SimulatorRunFixture::GetJobDescription(rJob, "--cache " + rCacheDirectory);
+        std::string filename = Key(job_description) + "_" + std::to_string(block) + ".block";
+        return FileFinder(SimulatorRunFixture::FilePath(rCacheDirectory, filename), RelativeTo::Absolute).Exists();
+    }
+
+    //Seeds [startSeed, endSeed] through SimulatorRun with the cache; returns the number simulated, not replayed
+    unsigned Run(const std::string& rDirectory, const std::string& rCacheDirectory, const std::string& rJob,
+                 unsigned startSeed, unsigned endSeed, std::string* pForwarded = NULL)
+    {
+        return SimulatorRunFixture::Run(rDirectory, rJob, "--cache " + rCacheDirectory, startSeed, endSeed, UINT_MAX, pForwarded);
+    }
+
+public:
+    void TestJobDescription()
+    {
+        //directory, filename & seeds (argv 1, 2, 4 & 5) are not part of the job; decimals are compared by value
+        const char* args_a[] = { "/bin/HeSimulator", "dirA", "fileA", "0", "1", "50", "0.2", "--cache", "c", "--serial" };
+        const char* args_b[] = { "HeSimulator", "dirB", "fileB", "0", "51", "100", "0.20" };
+        const char* args_c[] = { "HeSimulator", "dirB", "fileB", "01", "51", "100", "0.20" };
+        std::vector<int> skipped;
+        skipped.push_back(1);
+        skipped.push_back(2);
+        skipped.push_back(4);
+        skipped.push_back(5);
+
+        std::string job_a = ResultCache::MakeJobDescription(10, const_cast<char**>(args_a), skipped);
+        std::string job_b = ResultCache::MakeJobDescription(7, const_cast<char**>(args_b), skipped);
+        std::string job_c = ResultCache::MakeJobDescription(7, const_cast<char**>(args_c), skipped);
+        TS_ASSERT_EQUALS(job_a, job_b);
+        TS_ASSERT_DIFFERS(job_a, job_c); //outputMode "01" is not the number 1
+        TS_ASSERT_EQUALS(ResultCache::Hash(job_a), ResultCache::Hash(job_b));
+        TS_ASSERT_DIFFERS(ResultCache::Hash(job_a), ResultCache::Hash(job_c));
+    }
+
+    void TestHitAndMiss()
+    {
+        OutputFileHandler clean("TestResultCache/HitAndMiss", true);
+
+        TS_ASSERT_EQUALS(Run("TestResultCache/HitAndMiss/First", "TestResultCache/HitAndMiss/Cache", "1", 0, 49), 50u);
+        TS_ASSERT(BlockExists("TestResultCache/HitAndMiss/Cache", "1", 0));
+
+        //the same job replays every seed of the block; another job replays none
+        TS_ASSERT_EQUALS(Run("TestResultCache/HitAndMiss/Second", "TestResultCache/HitAndMiss/Cache", "1", 0, 49), 0u);
+        TS_ASSERT_EQUALS(Run("TestResultCache/HitAndMiss/Other", "TestResultCache/HitAndMiss/Cache", "2", 0, 49), 50u);
+
+        //a range partly overlapping the cached block replays only the seeds in it
+        TS_ASSERT_EQUALS(Run("TestResultCache/HitAndMiss/Overlap", "TestResultCache/HitAndMiss/Cache", "1", 40, 59), 10u);
+    }
+
+    void TestCollisionGuard()
+    {
+        OutputFileHandler clean("TestResultCache/Collision", true);
+
+        //another job's description under this job's key: the run must not use or fill the cache
+        std::string job_description = SimulatorRunFixture::GetJobDescription("1", "--cache TestResultCache/Collision");
+        out_stream p_job = clean.OpenOutputFile(Key(job_description) + ".job");
+        *p_job << "a different job";
+        p_job->close();
+
+        ResultCache cache;
+        cache.Open("TestResultCache/Collision", job_description);
+        TS_ASSERT(!cache.IsEnabled());
+
+        TS_ASSERT_EQUALS(Run("TestResultCache/Collision/Run", "TestResultCache/Collision", "1", 0, 49), 50u);
+        TS_ASSERT(!BlockExists("TestResultCache/Collision", "1", 0));
+        TS_ASSERT_EQUALS(Run("TestResultCache/Collision/Again", "TestResultCache/Collision", "1", 0, 49), 50u);
+    }
+
+    void TestPartialBlockIsNotWritten()
+    {
+        OutputFileHandler clean("TestResultCache/Partial", true);
+
+        //seeds 0-29 & 50-99: block 0 is incomplete, block 1 complete
+        Run("TestResultCache/Partial/Low", "TestResultCache/Partial/Cache", "1", 0, 29);
+        Run("TestResultCache/Partial/High", "TestResultCache/Partial/Cache", "1", 50, 99);
+        TS_ASSERT(!BlockExists("TestResultCache/Partial/Cache", "1", 0));
+        TS_ASSERT(BlockExists("TestResultCache/Partial/Cache", "1", 1));
+
+        TS_ASSERT_EQUALS(Run("TestResultCache/Partial/Again", "TestResultCache/Partial/Cache", "1", 0, 99), 50u);
+    }
+
+    void TestPartialFinalBlockIsNotWritten()
+    {
+        OutputFileHandler clean("TestResultCache/Final", true);
+
+        //seeds 0-74: the run ends with 25 seeds of block 1 pending, which are dropped, not written as a short block
+        TS_ASSERT_EQUALS(Run("TestResultCache/Final/First", "TestResultCache/Final/Cache", "1", 0, 74), 75u);
+        TS_ASSERT(BlockExists("TestResultCache/Final/Cache", "1", 0));
+        TS_ASSERT(!BlockExists("TestResultCache/Final/Cache", "1", 1));
+
+        //a longer range simulates all of block 1 & fills it; after that nothing is simulated
+        TS_ASSERT_EQUALS(Run("TestResultCache/Final/Longer", "TestResultCache/Final/Cache", "1", 0, 99), 50u);
+        TS_ASSERT(BlockExists("TestResultCache/Final/Cache", "1", 1));
+        TS_ASSERT_EQUALS(Run("TestResultCache/Final/Again", "TestResultCache/Final/Cache", "1", 0, 99), 0u);
+    }
+
+    void TestReplayMatchesFreshOutput()
+    {
+        OutputFileHandler clean("TestResultCache/Replay", true);
+
+        //fill blocks 0 & 1, then replay them from another start seed, so other entry numbers, against an uncached run
+        Run("TestResultCache/Replay/Fill", "TestResultCache/Replay/Cache", "1", 0, 99);
+        TS_ASSERT_EQUALS(Run("TestResultCache/Replay/Replayed", "TestResultCache/Replay/Cache", "1", 20, 119), 20u);
+        SimulatorRunFixture::Run("TestResultCache/Replay/Fresh", "1", "", 20, 119);
+
+        for (std::string file : { "runCounts", "runEvents" })
+        {
+            std::string fresh = SimulatorRunFixture::ReadFile("TestResultCache/Replay/Fresh", file);
+            TS_ASSERT(!fresh.empty());
+            TS_ASSERT_EQUALS(SimulatorRunFixture::ReadFile("TestResultCache/Replay/Replayed", file), fresh);
+        }
+    }
+
+    void TestReplayIsForwarded()
+    {
+        OutputFileHandler clean("TestResultCache/ReplayForwarded", true);
+
+        //replayed seeds are committed through LineageOutput, so a worker rank forwards them as it forwards simulated seeds
+        Run("TestResultCache/ReplayForwarded/Fill", "TestResultCache/ReplayForwarded/Cache", "1", 0, 49);
+        std::string replayed, fresh;
+        TS_ASSERT_EQUALS(Run("TestResultCache/ReplayForwarded/Replayed", "TestResultCache/ReplayForwarded/Cache", "1", 10, 59,
+                             &replayed), 10u);
+        SimulatorRunFixture::Run("TestResultCache/ReplayForwarded/Fresh", "1", "", 10, 59, UINT_MAX, &fresh);
+        TS_ASSERT(!fresh.empty());
+        TS_ASSERT_EQUALS(replayed, fresh);
+    }
+
+    void TestForwardedSeedsAreStored()
+    {
+        OutputFileHandler clean("TestResultCache/Forwarded", true);
+
+        //a worker rank's run through SimulatorRun: its seeds are forwarded, not written, & still fill the cache
+        std::string forwarded;
+        TS_ASSERT_EQUALS(Run("TestResultCache/Forwarded/Worker", "TestResultCache/Forwarded/Cache", "1", 0, 49, &forwarded), 50u);
+        TS_ASSERT(!forwarded.empty());
+        TS_ASSERT(BlockExists("TestResultCache/Forwarded/Cache", "1", 0));
+
+        //the stored block replays every seed, as an uncached run writes them
+        TS_ASSERT_EQUALS(Run("TestResultCache/Forwarded/Replayed", "TestResultCache/Forwarded/Cache", "1", 0, 49), 0u);
+        SimulatorRunFixture::Run("TestResultCache/Forwarded/Fresh", "1", "", 0, 49);
+        for (std::string file : { "runCounts", "runEvents" })
+        {
+            std::string fresh = SimulatorRunFixture::ReadFile("TestResultCache/Forwarded/Fresh", file);
+            TS_ASSERT(!fresh.empty());
+            TS_ASSERT_EQUALS(SimulatorRunFixture::ReadFile("TestResultCache/Forwarded/Replayed", file), fresh);
+        }
+    }
+};
+
+#endif /*TESTRESULTCACHE_HPP_*/
@@ -0,0 +1,84 @@
+#ifndef TESTSEEDJOURNAL_HPP_
+#define TESTSEEDJOURNAL_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <fstream>
+#include <string>
+
+#include "OutputFileHandler.hpp"
+#include "SimulatorRunFixture.hpp"
+
+class TestSeedJournal : public CxxTest::TestSuite
+{
+private:
+    void AppendToFile(const std::string& rDirectory, const std::string& rFilename, const std::string& rText)
+    {
+        std::ofstream file(SimulatorRunFixture::FilePath(rDirectory, rFilename).c_str(), std::ios::app);
+        file << rText;
+    }
+
+    //Journal lines after the job line, which hashes the whole command line, output directory included
+    std::string ReadJournalSeeds(const std::string& rDirectory)
+    {
+        std::string journal = SimulatorRunFixture::ReadFile(rDirectory, "run.journal");
+        return journal.substr(journal.find('\n') + 1);
+    }
+
+public:
+    void TestResumeMatchesUninterruptedRun()
+    {
+        OutputFileHandler clean("TestSeedJournal/Resume", true);
+
+        SimulatorRunFixture::Run("TestSeedJournal/Resume/Whole", "1", "", 10, 29);
+
+        //killed after 7 of 20 seeds, part way through writing the 8th: its output & journal line are cut off
+        TS_ASSERT_EQUALS(SimulatorRunFixture::Run("TestSeedJournal/Resume/Killed", "1", "", 10, 29, 7), 7u);
+        AppendToFile("TestSeedJournal/Resume/Killed", "runCounts", "8\t17\t");
+        AppendToFile("TestSeedJournal/Resume/Killed", "runEvents", "0\t17\t0\t0\n0.25\t1");
+        AppendToFile("TestSeedJournal/Resume/Killed", "run.journal", "17\t4");
+
+        //the partial journal line is ignored, so seed 17 is simulated again, after the output is truncated to seed 16's
+        TS_ASSERT_EQUALS(SimulatorRunFixture::Run("TestSeedJournal/Resume/Killed", "1", "--resume", 10, 29), 13u);
+
+        std::string whole_counts = SimulatorRunFixture::ReadFile("TestSeedJournal/Resume/Whole", "runCounts");
+        std::string whole_events = SimulatorRunFixture::ReadFile("TestSeedJournal/Resume/Whole", "runEvents");
+        TS_ASSERT(!whole_counts.empty());
+        TS_ASSERT(!whole_events.empty());
+        TS_ASSERT_EQUALS(SimulatorRunFixture::ReadFile("TestSeedJournal/Resume/Killed", "runCounts"), whole_counts);
+        TS_ASSERT_EQUALS(SimulatorRunFixture::ReadFile("TestSeedJournal/Resume/Killed", "runEvents"), whole_events);
+
+        //the partial journal line is cut off, so the journaled seeds & sizes are also those of the uninterrupted run
+        TS_ASSERT_EQUALS(ReadJournalSeeds("TestSeedJournal/Resume/Killed"), ReadJournalSeeds("TestSeedJournal/Resume/Whole"));
+
+        //every seed is journaled once the run has finished
+        TS_ASSERT_EQUALS(SimulatorRunFixture::Run("TestSeedJournal/Resume/Killed", "1", "--resume", 10, 29), 0u);
+        TS_ASSERT_EQUALS(SimulatorRunFixture::ReadFile("TestSeedJournal/Resume/Killed", "runCounts"), whole_counts);
+    }
+
+    void TestResumeWithNothingJournaled()
+    {
+        OutputFileHandler clean("TestSeedJournal/Empty", true);
+
+        //no journal yet: --resume starts the run from the beginning
+        SimulatorRunFixture::Run("TestSeedJournal/Empty/Whole", "1", "", 0, 9);
+        TS_ASSERT_EQUALS(SimulatorRunFixture::Run("TestSeedJournal/Empty/Resumed", "1", "--resume", 0, 9), 10u);
+        TS_ASSERT_EQUALS(SimulatorRunFixture::ReadFile("TestSeedJournal/Empty/Resumed", "runCounts"),
+                         SimulatorRunFixture::ReadFile("TestSeedJournal/Empty/Whole", "runCounts"));
+    }
+
+    void TestMismatchedJobIsRefused()
+    {
+        OutputFileHandler clean("TestSeedJournal/Mismatch", true);
+
+        SimulatorRunFixture::Run("TestSeedJournal/Mismatch", "1", "", 0, 9, 5);
+
+        TS_ASSERT_THROWS_CONTAINS(SimulatorRunFixture::Run("TestSeedJournal/Mismatch", "2", "--resume", 0, 9),
+                                  "was written by a different simulator command line");
+
+        //the refused journal is left as it was, so the right command line can still resume it
+        TS_ASSERT_EQUALS(SimulatorRunFixture::Run("TestSeedJournal/Mismatch", "1", "--resume", 0, 9), 5u);
+    }
+};
+
+#endif /*TESTSEEDJOURNAL_HPP_*/
@@ -0,0 +1,120 @@
+#ifndef TESTSEQUENCETRIE_HPP_
+#define TESTSEQUENCETRIE_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SequenceTrie.hpp"
+#include "RandomNumberGenerator.hpp"
+
+class TestSequenceTrie : public CxxTest::TestSuite
+{
+public:
+    void TestCountsAndTable()
+    {
+        //inserted out of order, with a repeat & the empty sequence (a founder that never divided)
+        SequenceTrie trie;
+        std::vector<std::string> sequences = { "21", "012", "", "01", "2", "01", "0120" };
+        for (unsigned i = 0; i < sequences.size(); i++)
+        {
+            trie.Insert(sequences[i]);
+        }
+
+        TS_ASSERT_EQUALS(trie.GetNumSequences(), 7u);
+        TS_ASSERT_EQUALS(trie.GetCount(""), 1u);
+        TS_ASSERT_EQUALS(trie.GetPrefixCount(""), 7u);
+        TS_ASSERT_EQUALS(trie.GetCount("0"), 0u);
+        TS_ASSERT_EQUALS(trie.GetPrefixCount("0"), 4u);
+        TS_ASSERT_EQUALS(trie.GetCount("01"), 2u);
+        TS_ASSERT_EQUALS(trie.GetPrefixCount("01"), 4u);
+        TS_ASSERT_EQUALS(trie.GetCount("012"), 1u);
+        TS_ASSERT_EQUALS(trie.GetPrefixCount("012"), 2u);
+
+        //sequences not in the trie, including ones passing through a node, or with other characters, count 0
+        TS_ASSERT_EQUALS(trie.GetCount("1"), 0u);
+        TS_ASSERT_EQUALS(trie.GetPrefixCount("1"), 0u);
+        TS_ASSERT_EQUALS(trie.GetCount("01201"), 0u);
+        TS_ASSERT_EQUALS(trie.GetPrefixCount("22"), 0u);
+        TS_ASSERT_EQUALS(trie.GetCount("0x"), 0u);
+
+        //depth-first, modes in order, the root as "-"
+        std::ostringstream table;
+        trie.Write(table);
+        TS_ASSERT_EQUALS(table.str(), "-\t1\t7\n"
+                                      "0\t0\t4\n"
+                                      "01\t2\t4\n"
+                                      "012\t1\t2\n"
+                                      "0120\t1\t1\n"
+                                      "2\t1\t2\n"
+                                      "21\t1\t1\n");
+
+        trie.Clear();
+        TS_ASSERT_EQUALS(trie.GetNumSequences(), 0u);
+        std::ostringstream cleared;
+        trie.Write(cleared);
+        TS_ASSERT_EQUALS(cleared.str(), "-\t0\t0\n");
+    }
+
+    void TestNonModeCharacterThrows()
+    {
+        SequenceTrie trie;
+        trie.Insert("01");
+        TS_ASSERT_THROWS_THIS(trie.Insert("013"),
+                              "Mitotic mode sequence \"013\" contains a character other than 0, 1 or 2");
+        TS_ASSERT_THROWS_THIS(trie.Insert("0 1"),
+                              "Mitotic mode sequence \"0 1\" contains a character other than 0, 1 or 2");
+
+        //a refused sequence is not partly counted
+        TS_ASSERT_EQUALS(trie.GetNumSequences(), 1u);
+        TS_ASSERT_EQUALS(trie.GetPrefixCount("0"), 1u);
+        TS_ASSERT_EQUALS(trie.GetPrefixCount("01"), 1u);
+    }
+
+    void TestCountsMatchSequenceTally()
+    {
+        //random sequences of up to 5 modes against a direct tally of each sequence & each prefix
+        RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+        p_RNG->Reseed(0);
+        SequenceTrie trie;
+        std::map<std::string, unsigned> counts, prefix_counts;
+        for (unsigned i = 0; i < 2000; i++)
+        {
+            std::string sequence;
+            unsigned length = p_RNG->randMod(6);
+            for (unsigned j = 0; j < length; j++)
+            {
+                sequence.push_back(char('0' + p_RNG->randMod(3)));
+            }
+            trie.Insert(sequence);
+            counts[sequence]++;
+            for (unsigned j = 0; j <= sequence.size(); j++)
+            {
+                prefix_counts[sequence.substr(0, j)]++;
+            }
+        }
+
+        TS_ASSERT_EQUALS(trie.GetNumSequences(), 2000u);
+        for (std::map<std::string, unsigned>::iterator it = prefix_counts.begin(); it != prefix_counts.end(); ++it)
+        {
+            TS_ASSERT_EQUALS(trie.GetPrefixCount(it->first), it->second);
+            TS_ASSERT_EQUALS(trie.GetCount(it->first), counts[it->first]);
+        }
+
+        //one row per prefix, in the map's (lexicographic) order
+        std::ostringstream expected;
+        for (std::map<std::string, unsigned>::iterator it = prefix_counts.begin(); it != prefix_counts.end(); ++it)
+        {
+            expected << (it->first.empty() ? "-" : it->first) << "\t" << counts[it->first] << "\t" << it->second << "\n";
+        }
+        std::ostringstream table;
+        trie.Write(table);
+        TS_ASSERT_EQUALS(table.str(), expected.str());
+        RandomNumberGenerator::Destroy();
+    }
+};
+
+#endif /*TESTSEQUENCETRIE_HPP_*/
@@ -0,0 +1,186 @@
+#ifndef TESTSEQUENTIALSTOPPING_HPP_
+#define TESTSEQUENTIALSTOPPING_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "OutputFileHandler.hpp"
+#include "SequentialStopping.hpp"
+
+class TestSequentialStopping : public CxxTest::TestSuite
+{
+private:
+    //Reference histogram file, one probability per line
+    std::string WriteReference(const std::string& rName, const std::vector<double>& rProbabilities)
+    {
+        OutputFileHandler handler("TestSequentialStopping", false);
+        out_stream p_file = handler.OpenOutputFile(rName);
+        for (unsigned i = 0; i < rProbabilities.size(); i++)
+        {
+            *p_file << rProbabilities[i] << "\n";
+        }
+        p_file->close();
+        return handler.GetOutputDirectoryFullPath() + rName;
+    }
+
+public:
+    void TestExactMatchHasFiniteLogRss()
+    {
+        //every seed has count 1, matching a reference of P(count = 1) = 1 exactly
+        std::vector<double> reference(1, 1.0);
+        SequentialStopping stopping;
+        stopping.Enable(10, 0, 0.01, WriteReference("exact.txt", reference));
+
+        for (unsigned i = 0; i < 9; i++)
+        {
+            TS_ASSERT(!stopping.AddLineage(1));
+        }
+        TS_ASSERT(!stopping.AddLineage(1)); //first block has no previous log RSS
+        TS_ASSERT(std::isfinite(stopping.GetLogRss()));
+
+        for (unsigned i = 0; i < 10; i++)
+        {
+            stopping.AddLineage(1);
+        }
+        TS_ASSERT(stopping.HasConverged()); //unchanged & exact
+    }
+
+    void TestLeavingAnExactMatchIsNotConvergence()
+    {
+        //half count 1, half count 2; the first block matches exactly, the second moves away from the reference
+        std::vector<double> reference(2, 0.5);
+        SequentialStopping stopping;
+        stopping.Enable(4, 0, 1.0, WriteReference("half.txt", reference));
+
+        unsigned first_block[4] = {1, 2, 1, 2};
+        for (unsigned i = 0; i < 4; i++)
+        {
+            stopping.AddLineage(first_block[i]);
+        }
+        TS_ASSERT(std::isfinite(stopping.GetLogRss()));
+
+        for (unsigned i = 0; i < 4; i++)
+        {
+            stopping.AddLineage(1);
+        }
+        TS_ASSERT(!stopping.HasConverged()); //log RSS rose from the floor by far more than 1
+    }
+
+    void TestCiWidthOfKnownStreams()
+    {
+        //no lineages yet: every interval is [0, 1]
+        SequentialStopping stopping;
+        stopping.Enable(100, 0.01, 0, "");
+        TS_ASSERT_DELTA(stopping.GetMaxCiWidth(), 1.0, 1e-12);
+
+        //100 lineages of count 1: p = 1 & p = 0 (counts not yet seen) both give the floor z^2 / (n + z^2)
+        for (unsigned i = 0; i < 100; i++)
+        {
+            stopping.AddLineage(1);
+        }
+        TS_ASSERT_DELTA(stopping.GetMaxCiWidth(), 0.036993498206986, 1e-12);
+
+        //a Bernoulli stream alternating counts 1 & 2: p = 0.5 at n = 100, the widest interval there is
+        SequentialStopping bernoulli;
+        bernoulli.Enable(100, 0.01, 0, "");
+        for (unsigned i = 0; i < 100; i++)
+        {
+            bernoulli.AddLineage(1 + i % 2);
+        }
+        TS_ASSERT_DELTA(bernoulli.GetMaxCiWidth(), 0.192336939268009, 1e-12);
+    }
+
+    void TestImmediateStop()
+    {
+        //a loose width is met by the first block, so the run stops at its end & no sooner
+        SequentialStopping stopping;
+        stopping.Enable(10, 0.5, 0, "");
+        for (unsigned i = 0; i < 9; i++)
+        {
+            TS_ASSERT(!stopping.AddLineage(3));
+        }
+        TS_ASSERT(stopping.AddLineage(3));
+        TS_ASSERT(stopping.HasConverged());
+        TS_ASSERT_EQUALS(stopping.GetNumLineages(), 10u);
+    }
+
+    void TestNeverStopsBeforeMinimum()
+    {
+        /*
+         * Unseen counts have p = 0, whose width z^2 / (n + z^2) is at most 0.05 only from n = 73: however tight the
+         * count distribution, checked after every seed the run stops there & not before
+         */
+        SequentialStopping stopping;
+        stopping.Enable(1, 0.05, 0, "");
+        for (unsigned i = 1; i < 73; i++)
+        {
+            TS_ASSERT(!stopping.AddLineage(1));
+        }
+        TS_ASSERT(stopping.AddLineage(1));
+        TS_ASSERT_EQUALS(stopping.GetNumLineages(), 73u);
+
+        //in blocks of 10, the first check at or after the minimum is at 80
+        SequentialStopping blocks;
+        blocks.Enable(10, 0.05, 0, "");
+        for (unsigned i = 1; i < 80; i++)
+        {
+            TS_ASSERT(!blocks.AddLineage(1));
+        }
+        TS_ASSERT(blocks.AddLineage(1));
+    }
+
+    void TestStopsOnlyAtBlockEnds()
+    {
+        /*
+         * The alternating 1 & 2 stream's widest interval is at most 0.2 from n = 93 on, but in blocks of 25 it is
+         * checked at 75 (0.2207, not met) & next at 100
+         */
+        SequentialStopping stopping;
+        stopping.Enable(25, 0.2, 0, "");
+        for (unsigned i = 1; i < 100; i++)
+        {
+            TS_ASSERT(!stopping.AddLineage(1 + i % 2));
+            if (i == 93) TS_ASSERT_LESS_THAN_EQUALS(stopping.GetMaxCiWidth(), 0.2);
+        }
+        TS_ASSERT(!stopping.HasConverged());
+        TS_ASSERT(stopping.AddLineage(1));
+        TS_ASSERT(stopping.HasConverged());
+    }
+
+    void TestBothCriteriaMustBeMet()
+    {
+        //the width is met from the first block, but the log RSS change only once a block repeats the last one's RSS
+        std::vector<double> reference(4, 0.25);
+        SequentialStopping stopping;
+        stopping.Enable(8, 0.9, 1e-9, WriteReference("quarters.txt", reference));
+
+        //counts 1-4 cycling: every block ends on an exact match
+        for (unsigned i = 0; i < 7; i++)
+        {
+            TS_ASSERT(!stopping.AddLineage(1 + i % 4));
+        }
+        TS_ASSERT(!stopping.AddLineage(4)); //no previous log RSS
+        for (unsigned i = 0; i < 7; i++)
+        {
+            TS_ASSERT(!stopping.AddLineage(1 + i % 4));
+        }
+        TS_ASSERT(stopping.AddLineage(4)); //unchanged at the floor
+
+        //the same stream with a width 16 seeds cannot reach: the log RSS change alone does not stop it
+        SequentialStopping tight;
+        tight.Enable(8, 0.01, 1e-9, WriteReference("quarters.txt", reference));
+        for (unsigned i = 0; i < 16; i++)
+        {
+            TS_ASSERT(!tight.AddLineage(1 + i % 4));
+        }
+
+        TS_ASSERT_THROWS_THIS(stopping.Enable(0, 0.1, 0, ""), "Sequential stopping block size must be > 0");
+        TS_ASSERT_THROWS_THIS(stopping.Enable(10, 0, 0, ""), "Sequential stopping needs a CI width or AIC change criterion");
+    }
+};
+
+#endif /*TESTSEQUENTIALSTOPPING_HPP_*/
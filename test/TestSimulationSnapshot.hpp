@@ -0,0 +1,141 @@
+#ifndef TESTSIMULATIONSNAPSHOT_HPP_
+#define TESTSIMULATIONSNAPSHOT_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "AbstractCellBasedTestSuite.hpp"
+#include "SmartPointers.hpp"
+#include "HeCellCycleModel.hpp"
+#include "OffLatticeSimulationPropertyStop.hpp"
+#include "SimulationSnapshot.hpp"
+#include "WildTypeCellMutationState.hpp"
+#include "TransitCellProliferativeType.hpp"
+#include "DifferentiatedCellProliferativeType.hpp"
+#include "HoneycombMeshGenerator.hpp"
+#include "NodesOnlyMesh.hpp"
+#include "NodeBasedCellPopulation.hpp"
+#include "RandomNumberGenerator.hpp"
+#include "SimulationTime.hpp"
+#include "CellId.hpp"
+
+class TestSimulationSnapshot : public AbstractCellBasedTestSuite
+{
+private:
+    static const double FORK_TIME;
+    static const double END_TIME;
+
+    //End state of a lineage: live cells' IDs (sorted) & how many are still mitotic
+    struct LineageEnd
+    {
+        std::vector<unsigned> mCellIds;
+        unsigned mNumMitotic;
+    };
+
+    LineageEnd GetEnd(NodeBasedCellPopulation<2>& rPopulation, boost::shared_ptr<AbstractCellProperty> pMitotic)
+    {
+        LineageEnd end;
+        end.mNumMitotic = 0;
+        for (AbstractCellPopulation<2>::Iterator cell_iter = rPopulation.Begin(); cell_iter != rPopulation.End(); ++cell_iter)
+        {
+            end.mCellIds.push_back((*cell_iter)->GetCellId());
+            if ((*cell_iter)->GetCellProliferativeType()->IsSame(pMitotic)) end.mNumMitotic++;
+        }
+        std::sort(end.mCellIds.begin(), end.mCellIds.end());
+        return end;
+    }
+
+    //Continue a population to END_TIME, as HeSimulator continues its fork variants
+    void Continue(NodeBasedCellPopulation<2>& rPopulation, boost::shared_ptr<AbstractCellProperty> pMitotic, bool initialiseCells)
+    {
+        OffLatticeSimulationPropertyStop<2> simulator(rPopulation, false, initialiseCells);
+        simulator.SetStopProperty(pMitotic);
+        simulator.SetDt(0.05);
+        simulator.SetEndTime(END_TIME);
+        simulator.DisableSimulationOutput();
+        simulator.Solve();
+    }
+
+public:
+    void TestRestoredPopulationContinuesIdentically()
+    {
+        MAKE_PTR(WildTypeCellMutationState, p_state);
+        MAKE_PTR(TransitCellProliferativeType, p_Mitotic);
+        MAKE_PTR(DifferentiatedCellProliferativeType, p_PostMitotic);
+
+        unsigned num_forked = 0;
+        for (unsigned seed = 0; seed < 5; seed++)
+        {
+            SimulationTime::Destroy();
+            SimulationTime::Instance()->SetStartTime(0.0);
+            CellId::ResetMaxCellId();
+            RandomNumberGenerator::Instance()->Reseed(seed);
+
+            //a He 2012 lineage from its first mitosis, as HeSimulator fixture 0
+            HeCellCycleModel* p_cycle_model = new HeCellCycleModel;
+            p_cycle_model->SetDimension(2);
+            p_cycle_model->SetModelParameters(0.0);
+
+            std::vector<CellPtr> cells;
+            CellPtr p_cell(new Cell(p_state, p_cycle_model));
+            p_cell->SetCellProliferativeType(p_Mitotic);
+            p_cell->InitialiseCellCycleModel();
+            cells.push_back(p_cell);
+
+            HoneycombMeshGenerator generator(1, 1);
+            NodesOnlyMesh<2> mesh;
+            mesh.ConstructNodesWithoutMesh(*generator.GetMesh(), 1.5);
+            NodeBasedCellPopulation<2>* p_population = new NodeBasedCellPopulation<2>(mesh, cells);
+
+            {
+                OffLatticeSimulationPropertyStop<2> simulator(*p_population);
+                simulator.SetStopProperty(p_Mitotic);
+                simulator.SetDt(0.05);
+                simulator.SetEndTime(FORK_TIME);
+                simulator.DisableSimulationOutput();
+                simulator.Solve();
+            }
+            if (p_Mitotic->GetCellCount() == 0)
+            {
+                //the lineage ended before the fork, so HeSimulator would not continue it
+                delete p_population;
+                continue;
+            }
+            num_forked++;
+
+            SimulationSnapshot<2> snapshot(*p_population);
+            TS_ASSERT_DELTA(snapshot.GetTime(), FORK_TIME, 1e-9);
+            TS_ASSERT_EQUALS(snapshot.GetNumCells(), p_population->GetNumRealCells());
+
+            //the simulated lineage, continued past the fork
+            Continue(*p_population, p_Mitotic, false);
+            LineageEnd simulated = GetEnd(*p_population, p_Mitotic);
+            delete p_population; //live cells are counted by their properties, so one population at a time
+
+            //the snapshot, restored twice & continued the same way
+            for (unsigned restore = 0; restore < 2; restore++)
+            {
+                NodeBasedCellPopulation<2>* p_restored = snapshot.Restore();
+                TS_ASSERT_DELTA(SimulationTime::Instance()->GetTime(), FORK_TIME, 1e-9);
+                TS_ASSERT_EQUALS(p_restored->GetNumRealCells(), snapshot.GetNumCells());
+
+                Continue(*p_restored, p_Mitotic, false);
+                LineageEnd restored = GetEnd(*p_restored, p_Mitotic);
+                TS_ASSERT_EQUALS(restored.mCellIds.size(), simulated.mCellIds.size());
+                TS_ASSERT(restored.mCellIds == simulated.mCellIds);
+                TS_ASSERT_EQUALS(restored.mNumMitotic, simulated.mNumMitotic);
+                delete p_restored;
+            }
+        }
+
+        //some lineages must still be growing at the fork, or the comparison says nothing
+        TS_ASSERT_LESS_THAN(0u, num_forked);
+    }
+};
+
+const double TestSimulationSnapshot::FORK_TIME = 24.0;
+const double TestSimulationSnapshot::END_TIME = 72.0;
+
+#endif /*TESTSIMULATIONSNAPSHOT_HPP_*/
@@ -0,0 +1,111 @@
+#ifndef TESTSOBOLINDICES_HPP_
+#define TESTSOBOLINDICES_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <cmath>
+#include <vector>
+
+#include "SobolIndices.hpp"
+#include "RandomNumberGenerator.hpp"
+
+class TestSobolIndices : public CxxTest::TestSuite
+{
+private:
+    typedef double (*Function)(const std::vector<double>&);
+
+    //Ishigami function, a = 7 & b = 0.1, on [-pi, pi]^3
+    static double Ishigami(const std::vector<double>& rX)
+    {
+        return std::sin(rX[0]) + 7.0 * std::sin(rX[1]) * std::sin(rX[1]) + 0.1 * std::pow(rX[2], 4) * std::sin(rX[0]);
+    }
+
+    //Depends on its first parameter only
+    static double FirstOnly(const std::vector<double>& rX)
+    {
+        return rX[0] * rX[0];
+    }
+
+    //A function's values over a Saltelli design on [-pi, pi]^d, laid out as SobolSweep's: A, B, then each AB_i
+    std::vector<double> EvaluateDesign(Function function, unsigned numBaseSamples, unsigned numSwept)
+    {
+        RandomNumberGenerator* p_RNG = RandomNumberGenerator::Instance();
+        p_RNG->Reseed(0);
+        std::vector<std::vector<double> > a(numBaseSamples, std::vector<double>(numSwept));
+        std::vector<std::vector<double> > b(numBaseSamples, std::vector<double>(numSwept));
+        for (unsigned r = 0; r < numBaseSamples; r++)
+        {
+            for (unsigned j = 0; j < numSwept; j++) a[r][j] = M_PI * (2 * p_RNG->ranf() - 1);
+            for (unsigned j = 0; j < numSwept; j++) b[r][j] = M_PI * (2 * p_RNG->ranf() - 1);
+        }
+
+        std::vector<double> values;
+        for (unsigned r = 0; r < numBaseSamples; r++) values.push_back(function(a[r]));
+        for (unsigned r = 0; r < numBaseSamples; r++) values.push_back(function(b[r]));
+        for (unsigned i = 0; i < numSwept; i++)
+        {
+            for (unsigned r = 0; r < numBaseSamples; r++)
+            {
+                std::vector<double> x = a[r];
+                x[i] = b[r][i];
+                values.push_back(function(x));
+            }
+        }
+        return values;
+    }
+
+public:
+    void TestIshigamiIndices()
+    {
+        //analytic indices: V1 = (1 + b pi^4 / 5)^2 / 2, V2 = a^2 / 8, V3 = 0 & V13 = 8 b^2 pi^8 / 225
+        double a = 7.0, b = 0.1;
+        double pi4 = std::pow(M_PI, 4), pi8 = std::pow(M_PI, 8);
+        double variance = a * a / 8 + b * pi4 / 5 + b * b * pi8 / 18 + 0.5;
+        double v1 = 0.5 * (1 + b * pi4 / 5) * (1 + b * pi4 / 5);
+        double v2 = a * a / 8;
+        double v13 = 8 * b * b * pi8 / 225;
+        std::vector<double> expected_first = { v1 / variance, v2 / variance, 0.0 };
+        std::vector<double> expected_total = { (v1 + v13) / variance, v2 / variance, v13 / variance };
+
+        //the estimators' error at 20000 base samples is about 0.01
+        const unsigned num_base_samples = 20000;
+        std::vector<double> first, total;
+        SobolIndices::Estimate(EvaluateDesign(Ishigami, num_base_samples, 3), num_base_samples, 3, first, total);
+        TS_ASSERT_EQUALS(first.size(), 3u);
+        TS_ASSERT_EQUALS(total.size(), 3u);
+        for (unsigned i = 0; i < 3; i++)
+        {
+            TS_ASSERT_DELTA(first[i], expected_first[i], 0.05);
+            TS_ASSERT_DELTA(total[i], expected_total[i], 0.05);
+        }
+    }
+
+    void TestUnusedParametersHaveZeroIndices()
+    {
+        //f_ABi equals f_A wherever parameter i is unused, so its indices are exactly 0
+        const unsigned num_base_samples = 2000;
+        std::vector<double> first, total;
+        SobolIndices::Estimate(EvaluateDesign(FirstOnly, num_base_samples, 3), num_base_samples, 3, first, total);
+        TS_ASSERT_DELTA(first[0], 1.0, 0.1);
+        TS_ASSERT_DELTA(total[0], 1.0, 0.1);
+        for (unsigned i = 1; i < 3; i++)
+        {
+            TS_ASSERT_EQUALS(first[i], 0.0);
+            TS_ASSERT_EQUALS(total[i], 0.0);
+        }
+    }
+
+    void TestConstantOutputHasZeroIndices()
+    {
+        std::vector<double> first(1, 1.0), total(1, 1.0);
+        SobolIndices::Estimate(std::vector<double>(4 * 10, 3.5), 10, 2, first, total);
+        TS_ASSERT_EQUALS(first.size(), 2u);
+        for (unsigned i = 0; i < 2; i++)
+        {
+            TS_ASSERT_EQUALS(first[i], 0.0);
+            TS_ASSERT_EQUALS(total[i], 0.0);
+        }
+    }
+};
+
+#endif /*TESTSOBOLINDICES_HPP_*/
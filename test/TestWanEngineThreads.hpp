@@ -0,0 +1,74 @@
+#ifndef TESTWANENGINETHREADS_HPP_
+#define TESTWANENGINETHREADS_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <vector>
+
+#include "AbstractCellBasedTestSuite.hpp"
+#include "WanEventEngine.hpp"
+#include "WanTestFixture.hpp"
+
+class TestWanEngineThreads : public AbstractCellBasedTestSuite
+{
+private:
+    typedef WanTestFixture::Rows Rows;
+
+public:
+    void TestCountsDoNotDependOnThreads()
+    {
+        std::vector<double> theta = WanTestFixture::GetTheta(200.0);
+        WanEventEngine one_thread(theta);
+        one_thread.SetNumThreads(1);
+        WanEventEngine four_threads(theta);
+        four_threads.SetNumThreads(4);
+
+        //lanes never interact, so the lanes' streams give the same counts however they are shared out
+        for (unsigned seed = 0; seed < 3; seed++)
+        {
+            for (unsigned samplingMultiple = 1; samplingMultiple <= 4; samplingMultiple += 3)
+            {
+                Rows expected = WanTestFixture::RunEngine(one_thread, seed, samplingMultiple);
+                Rows threaded = WanTestFixture::RunEngine(four_threads, seed, samplingMultiple);
+                TS_ASSERT_EQUALS(one_thread.GetNumSamples(), four_threads.GetNumSamples());
+                for (unsigned i = 0; i < one_thread.GetNumSamples() && i < four_threads.GetNumSamples(); i++)
+                {
+                    TS_ASSERT_EQUALS(one_thread.GetSampleTime(i), four_threads.GetSampleTime(i));
+                    TS_ASSERT(one_thread.GetSampleCounts(i) == four_threads.GetSampleCounts(i));
+                }
+                WanTestFixture::CompareRows(expected, threaded);
+            }
+        }
+    }
+
+    void TestThreadsStopWithSerialEngine()
+    {
+        //no stems & DD divisions only: the lanes' draws never reach the counts, so lanes follow the serial engine exactly
+        std::vector<double> theta = WanTestFixture::GetLosingTheta(200.0);
+        WanEventEngine serial(theta);
+        serial.SetNumThreads(0);
+
+        for (unsigned num_threads = 1; num_threads <= 4; num_threads += 3)
+        {
+            WanEventEngine threaded(theta);
+            threaded.SetNumThreads(num_threads);
+
+            for (unsigned seed = 0; seed < 5; seed++)
+            {
+                Rows expected = WanTestFixture::RunEngine(serial, seed, 1);
+                Rows lanes = WanTestFixture::RunEngine(threaded, seed, 1);
+
+                //the pool is lost before the end time & the run stops the step after, as WanSimulator's does
+                TS_ASSERT_LESS_THAN(2u, lanes.size());
+                TS_ASSERT_LESS_THAN(lanes.back()[0], 200.0 - 0.5);
+                TS_ASSERT_EQUALS(lanes.back()[2], 0.0);
+                TS_ASSERT_LESS_THAN(0.0, lanes[lanes.size() - 2][2]);
+
+                TS_ASSERT_EQUALS(lanes.size(), expected.size());
+                WanTestFixture::CompareRows(expected, lanes);
+            }
+        }
+    }
+};
+
+#endif /*TESTWANENGINETHREADS_HPP_*/
@@ -0,0 +1,67 @@
+#ifndef TESTWANEVENTENGINE_HPP_
+#define TESTWANEVENTENGINE_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <string>
+#include <vector>
+
+#include "AbstractCellBasedTestSuite.hpp"
+#include "WanEventEngine.hpp"
+#include "WanSeedSimulation.hpp"
+#include "WanTestFixture.hpp"
+
+class TestWanEventEngine : public AbstractCellBasedTestSuite
+{
+private:
+    typedef WanTestFixture::Rows Rows;
+
+public:
+    void TestEngineFollowsSimulator()
+    {
+        std::vector<double> theta = WanTestFixture::GetTheta(200.0);
+        WanEventEngine engine(theta);
+        engine.SetTauLeapTolerance(0.0);
+        engine.SetNumThreads(0);
+
+        for (unsigned samplingMultiple : { 1u, 4u })
+        {
+            WanSeedSimulation simulator(theta);
+            simulator.SetSamplingTimestepMultiple(samplingMultiple);
+
+            for (unsigned seed = 0; seed < 3; seed++)
+            {
+                std::string directory = "TestWanEventEngine/Seed" + std::to_string(seed) + "Sampling" + std::to_string(samplingMultiple);
+                WanTestFixture::RunSimulator(simulator, seed, directory);
+                Rows simulated = WanTestFixture::ReadCellTypes(directory);
+                TS_ASSERT_LESS_THAN(1u, simulated.size());
+
+                WanTestFixture::CompareRows(simulated, WanTestFixture::RunEngine(engine, seed, samplingMultiple));
+            }
+        }
+    }
+
+    void TestEngineStopsWithSimulator()
+    {
+        std::vector<double> theta = WanTestFixture::GetLosingTheta(200.0);
+        WanEventEngine engine(theta);
+        WanSeedSimulation simulator(theta);
+
+        for (unsigned seed = 0; seed < 3; seed++)
+        {
+            std::string directory = "TestWanEventEngine/LosingSeed" + std::to_string(seed);
+            WanTestFixture::RunSimulator(simulator, seed, directory);
+            Rows simulated = WanTestFixture::ReadCellTypes(directory);
+
+            //the simulation stopped before the end time, one step after its last progenitor was lost
+            TS_ASSERT_LESS_THAN(2u, simulated.size());
+            TS_ASSERT_LESS_THAN(simulated.back()[0], 200.0 - 0.5);
+            TS_ASSERT_EQUALS(simulated.back()[2], 0.0);
+            TS_ASSERT_LESS_THAN(0.0, simulated[simulated.size() - 2][2]);
+
+            WanTestFixture::CompareRows(simulated, WanTestFixture::RunEngine(engine, seed, 1));
+        }
+    }
+};
+
+#endif /*TESTWANEVENTENGINE_HPP_*/
@@ -0,0 +1,110 @@
+#ifndef TESTWANMEANFIELD_HPP_
+#define TESTWANMEANFIELD_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "AbstractCellBasedTestSuite.hpp"
+#include "LineageModelRules.hpp"
+#include "WanEventEngine.hpp"
+#include "WanMeanField.hpp"
+#include "WanTestFixture.hpp"
+
+class TestWanMeanField : public AbstractCellBasedTestSuite
+{
+private:
+    typedef WanTestFixture::Rows Rows;
+
+    //WanStemCellCycleModel::ResetForDivision()'s lens growth factor at a simulated time (3dpf is time 0)
+    double GetLensGrowthFactor(double time)
+    {
+        return LineageModelRules::GetLensGrowthFactor(time + LineageModelRules::WAN_RETINA_AGE_AT_START);
+    }
+
+public:
+    void TestMeanFieldFollowsEngineMean()
+    {
+        std::vector<double> theta = WanTestFixture::GetTheta(500.0);
+        const unsigned num_seeds = 200;
+        const unsigned sampling_multiple = 10;
+
+        WanMeanField mean_field(theta);
+        mean_field.Solve(sampling_multiple);
+        Rows expected = WanTestFixture::GetSampleRows(mean_field);
+
+        //sums & sums of squares of the engine's stem & transit counts at each sample
+        WanEventEngine engine(theta);
+        std::vector<std::vector<double> > sums(expected.size(), std::vector<double>(2, 0.0));
+        std::vector<std::vector<double> > sum_squares(expected.size(), std::vector<double>(2, 0.0));
+        for (unsigned seed = 0; seed < num_seeds; seed++)
+        {
+            Rows rows = WanTestFixture::RunEngine(engine, seed, sampling_multiple);
+
+            //this theta's stems keep producing progenitors, so no seed stops early
+            TS_ASSERT_EQUALS(rows.size(), expected.size());
+            for (unsigned i = 0; i < std::min(rows.size(), expected.size()); i++)
+            {
+                TS_ASSERT_DELTA(rows[i][0], expected[i][0], 1e-9);
+                for (unsigned j = 0; j < 2; j++)
+                {
+                    sums[i][j] += rows[i][j + 1];
+                    sum_squares[i][j] += rows[i][j + 1] * rows[i][j + 1];
+                }
+            }
+        }
+
+        /*
+         * The mean field takes means before the simulator's rounding of the starting populations & lens target, so it
+         * follows the engine's mean to within 5 standard errors of that mean plus 5% of the expected count
+         */
+        for (unsigned i = 0; i < expected.size(); i++)
+        {
+            for (unsigned j = 0; j < 2; j++)
+            {
+                double mean = sums[i][j] / num_seeds;
+                double variance = std::max(0.0, (sum_squares[i][j] - num_seeds * mean * mean) / (num_seeds - 1));
+                double standard_error = std::sqrt(variance / num_seeds);
+                TS_ASSERT_DELTA(expected[i][j + 1], mean, 5 * standard_error + 0.05 * expected[i][j + 1]);
+            }
+            TS_ASSERT_EQUALS(expected[i][3], 0.0);
+            TS_ASSERT_EQUALS(expected[i][4], 0.0);
+        }
+    }
+
+    void TestStemsRespectLensTarget()
+    {
+        std::vector<double> theta = WanTestFixture::GetTheta(2000.0);
+
+        //expected stems never pass the lens target on the mean starting stems, once it is above them, & never fall
+        WanMeanField mean_field(theta);
+        mean_field.Solve(10);
+        Rows expected = WanTestFixture::GetSampleRows(mean_field);
+        double base_stems = theta[2] / theta[1];
+        TS_ASSERT_DELTA(expected[0][1], base_stems, 1e-9);
+        for (unsigned i = 0; i < expected.size(); i++)
+        {
+            double cap = std::max(base_stems, base_stems * GetLensGrowthFactor(expected[i][0]));
+            TS_ASSERT_LESS_THAN_EQUALS(expected[i][1], cap + 1e-9);
+            if (i > 0) TS_ASSERT_LESS_THAN_EQUALS(expected[i - 1][1], expected[i][1]);
+        }
+        TS_ASSERT_LESS_THAN(2 * base_stems, expected.back()[1]);
+
+        //each seed's stems: symmetric divisions stop at the rounded target on its starting stems
+        WanEventEngine engine(theta);
+        for (unsigned seed = 0; seed < 10; seed++)
+        {
+            Rows rows = WanTestFixture::RunEngine(engine, seed, 10);
+            double starting_stems = rows[0][1];
+            for (unsigned i = 0; i < rows.size(); i++)
+            {
+                double cap = std::max(starting_stems, std::round(starting_stems * GetLensGrowthFactor(rows[i][0])));
+                TS_ASSERT_LESS_THAN_EQUALS(rows[i][1], cap);
+            }
+        }
+    }
+};
+
+#endif /*TESTWANMEANFIELD_HPP_*/
@@ -0,0 +1,97 @@
+#ifndef TESTWANSEEDSIMULATION_HPP_
+#define TESTWANSEEDSIMULATION_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <string>
+#include <vector>
+
+#include "AbstractCellBasedTestSuite.hpp"
+#include "WanSeedSimulation.hpp"
+#include "WanTestFixture.hpp"
+
+class TestWanSeedSimulation : public AbstractCellBasedTestSuite
+{
+private:
+    typedef WanTestFixture::Rows Rows;
+
+    //Rows as expected, & one per sample time
+    void CompareRows(const Rows& rExpected, const Rows& rActual)
+    {
+        WanTestFixture::CompareRows(rExpected, rActual);
+        for (unsigned i = 1; i < rActual.size(); i++)
+        {
+            TS_ASSERT_LESS_THAN(rActual[i - 1][0], rActual[i][0]);
+        }
+    }
+
+public:
+    void TestCheckpointedRunWritesOneFile()
+    {
+        std::vector<double> theta = WanTestFixture::GetTheta(200.0);
+
+        for (unsigned samplingMultiple : { 1u, 4u })
+        {
+            WanSeedSimulation uncheckpointed(theta);
+            uncheckpointed.SetSamplingTimestepMultiple(samplingMultiple);
+            WanSeedSimulation checkpointed(theta);
+            checkpointed.SetSamplingTimestepMultiple(samplingMultiple);
+            checkpointed.SetCheckpointInterval(48);
+
+            for (unsigned seed = 0; seed < 2; seed++)
+            {
+                std::string suffix = "Seed" + std::to_string(seed) + "Sampling" + std::to_string(samplingMultiple);
+                WanTestFixture::RunSimulator(uncheckpointed, seed, "TestWanSeedSimulation/Uncheckpointed" + suffix);
+                WanTestFixture::RunSimulator(checkpointed, seed, "TestWanSeedSimulation/Checkpointed" + suffix);
+
+                //every sample from 0 to the end time, once, as in the run without checkpoints
+                Rows expected = WanTestFixture::ReadCellTypes("TestWanSeedSimulation/Uncheckpointed" + suffix);
+                TS_ASSERT_EQUALS(expected.size(), 200u / samplingMultiple + 1);
+                CompareRows(expected, WanTestFixture::ReadCellTypes("TestWanSeedSimulation/Checkpointed" + suffix));
+            }
+        }
+    }
+
+    void TestRestartContinuesCheckpointedRun()
+    {
+        WanSeedSimulation uncheckpointed(WanTestFixture::GetTheta(200.0));
+        WanSeedSimulation first_part(WanTestFixture::GetTheta(150.0));
+        first_part.SetCheckpointInterval(48);
+        WanSeedSimulation restart(WanTestFixture::GetTheta(200.0));
+        restart.SetCheckpointInterval(48);
+
+        for (unsigned seed = 0; seed < 2; seed++)
+        {
+            std::string directory = "TestWanSeedSimulation/Restarted" + std::to_string(seed);
+            WanTestFixture::RunSimulator(uncheckpointed, seed, "TestWanSeedSimulation/Whole" + std::to_string(seed));
+            WanTestFixture::RunSimulator(first_part, seed, directory);
+
+            //from the checkpoint at 96, so the first run's rows after it are written again
+            WanTestFixture::RunSimulator(restart, seed, directory, 96);
+            CompareRows(WanTestFixture::ReadCellTypes("TestWanSeedSimulation/Whole" + std::to_string(seed)), WanTestFixture::ReadCellTypes(directory));
+        }
+    }
+
+    void TestCheckpointedRunStopsWithUncheckpointed()
+    {
+        std::vector<double> theta = WanTestFixture::GetLosingTheta(200.0);
+        WanSeedSimulation uncheckpointed(theta);
+        WanSeedSimulation checkpointed(theta);
+        checkpointed.SetCheckpointInterval(8);
+
+        for (unsigned seed = 0; seed < 3; seed++)
+        {
+            std::string suffix = "Seed" + std::to_string(seed);
+            WanTestFixture::RunSimulator(uncheckpointed, seed, "TestWanSeedSimulation/LosingUncheckpointed" + suffix);
+            WanTestFixture::RunSimulator(checkpointed, seed, "TestWanSeedSimulation/LosingCheckpointed" + suffix);
+
+            //the pool is lost before the end time, & the joined counts stop where the single run's do
+            Rows expected = WanTestFixture::ReadCellTypes("TestWanSeedSimulation/LosingUncheckpointed" + suffix);
+            TS_ASSERT_LESS_THAN(expected.back()[0], 200.0 - 0.5);
+            TS_ASSERT_EQUALS(expected.back()[2], 0.0);
+            CompareRows(expected, WanTestFixture::ReadCellTypes("TestWanSeedSimulation/LosingCheckpointed" + suffix));
+        }
+    }
+};
+
+#endif /*TESTWANSEEDSIMULATION_HPP_*/
@@ -0,0 +1,83 @@
+#ifndef TESTWANTAULEAPING_HPP_
+#define TESTWANTAULEAPING_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "AbstractCellBasedTestSuite.hpp"
+#include "WanEventEngine.hpp"
+#include "RandomNumberGenerator.hpp"
+#include "WanTestFixture.hpp"
+
+class TestWanTauLeaping : public AbstractCellBasedTestSuite
+{
+private:
+    typedef WanTestFixture::Rows Rows;
+
+public:
+    void TestBinomialRandomDeviate()
+    {
+        RandomNumberGenerator::Instance()->Reseed(0);
+        const unsigned num_samples = 20000;
+
+        //trials either side of the direct limit, with p mid-range & near 0 & 1
+        unsigned direct = WanEventEngine::BINOMIAL_DIRECT_TRIALS;
+        std::vector<std::pair<unsigned, double> > cases = { { 20, 0.3 }, { direct, 0.5 }, { direct + 1, 0.5 }, { 1000, 0.3 },
+                                                            { 20, 0.002 }, { 5000, 0.0005 }, { 20, 0.998 }, { 5000, 0.9995 } };
+        for (unsigned c = 0; c < cases.size(); c++)
+        {
+            unsigned n = cases[c].first;
+            double p = cases[c].second;
+
+            double sum = 0, sum_squares = 0;
+            unsigned max_draw = 0;
+            for (unsigned i = 0; i < num_samples; i++)
+            {
+                unsigned draw = WanEventEngine::BinomialRandomDeviate(n, p);
+                max_draw = std::max(max_draw, draw);
+                sum += draw;
+                sum_squares += double(draw) * draw;
+            }
+            TS_ASSERT_LESS_THAN_EQUALS(max_draw, n);
+
+            //sample mean & variance within 5 standard errors of n p & n p (1 - p)
+            double mean = sum / num_samples;
+            double variance = (sum_squares - num_samples * mean * mean) / (num_samples - 1);
+            double expected_variance = n * p * (1 - p);
+            double fourth_moment = expected_variance * (1 + 3 * (n - 2.0) * p * (1 - p));
+            double variance_se = std::sqrt((fourth_moment - expected_variance * expected_variance * (num_samples - 3.0) / (num_samples - 1))
+                                           / num_samples);
+            TS_ASSERT_DELTA(mean, n * p, 5 * std::sqrt(expected_variance / num_samples));
+            TS_ASSERT_DELTA(variance, expected_variance, 5 * variance_se);
+        }
+
+        //p at the ends takes no draws
+        TS_ASSERT_EQUALS(WanEventEngine::BinomialRandomDeviate(1000, 0.0), 0u);
+        TS_ASSERT_EQUALS(WanEventEngine::BinomialRandomDeviate(1000, 1.0), 1000u);
+        TS_ASSERT_EQUALS(WanEventEngine::BinomialRandomDeviate(0, 0.5), 0u);
+    }
+
+    void TestTauLeapToleranceZeroIsExact()
+    {
+        std::vector<double> theta = WanTestFixture::GetTheta(200.0);
+        WanEventEngine exact(theta);
+
+        //WanSimulator reuses one engine for its seeds: a tolerance set back to 0 runs every division again
+        WanEventEngine reset(theta);
+        reset.SetTauLeapTolerance(0.03);
+        WanTestFixture::RunEngine(reset, 0, 1);
+        reset.SetTauLeapTolerance(0.0);
+
+        for (unsigned seed = 0; seed < 3; seed++)
+        {
+            Rows expected = WanTestFixture::RunEngine(exact, seed, 1);
+            WanTestFixture::CompareRows(expected, WanTestFixture::RunEngine(reset, seed, 1));
+        }
+    }
+};
+
+#endif /*TESTWANTAULEAPING_HPP_*/
@@ -0,0 +1,119 @@
+#ifndef WANTESTFIXTURE_HPP_
+#define WANTESTFIXTURE_HPP_
+
+#include <cxxtest/TestSuite.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "WanSeedSimulation.hpp"
+#include "OutputFileHandler.hpp"
+#include "RandomNumberGenerator.hpp"
+#include "SimulationTime.hpp"
+#include "CellId.hpp"
+
+/***********************************
+ * WAN TEST FIXTURE
+ * Parameters, seed runs & celltypes.dat rows shared by the Wan CMZ suites (TestWanSeedSimulation, TestWanEventEngine,
+ * TestWanTauLeaping, TestWanEngineThreads, TestWanMeanField). Seeds run as WanSimulator runs them: SimulationTime
+ * from 0 & the RandomNumberGenerator reseeded, through WanSeedSimulation or an engine.
+ ************************************/
+
+class WanTestFixture
+{
+public:
+    //celltypes.dat rows: time, then the stem, transit, differentiated & default counts
+    typedef std::vector<std::vector<double> > Rows;
+
+    /**
+     * WanSimulator's arguments 4-22 & the end time, in ModelLineage's Wan order: the output fixture's parameters with a
+     * small progenitor pool, so the simulator runs quickly
+     */
+    static std::vector<double> GetTheta(double endTime)
+    {
+        return { 17.0, 10, 80, 16, 4, 6.5, 4, 4, 2, 1, 1, 8, 15, 1.0, 0.0, 0.2, 0.4, 0.2, 0.0, endTime };
+    }
+
+    //No stems, & every progenitor division DD, so the pool is lost within a few cycles
+    static std::vector<double> GetLosingTheta(double endTime)
+    {
+        return { 17.0, 100, 20, 1, 4, 6.5, 4, 4, 2, 1, 1, 8, 15, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, endTime };
+    }
+
+    //One seed through WanSimulator's Chaste path; a restart continues the seed's checkpoint instead
+    static void RunSimulator(WanSeedSimulation& rSimulation, unsigned seed, const std::string& rDirectory,
+                             double restartTime = -1)
+    {
+        SimulationTime::Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+        CellId::ResetMaxCellId();
+        RandomNumberGenerator::Instance()->Reseed(seed);
+        rSimulation.Run(rDirectory, restartTime);
+        SimulationTime::Destroy();
+    }
+
+    static Rows ReadCellTypes(const std::string& rDirectory)
+    {
+        OutputFileHandler handler(rDirectory + "/results_from_time_0", false);
+        std::ifstream file((handler.GetOutputDirectoryFullPath() + "celltypes.dat").c_str());
+        Rows rows;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream fields(line);
+            std::vector<double> row;
+            double value;
+            while (fields >> value)
+            {
+                row.push_back(value);
+            }
+            if (!row.empty()) rows.push_back(row);
+        }
+        return rows;
+    }
+
+    //A WanEventEngine's or WanMeanField's samples as celltypes.dat rows
+    template<class SAMPLER>
+    static Rows GetSampleRows(const SAMPLER& rSampler)
+    {
+        Rows rows;
+        for (unsigned i = 0; i < rSampler.GetNumSamples(); i++)
+        {
+            std::vector<double> row(1, rSampler.GetSampleTime(i));
+            auto counts = rSampler.GetSampleCounts(i);
+            row.insert(row.end(), counts.begin(), counts.end());
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+    //One seed through an engine
+    template<class ENGINE>
+    static Rows RunEngine(ENGINE& rEngine, unsigned seed, unsigned samplingMultiple)
+    {
+        SimulationTime::Destroy();
+        SimulationTime::Instance()->SetStartTime(0.0);
+        RandomNumberGenerator::Instance()->Reseed(seed);
+        rEngine.Run(samplingMultiple);
+        SimulationTime::Destroy();
+        return GetSampleRows(rEngine);
+    }
+
+    static void CompareRows(const Rows& rExpected, const Rows& rActual, double tolerance = 1e-6)
+    {
+        TS_ASSERT_EQUALS(rActual.size(), rExpected.size());
+        for (unsigned i = 0; i < std::min(rActual.size(), rExpected.size()); i++)
+        {
+            TS_ASSERT_EQUALS(rActual[i].size(), rExpected[i].size());
+            for (unsigned j = 0; j < std::min(rActual[i].size(), rExpected[i].size()); j++)
+            {
+                TS_ASSERT_DELTA(rActual[i][j], rExpected[i][j], tolerance);
+            }
+        }
+    }
+};
+
+#endif /*WANTESTFIXTURE_HPP_*/